@@ -0,0 +1,56 @@
+// Shared by the IBL compute shaders
+
+const float PI = 3.14159265359;
+
+// Every IBL pass uses the same set: a source to sample and the mip being written
+layout(push_constant) uniform Pass {
+	float roughness;
+	uint size;
+} pass;
+
+// World direction through the centre of a texel of a cubemap face, using Vulkan's face order and orientation
+vec3 GetCubeDirection(uvec3 id, uint size)
+{
+	vec2 uv = (vec2(id.xy) + 0.5) / float(size) * 2.0 - 1.0;
+	vec3 direction;
+	switch (id.z)
+	{
+	case 0: direction = vec3(1.0, -uv.y, -uv.x); break;
+	case 1: direction = vec3(-1.0, -uv.y, uv.x); break;
+	case 2: direction = vec3(uv.x, 1.0, uv.y); break;
+	case 3: direction = vec3(uv.x, -1.0, -uv.y); break;
+	case 4: direction = vec3(uv.x, -uv.y, 1.0); break;
+	default: direction = vec3(-uv.x, -uv.y, -1.0); break;
+	}
+	return normalize(direction);
+}
+
+// Low discrepancy points for importance sampling
+vec2 Hammersley(uint i, uint count)
+{
+	uint bits = i;
+	bits = (bits << 16u) | (bits >> 16u);
+	bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+	bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+	bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+	bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+	return vec2(float(i) / float(count), float(bits) * 2.3283064365386963e-10);
+}
+
+// Half vector around N distributed like the GGX lobe
+vec3 ImportanceSampleGGX(vec2 xi, vec3 N, float roughness)
+{
+	float a = roughness * roughness;
+
+	float phi = 2.0 * PI * xi.x;
+	float cosTheta = sqrt((1.0 - xi.y) / (1.0 + (a * a - 1.0) * xi.y));
+	float sinTheta = sqrt(1.0 - cosTheta * cosTheta);
+
+	vec3 H = vec3(cos(phi) * sinTheta, sin(phi) * sinTheta, cosTheta);
+
+	vec3 up = abs(N.z) < 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(1.0, 0.0, 0.0);
+	vec3 tangent = normalize(cross(up, N));
+	vec3 bitangent = cross(N, tangent);
+
+	return normalize(tangent * H.x + bitangent * H.y + N * H.z);
+}
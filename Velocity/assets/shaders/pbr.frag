@@ -18,17 +18,17 @@ layout(push_constant) uniform PushConstants {
     layout(offset = 0) mat4 model;
 	layout(offset = 64) int albedoIndex;
 	layout(offset = 68) int normalIndex;
-	layout(offset = 72) int heightIndex;
-	layout(offset = 76) int metallicIndex;
-	layout(offset = 80) int roughnessIndex;
-	layout(offset = 84) float cameraPosX;
-	layout(offset = 88) float cameraPosY;
-	layout(offset = 92) float cameraPosZ;
-	layout(offset = 96) bool hasSkybox;
+	layout(offset = 72) int packedIndex;		// R occlusion, G roughness, B metallic, A height
+	layout(offset = 76) int heightMapped;
+	layout(offset = 80) float cameraPosX;
+	layout(offset = 84) float cameraPosY;
+	layout(offset = 88) float cameraPosZ;
+	layout(offset = 92) bool hasSkybox;
 } pc;
 
 layout(binding = 1) uniform PointLightData {
 	uint			Count;
+	vec4			IrradianceSH[9];	// Skybox diffuse as spherical harmonics, already convolved and divided by PI
 	PointLight[128]	Lights;
 } pointLights;
 
@@ -48,7 +48,7 @@ vec3 getNormalFromMap(inout vec2 UV)
 	vec3 biTangent = cross(modelNormal, modelTangent);					// Model space
 	mat3 invTangentMatrix = mat3(modelTangent, biTangent, modelNormal);	// Model space
 
-	if (pc.heightIndex != -1)
+	if (pc.heightMapped != 0)
 	{
 		// Calculate camera direction
 		vec3 cameraPos = vec3(pc.cameraPosX,pc.cameraPosY,pc.cameraPosZ);
@@ -63,12 +63,15 @@ vec3 getNormalFromMap(inout vec2 UV)
 		vec2 offsetDir = (cameraModelDir * tangentMatrix).xy;
 	
 		// offset uvec2
-		float texDepth = 0.06f * (texture(texSampler[pc.heightIndex],UV).r - 0.5f);
+		float texDepth = 0.06f * (texture(texSampler[pc.packedIndex],UV).a - 0.5f);
 		UV += texDepth * offsetDir;
 	}
 
 	// Extract normal from map and shift to -1 to 1 range
-	vec3 textureNormal = 2.0f * texture(texSampler[pc.normalIndex],UV).rgb - 1.0f;
+	// Blue is rebuilt from red and green so two channel (BC5) cooked maps work too
+	vec3 textureNormal;
+	textureNormal.xy = 2.0f * texture(texSampler[pc.normalIndex],UV).rg - 1.0f;
+	textureNormal.z = sqrt(max(1.0f - dot(textureNormal.xy, textureNormal.xy), 0.0f));
 	textureNormal.y = -textureNormal.y;
 
 	// Convert normal from tangent to world space
@@ -114,6 +117,22 @@ float GeometrySmith(vec3 N, vec3 V, vec3 L, float roughness)
 	return ggx1 * ggx2;
 }
 
+// Diffuse light arriving around a world space normal, evaluated from the skybox's harmonics
+// Basis order and constants match SphericalHarmonics on the CPU
+vec3 IrradianceSH(vec3 n)
+{
+	vec3 irradiance = 0.282095f * pointLights.IrradianceSH[0].rgb;
+
+	irradiance += 0.488603f * (n.y * pointLights.IrradianceSH[1].rgb + n.z * pointLights.IrradianceSH[2].rgb + n.x * pointLights.IrradianceSH[3].rgb);
+
+	irradiance += 1.092548f * (n.x * n.y * pointLights.IrradianceSH[4].rgb + n.y * n.z * pointLights.IrradianceSH[5].rgb + n.x * n.z * pointLights.IrradianceSH[7].rgb);
+	irradiance += 0.315392f * (3.0f * n.z * n.z - 1.0f) * pointLights.IrradianceSH[6].rgb;
+	irradiance += 0.546274f * (n.x * n.x - n.y * n.y) * pointLights.IrradianceSH[8].rgb;
+
+	// Ringing can dip below zero opposite very bright spots
+	return max(irradiance, vec3(0.0f));
+}
+
 // Reflectance
 vec3 fresnelSchlick(float cosTheta, vec3 F0)
 {
@@ -136,10 +155,11 @@ void main() {
 	// Albedo color normalised to linear space
 	vec3 albedo = pow(texture(texSampler[pc.albedoIndex],offsetUV).rgb,vec3(2.2f));
 
-	// Roughness and shinyness in linear space
-	float metallic = texture(texSampler[pc.metallicIndex],offsetUV).r;
-	float roughness = texture(texSampler[pc.roughnessIndex],offsetUV).r;
-	// TODO: AO
+	// Occlusion, roughness and shinyness in linear space, all from one fetch
+	vec4 packedMaps = texture(texSampler[pc.packedIndex],offsetUV);
+	float occlusion = packedMaps.r;
+	float roughness = packedMaps.g;
+	float metallic = packedMaps.b;
 
 	// Calculate reflectance at normal incidence.
 	vec3 F0 = vec3(0.04f);
@@ -195,8 +215,8 @@ void main() {
 
 		// Sample diffuse and specular of skybox
 
-		// Appromation to increase diffuse level
-		vec3 enviromentDiffuse = textureLod(skybox,N,8.0f).rgb;
+		// Nine coefficients instead of a blurry cubemap fetch
+		vec3 enviromentDiffuse = IrradianceSH(N);
 
 		float roughnessMip = 8.0f * log2(roughness + 1);
 
@@ -210,8 +230,8 @@ void main() {
 		ambient = mix(albedo,albedo * enviromentDiffuse + (1-roughness) * fresnelIBL * enviromentSpecular,0.7f);
 	}
 
-	// Final color in linear space
-	vec3 color = ambient + Lo;
+	// Final color in linear space. Occlusion only blocks indirect light
+	vec3 color = ambient * occlusion + Lo;
 
 	// Tonemap
 	color = color / (color + vec3(1.0f));
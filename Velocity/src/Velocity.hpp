@@ -26,6 +26,7 @@
 #include "Velocity/Renderer/Texture.hpp"
 #include "Velocity/Renderer/Skybox.hpp"
 #include "Velocity/Renderer/IBLMap.hpp"
+#include "Velocity/Renderer/TextureCooker.hpp"
 
 #include "imgui/imgui.h"
 
@@ -36,6 +37,8 @@
 #include "Velocity/ECS/Scene.hpp"
 #include "Velocity/ECS/Entity.hpp"
 #include "Velocity/ECS/Components.hpp"
+#include "Velocity/ECS/SceneAutosave.hpp"
+#include "Velocity/ECS/SceneLoad.hpp"
 
 // Math includes
 #define GLM_FORCE_RADIANS
@@ -46,4 +49,9 @@
 #include "Velocity/Audio/AudioManager.hpp"
 
 // Util
-#include "Velocity/Utility/Input.hpp" 
\ No newline at end of file
+#include "Velocity/Utility/AssetManifest.hpp"
+#include "Velocity/Utility/Input.hpp"
+#include "Velocity/Utility/ThreadPool.hpp"
+#include "Velocity/Utility/VirtualFileSystem.hpp"
+#include "Velocity/Utility/ImportBenchmark.hpp"
+#include "Velocity/Utility/SceneBenchmark.hpp"
\ No newline at end of file
@@ -6,6 +6,7 @@
 
 #include "Velocity/Core/Application.hpp"
 #include "Velocity/Core/Log.hpp"
+#include "Velocity/Utility/VirtualFileSystem.hpp"
 
 #ifdef VEL_PLATFORM_WINDOWS
 #define GLFW_EXPOSE_NATIVE_WIN32
@@ -64,9 +65,18 @@ namespace Velocity
 		// Load and insert sound if not loaded
 		if (m_LoadedSounds.find(filePath.c_str()) == m_LoadedSounds.end())
 		{
+			VirtualFileSystem::File file;
+			if (!VirtualFileSystem::Open(filePath, file))
+			{
+				VEL_CORE_ERROR("Failed to open sound: " + filePath);
+				throw std::runtime_error("See console!");
+			}
+
+			cs_loaded_sound_t sound = {};
+			cs_read_mem_wav(file.GetData(), static_cast<int>(file.GetSize()), &sound);
 			m_LoadedSounds.insert({
 				filePath.c_str(),
-				cs_load_wav(filePath.c_str())
+				sound
 			});
 
 			if (m_LoadedSounds[filePath.c_str()].channels[0] == nullptr)
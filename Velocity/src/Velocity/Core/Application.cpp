@@ -1,6 +1,8 @@
 #include "velpch.h"
 #include "Application.hpp"
 
+#include <filesystem>
+
 #include <GLFW/glfw3.h>
 
 
@@ -10,7 +12,9 @@
 #include "Velocity/Core/Log.hpp"
 
 #include "Velocity/Renderer/Renderer.hpp"
+#include "Velocity/Utility/AssetManifest.hpp"
 #include "Velocity/Utility/Input.hpp"
+#include "Velocity/Utility/VirtualFileSystem.hpp"
 
 namespace Velocity
 {
@@ -18,6 +22,23 @@ namespace Velocity
 	
 	Application::Application(const std::string& windowTitle,const uint32_t width, const uint32_t height)
 	{
+		// Packs and cooked asset manifests go up before anything reads its assets. Without them everything is read loose
+		for (const std::string folder : { "../Velocity/assets", "assets" })
+		{
+			std::error_code error;
+			const std::string packPath = folder + VirtualFileSystem::EXTENSION;
+			if (std::filesystem::exists(packPath, error))
+			{
+				VirtualFileSystem::Mount(packPath, folder + "/");
+			}
+
+			const std::string manifestPath = folder + "/" + AssetManifest::FILENAME;
+			if (VirtualFileSystem::Exists(manifestPath))
+			{
+				AssetManifest::Load(manifestPath, folder + "/");
+			}
+		}
+
 		s_Window = std::make_shared<Window>(WindowProps( windowTitle,width,height ));
 		s_Window->SetEventCallback(BIND_EVENT_FN(Application::OnEvent));
 
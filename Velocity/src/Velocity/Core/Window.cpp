@@ -12,6 +12,7 @@
 
 #include "Velocity/Renderer/Renderer.hpp"
 #include "Velocity/Utility/KeyCodes.hpp"
+#include "Velocity/Utility/VirtualFileSystem.hpp"
 
 namespace Velocity
 {
@@ -168,11 +169,23 @@ namespace Velocity
 
 	void Window::SetWindowIcon(const std::string& imagePath)
 	{
+		VirtualFileSystem::File file;
+		if (!VirtualFileSystem::Open(imagePath, file))
+		{
+			VEL_CORE_WARN("Failed to open window icon {0}", imagePath);
+			return;
+		}
+
 		GLFWimage newIcon;
-		newIcon.pixels = stbi_load(imagePath.c_str(), &newIcon.width, &newIcon.height, 0, 4);
+		newIcon.pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &newIcon.width, &newIcon.height, 0, 4);
+		if (!newIcon.pixels)
+		{
+			VEL_CORE_WARN("Failed to decode window icon {0}", imagePath);
+			return;
+		}
+
 		glfwSetWindowIcon(m_Window, 1, &newIcon);
 		stbi_image_free(newIcon.pixels);
-
 	}
 	void Window::SetWindowTitle(const std::string& newTitle)
 	{
@@ -0,0 +1,270 @@
+#include "velpch.h"
+
+#include "AssetStore.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <unordered_set>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	const char* AssetStore::STORE_DIRECTORY = "../Velocity/store/";
+	const char* AssetStore::ROOTS_FILENAME = "scenes.txt";
+
+	std::shared_mutex AssetStore::s_SaveMutex;
+	std::mutex AssetStore::s_RootMutex;
+
+	std::mutex AssetStore::s_ResidentMutex;
+	std::unordered_map<uint64_t, std::weak_ptr<const SceneFileReader>> AssetStore::s_Resident;
+
+	uint64_t AssetStore::ComputeKey(Kind kind, const std::vector<Chunk>& chunks, uint64_t extra)
+	{
+		uint64_t key = Hash::Combine(static_cast<uint64_t>(kind), extra);
+		for (const auto& chunk : chunks)
+		{
+			key = Hash::Combine(key, static_cast<uint32_t>(chunk.Type));
+			key = Hash::Combine(key, chunk.ElementSize);
+			key = Hash::Bytes(chunk.Data, chunk.Size, key);
+		}
+		return key != 0u ? key : 1u;
+	}
+
+	bool AssetStore::Contains(uint64_t key)
+	{
+		{
+			std::lock_guard<std::mutex> lock(s_ResidentMutex);
+			auto resident = s_Resident.find(key);
+			if (resident != s_Resident.end() && !resident->second.expired())
+			{
+				return true;
+			}
+		}
+
+		std::error_code error;
+		return std::filesystem::exists(GetPath(key), error);
+	}
+
+	std::future<bool> AssetStore::Store(uint64_t key, std::vector<Chunk> chunks, const SceneSaveOptions& options)
+	{
+		// Waiting on the pool from inside it could starve it
+		if (ThreadPool::IsWorkerThread())
+		{
+			std::promise<bool> result;
+			result.set_value(Write(key, chunks, options));
+			return result.get_future();
+		}
+
+		return ThreadPool::Get().Enqueue([key, chunks, options]() { return Write(key, chunks, options); });
+	}
+
+	bool AssetStore::Write(uint64_t key, const std::vector<Chunk>& chunks, const SceneSaveOptions& options)
+	{
+		if (Contains(key))
+		{
+			return true;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(STORE_DIRECTORY, error);
+
+		// The writer only swaps the file in once it is complete, so a key that exists is always a whole asset
+		SceneFileWriter file;
+		if (!file.Begin(GetPath(key), options))
+		{
+			return false;
+		}
+		for (const auto& chunk : chunks)
+		{
+			file.AddChunk(chunk.Type, chunk.Owner, chunk.Data, chunk.Size, chunk.ElementSize);
+		}
+		return file.Finish();
+	}
+
+	std::shared_ptr<const SceneFileReader> AssetStore::Open(uint64_t key)
+	{
+		std::lock_guard<std::mutex> lock(s_ResidentMutex);
+		auto& resident = s_Resident[key];
+		if (auto reader = resident.lock())
+		{
+			return reader;
+		}
+
+		auto reader = std::make_shared<SceneFileReader>();
+		if (!reader->Open(GetPath(key)))
+		{
+			VEL_CORE_ERROR("Asset {0} is missing from the store!", Hash::ToString(key));
+			s_Resident.erase(key);
+			return nullptr;
+		}
+
+		resident = reader;
+		return reader;
+	}
+
+	std::string AssetStore::GetPath(uint64_t key)
+	{
+		return std::string(STORE_DIRECTORY) + Hash::ToString(key) + ".vasset";
+	}
+
+	std::shared_lock<std::shared_mutex> AssetStore::LockForSave()
+	{
+		return std::shared_lock<std::shared_mutex>(s_SaveMutex);
+	}
+
+	void AssetStore::AddRoot(const std::string& scenePath)
+	{
+		const std::string root = std::filesystem::absolute(scenePath).lexically_normal().generic_string();
+
+		std::lock_guard<std::mutex> lock(s_RootMutex);
+		std::vector<std::string> roots;
+		ReadRoots(roots);
+		if (std::find(roots.begin(), roots.end(), root) == roots.end())
+		{
+			roots.push_back(root);
+			WriteRoots(roots);
+		}
+	}
+
+	size_t AssetStore::Collect(const std::function<bool(const std::string&, std::vector<uint64_t>&)>& readKeys)
+	{
+		// Saves wait until the sweep is done
+		std::unique_lock<std::shared_mutex> saving(s_SaveMutex);
+		std::lock_guard<std::mutex> lock(s_RootMutex);
+
+		std::vector<std::string> roots;
+		if (!ReadRoots(roots))
+		{
+			VEL_CORE_WARN("No scenes have been saved against the store, leaving it alone");
+			return 0u;
+		}
+
+		std::unordered_set<uint64_t> reachable;
+		std::vector<std::string> remaining;
+		for (const auto& root : roots)
+		{
+			std::error_code error;
+			const bool bExists = std::filesystem::exists(root, error);
+			if (error)
+			{
+				VEL_CORE_ERROR("Couldnt check for scene {0}, leaving the store alone: {1}", root, error.message());
+				return 0u;
+			}
+			if (!bExists)
+			{
+				continue;
+			}
+
+			std::vector<uint64_t> keys;
+			if (!readKeys(root, keys))
+			{
+				VEL_CORE_ERROR("Couldnt read scene {0}, leaving the store alone", root);
+				return 0u;
+			}
+			reachable.insert(keys.begin(), keys.end());
+			remaining.push_back(root);
+		}
+
+		// Live scenes keep what they loaded from, they may be saved again
+		{
+			std::lock_guard<std::mutex> residentLock(s_ResidentMutex);
+			for (const auto& resident : s_Resident)
+			{
+				if (!resident.second.expired())
+				{
+					reachable.insert(resident.first);
+				}
+			}
+		}
+
+		std::unordered_set<std::string> keep;
+		for (const uint64_t key : reachable)
+		{
+			keep.insert(Hash::ToString(key) + ".vasset");
+		}
+
+		size_t deleted = 0u;
+		uint64_t bytes = 0u;
+		std::error_code error;
+		for (auto it = std::filesystem::directory_iterator(STORE_DIRECTORY, error); !error && it != std::filesystem::directory_iterator(); it.increment(error))
+		{
+			const auto& path = it->path();
+			if (path.extension() != ".vasset" || keep.count(path.filename().generic_string()) != 0u)
+			{
+				continue;
+			}
+
+			std::error_code removeError;
+			const uint64_t size = static_cast<uint64_t>(it->file_size(removeError));
+			if (std::filesystem::remove(path, removeError))
+			{
+				++deleted;
+				bytes += removeError ? 0u : size;
+			}
+		}
+
+		// Scenes that are gone dont point at anything any more
+		if (remaining.size() != roots.size())
+		{
+			WriteRoots(remaining);
+		}
+
+		VEL_CORE_INFO("Deleted {0} unused assets ({1} bytes) from the store, {2} scenes point at the rest", deleted, bytes, remaining.size());
+		return deleted;
+	}
+
+	bool AssetStore::ReadRoots(std::vector<std::string>& outRoots)
+	{
+		std::ifstream input(std::string(STORE_DIRECTORY) + ROOTS_FILENAME);
+		if (!input.is_open())
+		{
+			return false;
+		}
+
+		std::string root;
+		while (std::getline(input, root))
+		{
+			if (!root.empty())
+			{
+				outRoots.push_back(root);
+			}
+		}
+		return true;
+	}
+
+	bool AssetStore::WriteRoots(const std::vector<std::string>& roots)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(STORE_DIRECTORY, error);
+
+		// Swapped in once whole, a torn record would let Collect delete assets a scene needs
+		const std::string path = std::string(STORE_DIRECTORY) + ROOTS_FILENAME;
+		const std::string tempPath = path + ".tmp";
+		{
+			std::ofstream output(tempPath, std::ios::trunc);
+			for (const auto& root : roots)
+			{
+				output << root << '\n';
+			}
+			if (!output.good())
+			{
+				VEL_CORE_ERROR("Failed to write the store's scene record {0}", path);
+				output.close();
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(tempPath, path, error);
+		if (error)
+		{
+			VEL_CORE_ERROR("Failed to replace the store's scene record {0}: {1}", path, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+}
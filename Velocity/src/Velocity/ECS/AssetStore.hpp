@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "SceneFile.hpp"
+
+namespace Velocity
+{
+	// Content addressed store for the heavy parts of scenes, meshes, textures and skyboxes
+	// Each asset is a scene file of its own named by the hash of its contents, so an asset shared by many scenes is stored
+	// once and one that hasnt changed is never written again. Scenes only keep the keys, see Scene::SaveScene
+	// Keys only cover what an asset holds, so a new container version reads old assets rather than storing them again
+	// Every scene saved against the store is recorded, and Collect deletes the assets none of them point at
+	class AssetStore
+	{
+	public:
+		// Part of every key so different kinds of asset with the same bytes dont collide
+		enum class Kind : uint32_t
+		{
+			Mesh,		// Vertices, indices and meshlets, meshlets relative to the mesh's indices
+			Texture,	// One texture chunk, raw pixels or a cooked file
+			Skybox		// Six skybox faces
+		};
+
+		// One chunk of an asset. Owner keeps the data alive until it is written
+		struct Chunk
+		{
+			SceneChunk					Type = SceneChunk::Scene;
+			std::shared_ptr<const void>	Owner;
+			const void*					Data = nullptr;
+			size_t						Size = 0u;
+			uint32_t					ElementSize = 0u;
+		};
+
+		// Where assets are written. Scenes saved against the store need it, so unlike the caches it isnt safe to delete
+		static const char* STORE_DIRECTORY;
+
+		// Key of an asset with these chunks. Never 0, scenes use that for something stored in the scene itself
+		static uint64_t ComputeKey(Kind kind, const std::vector<Chunk>& chunks, uint64_t extra = 0u);
+
+		// True if the asset is on disk already
+		static bool Contains(uint64_t key);
+
+		// Writes the asset on the pool, or inline on a worker. Assets already stored are skipped
+		// The future is false if it couldnt be written
+		static std::future<bool> Store(uint64_t key, std::vector<Chunk> chunks, const SceneSaveOptions& options);
+
+		// Maps an asset. Assets still held by another scene are shared rather than opened again. nullptr if missing or corrupt
+		static std::shared_ptr<const SceneFileReader> Open(uint64_t key);
+
+		static std::string GetPath(uint64_t key);
+
+		// Scenes saved against the store, a full path a line. Kept in the store directory
+		static const char* ROOTS_FILENAME;
+
+		// Held by a save from checking for its assets until the scene pointing at them is written and recorded
+		// Collect waits for every save to let go, so it never deletes an asset a save has just found
+		static std::shared_lock<std::shared_mutex> LockForSave();
+
+		// Records a scene saved against the store. Call with the save lock held
+		static void AddRoot(const std::string& scenePath);
+
+		// Deletes every asset that no recorded scene points at and no live scene has mapped. Returns how many went
+		// ReadKeys gives the keys a scene file points at, see SceneLoad::ReadAssetKeys. Scenes gone from the disk are
+		// dropped from the record. Nothing is deleted if a recorded scene cant be read, or none have been recorded yet
+		// Scenes saved before the record existed or copied outside the editor arent in it, so save them again first
+		static size_t Collect(const std::function<bool(const std::string&, std::vector<uint64_t>&)>& readKeys);
+
+	private:
+		static bool Write(uint64_t key, const std::vector<Chunk>& chunks, const SceneSaveOptions& options);
+
+		// Returns false if no scene has been recorded yet
+		static bool ReadRoots(std::vector<std::string>& outRoots);
+		static bool WriteRoots(const std::vector<std::string>& roots);
+
+		static std::shared_mutex s_SaveMutex;
+		static std::mutex s_RootMutex;
+
+		// Assets mapped by any live scene
+		static std::mutex s_ResidentMutex;
+		static std::unordered_map<uint64_t, std::weak_ptr<const SceneFileReader>> s_Resident;
+	};
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+#include <cereal/cereal.hpp>
+
+namespace Velocity
+{
+	// Types that can go to disk as their raw bytes in one block instead of field by field
+	// Pointers are trivially copyable but mean nothing once saved
+	template<typename T>
+	struct IsBulkSerialisable : std::bool_constant<std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T> && !std::is_pointer_v<T>> {};
+
+	template<typename T>
+	inline constexpr bool IsBulkSerialisable_v = IsBulkSerialisable<T>::value;
+
+	// Written ahead of bulk data. Raw bytes are only valid on a machine with the same byte order
+	// Layout changes are caught by each component's version and size, and by the scene file version for everything else
+	struct BulkLayout
+	{
+		// Reads back as 0x04030201 on the other byte order
+		static constexpr uint32_t ENDIAN_TAG = 0x01020304u;
+
+		uint32_t	Endian = ENDIAN_TAG;
+
+		bool IsCompatible() const { return Endian == ENDIAN_TAG; }
+
+		template<class Archive>
+		void serialize(Archive& ar)
+		{
+			ar(Endian);
+		}
+
+		// Files from before components carried their own versions wrote a layout version after the tag, it is skipped
+		template<class Archive>
+		void LoadVersioned(Archive& ar)
+		{
+			uint32_t version = 0u;
+			ar(Endian, version);
+		}
+	};
+
+	// A single value as one block
+	template<typename T>
+	auto BulkData(T& value)
+	{
+		static_assert(IsBulkSerialisable_v<std::remove_const_t<T>>, "Only trivially copyable types can be bulk serialised");
+		return cereal::binary_data(&value, sizeof(T));
+	}
+}
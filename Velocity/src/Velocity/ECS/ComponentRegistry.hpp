@@ -0,0 +1,431 @@
+#pragma once
+
+#include <cstdint>
+#include <sstream>
+#include <type_traits>
+#include <vector>
+
+#include <entt/entt.hpp>
+#include <cereal/archives/binary.hpp>
+
+#include <Velocity/Utility/Hash.hpp>
+
+#include "BulkSerialisation.hpp"
+#include "Components.hpp"
+
+namespace Velocity
+{
+	class Scene;
+
+	// Carries a type through generic lambdas
+	template<typename T>
+	struct TypeTag
+	{
+		using Type = T;
+	};
+
+	// Compile time list of types. Everything is expanded at compile time, nothing is looked up at runtime
+	template<typename... Types>
+	struct TypeList
+	{
+		static constexpr size_t SIZE = sizeof...(Types);
+
+		// Calls function(TypeTag<T>{}) for each type in order
+		template<typename Function>
+		static void ForEach(Function&& function)
+		{
+			(function(TypeTag<Types>{}), ...);
+		}
+
+		// Calls function(TypeTag<T>{}...) once with every type, for APIs that take the whole pack
+		template<typename Function>
+		static decltype(auto) Expand(Function&& function)
+		{
+			return function(TypeTag<Types>{}...);
+		}
+
+		// Target<Types...>, to build a type from every entry
+		template<template<typename...> class Target>
+		using Apply = Target<Types...>;
+
+		// Position of T in the list
+		template<typename T>
+		static constexpr size_t IndexOf()
+		{
+			static_assert((std::is_same_v<T, Types> || ...), "Type is not in the list");
+			size_t index = 0u;
+			bool found = false;
+			((found = found || std::is_same_v<T, Types>, index += found ? 0u : 1u), ...);
+			return index;
+		}
+	};
+
+	// Defaults every component's traits start from
+	template<typename T>
+	struct ComponentTraitsBase
+	{
+		// Bump when a component's saved form changes and give it an upgrade path below
+		static constexpr uint32_t VERSION = 1u;
+
+		// Saved as raw blocks, see BulkSerialisation
+		static constexpr bool BULK = IsBulkSerialisable_v<T>;
+
+		// Marks the scene dirty and calls OnChanged on construct, update and destroy
+		static constexpr bool TRACK_CHANGES = true;
+
+		// Called after any tracked change to a component of this type
+		static void OnChanged(Scene& scene) {}
+
+		// Reads a component saved at an older version through the archive. Return false if there is no way to
+		template<class Archive>
+		static bool LoadVersion(Archive& ar, T& component, uint32_t version) { return false; }
+
+		// As above for bulk components, bytes are one component in the old layout
+		static bool UpgradeBulk(const uint8_t* bytes, uint32_t size, uint32_t version, T& component) { return false; }
+	};
+
+	// Specialise for every component in SceneComponents. NAME is what the editor shows and what sections are keyed by
+	template<typename T>
+	struct ComponentTraits;
+
+	template<>
+	struct ComponentTraits<TagComponent> : ComponentTraitsBase<TagComponent>
+	{
+		static constexpr const char* NAME = "Tag";
+	};
+
+	template<>
+	struct ComponentTraits<TransformComponent> : ComponentTraitsBase<TransformComponent>
+	{
+		static constexpr const char* NAME = "Transform";
+	};
+
+	template<>
+	struct ComponentTraits<MeshComponent> : ComponentTraitsBase<MeshComponent>
+	{
+		static constexpr const char* NAME = "Mesh";
+	};
+
+	template<>
+	struct ComponentTraits<TextureComponent> : ComponentTraitsBase<TextureComponent>
+	{
+		static constexpr const char* NAME = "Texture";
+	};
+
+	template<>
+	struct ComponentTraits<PointLightComponent> : ComponentTraitsBase<PointLightComponent>
+	{
+		static constexpr const char* NAME = "Point Light";
+
+		// The renderer keeps its own packed copy of every light. Defined in Scene.cpp
+		static void OnChanged(Scene& scene);
+	};
+
+	template<>
+	struct ComponentTraits<PBRComponent> : ComponentTraitsBase<PBRComponent>
+	{
+		static constexpr const char* NAME = "PBR Material";
+
+		// 2 saves the height flag as a bool
+		static constexpr uint32_t VERSION = 2u;
+
+		template<class Archive>
+		static bool LoadVersion(Archive& ar, PBRComponent& component, uint32_t version)
+		{
+			if (version != 1u)
+			{
+				return false;
+			}
+			ar(component.MaterialName, component.TextureIDs, component.HeightMapped);
+			return true;
+		}
+	};
+
+	// Every component a scene can hold. Scenes from before the chunked format snapshot in this order, so only append
+	using SceneComponents = TypeList<TagComponent, TransformComponent, MeshComponent, TextureComponent, PointLightComponent, PBRComponent>;
+
+	// A component saved through its archive at a known older version, for archives that dont record one
+	template<typename T, uint32_t Version>
+	struct SavedComponent
+	{
+		T Component;
+
+		template<class Archive>
+		void load(Archive& ar)
+		{
+			if (Version == ComponentTraits<T>::VERSION)
+			{
+				ar(Component);
+			}
+			else if (!ComponentTraits<T>::LoadVersion(ar, Component, Version))
+			{
+				throw cereal::Exception(std::string("No upgrade for saved ") + ComponentTraits<T>::NAME + " components");
+			}
+		}
+	};
+
+	// Registry components without entt's per component snapshot, generated from SceneComponents
+	// Each type is a section keyed by its name with its version and size, so sections for unknown types are skipped
+	// and types missing from the file are left off. Trivially copyable types are written as two blocks, entities then components
+	// Entities themselves still go through entt's snapshot
+	class ComponentSerialiser
+	{
+	public:
+		static void Save(cereal::BinaryOutputArchive& ar, entt::registry& registry)
+		{
+			WriteLayout(ar, static_cast<uint32_t>(SceneComponents::SIZE));
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				auto view = registry.view<Component>();
+
+				std::vector<entt::entity> entities;
+				std::vector<Component> components;
+				entities.reserve(view.size());
+				components.reserve(view.size());
+				for (auto entity : view)
+				{
+					entities.push_back(entity);
+					components.push_back(registry.get<Component>(entity));
+				}
+				WriteSection(ar, entities, components);
+			});
+		}
+
+		// Call between the snapshot loader's entities and orphans so the entity ids already exist
+		static void Load(cereal::BinaryInputArchive& ar, entt::registry& registry)
+		{
+			const uint32_t sectionCount = ReadLayout(ar);
+			for (uint32_t i = 0; i < sectionCount; ++i)
+			{
+				ReadSection(ar, [&registry](auto tag, entt::entity entity, auto& component)
+				{
+					registry.emplace<typename decltype(tag)::Type>(entity, std::move(component));
+				});
+			}
+		}
+
+		// Writes the layout and the number of sections that follow. For anything else made of sections
+		static void WriteLayout(cereal::BinaryOutputArchive& ar, uint32_t sectionCount)
+		{
+			BulkLayout layout;
+			ar(layout, sectionCount);
+		}
+
+		// Returns the number of sections that follow
+		static uint32_t ReadLayout(cereal::BinaryInputArchive& ar)
+		{
+			BulkLayout layout;
+			uint32_t sectionCount = 0u;
+			ar(layout, sectionCount);
+			if (!layout.IsCompatible())
+			{
+				throw cereal::Exception("Components were saved with a different byte order");
+			}
+			return sectionCount;
+		}
+
+		// One section of components with the entities they belong to. Trivially copyable types go as two blocks
+		template<typename Component>
+		static void WriteSection(cereal::BinaryOutputArchive& ar, const std::vector<entt::entity>& entities, const std::vector<Component>& components)
+		{
+			using Traits = ComponentTraits<Component>;
+
+			SectionHeader header;
+			header.ID = GetID<Component>();
+			header.Version = Traits::VERSION;
+			header.Count = static_cast<uint64_t>(entities.size());
+
+			if constexpr (Traits::BULK)
+			{
+				header.ComponentSize = sizeof(Component);
+				header.PayloadSize = entities.size() * sizeof(entt::entity) + components.size() * sizeof(Component);
+				ar(BulkData(header));
+				ar(cereal::binary_data(entities.data(), entities.size() * sizeof(entt::entity)));
+				ar(cereal::binary_data(components.data(), components.size() * sizeof(Component)));
+			}
+			else
+			{
+				// Archived on its own first so the section size is known and it can be skipped
+				std::ostringstream stream;
+				{
+					cereal::BinaryOutputArchive sectionArchive(stream);
+					for (size_t i = 0; i < entities.size(); ++i)
+					{
+						sectionArchive(entities[i], components[i]);
+					}
+				}
+				const auto payload = stream.str();
+
+				header.PayloadSize = payload.size();
+				ar(BulkData(header));
+				ar(cereal::binary_data(payload.data(), payload.size()));
+			}
+		}
+
+		// Reads the next section and hands every component in it to apply(TypeTag<Component>{}, entity, component)
+		// Sections for removed components are dropped
+		template<typename Function>
+		static void ReadSection(cereal::BinaryInputArchive& ar, Function&& apply)
+		{
+			SectionHeader header;
+			ar(BulkData(header));
+
+			std::vector<uint8_t> payload(static_cast<size_t>(header.PayloadSize));
+			ar(cereal::binary_data(payload.data(), payload.size()));
+
+			bool bKnown = false;
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				if (!bKnown && header.ID == GetID<Component>())
+				{
+					bKnown = true;
+					LoadSection<Component>(header, payload, apply);
+				}
+			});
+		}
+
+		// Components as the first block format saved them, every type in list order without sections
+		// Bulk types were a count, their size, then entities and components as two blocks. The rest were archived one by one
+		// Nothing was versioned, so everything is at version 1
+		static void LoadUnsectioned(cereal::BinaryInputArchive& ar, entt::registry& registry)
+		{
+			BulkLayout layout;
+			layout.LoadVersioned(ar);
+			if (!layout.IsCompatible())
+			{
+				throw cereal::Exception("Components were saved with a different byte order");
+			}
+
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				using Traits = ComponentTraits<Component>;
+
+				SectionHeader header;
+				header.Version = 1u;
+				ar(header.Count);
+
+				if constexpr (Traits::BULK)
+				{
+					ar(header.ComponentSize);
+					header.PayloadSize = header.Count * (sizeof(entt::entity) + header.ComponentSize);
+					std::vector<uint8_t> payload(static_cast<size_t>(header.PayloadSize));
+					ar(cereal::binary_data(payload.data(), payload.size()));
+					auto apply = [&registry](auto, entt::entity entity, Component& component)
+					{
+						registry.emplace<Component>(entity, std::move(component));
+					};
+					LoadSection<Component>(header, payload, apply);
+				}
+				else
+				{
+					for (uint64_t i = 0; i < header.Count; ++i)
+					{
+						entt::entity entity;
+						SavedComponent<Component, 1u> saved;
+						ar(entity, saved);
+						registry.emplace<Component>(entity, std::move(saved.Component));
+					}
+				}
+			});
+		}
+
+		// Components as the first chunked scenes saved them, through entt's own snapshot at version 1
+		// Call between the loader's entities and orphans
+		template<typename Loader>
+		static void LoadSnapshot(Loader& loader, cereal::BinaryInputArchive& ar, entt::registry& registry)
+		{
+			SceneComponents::Expand([&](auto... tags) { loader.template component<SavedComponent<typename decltype(tags)::Type, 1u>...>(ar); });
+
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				using Saved = SavedComponent<Component, 1u>;
+				for (auto entity : registry.view<Saved>())
+				{
+					registry.emplace<Component>(entity, std::move(registry.get<Saved>(entity).Component));
+				}
+				registry.clear<Saved>();
+			});
+		}
+
+		// Stable id of a component type in saved files
+		template<typename Component>
+		static uint64_t GetID()
+		{
+			const std::string name = ComponentTraits<Component>::NAME;
+			return Hash::Bytes(name.data(), name.size());
+		}
+
+	private:
+		struct SectionHeader
+		{
+			uint64_t	ID = 0u;
+			uint32_t	Version = 0u;
+			uint32_t	ComponentSize = 0u;		// 0 for components that go through their archive
+			uint64_t	Count = 0u;
+			uint64_t	PayloadSize = 0u;
+		};
+
+		template<typename Component, typename Function>
+		static void LoadSection(const SectionHeader& header, const std::vector<uint8_t>& payload, Function& apply)
+		{
+			using Traits = ComponentTraits<Component>;
+			const auto count = static_cast<size_t>(header.Count);
+
+			if (header.ComponentSize > 0u)
+			{
+				if constexpr (Traits::BULK)
+				{
+					const uint64_t entityBytes = header.Count * sizeof(entt::entity);
+					if (entityBytes + header.Count * header.ComponentSize != header.PayloadSize)
+					{
+						throw cereal::Exception("Component section is the wrong size");
+					}
+
+					const bool bCurrent = header.Version == Traits::VERSION && header.ComponentSize == sizeof(Component);
+					for (size_t i = 0; i < count; ++i)
+					{
+						entt::entity entity;
+						memcpy(&entity, payload.data() + i * sizeof(entt::entity), sizeof(entt::entity));
+
+						const auto* bytes = payload.data() + entityBytes + i * header.ComponentSize;
+						Component component;
+						if (bCurrent)
+						{
+							memcpy(&component, bytes, sizeof(Component));
+						}
+						else if (!Traits::UpgradeBulk(bytes, header.ComponentSize, header.Version, component))
+						{
+							throw cereal::Exception(std::string("No upgrade for saved ") + Traits::NAME + " components");
+						}
+						apply(TypeTag<Component>{}, entity, component);
+					}
+					return;
+				}
+				throw cereal::Exception(std::string(Traits::NAME) + " components were saved as blocks but no longer can be");
+			}
+
+			// Archived per component
+			std::istringstream stream(std::string(payload.begin(), payload.end()));
+			cereal::BinaryInputArchive sectionArchive(stream);
+			for (size_t i = 0; i < count; ++i)
+			{
+				entt::entity entity;
+				Component component;
+				sectionArchive(entity);
+				if (header.Version == Traits::VERSION)
+				{
+					sectionArchive(component);
+				}
+				else if (!Traits::LoadVersion(sectionArchive, component, header.Version))
+				{
+					throw cereal::Exception(std::string("No upgrade for saved ") + Traits::NAME + " components");
+				}
+				apply(TypeTag<Component>{}, entity, component);
+			}
+		}
+	};
+}
@@ -132,7 +132,7 @@ namespace Velocity
 		template <class Archive>
 		void load(Archive& ar)
 		{
-			ar(Position.x, Position.y, Position.z, Color.x, Color.y, Color.z);
+			ar(Position.x, Position.y, Position.z, Intensity, Color.x, Color.y, Color.z);
 		}
 	};
 
@@ -140,42 +140,41 @@ namespace Velocity
 	{
 		int32_t& AlbedoID() { return TextureIDs[0]; }
 		int32_t& NormalID() { return TextureIDs[1]; }
-		int32_t& HeightID() { return TextureIDs[2]; }
-		int32_t& MetallicID() { return TextureIDs[3]; }
-		int32_t& RoughnessID() { return TextureIDs[4]; }
+		// Occlusion, roughness, metallic and height packed into R, G, B and A
+		int32_t& PackedID() { return TextureIDs[2]; }
 
 		PBRComponent() = default;
 		PBRComponent(const PBRComponent&) = default;
 
 		std::string				MaterialName = "";
-		std::array<int32_t, 5> TextureIDs = { 0,0,0,0,0 };
+		std::array<int32_t, 3> TextureIDs = { 0,0,0 };
 
-		uint32_t GetSize()
-		{
-			return sizeof(int32_t) * static_cast<int32_t>(TextureIDs.size());
-		}
+		// Not a texture, 1 if the packed alpha holds a height map to parallax with
+		int32_t					HeightMapped = 0;
 
-		// This works for a single component as structs are contiguous
-		int32_t* GetPointer()
+		// What the fragment shader takes after the model matrix, the texture indices then the height flag
+		std::array<int32_t, 4> GetPushConstants() const
 		{
-			return TextureIDs.data();
+			return { TextureIDs[0], TextureIDs[1], TextureIDs[2], HeightMapped };
 		}
 
+		// The flag is saved as the bool it is. Version 1 saved it as an int, see ComponentTraits<PBRComponent>
 		template <class Archive>
 		void save(Archive& ar) const
 		{
-			ar(MaterialName,TextureIDs);
+			ar(MaterialName,TextureIDs,HeightMapped != 0);
 		}
 
 		template <class Archive>
 		void load(Archive& ar)
 		{
-			ar(MaterialName, TextureIDs);
+			bool heightMapped = false;
+			ar(MaterialName, TextureIDs, heightMapped);
+			HeightMapped = heightMapped ? 1 : 0;
 		}
 		
 	};
 
-	// This is really bad but idk
-	#define COMPONENT_LIST TagComponent,TransformComponent,MeshComponent,TextureComponent,PointLightComponent,PBRComponent
+	// The list of components and their traits is in ComponentRegistry
 	
 }
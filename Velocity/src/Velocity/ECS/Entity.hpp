@@ -39,6 +39,14 @@ namespace Velocity
 		}
 
 
+		// Call after editing a component in place so change tracking and its hooks see it
+		template<typename T>
+		void NotifyChanged()
+		{
+			VEL_CORE_ASSERT(HasComponent<T>(), "Entity does not have component!");
+			m_Scene->m_Registry.replace<T>(m_EntityHandle, m_Scene->m_Registry.get<T>(m_EntityHandle));
+		}
+
 		template<typename T>
 		bool HasComponent()
 		{
@@ -2,6 +2,11 @@
 
 #include "Scene.hpp"
 
+#include <map>
+#include <set>
+#include <sstream>
+#include <unordered_set>
+
 #include <entt/entt.hpp>
 
 #include <cereal/types/unordered_map.hpp>
@@ -13,19 +18,235 @@
 
 #include "Components.hpp"
 #include "Entity.hpp"
+#include "SceneArchive.hpp"
+#include "SceneLayout.hpp"
+#include "SceneLoad.hpp"
 
 #include <Velocity/Renderer/Renderer.hpp>
+#include <Velocity/Renderer/TextureCooker.hpp>
+#include <Velocity/Utility/Hash.hpp>
 
 namespace Velocity
 {
+	namespace
+	{
+		// Scenes from before the chunked format carry no version, these are the layouts they were written in
+		enum class LegacyLayout
+		{
+			Baseline,		// Raw textures only, materials with a texture per map
+			CookedTextures,	// Whole cooked files saved after the raw pixels
+			PackedMaterials	// Materials with their masks in one packed texture
+		};
+
+		// Everything a legacy scene holds, read in full before any of it replaces the open scene
+		struct LegacyScene
+		{
+			std::string														Name;
+			entt::registry													Registry;
+			std::unordered_map<std::string, LegacyMeshRange>				Ranges;
+			std::vector<Vertex>												Vertices;
+			std::vector<uint32_t>											Indices;
+			std::unique_ptr<Camera>											SceneCamera;
+			std::vector<std::string>										TextureNames;
+			std::vector<stbi_uc>											TexturePixels;
+			std::vector<int>												TextureSizes;	// Width then height of every texture
+			std::vector<std::vector<uint8_t>>								TextureCooked;	// Whole cooked files, empty for raw textures
+			std::unordered_map<std::string, PBRComponent>					Materials;
+			std::unordered_map<std::string, LegacyMaterial>					LegacyMaterials;	// Instead of materials in the older layouts, entities hold them too
+			bool															bHasSkybox = false;
+			uint32_t														SkyboxWidth = 0u;
+			uint32_t														SkyboxHeight = 0u;
+			std::vector<stbi_uc>											SkyboxPixels;
+		};
+
+		// Moves every component of the listed types across, the entities have to exist in both already
+		template<typename... Components>
+		void MoveComponents(entt::registry& from, entt::registry& to)
+		{
+			([&]()
+			{
+				for (const auto entity : from.view<Components>())
+				{
+					to.emplace<Components>(entity, std::move(from.get<Components>(entity)));
+				}
+			}(), ...);
+		}
+
+		// Returns false unless the bytes read as the layout from start to end
+		bool ReadLegacy(const std::string& bytes, LegacyLayout layout, LegacyScene& scene)
+		{
+			std::istringstream stream(bytes);
+			try
+			{
+				cereal::BinaryInputArchive archive(stream);
+				archive(scene.Name);
+
+				// The components as they were listed then, through their own archives
+				entt::snapshot_loader loader{ scene.Registry };
+				loader.entities(archive);
+				using PackedMaterial = SavedComponent<PBRComponent, 1u>;
+				if (layout == LegacyLayout::PackedMaterials)
+				{
+					loader.component<TagComponent, TransformComponent, MeshComponent, TextureComponent, PointLightComponent, PackedMaterial>(archive);
+					for (auto entity : scene.Registry.view<PackedMaterial>())
+					{
+						scene.Registry.emplace<PBRComponent>(entity, std::move(scene.Registry.get<PackedMaterial>(entity).Component));
+					}
+					scene.Registry.clear<PackedMaterial>();
+				}
+				else
+				{
+					loader.component<TagComponent, TransformComponent, MeshComponent, TextureComponent, PointLightComponent, LegacyMaterial>(archive);
+				}
+				loader.orphans();
+
+				archive(scene.Ranges, scene.Vertices, scene.Indices, scene.SceneCamera);
+				archive(scene.TextureNames, scene.TexturePixels, scene.TextureSizes);
+				if (layout == LegacyLayout::Baseline)
+				{
+					scene.TextureCooked.resize(scene.TextureNames.size());
+				}
+				else
+				{
+					archive(scene.TextureCooked);
+				}
+
+				if (layout == LegacyLayout::PackedMaterials)
+				{
+					std::unordered_map<std::string, PackedMaterial> materials;
+					archive(materials);
+					for (auto& [name, material] : materials)
+					{
+						scene.Materials[name] = std::move(material.Component);
+					}
+				}
+				else
+				{
+					archive(scene.LegacyMaterials);
+				}
+				archive(scene.bHasSkybox);
+				if (scene.bHasSkybox)
+				{
+					archive(scene.SkyboxWidth, scene.SkyboxHeight, scene.SkyboxPixels);
+				}
+			}
+			catch (const std::exception&)
+			{
+				// Reading the wrong layout can take any bytes for a length
+				return false;
+			}
+
+			// The wrong layout can still read without running out, so the sizes have to add up as well
+			if (stream.peek() != std::char_traits<char>::eof() || !scene.SceneCamera ||
+				scene.TextureSizes.size() != scene.TextureNames.size() * 2u || scene.TextureCooked.size() != scene.TextureNames.size())
+			{
+				return false;
+			}
+
+			size_t rawSize = 0u;
+			for (size_t i = 0; i < scene.TextureNames.size(); ++i)
+			{
+				const int width = scene.TextureSizes[i * 2u];
+				const int height = scene.TextureSizes[i * 2u + 1u];
+				if (width < 0 || height < 0)
+				{
+					return false;
+				}
+				if (scene.TextureCooked[i].empty())
+				{
+					rawSize += static_cast<size_t>(width) * height * 4u;
+				}
+			}
+			if (rawSize != scene.TexturePixels.size())
+			{
+				return false;
+			}
+
+			for (const auto& range : scene.Ranges)
+			{
+				if (static_cast<size_t>(range.second.VertexOffset) + range.second.VertexCount > scene.Vertices.size() ||
+					static_cast<size_t>(range.second.IndexStart) + range.second.IndexCount > scene.Indices.size())
+				{
+					return false;
+				}
+			}
+
+			return !scene.bHasSkybox || scene.SkyboxPixels.size() == static_cast<size_t>(scene.SkyboxWidth) * scene.SkyboxHeight * 4u * 6u;
+		}
+
+		// Packs the height, metallic and roughness maps of every distinct legacy material into a new texture, added to the batch
+		// Returns the batch index of each material's packed texture by the maps it was made from
+		std::map<std::array<int32_t, 3>, size_t> PackLegacyMaterials(LegacyScene& scene, std::vector<Renderer::RawTexture>& textures)
+		{
+			std::vector<const LegacyMaterial*> materials;
+			for (const auto& material : scene.LegacyMaterials)
+			{
+				materials.push_back(&material.second);
+			}
+			for (const auto entity : scene.Registry.view<LegacyMaterial>())
+			{
+				materials.push_back(&scene.Registry.get<LegacyMaterial>(entity));
+			}
+
+			// Only the file's raw textures can be read back, cooked ones are block compressed
+			const size_t fileTextures = scene.TextureNames.size();
+			const auto getMap = [&](int32_t id)
+			{
+				MapPixels map;
+				if (id >= 0 && static_cast<size_t>(id) < fileTextures && textures[id].Pixels)
+				{
+					map = { textures[id].Pixels.get(), static_cast<uint32_t>(textures[id].Width), static_cast<uint32_t>(textures[id].Height) };
+				}
+				else if (id >= 0)
+				{
+					VEL_CORE_WARN("Legacy material map {0} cant be packed, using the default instead", id);
+				}
+				return map;
+			};
+
+			std::map<std::array<int32_t, 3>, size_t> packed;
+			for (const LegacyMaterial* material : materials)
+			{
+				const auto& ids = material->TextureIDs;
+				const std::array<int32_t, 3> key = { ids[2], ids[3], ids[4] };
+				if (packed.count(key))
+				{
+					continue;
+				}
+
+				// No occlusion map back then
+				std::vector<uint8_t> pixels;
+				uint32_t width = 0u;
+				uint32_t height = 0u;
+				TextureCooker::PackMaterial({ MapPixels(), getMap(ids[4]), getMap(ids[3]), getMap(ids[2]) }, pixels, width, height);
+
+				Renderer::RawTexture texture;
+				texture.ReferenceName = "VEL_INTERNAL_" + material->MaterialName + "_packed";
+				texture.Pixels = std::unique_ptr<stbi_uc>(new stbi_uc[pixels.size()]);
+				memcpy(texture.Pixels.get(), pixels.data(), pixels.size());
+				texture.Width = static_cast<int>(width);
+				texture.Height = static_cast<int>(height);
+
+				packed[key] = textures.size();
+				textures.push_back(std::move(texture));
+			}
+			return packed;
+		}
+	}
+
 	Scene::Scene()
 	{
 		m_SceneName = "New Scene";
 		m_Skybox = nullptr;
 		
-		m_Registry.on_construct<PointLightComponent>().connect<&Scene::OnPointLightChanged>(this);
-		m_Registry.on_destroy<PointLightComponent>().connect<&Scene::OnPointLightChanged>(this);
-		m_Registry.on_update<PointLightComponent>().connect<&Scene::OnPointLightChanged>(this);
+		// Change tracking, and the change log which needs every component whether it is tracked or not
+		SceneComponents::ForEach([this](auto tag)
+		{
+			using Component = typename decltype(tag)::Type;
+			m_Registry.on_construct<Component>().template connect<&Scene::OnComponentChanged<Component>>(this);
+			m_Registry.on_destroy<Component>().template connect<&Scene::OnComponentChanged<Component>>(this);
+			m_Registry.on_update<Component>().template connect<&Scene::OnComponentChanged<Component>>(this);
+		});
 	}
 	Entity Scene::CreateEntity(const std::string& name)
 	{
@@ -54,10 +275,99 @@ namespace Velocity
 	void Scene::CreateSkybox(const std::string& baseFilepath, const std::string& extension)
 	{
 		m_Skybox = std::unique_ptr<Skybox>(Renderer::GetRenderer()->CreateSkybox(baseFilepath, extension));
+		m_SkyboxAsset = 0u;
 
 	}
 	
-	void Scene::OnPointLightChanged(entt::registry& reg, entt::entity entity)
+	Entity Scene::DuplicateEntity(Entity& entity)
+	{
+		Entity copy = { m_Registry.create(), this };
+		SceneComponents::ForEach([&](auto tag)
+		{
+			using Component = typename decltype(tag)::Type;
+			if (m_Registry.has<Component>(entity.m_EntityHandle))
+			{
+				// Copied out first as adding can move the pool the original lives in
+				const Component component = m_Registry.get<Component>(entity.m_EntityHandle);
+				m_Registry.emplace<Component>(copy.m_EntityHandle, component);
+			}
+		});
+
+		if (copy.HasComponent<TagComponent>())
+		{
+			copy.GetComponent<TagComponent>().Tag += " (Copy)";
+		}
+
+		m_Entities.push_back(copy);
+		return copy;
+	}
+
+	template<typename T>
+	void Scene::OnComponentChanged(entt::registry& reg, entt::entity entity)
+	{
+		if (m_bLogChanges)
+		{
+			m_ChangedEntities[SceneComponents::IndexOf<T>()].insert(entity);
+		}
+
+		if constexpr (ComponentTraits<T>::TRACK_CHANGES)
+		{
+			m_DirtyComponents.set(SceneComponents::IndexOf<T>());
+			ComponentTraits<T>::OnChanged(*this);
+		}
+	}
+
+	void Scene::SetChangeLog(bool bEnabled)
+	{
+		m_bLogChanges = bEnabled;
+		for (auto& changed : m_ChangedEntities)
+		{
+			changed.clear();
+		}
+	}
+
+	bool Scene::HasLoggedChanges() const
+	{
+		return std::any_of(m_ChangedEntities.begin(), m_ChangedEntities.end(), [](const auto& changed) { return !changed.empty(); });
+	}
+
+	SceneDelta Scene::TakeDelta()
+	{
+		SceneDelta delta;
+
+		// Whether a logged entity was changed, lost the component or was destroyed is only worked out now
+		std::unordered_set<entt::entity> destroyed;
+		SceneComponents::ForEach([&](auto tag)
+		{
+			using Component = typename decltype(tag)::Type;
+			auto& changed = m_ChangedEntities[SceneComponents::IndexOf<Component>()];
+			auto& changes = delta.template Get<Component>();
+			changes.Entities.reserve(changed.size());
+			changes.Components.reserve(changed.size());
+			for (auto entity : changed)
+			{
+				if (!m_Registry.valid(entity))
+				{
+					destroyed.insert(entity);
+				}
+				else if (!m_Registry.has<Component>(entity))
+				{
+					changes.Removed.push_back(entity);
+				}
+				else
+				{
+					changes.Entities.push_back(entity);
+					changes.Components.push_back(m_Registry.get<Component>(entity));
+				}
+			}
+			changed.clear();
+		});
+		delta.Destroyed.assign(destroyed.begin(), destroyed.end());
+
+		return delta;
+	}
+
+	void ComponentTraits<PointLightComponent>::OnChanged(Scene& scene)
 	{
 		Renderer::GetRenderer()->UpdatePointlightArray();
 	}
@@ -66,279 +376,775 @@ namespace Velocity
 	Scene* Scene::LoadScene(const std::string& sceneFilepath)
 	{
 		Renderer::GetRenderer()->m_LogicalDevice->waitIdle();
-		
-		// Allocate memory
-		auto* newScene = new Scene();
 
 		// Allow for this to create a new scene
+		Scene* newScene = nullptr;
 		if (!sceneFilepath.empty())
 		{
-			
-			// Load registry from the file. Open in binary
-			std::ifstream is;
-			is.open(sceneFilepath, std::ios::binary | std::fstream::in);
-
-			// Create string streams for compression processing
-			std::string isUncompressed;
-
-			// Read in file
-			// go to end of file
-			is.seekg(0, std::ios::end);
-			// Allocate
-			size_t size = is.tellg();
-			std::string isCompressed(size,' ');
-			// Go back to start
-			is.seekg(0);
-			is.read(&isCompressed[0], size);
-		
-			// Uncompress
-			
-			snappy::Uncompress(isCompressed.data(), isCompressed.size(), &isUncompressed);
-			
-			std::stringstream uncompressed{ isUncompressed };
-			
-			cereal::BinaryInputArchive archive(uncompressed);
-
-			archive(newScene->m_SceneName);
-
-			// Loads entity data from registry
-			entt::snapshot_loader{ newScene->m_Registry }
-				.entities(archive)
-				.component<COMPONENT_LIST>(archive)
-				.orphans();
-
-			// Processes registry into m_Entities array
-			newScene->m_Registry.each([&](auto rawEntity) {
-
-				newScene->m_Entities.push_back({ rawEntity,newScene });
-
-				});
-
-			// Get renderer reference
-			auto& renderer = Renderer::GetRenderer();
-
-			// Clear the state before we load
-			renderer->ClearState();
-
-			// load the renderables list
-			archive(renderer->m_Renderables);
-
-			// load the raw state of the buffer manager
-			archive(renderer->m_BufferManager->m_Vertices,renderer->m_BufferManager->m_Indices);
-			renderer->m_BufferManager->Sync();
-
-			// Process camera
-			archive(newScene->m_SceneCamera);
-
-			std::vector<std::string> flattenedTextureMapping;
-			std::vector<stbi_uc> flattenedTextureRaw;			
-			std::vector<int> flattenedTextureSizes;
-			
-			// Read in flattened mappings
-			archive(flattenedTextureMapping);
-			archive(flattenedTextureRaw);
-			archive(flattenedTextureSizes);
-
-			// Loop in pairs at a time
-			size_t rawOffset = 0;
-			size_t sizeIndex = 0;
-			for (size_t i = 0; i < flattenedTextureMapping.size(); ++i)
-			{
-				// Recalculate how much to go into the raw array with saved data
-				VkDeviceSize texRawSize = flattenedTextureSizes[sizeIndex] * flattenedTextureSizes[sizeIndex + 1] * 4;
-
-				// Create a pointer and back with memory
-				void* backedPixels = new stbi_uc[texRawSize];
-				// Copy into the pointer
-				memcpy(backedPixels, &flattenedTextureRaw[rawOffset], texRawSize);
-				// Wrap in a unique_ptr
-				std::unique_ptr<stbi_uc> wrappedPixels = std::unique_ptr<stbi_uc>(static_cast<stbi_uc*>(backedPixels));
-				// Move along offset
-				rawOffset += texRawSize;
-
-				// Recreate texture
-				renderer->CreateTexture(std::move(wrappedPixels), flattenedTextureSizes[sizeIndex], flattenedTextureSizes[sizeIndex + 1], flattenedTextureMapping[i]);
-
-				sizeIndex += 2;
+			SceneLoad load(sceneFilepath, true);
+			newScene = load.Finish();
+			if (!newScene)
+			{
+				VEL_CORE_ERROR("Failed to load scene {0}, starting a new one", sceneFilepath);
 			}
+		}
+
+		return newScene ? newScene : CreateBlank();
+	}
+
+	std::unique_ptr<SceneLoad> Scene::LoadSceneAsync(const std::string& sceneFilepath)
+	{
+		return std::make_unique<SceneLoad>(sceneFilepath);
+	}
+
+	Scene* Scene::CreateBlank()
+	{
+		auto* newScene = new Scene();
+
+		auto& renderer = Renderer::GetRenderer();
+		renderer->ClearState();
+
+		// Load the skybox default
+		renderer->LoadMesh("../Velocity/assets/models/sphere.obj", "VEL_INTERNAL_Skybox");
+		renderer->m_BufferManager->Sync();
 
-			// Read in PBR Materials
-			archive(renderer->m_PBRMaterials);
+		// Camera needs to be init at default
+		newScene->m_SceneCamera = std::make_unique<Camera>();
 
-			// Check for skybox marker
-			bool bHasSkybox = false;
-			archive(bHasSkybox);
+		newScene->ClearDirty();
+		return newScene;
+	}
+
+	bool Scene::LoadLegacy(const MappedFile& file)
+	{
+		// Uncompress
+		std::string uncompressed;
+		if (!snappy::Uncompress(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), &uncompressed))
+		{
+			return false;
+		}
 
-			if (bHasSkybox)
+		// The files carry no version, so each layout is tried until one reads the whole file
+		std::unique_ptr<LegacyScene> legacy;
+		for (const auto layout : { LegacyLayout::Baseline, LegacyLayout::CookedTextures, LegacyLayout::PackedMaterials })
+		{
+			legacy = std::make_unique<LegacyScene>();
+			if (ReadLegacy(uncompressed, layout, *legacy))
 			{
-				// Read in width/height
-				uint32_t width, height;
-				archive(width);
-				archive(height);
+				break;
+			}
+			legacy.reset();
+		}
+
+		if (!legacy)
+		{
+			VEL_CORE_ERROR("Scene isnt in any of the layouts from before the chunked format");
+			return false;
+		}
 
-				// read in pixels
-				std::vector<stbi_uc> rawPixels;
-				archive(rawPixels);
+		m_SceneName = std::move(legacy->Name);
+		m_SceneCamera = std::move(legacy->SceneCamera);
 
-				// split into 6 layers
-				std::array<std::unique_ptr<stbi_uc>,6> layerPointers;
-				rawOffset = 0;
-				for (size_t i = 0; i < 6; ++i)
-				{
-					const VkDeviceSize layerSize = width * height * 4;
-					
-					void* backedPixels = new stbi_uc[layerSize];
-					memcpy(backedPixels, &rawPixels[rawOffset], layerSize);
+		// Get renderer reference
+		auto& renderer = Renderer::GetRenderer();
 
-					std::unique_ptr<stbi_uc> wrappedLayer = std::unique_ptr<stbi_uc>(static_cast<stbi_uc*>(backedPixels));
-					layerPointers.at(i) = std::move(wrappedLayer);
+		// Clear the state before we load
+		renderer->ClearState();
 
-					rawOffset += layerSize;
-					
-				}
+		// load the renderables list
+		for (const auto& [name, range] : legacy->Ranges)
+		{
+			auto& indexer = renderer->m_Renderables[name];
+			indexer.VertexOffset = range.VertexOffset;
+			indexer.VertexCount = range.VertexCount;
+			indexer.IndexStart = range.IndexStart;
+			indexer.IndexCount = range.IndexCount;
+		}
+
+		// load the raw state of the buffer manager
+		renderer->m_BufferManager->m_Vertices = std::move(legacy->Vertices);
+		renderer->m_BufferManager->m_Indices = std::move(legacy->Indices);
+		renderer->m_BufferManager->RebuildMeshlets(renderer->m_Renderables);
+		renderer->m_BufferManager->Sync();
 
-				newScene->m_Skybox = std::unique_ptr<Skybox>(Renderer::GetRenderer()->CreateSkybox(layerPointers, width, height));
-				
+		// Gather every texture first so they go up to the GPU as one batch
+		const auto& names = legacy->TextureNames;
+		std::vector<Renderer::RawTexture> textures(names.size());
+
+		// Loop in pairs at a time
+		size_t rawOffset = 0;
+		size_t sizeIndex = 0;
+		for (size_t i = 0; i < names.size(); ++i)
+		{
+			textures[i].ReferenceName = names[i];
+
+			// Cooked textures have no raw pixels saved
+			const auto& cooked = legacy->TextureCooked[i];
+			if (!cooked.empty())
+			{
+				textures[i].Cooked = std::make_unique<CookedTexture>();
+				if (!CookedTexture::Deserialise(cooked.data(), cooked.size(), *textures[i].Cooked))
+				{
+					VEL_CORE_ERROR("Scene has a corrupt cooked texture: {0}", names[i]);
+					VEL_CORE_ASSERT(false, "Scene has a corrupt cooked texture: {0}", names[i]);
+
+					// Keep the slot with a white pixel so later indices still line up
+					textures[i].Cooked.reset();
+					textures[i].Pixels = std::unique_ptr<stbi_uc>(new stbi_uc[4]{ 255, 255, 255, 255 });
+					textures[i].Width = 1;
+					textures[i].Height = 1;
+				}
+				sizeIndex += 2;
+				continue;
 			}
+
+			// Recalculate how much to go into the raw array with saved data
+			const size_t texRawSize = static_cast<size_t>(legacy->TextureSizes[sizeIndex]) * legacy->TextureSizes[sizeIndex + 1] * 4;
+
+			// Create a pointer and back with memory
+			void* backedPixels = new stbi_uc[texRawSize];
+			// Copy into the pointer
+			memcpy(backedPixels, &legacy->TexturePixels[rawOffset], texRawSize);
+			// Wrap in a unique_ptr
+			textures[i].Pixels = std::unique_ptr<stbi_uc>(static_cast<stbi_uc*>(backedPixels));
+			// Move along offset
+			rawOffset += texRawSize;
+
+			textures[i].Width = legacy->TextureSizes[sizeIndex];
+			textures[i].Height = legacy->TextureSizes[sizeIndex + 1];
+
+			sizeIndex += 2;
 		}
-		else
+
+		// Older materials have their maps packed, then use the packed texture
+		const auto packed = PackLegacyMaterials(*legacy, textures);
+
+		// Recreate textures
+		const auto slots = renderer->CreateTextureBatch(textures);
+
+		const auto upgrade = [&](const LegacyMaterial& old)
+		{
+			const auto& ids = old.TextureIDs;
+			PBRComponent material;
+			material.MaterialName = old.MaterialName;
+			material.AlbedoID() = ids[0];
+			material.NormalID() = ids[1];
+			material.PackedID() = static_cast<int32_t>(slots[packed.at({ ids[2], ids[3], ids[4] })]);
+			material.HeightMapped = ids[2] != -1 ? 1 : 0;
+			return material;
+		};
+
+		renderer->m_PBRMaterials = std::move(legacy->Materials);
+		for (const auto& [name, material] : legacy->LegacyMaterials)
 		{
-			auto& renderer = Renderer::GetRenderer();
-			renderer->ClearState();
+			renderer->m_PBRMaterials[name] = upgrade(material);
+		}
 
-			// Load the skybox default
-			Renderer::GetRenderer()->LoadMesh("../Velocity/assets/models/sphere.obj", "VEL_INTERNAL_Skybox");
-			renderer->m_BufferManager->Sync();
-			
-			// Camera needs to be init at default
-			newScene->m_SceneCamera = std::make_unique<Camera>();
+		if (legacy->bHasSkybox)
+		{
+			// split into 6 layers
+			const size_t layerSize = static_cast<size_t>(legacy->SkyboxWidth) * legacy->SkyboxHeight * 4;
+			std::array<std::unique_ptr<stbi_uc>,6> layerPointers;
+			for (size_t i = 0; i < 6; ++i)
+			{
+				layerPointers.at(i) = std::unique_ptr<stbi_uc>(new stbi_uc[layerSize]);
+				memcpy(layerPointers.at(i).get(), &legacy->SkyboxPixels[i * layerSize], layerSize);
+			}
 
-			
+			m_Skybox = std::unique_ptr<Skybox>(renderer->CreateSkybox(layerPointers, legacy->SkyboxWidth, legacy->SkyboxHeight));
 		}
 
-		return newScene;
+		// Entities keep their saved ids
+		legacy->Registry.each([&](auto staged)
+		{
+			const auto entity = m_Registry.create(staged);
+			m_Entities.push_back({ entity, this });
+		});
+		MoveComponents<TagComponent, TransformComponent, MeshComponent, TextureComponent, PointLightComponent, PBRComponent>(legacy->Registry, m_Registry);
+		for (const auto staged : legacy->Registry.view<LegacyMaterial>())
+		{
+			m_Registry.emplace<PBRComponent>(staged, upgrade(legacy->Registry.get<LegacyMaterial>(staged)));
+		}
+
+		return true;
 	}
 
-	void Scene::SaveScene(const std::string& saveFilepath)
+	void Scene::SaveScene(const std::string& saveFilepath, const SceneSaveOptions& options)
 	{
-		// Open registry file
-		std::ofstream finalOutput;
-		finalOutput.open(saveFilepath,std::fstream::out | std::ios::binary);
-		
-		if (finalOutput.is_open())
+		Save(saveFilepath, options, SaveMode::Scene);
+	}
+
+	void Scene::ExportPack(const std::string& saveFilepath, const SceneSaveOptions& options)
+	{
+		Save(saveFilepath, options, SaveMode::Pack);
+	}
+
+	struct Scene::SaveSnapshot
+	{
+		std::string							Name;
+		std::unique_ptr<Camera>				SceneCamera;
+
+		// Set by whoever writes the snapshot. Autosaves carry what changed since the last one instead, see WriteAutosave
+		entt::registry*						Registry = nullptr;
+		SceneDelta							Delta;
+
+		// A renderable. Meshlets are only copied out for a mesh the store doesnt have yet, Stored has its asset otherwise
+		struct Mesh
 		{
-			// Create a string stream for the uncompressed data
-			std::stringstream os;
-			
-			m_SceneName = GetRefName(saveFilepath);
-			
-			cereal::BinaryOutputArchive archive(os);
+			std::string								Name;
+			BufferManager::MeshIndexer				Indexer;
+			StoredMesh								Stored;
+			std::shared_ptr<std::vector<Meshlet>>	Meshlets;
+		};
+		std::vector<Mesh>					Meshes;
 
-			archive(m_SceneName);
+		// The whole geometry heap, started only if a mesh needs storing or for packs. Packs also take every meshlet
+		BufferManager::HeapReadbackJob		Heap;
+		std::vector<Meshlet>				HeapMeshlets;
 
-			// Save registry
-			entt::snapshot{ m_Registry }
-				.entities(archive)
-				.component<COMPONENT_LIST>(archive);
+		// Data is only set if the entry doesnt already have its asset
+		struct Texture
+		{
+			SceneTexture					Entry;
+			ReadbackJob						Data;
+		};
+		std::vector<Texture>				Textures;
 
-			// Get renderer reference
-			auto& renderer = Renderer::GetRenderer();
-			
-			// Archive the renderables list
-			archive(renderer->m_Renderables);
+		std::unordered_map<std::string, PBRComponent> Materials;
 
-			// Archive the raw state of the buffer manager
-			archive(renderer->m_BufferManager->m_Vertices, renderer->m_BufferManager->m_Indices);
-
-			// Save out the camera details
-			archive(m_SceneCamera);
-
-			// Get list of textures
-			std::vector<std::string> flattenedTextureMapping;
-			std::vector<stbi_uc> flattenedTextureRaw;
-			std::vector<int> flattenedTextureSizes;
-			
-			flattenedTextureMapping.reserve(renderer->m_Textures.size());
-			// Cant reserve raw as size can drastically change
-			flattenedTextureSizes.reserve(renderer->m_Textures.size() * 2);
-			
-			// Flatten the texture array
-			for (size_t i = 1; i < renderer->m_Textures.size(); ++i)
-			{
-				auto& texture = renderer->m_Textures.at(i);
-				
-				flattenedTextureMapping.push_back(texture.first);
-
-				flattenedTextureSizes.push_back(texture.second->m_Width);
-				flattenedTextureSizes.push_back(texture.second->m_Height);
-
-				// Loop raw pixels
-				VkDeviceSize texRawSize = texture.second->m_Width * texture.second->m_Height * 4;
-				for (size_t j = 0; j < texRawSize; ++j)
+		uint32_t							SkyboxWidth = 0u;
+		uint32_t							SkyboxHeight = 0u;
+		uint64_t							SkyboxAsset = 0u;
+		ReadbackJob							SkyboxPixels;
+
+		// Keys of everything in the store once written, see KeepStoredAssets
+		std::unordered_map<std::string, StoredMesh>	StoredMeshes;
+		std::unordered_map<std::string, uint64_t>	StoredTextures;
+	};
+
+	void Scene::CollectGarbage()
+	{
+		auto& renderer = Renderer::GetRenderer();
+
+		// Anything still loading would land in a range or slot that has since moved
+		renderer->FlushMeshLoads();
+		renderer->FlushTextureLoads();
+
+		// Internal meshes like the skybox sphere arent referenced by components
+		std::unordered_set<std::string> usedMeshes;
+		std::unordered_set<std::string> usedMaterials;
+		std::vector<bool> usedTextures(renderer->m_Textures.size(), false);
+		auto useTextures = [&usedTextures](const PBRComponent& material)
+		{
+			for (const int32_t id : material.TextureIDs)
+			{
+				if (id >= 0 && static_cast<size_t>(id) < usedTextures.size())
 				{
-					flattenedTextureRaw.push_back(texture.second->m_RawPixels.get()[j]);
+					usedTextures[id] = true;
 				}
 			}
-			// Archive
-			archive(flattenedTextureMapping);
-			archive(flattenedTextureRaw);
-			archive(flattenedTextureSizes);
+		};
 
-			// Archive materials list
-			archive(renderer->m_PBRMaterials);
+		for (auto entity : m_Registry.view<MeshComponent>())
+		{
+			usedMeshes.insert(m_Registry.get<MeshComponent>(entity).MeshReference);
+		}
+		for (auto entity : m_Registry.view<TextureComponent>())
+		{
+			const uint32_t id = m_Registry.get<TextureComponent>(entity).TextureID;
+			if (id < usedTextures.size())
+			{
+				usedTextures[id] = true;
+			}
+		}
+		for (auto entity : m_Registry.view<PBRComponent>())
+		{
+			const auto& material = m_Registry.get<PBRComponent>(entity);
+			usedMaterials.insert(material.MaterialName);
+			useTextures(material);
+		}
 
-			// Archive skybox if exists
-			bool bHasSkybox = false;
-			if (m_Skybox)
+		size_t meshCount = 0u;
+		for (auto it = renderer->m_Renderables.begin(); it != renderer->m_Renderables.end();)
+		{
+			if (usedMeshes.count(it->first) == 0u && it->first.rfind("VEL_INTERNAL_", 0) != 0u)
 			{
-				// Archive a boolean
-				bHasSkybox = true;
+				it = renderer->m_Renderables.erase(it);
+				++meshCount;
+				continue;
 			}
-			archive(bHasSkybox);
-			if (bHasSkybox)
+			++it;
+		}
+
+		size_t materialCount = 0u;
+		for (auto it = renderer->m_PBRMaterials.begin(); it != renderer->m_PBRMaterials.end();)
+		{
+			if (usedMaterials.count(it->first) == 0u)
 			{
-				// Archive the actual skybox because the marker for it is in the scene file
+				it = renderer->m_PBRMaterials.erase(it);
+				++materialCount;
+				continue;
+			}
+			useTextures(it->second);
+			++it;
+		}
 
-				// Archive the width / height
-				archive(m_Skybox->m_Width);
-				archive(m_Skybox->m_Height);
+		const size_t textureCount = static_cast<size_t>(std::count(usedTextures.begin() + 1, usedTextures.end(), false));
+		if (meshCount == 0u && materialCount == 0u && textureCount == 0u)
+		{
+			return;
+		}
+
+		// Both rewrite what frames in flight are reading
+		renderer->m_LogicalDevice->waitIdle();
+
+		const size_t vertexCount = renderer->m_BufferManager->m_VertexCount;
+		const size_t indexCount = renderer->m_BufferManager->m_IndexCount;
+		if (meshCount > 0u)
+		{
+			renderer->m_BufferManager->Compact(renderer->m_Renderables);
+		}
+
+		if (textureCount > 0u)
+		{
+			const auto newIndices = renderer->CompactTextures(usedTextures);
+			auto remap = [&newIndices](auto id)
+			{
+				return static_cast<decltype(id)>(id >= 0 && static_cast<size_t>(id) < newIndices.size() && newIndices[id] != TextureResidency::NO_SLOT ? newIndices[id] : 0u);
+			};
+			auto remapMaterial = [&remap](PBRComponent& material)
+			{
+				for (auto& id : material.TextureIDs)
+				{
+					id = remap(id);
+				}
+			};
 
-				// Archive the pixels
-				std::vector<stbi_uc> rawPixels;
-				for (size_t i = 0; i < 6; ++i)
+			// Replaced only when an index moved so change tracking sees exactly what changed
+			for (auto entity : m_Registry.view<TextureComponent>())
+			{
+				TextureComponent texture = m_Registry.get<TextureComponent>(entity);
+				const uint32_t id = remap(texture.TextureID);
+				if (id != texture.TextureID)
+				{
+					texture.TextureID = id;
+					m_Registry.replace<TextureComponent>(entity, texture);
+				}
+			}
+			for (auto entity : m_Registry.view<PBRComponent>())
+			{
+				PBRComponent material = m_Registry.get<PBRComponent>(entity);
+				const auto ids = material.TextureIDs;
+				remapMaterial(material);
+				if (material.TextureIDs != ids)
 				{
-					const VkDeviceSize layerSize = m_Skybox->m_Width * m_Skybox->m_Height * 4;
-					for (size_t j = 0; j < layerSize; ++j)
+					m_Registry.replace<PBRComponent>(entity, material);
+				}
+			}
+			for (auto& [name, material] : renderer->m_PBRMaterials)
+			{
+				remapMaterial(material);
+			}
+		}
+
+		VEL_CORE_INFO("Released {0} meshes, {1} materials and {2} textures. Geometry heap went from {3} to {4} vertices and {5} to {6} indices",
+			meshCount, materialCount, textureCount, vertexCount, renderer->m_BufferManager->m_VertexCount, indexCount, renderer->m_BufferManager->m_IndexCount);
+	}
+
+	bool Scene::Save(const std::string& saveFilepath, const SceneSaveOptions& options, SaveMode mode)
+	{
+		const bool bPack = mode == SaveMode::Pack;
+		const std::string sceneName = GetRefName(saveFilepath);
+
+		CollectGarbage();
+
+		// Textures still decoding only have the default texture in their slot, so finish them first
+		Renderer::GetRenderer()->FlushTextureLoads();
+
+		// Keeps AssetStore::Collect from deleting an asset between finding it stored and the scene pointing at it
+		std::shared_lock<std::shared_mutex> storeLock;
+		if (!bPack)
+		{
+			storeLock = AssetStore::LockForSave();
+		}
+
+		// Written straight away, so the snapshot can use the registry rather than copy it
+		SaveSnapshot snapshot;
+		TakeSnapshot(snapshot, bPack);
+		snapshot.Name = sceneName;
+		snapshot.Registry = &m_Registry;
+		if (!WriteSnapshot(saveFilepath, options, snapshot, bPack))
+		{
+			VEL_CORE_ERROR("Failed to save scene!");
+			return false;
+		}
+
+		// Anything saved against the store can skip the same assets next time
+		if (!bPack)
+		{
+			KeepStoredAssets(snapshot);
+		}
+
+		// Packs are copies, the scene still belongs to the file it was saved to
+		if (mode == SaveMode::Scene)
+		{
+			m_SceneName = sceneName;
+			ClearDirty();
+		}
+		return true;
+	}
+
+	void Scene::TakeSnapshot(SaveSnapshot& snapshot, bool bPack)
+	{
+		auto& renderer = Renderer::GetRenderer();
+
+		snapshot.SceneCamera = m_SceneCamera ? std::make_unique<Camera>(*m_SceneCamera) : nullptr;
+
+		// Geometry is only started here, the copy back is waited on by whoever writes the snapshot
+		snapshot.Meshes.reserve(renderer->m_Renderables.size());
+		if (bPack)
+		{
+			for (const auto& [name, indexer] : renderer->m_Renderables)
+			{
+				snapshot.Meshes.push_back({ name, indexer });
+			}
+			snapshot.Heap = renderer->m_BufferManager->ReadBackAsync();
+			snapshot.HeapMeshlets = renderer->m_BufferManager->m_Meshlets;
+		}
+		else
+		{
+			auto isStored = [this](const std::string& name, const BufferManager::MeshIndexer& indexer)
+			{
+				auto stored = m_MeshAssets.find(name);
+				return stored != m_MeshAssets.end() && stored->second.VertexCount == indexer.VertexCount &&
+					stored->second.IndexCount == indexer.IndexCount && stored->second.MeshletCount == indexer.MeshletCount &&
+					AssetStore::Contains(stored->second.Key);
+			};
+
+			// Renderables loaded from the same file share a range, which only needs copying out once
+			const auto& heapMeshlets = renderer->m_BufferManager->m_Meshlets;
+			std::set<std::pair<uint32_t, uint32_t>> ranges;
+			for (const auto& [name, indexer] : renderer->m_Renderables)
+			{
+				SaveSnapshot::Mesh mesh = { name, indexer };
+				if (isStored(name, indexer))
+				{
+					mesh.Stored = m_MeshAssets[name];
+				}
+				else if (ranges.count({ indexer.VertexOffset, indexer.IndexStart }) == 0u)
+				{
+					if (static_cast<size_t>(indexer.VertexOffset) + indexer.VertexCount > renderer->m_BufferManager->m_VertexCount ||
+						static_cast<size_t>(indexer.IndexStart) + indexer.IndexCount > renderer->m_BufferManager->m_IndexCount ||
+						static_cast<size_t>(indexer.MeshletStart) + indexer.MeshletCount > heapMeshlets.size())
+					{
+						VEL_CORE_ERROR("Renderable {0} is outside the geometry heap, not saved", name);
+						continue;
+					}
+
+					// Copied to make them relative to the mesh, the vertices and indices come out of the heap read back
+					mesh.Meshlets = std::make_shared<std::vector<Meshlet>>(heapMeshlets.begin() + indexer.MeshletStart, heapMeshlets.begin() + indexer.MeshletStart + indexer.MeshletCount);
+					for (auto& meshlet : *mesh.Meshlets)
 					{
-						// Traverse the pointer
-						rawPixels.push_back(m_Skybox->m_RawPixels.at(i).get()[j]);
+						meshlet.IndexStart -= indexer.IndexStart;
 					}
+					mesh.Stored = { 0u, indexer.VertexCount, indexer.IndexCount, indexer.MeshletCount };
 				}
+				// Otherwise it gets whatever the first renderable in its range is stored as when written
+
+				ranges.insert({ indexer.VertexOffset, indexer.IndexStart });
+				snapshot.Meshes.push_back(std::move(mesh));
+			}
+
+			// Only read the heap back if a mesh isnt already in the store
+			if (std::any_of(snapshot.Meshes.begin(), snapshot.Meshes.end(), [](const SaveSnapshot::Mesh& mesh) { return mesh.Meshlets != nullptr; }))
+			{
+				snapshot.Heap = renderer->m_BufferManager->ReadBackAsync();
+			}
+		}
+
+		// Cooked textures are kept as their whole file instead of raw pixels
+		snapshot.Textures.reserve(renderer->m_Textures.size());
+		for (size_t i = 1; i < renderer->m_Textures.size(); ++i)
+		{
+			auto& texture = renderer->m_Textures.at(i);
+			const bool bCooked = texture.second->m_Cooked != nullptr;
+			SaveSnapshot::Texture entry = { { texture.first, texture.second->m_Width, texture.second->m_Height, bCooked } };
+
+			auto stored = m_TextureAssets.find(texture.first);
+			if (!bPack && stored != m_TextureAssets.end() && AssetStore::Contains(stored->second))
+			{
+				entry.Entry.Asset = stored->second;
+			}
+			else
+			{
+				entry.Data = texture.second->ReadBackAsync();
+			}
+			snapshot.Textures.push_back(std::move(entry));
+		}
+
+		snapshot.Materials = renderer->m_PBRMaterials;
+
+		snapshot.SkyboxWidth = m_Skybox ? m_Skybox->m_Width : 0u;
+		snapshot.SkyboxHeight = m_Skybox ? m_Skybox->m_Height : 0u;
+		if (m_Skybox && !bPack && m_SkyboxAsset != 0u && AssetStore::Contains(m_SkyboxAsset))
+		{
+			snapshot.SkyboxAsset = m_SkyboxAsset;
+		}
+		else if (m_Skybox)
+		{
+			snapshot.SkyboxPixels = m_Skybox->ReadBackAsync();
+		}
+	}
+
+	std::shared_ptr<Scene::SaveSnapshot> Scene::TakeAutosave()
+	{
+		// Waiting for them would stall the frame
+		if (!Renderer::GetRenderer()->m_PendingTextureLoads.empty())
+		{
+			return nullptr;
+		}
+
+		auto snapshot = std::make_shared<SaveSnapshot>();
+		TakeSnapshot(*snapshot, false);
+
+		// An autosave keeps the name so recovering it gives back the same scene
+		snapshot->Name = m_SceneName;
+
+		// The autosave's copy of the registry already has everything before this
+		snapshot->Delta = TakeDelta();
+		return snapshot;
+	}
 
-				archive(rawPixels);
+	bool Scene::WriteAutosave(const std::string& saveFilepath, SaveSnapshot& snapshot, entt::registry& registry)
+	{
+		SceneJournal::Apply(registry, snapshot.Delta);
+		snapshot.Registry = &registry;
+		const bool bWritten = WriteSnapshot(saveFilepath, SceneSaveOptions::Fast(), snapshot, false);
+		snapshot.Registry = nullptr;
+		return bWritten;
+	}
+
+	bool Scene::WriteSnapshot(const std::string& saveFilepath, const SceneSaveOptions& options, SaveSnapshot& snapshot, bool bPack)
+	{
+		// Keys found while taking the snapshot are only safe from AssetStore::Collect if the save lock was held then too
+		if (!bPack)
+		{
+			const bool bMissing = std::any_of(snapshot.Meshes.begin(), snapshot.Meshes.end(), [](const SaveSnapshot::Mesh& mesh) { return !mesh.Meshlets && mesh.Stored.Key != 0u && !AssetStore::Contains(mesh.Stored.Key); }) ||
+				std::any_of(snapshot.Textures.begin(), snapshot.Textures.end(), [](const SaveSnapshot::Texture& texture) { return texture.Entry.Asset != 0u && !AssetStore::Contains(texture.Entry.Asset); }) ||
+				(snapshot.SkyboxAsset != 0u && !AssetStore::Contains(snapshot.SkyboxAsset));
+			if (bMissing)
+			{
+				VEL_CORE_WARN("An asset {0} uses was removed from the store while it was saved", snapshot.Name);
+				return false;
 			}
+		}
+
+		// The heap read back was started when the snapshot was taken, this is the first thing that waits on it
+		auto vertices = std::make_shared<std::vector<Vertex>>();
+		auto indices = std::make_shared<std::vector<uint32_t>>();
+		if (snapshot.Heap && !snapshot.Heap(*vertices, *indices))
+		{
+			VEL_CORE_ERROR("Failed to read back the geometry heap");
+			return false;
+		}
+
+		// Chunks compress on the pool and stream out while the next ones are gathered
+		SceneFileWriter file;
+		if (!file.Begin(saveFilepath, options))
+		{
+			VEL_CORE_ERROR("Failed to open {0} to save scene!", saveFilepath);
+			return false;
+		}
 
-			// Now os contains the uncompressed string stream
+		// Assets write on the pool alongside the scene file, which only goes in once they are all stored
+		std::vector<std::future<bool>> assetJobs;
+		auto storeAsset = [&assetJobs, &options](AssetStore::Kind kind, std::vector<AssetStore::Chunk> chunks, uint64_t extra)
+		{
+			const uint64_t key = AssetStore::ComputeKey(kind, chunks, extra);
+			if (!AssetStore::Contains(key))
+			{
+				assetJobs.push_back(AssetStore::Store(key, std::move(chunks), options));
+			}
+			return key;
+		};
 
-			// Prepare a stream to store compressed data
-			std::string osCompressed;
+		// A scene must never point at assets that didnt make it to disk, so every job is waited on whatever happens
+		auto finishAssets = [&assetJobs]()
+		{
+			bool bStored = true;
+			for (auto& job : assetJobs)
+			{
+				bStored = job.get() && bStored;
+			}
+			return bStored;
+		};
 
-			// Compress
-			snappy::Compress(os.str().data(), os.str().size(), &osCompressed);
+		// Save registry. Components skip the snapshot so plain ones save as blocks
+		SceneArchive::Write(file, SceneChunk::Registry, [&snapshot](cereal::BinaryOutputArchive& archive) { SceneArchive::WriteRegistry(archive, *snapshot.Registry); });
 
-			// Output to file
-			finalOutput << osCompressed;
+		// Renderables keep their clusters and bounds so loading doesnt need the geometry on the CPU
+		std::vector<SceneMesh> meshes;
+		meshes.reserve(snapshot.Meshes.size());
+		std::vector<StoredMesh> meshAssets;
+		if (bPack)
+		{
+			for (const auto& mesh : snapshot.Meshes)
+			{
+				meshes.push_back({ mesh.Name, mesh.Indexer });
+			}
 
-			// Close
-			finalOutput.close();
-			
+			// Archive the raw state of the buffer manager
+			file.AddChunk(SceneChunk::Vertices, std::move(*vertices), sizeof(Vertex));
+			file.AddChunk(SceneChunk::Indices, std::move(*indices), sizeof(uint32_t));
+			file.AddChunk(SceneChunk::Meshlets, std::move(snapshot.HeapMeshlets), sizeof(Meshlet));
 		}
 		else
 		{
-			VEL_CORE_ERROR("Failed to open file to save scene!");
+			// Each distinct mesh is an asset, packed back to back in the order first used so the heap loads without gaps
+			std::map<std::pair<uint32_t, uint32_t>, StoredMesh> storedByRange;
+			std::unordered_map<uint64_t, BufferManager::MeshIndexer> packedByKey;
+			BufferManager::MeshIndexer end;
+			for (auto& mesh : snapshot.Meshes)
+			{
+				const auto& indexer = mesh.Indexer;
+				StoredMesh stored = mesh.Stored;
+				auto range = storedByRange.find({ indexer.VertexOffset, indexer.IndexStart });
+				if (range != storedByRange.end())
+				{
+					stored = range->second;
+				}
+				else if (mesh.Meshlets)
+				{
+					// Vertices and indices point into the read back
+					stored.Key = storeAsset(AssetStore::Kind::Mesh, {
+						{ SceneChunk::Vertices, vertices, vertices->data() + indexer.VertexOffset, indexer.VertexCount * sizeof(Vertex), sizeof(Vertex) },
+						{ SceneChunk::Indices, indices, indices->data() + indexer.IndexStart, indexer.IndexCount * sizeof(uint32_t), sizeof(uint32_t) },
+						{ SceneChunk::Meshlets, mesh.Meshlets, mesh.Meshlets->data(), mesh.Meshlets->size() * sizeof(Meshlet), sizeof(Meshlet) } }, 0u);
+				}
+				storedByRange[{ indexer.VertexOffset, indexer.IndexStart }] = stored;
+
+				// Meshes with the same contents share one range
+				auto packed = packedByKey.find(stored.Key);
+				if (packed == packedByKey.end())
+				{
+					BufferManager::MeshIndexer next = indexer;
+					next.VertexOffset = end.VertexOffset;
+					next.IndexStart = end.IndexStart;
+					next.MeshletStart = end.MeshletStart;
+					end.VertexOffset += stored.VertexCount;
+					end.IndexStart += stored.IndexCount;
+					end.MeshletStart += stored.MeshletCount;
+					packed = packedByKey.emplace(stored.Key, next).first;
+					meshAssets.push_back(stored);
+				}
+
+				meshes.push_back({ mesh.Name, packed->second });
+				snapshot.StoredMeshes[mesh.Name] = stored;
+			}
 		}
-		
+		SceneArchive::Write(file, SceneChunk::Renderables, [&meshes](cereal::BinaryOutputArchive& archive) { archive(meshes); });
+
+		// Texture table goes in the scene chunk, the pixels each get their own chunk or asset
+		// Each read back is waited on in turn, overlapping with the compression of the ones before. Only raw pixels are filtered
+		std::vector<SceneTexture> textureTable;
+		textureTable.reserve(snapshot.Textures.size());
+		for (auto& texture : snapshot.Textures)
+		{
+			SceneTexture entry = texture.Entry;
+			if (texture.Data)
+			{
+				auto data = std::make_shared<const std::vector<uint8_t>>(texture.Data());
+				if (data->empty())
+				{
+					VEL_CORE_ERROR("Failed to read back texture {0}", entry.ReferenceName);
+					finishAssets();
+					return false;
+				}
+
+				AssetStore::Chunk chunk = { SceneChunk::Texture, data, data->data(), data->size(), entry.Cooked ? 0u : 4u };
+				if (bPack)
+				{
+					file.AddChunk(chunk.Type, chunk.Owner, chunk.Data, chunk.Size, chunk.ElementSize);
+				}
+				else
+				{
+					entry.Asset = storeAsset(AssetStore::Kind::Texture, { chunk }, Hash::Combine(Hash::Combine(static_cast<uint64_t>(entry.Width), entry.Height), entry.Cooked));
+				}
+			}
+
+			if (entry.Asset != 0u)
+			{
+				snapshot.StoredTextures[entry.ReferenceName] = entry.Asset;
+			}
+			textureTable.push_back(entry);
+		}
+
+		// Archive materials list
+		// Materials dont go through sections, so carry their component version themselves
+		const uint32_t materialVersion = ComponentTraits<PBRComponent>::VERSION;
+		SceneArchive::Write(file, SceneChunk::Materials, [&](cereal::BinaryOutputArchive& archive) { archive(materialVersion, snapshot.Materials); });
+
+		// Each face on its own so they load straight into their own layer. All six share the one read back
+		if (snapshot.SkyboxPixels)
+		{
+			const auto rawPixels = std::make_shared<const std::vector<stbi_uc>>(snapshot.SkyboxPixels());
+			const size_t faceSize = static_cast<size_t>(snapshot.SkyboxWidth) * snapshot.SkyboxHeight * 4u;
+			std::vector<AssetStore::Chunk> faces;
+			for (size_t face = 0; face < 6 && (face + 1u) * faceSize <= rawPixels->size(); ++face)
+			{
+				faces.push_back({ SceneChunk::SkyboxFace, rawPixels, rawPixels->data() + face * faceSize, faceSize, 4u });
+			}
+
+			if (bPack)
+			{
+				for (const auto& face : faces)
+				{
+					file.AddChunk(face.Type, face.Owner, face.Data, face.Size, face.ElementSize);
+				}
+			}
+			else
+			{
+				snapshot.SkyboxAsset = storeAsset(AssetStore::Kind::Skybox, std::move(faces), Hash::Combine(static_cast<uint64_t>(snapshot.SkyboxWidth), snapshot.SkyboxHeight));
+			}
+		}
+
+		// Written last as it holds the keys of everything above
+		BulkLayout layout;
+		uint32_t vertexSize = sizeof(Vertex);
+		bool bStoredGeometry = !bPack;
+		SceneArchive::Write(file, SceneChunk::Scene, [&](cereal::BinaryOutputArchive& archive)
+			{ archive(snapshot.Name, snapshot.SceneCamera, layout, vertexSize, textureTable, snapshot.SkyboxWidth, snapshot.SkyboxHeight, snapshot.SkyboxAsset, bStoredGeometry, meshAssets); });
+
+		if (!finishAssets() || !file.Finish())
+		{
+			return false;
+		}
+
+		if (!bPack)
+		{
+			AssetStore::AddRoot(saveFilepath);
+		}
+		return true;
+	}
+
+	void Scene::KeepStoredAssets(SaveSnapshot& snapshot)
+	{
+		m_MeshAssets = std::move(snapshot.StoredMeshes);
+		m_TextureAssets = std::move(snapshot.StoredTextures);
+		m_SkyboxAsset = snapshot.SkyboxAsset;
 	}
 
+	void Scene::CopyRegistry(entt::registry& outRegistry)
+	{
+		m_Registry.each([&outRegistry](auto entity) { outRegistry.create(entity); });
+		SceneComponents::ForEach([&](auto tag)
+		{
+			using Component = typename decltype(tag)::Type;
+			for (auto entity : m_Registry.view<Component>())
+			{
+				outRegistry.emplace<Component>(entity, m_Registry.get<Component>(entity));
+			}
+		});
+	}
 
 }
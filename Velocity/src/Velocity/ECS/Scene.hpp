@@ -1,4 +1,8 @@
 #pragma once
+#include <array>
+#include <bitset>
+#include <unordered_set>
+
 #include <entt/entt.hpp>
 #include <Velocity/Utility/Camera.hpp>
 
@@ -6,9 +10,15 @@
 
 #include "Velocity/Renderer/IBLMap.hpp"
 
+#include "AssetStore.hpp"
+#include "ComponentRegistry.hpp"
+#include "SceneFile.hpp"
+#include "SceneJournal.hpp"
+
 namespace Velocity
 {
 	class Entity;
+	class SceneLoad;
 	
 	class Scene
 	{
@@ -19,8 +29,11 @@ namespace Velocity
 		Entity CreateEntity(const std::string & name = "New Entity");
 		void RemoveEntity(Entity& entity);
 
+		// New entity with a copy of every component the given one has
+		Entity DuplicateEntity(Entity& entity);
+
 		void CreateSkybox(const std::string& baseFilepath, const std::string& extension);
-		void RemoveSkybox() { m_Skybox.reset(nullptr); }
+		void RemoveSkybox() { m_Skybox.reset(nullptr); m_SkyboxAsset = 0u; }
 
 		std::vector<Entity>& GetEntities() { return m_Entities; }
 		const std::string& GetSceneName() { return m_SceneName; }
@@ -30,11 +43,41 @@ namespace Velocity
 
 		// Static function to load a default scene from a file
 		// Filepath should be relative path with no file extension
-		// Blank string to create new
+		// Blank string to create new. A file that fails to load also gives a new scene
 		static Scene* LoadScene(const std::string& sceneFilepath);
 
-		// Saves out data from given scene
-		void SaveScene(const std::string& saveFilepath);
+		// Loads in the background while the current scene keeps rendering, see SceneLoad
+		// Call Update on the handle every frame and swap in the scene it returns
+		static std::unique_ptr<SceneLoad> LoadSceneAsync(const std::string& sceneFilepath);
+
+		// True if any tracked component was added, changed or removed since the last load or save
+		// Components edited in place only count once Entity::NotifyChanged is called
+		bool IsDirty() const { return m_DirtyComponents.any(); }
+		void ClearDirty() { m_DirtyComponents.reset(); }
+
+		template<typename T>
+		bool IsComponentDirty() const { return m_DirtyComponents.test(SceneComponents::IndexOf<T>()); }
+
+		// Saves out data from given scene as a chunked scene file, see SceneFile
+		// Meshes, textures and the skybox go to the AssetStore and the scene only keeps their keys
+		// Options pick the codec and filter for each class of chunk, SceneSaveOptions::Fast suits autosaves
+		void SaveScene(const std::string& saveFilepath, const SceneSaveOptions& options = {});
+
+		// As above but self contained, every asset is written into the scene file itself. For shipping
+		void ExportPack(const std::string& saveFilepath, const SceneSaveOptions& options = SceneSaveOptions::Archive());
+
+		// Releases the meshes, materials and textures no component references, then packs the geometry heap and texture slots
+		// Texture indices in components and materials are remapped to match. SaveScene and ExportPack run it first
+		// Renderer state is shared so only call it on the scene being rendered
+		void CollectGarbage();
+
+		// While on, every entity whose components are added, changed or removed is logged for TakeDelta
+		void SetChangeLog(bool bEnabled);
+		bool HasLoggedChanges() const;
+
+		// Copies the current value of everything logged since the last call and clears the log
+		// Only logged components are copied so this stays cheap however big the scene is
+		SceneDelta TakeDelta();
 
 		// Extracts reference names from filepaths for scene management
 		static std::string GetRefName(const std::string& fullPath)
@@ -84,11 +127,89 @@ namespace Velocity
 		// Scene skybox
 		std::unique_ptr <Skybox> m_Skybox = nullptr;
 
-		void OnPointLightChanged(entt::registry& reg, entt::entity entity);
+		// One bit per entry in SceneComponents
+		std::bitset<SceneComponents::SIZE> m_DirtyComponents;
+
+		// Entities logged per entry in SceneComponents, see SetChangeLog
+		bool m_bLogChanges = false;
+		std::array<std::unordered_set<entt::entity>, SceneComponents::SIZE> m_ChangedEntities;
+
+		// A mesh in the asset store and the size of its ranges
+		struct StoredMesh
+		{
+			uint64_t	Key = 0u;
+			uint32_t	VertexCount = 0u;
+			uint32_t	IndexCount = 0u;
+			uint32_t	MeshletCount = 0u;
+
+			template<class Archive>
+			void serialize(Archive& ar)
+			{
+				ar(Key, VertexCount, IndexCount, MeshletCount);
+			}
+		};
+
+		// Store keys from the last load or save by renderable and texture name
+		// Renderer resources never change under a name, so these are saved again without being read back or hashed
+		std::unordered_map<std::string, StoredMesh> m_MeshAssets;
+		std::unordered_map<std::string, uint64_t> m_TextureAssets;
+		uint64_t m_SkyboxAsset = 0u;
+
+		// Assets the scene was loaded from. Held so a scene opened next that shares them reuses the mapping
+		std::vector<std::shared_ptr<const SceneFileReader>> m_Assets;
+
+		// Connected for every component whose traits track changes
+		template<typename T>
+		void OnComponentChanged(entt::registry& reg, entt::entity entity);
+
+		enum class SaveMode
+		{
+			Scene,		// The scene now belongs to the file
+			Pack		// Self contained copy
+		};
+
+		// Writes the scene, with its assets in the store or packed into the file
+		bool Save(const std::string& saveFilepath, const SceneSaveOptions& options, SaveMode mode);
+
+		// Everything a save needs from the scene and the renderer, taken on the main thread and written on any
+		// Defined in Scene.cpp with the chunk layouts
+		struct SaveSnapshot;
+
+		// Copies the camera and materials, and starts reading back off the GPU whatever the store doesnt have yet
+		// or everything for a pack. Leaves the registry to the caller. Main thread only, with no textures still loading
+		void TakeSnapshot(SaveSnapshot& snapshot, bool bPack);
+
+		// For SceneAutosave. As TakeSnapshot against the store, with the change log taken as a delta instead of any registry
+		// so the cost is in what changed rather than the size of the scene. nullptr while textures are still loading
+		std::shared_ptr<SaveSnapshot> TakeAutosave();
+
+		// Waits for the snapshot's read backs, hashes and stores its assets then writes the scene pointing at them. Any thread
+		// Saves against the store need AssetStore::LockForSave held. Returns false if anything failed
+		static bool WriteSnapshot(const std::string& saveFilepath, const SceneSaveOptions& options, SaveSnapshot& snapshot, bool bPack);
+
+		// Plays an autosave snapshot's delta onto registry, the autosave's own copy, and writes it with that. Any thread
+		// The registry has the delta whether or not the write worked
+		static bool WriteAutosave(const std::string& saveFilepath, SaveSnapshot& snapshot, entt::registry& registry);
+
+		// Remembers the keys a written snapshot stored its assets under so the next save skips them. Main thread only
+		void KeepStoredAssets(SaveSnapshot& snapshot);
+
+		// Every entity and component into an empty registry, keeping their ids so deltas taken afterwards line up
+		void CopyRegistry(entt::registry& outRegistry);
+
+		// Empty scene with a default camera. Clears the renderer
+		static Scene* CreateBlank();
+
+		// Scenes saved before the chunked format, one snappy compressed archive of everything
+		// Read in full before anything is replaced, returns false and leaves the scene empty if no known layout fits
+		bool LoadLegacy(const MappedFile& file);
 		
 		// Both need access to registry but the end user doesnt
 		friend class Renderer;
 		friend class Entity;
+		friend class SceneLoad;
+		friend class SceneAutosave;
+		friend class SceneBenchmark;
 
 		
 	};
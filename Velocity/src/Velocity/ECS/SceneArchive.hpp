@@ -0,0 +1,111 @@
+#pragma once
+
+#include <istream>
+#include <sstream>
+#include <streambuf>
+#include <vector>
+
+#include <entt/entt.hpp>
+#include <cereal/archives/binary.hpp>
+
+#include <Velocity/Core/Log.hpp>
+
+#include "ComponentRegistry.hpp"
+#include "SceneFile.hpp"
+
+namespace Velocity
+{
+	// Chunks of a scene file that go through cereal, shared by scene saves and autosaves
+	class SceneArchive
+	{
+	public:
+		// Archives into a single chunk
+		template<typename Function>
+		static void Write(SceneFileWriter& file, SceneChunk type, Function&& function)
+		{
+			std::ostringstream stream;
+			{
+				cereal::BinaryOutputArchive archive(stream);
+				function(archive);
+			}
+			file.AddChunk(type, stream.str());
+		}
+
+		// Reads the first chunk of a type through an archive. Uncompressed chunks are read from the mapping
+		template<typename Function>
+		static bool Read(const SceneFileReader& file, SceneChunk type, Function&& function)
+		{
+			const auto* entry = file.FindFirst(type);
+			if (!entry)
+			{
+				return false;
+			}
+
+			std::vector<char> buffer;
+			const auto* data = reinterpret_cast<const char*>(file.GetDirect(*entry));
+			if (!data)
+			{
+				buffer.resize(static_cast<size_t>(entry->Size));
+				if (!file.Read(*entry, buffer.data()))
+				{
+					return false;
+				}
+				data = buffer.data();
+			}
+
+			ChunkStreamBuffer streamBuffer(data, static_cast<size_t>(entry->Size));
+			std::istream stream(&streamBuffer);
+			try
+			{
+				cereal::BinaryInputArchive archive(stream);
+				function(archive);
+			}
+			catch (const cereal::Exception& exception)
+			{
+				VEL_CORE_WARN("Failed to read scene chunk: {0}", exception.what());
+				return false;
+			}
+			return true;
+		}
+
+		// The registry chunk. Components skip the snapshot so plain ones save as blocks
+		static void WriteRegistry(cereal::BinaryOutputArchive& archive, entt::registry& registry)
+		{
+			entt::snapshot{ registry }
+				.entities(archive);
+			ComponentSerialiser::Save(archive, registry);
+		}
+
+		// Older files are read the way their version wrote them
+		static void ReadRegistry(cereal::BinaryInputArchive& archive, entt::registry& registry, uint32_t version)
+		{
+			entt::snapshot_loader loader{ registry };
+			loader.entities(archive);
+			if (version < SceneFile::BLOCKS_VERSION)
+			{
+				ComponentSerialiser::LoadSnapshot(loader, archive, registry);
+			}
+			else if (version < SceneFile::SECTIONS_VERSION)
+			{
+				ComponentSerialiser::LoadUnsectioned(archive, registry);
+			}
+			else
+			{
+				ComponentSerialiser::Load(archive, registry);
+			}
+			loader.orphans();
+		}
+
+	private:
+		// Lets cereal read a chunk where it sits without copying it into a stringstream
+		class ChunkStreamBuffer : public std::streambuf
+		{
+		public:
+			ChunkStreamBuffer(const char* data, size_t size)
+			{
+				auto* begin = const_cast<char*>(data);
+				setg(begin, begin, begin + size);
+			}
+		};
+	};
+}
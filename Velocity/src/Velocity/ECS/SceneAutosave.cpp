@@ -0,0 +1,264 @@
+#include "velpch.h"
+
+#include "SceneAutosave.hpp"
+#include "SceneArchive.hpp"
+#include "Scene.hpp"
+
+#include <chrono>
+#include <filesystem>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Renderer/Renderer.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	const char* SceneAutosave::AUTOSAVE_DIRECTORY = "../Velocity/autosave/";
+	const float SceneAutosave::INTERVAL_SECONDS = 10.0f;
+
+	SceneAutosave::SceneAutosave(Scene* scene) :
+		r_Scene(scene),
+		m_Worker(std::make_unique<Worker>())
+	{
+		m_Worker->Path = GetPath(scene->GetSceneName());
+		m_AssetSignature = GetAssetSignature(scene);
+
+		std::error_code error;
+		if (std::filesystem::exists(m_Worker->Path, error))
+		{
+			VEL_CORE_WARN("{0} has an autosave, File > Recover Autosave opens it. It is replaced once this scene changes", scene->GetSceneName());
+		}
+
+		// Deltas from here on are played onto this
+		scene->CopyRegistry(m_Worker->Mirror);
+		scene->SetChangeLog(true);
+	}
+
+	SceneAutosave::~SceneAutosave()
+	{
+		if (m_Job.valid())
+		{
+			FinishJob();
+		}
+		r_Scene->SetChangeLog(false);
+
+		// Everything is in the scene's own file, the autosave would only bring back older changes
+		if (m_bWritten && !r_Scene->IsDirty())
+		{
+			std::error_code error;
+			std::filesystem::remove(m_Worker->Path, error);
+			std::filesystem::remove(SceneJournal::GetPath(m_Worker->Path), error);
+		}
+	}
+
+	void SceneAutosave::Update(float deltaTime)
+	{
+		m_Elapsed += deltaTime;
+		if (m_Elapsed < INTERVAL_SECONDS)
+		{
+			return;
+		}
+
+		// Still writing the last one, try again next frame
+		if (m_Job.valid())
+		{
+			if (m_Job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				return;
+			}
+			FinishJob();
+		}
+		m_Elapsed = 0.0f;
+
+		auto* worker = m_Worker.get();
+		const uint64_t signature = GetAssetSignature(r_Scene);
+		if (signature != m_AssetSignature || (worker->bNeedsFullSave && (r_Scene->HasLoggedChanges() || m_bChangesLost)))
+		{
+			// What changed plus read backs of anything not stored yet, the worker waits for those
+			auto snapshot = r_Scene->TakeAutosave();
+			if (!snapshot)
+			{
+				// Textures are still loading, try again next frame
+				m_Elapsed = INTERVAL_SECONDS;
+				return;
+			}
+
+			std::error_code error;
+			std::filesystem::create_directories(AUTOSAVE_DIRECTORY, error);
+
+			m_Snapshot = snapshot;
+			m_SnapshotSignature = signature;
+			m_Job = ThreadPool::Get().Enqueue([worker, snapshot]() { return worker->Save(*snapshot); });
+			return;
+		}
+
+		if (worker->bNeedsFullSave || !r_Scene->HasLoggedChanges())
+		{
+			return;
+		}
+
+		// The only work on this thread, a copy of what changed
+		auto delta = std::make_shared<SceneDelta>(r_Scene->TakeDelta());
+		m_Job = ThreadPool::Get().Enqueue([worker, delta]() { return worker->Append(*delta); });
+	}
+
+	void SceneAutosave::FinishJob()
+	{
+		const bool bWritten = m_Job.get();
+		m_bChangesLost = !bWritten;
+		if (!m_Snapshot)
+		{
+			return;
+		}
+
+		if (bWritten)
+		{
+			m_bWritten = true;
+			m_AssetSignature = m_SnapshotSignature;
+
+			// The skybox isnt stored by name, so the keys only fit if nothing they came from has changed since
+			if (GetAssetSignature(r_Scene) == m_SnapshotSignature)
+			{
+				r_Scene->KeepStoredAssets(*m_Snapshot);
+			}
+		}
+		m_Snapshot.reset();
+	}
+
+	std::string SceneAutosave::GetPath(const std::string& sceneName)
+	{
+		return std::string(AUTOSAVE_DIRECTORY) + sceneName + ".velocity";
+	}
+
+	uint64_t SceneAutosave::GetAssetSignature(Scene* scene)
+	{
+		auto& renderer = Renderer::GetRenderer();
+
+		// Summed per entry so the unordered maps hash the same whatever their order
+		uint64_t meshes = 0u;
+		for (const auto& [name, indexer] : renderer->GetMeshList())
+		{
+			meshes += Hash::Combine(Hash::Bytes(name.data(), name.size()), indexer.VertexCount);
+		}
+
+		uint64_t materials = 0u;
+		for (const auto& [name, material] : renderer->GetMaterialsList())
+		{
+			materials += Hash::Bytes(material.TextureIDs.data(), sizeof(material.TextureIDs), Hash::Bytes(name.data(), name.size()));
+		}
+
+		uint64_t signature = Hash::Combine(meshes, materials);
+		for (const auto& texture : renderer->GetTexturesList())
+		{
+			signature = Hash::Bytes(texture.first.data(), texture.first.size(), signature);
+		}
+		return Hash::Combine(signature, reinterpret_cast<uintptr_t>(scene->GetSkybox()));
+	}
+
+	bool SceneAutosave::Worker::Save(Scene::SaveSnapshot& snapshot)
+	{
+		{
+			// Held until the autosave pointing at the assets is recorded, see AssetStore::Collect
+			auto storeLock = AssetStore::LockForSave();
+			if (!Scene::WriteAutosave(Path, snapshot, Mirror))
+			{
+				VEL_CORE_WARN("Autosave of {0} failed", Path);
+				bNeedsFullSave = true;
+				return false;
+			}
+		}
+
+		// The mirror is what was just written, so the file isnt read back for it
+		SceneFileReader file;
+		if (!file.Open(Path) || !Journal.Begin(SceneJournal::GetPath(Path), SceneJournal::GetBaseKey(file)))
+		{
+			VEL_CORE_WARN("Autosave couldnt start a journal for {0}", Path);
+			bNeedsFullSave = true;
+			return true;
+		}
+		bNeedsFullSave = false;
+		return true;
+	}
+
+	bool SceneAutosave::Worker::Append(SceneDelta& delta)
+	{
+		// The mirror takes it either way, only the file is behind if the journal fails
+		const bool bAppended = Journal.Append(delta);
+		SceneJournal::Apply(Mirror, delta);
+		if (!bAppended)
+		{
+			bNeedsFullSave = true;
+			return false;
+		}
+
+		// The delta is on disk even if this fails, the next autosave is just a full one
+		if (Journal.GetRecordCount() >= MAX_RECORDS || Journal.GetSize() >= MAX_JOURNAL_SIZE)
+		{
+			Compact();
+		}
+		return true;
+	}
+
+	void SceneAutosave::Worker::Compact()
+	{
+		// Copied out first, the writer cant replace a file that is still mapped
+		struct CopiedChunk
+		{
+			SceneChunk								Type = SceneChunk::Scene;
+			uint32_t								ElementSize = 0u;
+			std::shared_ptr<std::vector<uint8_t>>	Data;
+		};
+		std::vector<CopiedChunk> chunks;
+		{
+			// Chunks are copied as they are, so only a file of this version can take a new registry
+			SceneFileReader file;
+			if (!file.Open(Path) || file.GetVersion() != SceneFile::FORMAT_VERSION)
+			{
+				bNeedsFullSave = true;
+				return;
+			}
+			for (const auto& entry : file.GetChunks())
+			{
+				if (entry.Type == SceneChunk::Registry)
+				{
+					continue;
+				}
+
+				CopiedChunk chunk = { entry.Type, entry.ElementSize, std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entry.Size)) };
+				if (!file.Read(entry, chunk.Data->data()))
+				{
+					bNeedsFullSave = true;
+					return;
+				}
+				chunks.push_back(chunk);
+			}
+		}
+
+		// Registry first as the scene saves do, the Scene chunk stays last
+		SceneFileWriter writer;
+		if (!writer.Begin(Path, SceneSaveOptions::Fast()))
+		{
+			bNeedsFullSave = true;
+			return;
+		}
+		SceneArchive::Write(writer, SceneChunk::Registry, [this](cereal::BinaryOutputArchive& archive) { SceneArchive::WriteRegistry(archive, Mirror); });
+		for (const auto& chunk : chunks)
+		{
+			writer.AddChunk(chunk.Type, chunk.Data, chunk.Data->data(), chunk.Data->size(), chunk.ElementSize);
+		}
+		if (!writer.Finish())
+		{
+			VEL_CORE_WARN("Autosave couldnt compact {0}", Path);
+			bNeedsFullSave = true;
+			return;
+		}
+
+		// The old journal no longer matches the file, so it is ignored until this replaces it
+		SceneFileReader file;
+		if (!file.Open(Path) || !Journal.Begin(SceneJournal::GetPath(Path), SceneJournal::GetBaseKey(file)))
+		{
+			bNeedsFullSave = true;
+		}
+	}
+}
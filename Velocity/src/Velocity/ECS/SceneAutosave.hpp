@@ -0,0 +1,104 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <entt/entt.hpp>
+
+#include "Scene.hpp"
+#include "SceneJournal.hpp"
+
+namespace Velocity
+{
+	// Saves a scene in the background while it is edited
+	// A worker keeps its own copy of the registry, made once when the autosave starts. At a frame boundary the main
+	// thread only copies the components changed since the last autosave, and the worker plays them onto its copy
+	// Usually it then appends them to a journal next to the last full save. The first autosave, and any after meshes,
+	// textures, materials or the skybox change, is instead a full save of the worker's copy against the asset store,
+	// for which the main thread only starts GPU read backs of assets the store doesnt have yet. Once the journal grows
+	// too long the worker folds it into a new full save too, so the main thread never touches the whole scene
+	// Loading the autosave replays the journal
+	class SceneAutosave
+	{
+	public:
+		// Where autosaves go, one per scene name
+		static const char* AUTOSAVE_DIRECTORY;
+
+		// Seconds between autosaves
+		static const float INTERVAL_SECONDS;
+
+		// Journal limits before it is compacted into a full save
+		static constexpr uint32_t MAX_RECORDS = 64u;
+		static constexpr uint64_t MAX_JOURNAL_SIZE = 16u * 1024u * 1024u;
+
+		// Copies the registry and starts logging the scene's changes. Has to be destroyed before the scene is
+		// Made alongside a load or save, which already go through every entity
+		explicit SceneAutosave(Scene* scene);
+
+		// Waits for any write in flight. An autosave this wrote is removed if the scene was saved since
+		~SceneAutosave();
+
+		SceneAutosave(const SceneAutosave&) = delete;
+		SceneAutosave& operator=(const SceneAutosave&) = delete;
+
+		// Call once a frame, outside any system that edits the registry
+		void Update(float deltaTime);
+
+		// The autosave of a scene with this name
+		static std::string GetPath(const std::string& sceneName);
+
+	private:
+		// Everything the worker owns. Only touched by the job in flight, or the main thread when there isnt one
+		struct Worker
+		{
+			std::string			Path;
+
+			// Registry as of the last autosave, so full saves and compaction dont need the scene
+			entt::registry		Mirror;
+			SceneJournal		Journal;
+
+			// Set when a write fails, the next autosave is a full one
+			std::atomic<bool>	bNeedsFullSave = true;
+
+			// Plays the snapshot's delta onto the mirror, writes a full save of it and starts a journal against that
+			// Returns false if the save wasnt written
+			bool Save(Scene::SaveSnapshot& snapshot);
+
+			// Plays a delta onto the mirror, appends it and compacts if the journal is over its limits
+			// Returns false if it couldnt be appended
+			bool Append(SceneDelta& delta);
+
+			// Rewrites the full save from the mirror, keeping every other chunk as it is
+			void Compact();
+		};
+
+		// Changes when anything a journal cant carry does
+		static uint64_t GetAssetSignature(Scene* scene);
+
+		// Waits for the job in flight and hands the scene the keys a full save stored its assets under
+		void FinishJob();
+
+		Scene*									r_Scene;
+		std::unique_ptr<Worker>					m_Worker;
+		std::future<bool>						m_Job;
+
+		// The full save in flight, if it is one, and the signature it was taken at
+		std::shared_ptr<Scene::SaveSnapshot>	m_Snapshot;
+		uint64_t								m_SnapshotSignature = 0u;
+
+		float									m_Elapsed = 0.0f;
+		uint64_t								m_AssetSignature = 0u;
+
+		// Set once this has replaced whatever autosave was there before
+		bool									m_bWritten = false;
+
+		// Set when a write failed, so the next full save goes ahead with nothing new logged
+		bool									m_bChangesLost = false;
+
+		// Times the main thread side against a generated scene
+		friend class SceneBenchmark;
+	};
+}
@@ -0,0 +1,257 @@
+#include "velpch.h"
+
+#include "SceneCodec.hpp"
+
+#include <algorithm>
+
+#include <snappy.h>
+#include <zlib.h>
+
+namespace Velocity
+{
+	namespace
+	{
+		// zlib counts in uInt, large chunks are fed through in steps
+		const size_t DEFLATE_STEP = 1u << 30;
+
+		bool DeflateCompress(int level, const uint8_t* data, size_t size, size_t maxSize, std::string& output)
+		{
+			z_stream stream = {};
+			if (deflateInit(&stream, level > 0 ? std::min(level, Z_BEST_COMPRESSION) : Z_DEFAULT_COMPRESSION) != Z_OK)
+			{
+				return false;
+			}
+
+			// Anything past maxSize is thrown away anyway, so stop there rather than growing the output
+			output.resize(maxSize);
+			stream.next_in = const_cast<Bytef*>(data);
+			stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+
+			size_t inputLeft = size;
+			size_t outputLeft = maxSize;
+			int result = Z_OK;
+			while (result == Z_OK && outputLeft > 0u)
+			{
+				const auto inputStep = static_cast<uInt>(std::min(inputLeft, DEFLATE_STEP));
+				const auto outputStep = static_cast<uInt>(std::min(outputLeft, DEFLATE_STEP));
+				stream.avail_in = inputStep;
+				stream.avail_out = outputStep;
+				result = deflate(&stream, inputLeft == inputStep ? Z_FINISH : Z_NO_FLUSH);
+				inputLeft -= inputStep - stream.avail_in;
+				outputLeft -= outputStep - stream.avail_out;
+			}
+			deflateEnd(&stream);
+
+			if (result != Z_STREAM_END)
+			{
+				output.clear();
+				return false;
+			}
+			output.resize(maxSize - outputLeft);
+			return true;
+		}
+
+		bool DeflateDecompress(const uint8_t* stored, size_t storedSize, uint8_t* output, size_t size)
+		{
+			z_stream stream = {};
+			if (inflateInit(&stream) != Z_OK)
+			{
+				return false;
+			}
+
+			stream.next_in = const_cast<Bytef*>(stored);
+			stream.next_out = output;
+
+			size_t inputLeft = storedSize;
+			size_t outputLeft = size;
+			int result = Z_OK;
+			while (result == Z_OK)
+			{
+				const auto inputStep = static_cast<uInt>(std::min(inputLeft, DEFLATE_STEP));
+				const auto outputStep = static_cast<uInt>(std::min(outputLeft, DEFLATE_STEP));
+				stream.avail_in = inputStep;
+				stream.avail_out = outputStep;
+				result = inflate(&stream, Z_NO_FLUSH);
+				inputLeft -= inputStep - stream.avail_in;
+				outputLeft -= outputStep - stream.avail_out;
+			}
+			inflateEnd(&stream);
+
+			return result == Z_STREAM_END && inputLeft == 0u && outputLeft == 0u;
+		}
+
+		// Elements per block for a given element size
+		size_t GetBlockElements(uint32_t elementSize, size_t blockSize)
+		{
+			return std::max<size_t>(1u, blockSize / elementSize);
+		}
+	}
+
+	bool SceneCodec::IsAvailable(SceneCompression codec)
+	{
+		switch (codec)
+		{
+		case SceneCompression::None:
+		case SceneCompression::Snappy:
+		case SceneCompression::Deflate:
+			return true;
+		}
+		return false;
+	}
+
+	const char* SceneCodec::GetName(SceneCompression codec)
+	{
+		switch (codec)
+		{
+		case SceneCompression::None:	return "None";
+		case SceneCompression::Snappy:	return "Snappy";
+		case SceneCompression::Deflate:	return "Deflate";
+		}
+		return "Unknown";
+	}
+
+	const char* SceneCodec::GetName(SceneFilter filter)
+	{
+		switch (filter)
+		{
+		case SceneFilter::None:			return "None";
+		case SceneFilter::Shuffle:		return "Shuffle";
+		case SceneFilter::ShuffleDelta:	return "Shuffle + Delta";
+		}
+		return "Unknown";
+	}
+
+	bool SceneCodec::Compress(SceneCompression codec, int level, const uint8_t* data, size_t size, size_t maxSize, std::string& output)
+	{
+		output.clear();
+		switch (codec)
+		{
+		case SceneCompression::Snappy:
+			snappy::Compress(reinterpret_cast<const char*>(data), size, &output);
+			return !output.empty() && output.size() <= maxSize;
+		case SceneCompression::Deflate:
+			return DeflateCompress(level, data, size, maxSize, output);
+		default:
+			return false;
+		}
+	}
+
+	bool SceneCodec::Decompress(SceneCompression codec, const uint8_t* stored, size_t storedSize, uint8_t* output, size_t size)
+	{
+		switch (codec)
+		{
+		case SceneCompression::None:
+			if (storedSize != size)
+			{
+				return false;
+			}
+			memcpy(output, stored, size);
+			return true;
+		case SceneCompression::Snappy:
+		{
+			size_t length = 0u;
+			const auto* compressed = reinterpret_cast<const char*>(stored);
+			if (!snappy::GetUncompressedLength(compressed, storedSize, &length) || length != size)
+			{
+				return false;
+			}
+			return snappy::RawUncompress(compressed, storedSize, reinterpret_cast<char*>(output));
+		}
+		case SceneCompression::Deflate:
+			return DeflateDecompress(stored, storedSize, output, size);
+		default:
+			return false;
+		}
+	}
+
+	void SceneCodec::Filter(SceneFilter filter, uint32_t elementSize, const uint8_t* input, uint8_t* output, size_t size)
+	{
+		if (filter == SceneFilter::None || elementSize < 2u)
+		{
+			memcpy(output, input, size);
+			return;
+		}
+
+		const bool bDelta = filter == SceneFilter::ShuffleDelta;
+		const size_t count = size / elementSize;
+		const size_t blockElements = GetBlockElements(elementSize, FILTER_BLOCK_SIZE);
+
+		for (size_t first = 0; first < count; first += blockElements)
+		{
+			const size_t elements = std::min(blockElements, count - first);
+			const uint8_t* block = input + first * elementSize;
+			uint8_t* planes = output + first * elementSize;
+
+			for (uint32_t byte = 0; byte < elementSize; ++byte)
+			{
+				const uint8_t* source = block + byte;
+				uint8_t* plane = planes + byte * elements;
+				if (bDelta)
+				{
+					uint8_t previous = 0u;
+					for (size_t i = 0; i < elements; ++i)
+					{
+						const uint8_t value = source[i * elementSize];
+						plane[i] = static_cast<uint8_t>(value - previous);
+						previous = value;
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < elements; ++i)
+					{
+						plane[i] = source[i * elementSize];
+					}
+				}
+			}
+		}
+
+		const size_t body = count * elementSize;
+		memcpy(output + body, input + body, size - body);
+	}
+
+	void SceneCodec::Unfilter(SceneFilter filter, uint32_t elementSize, const uint8_t* input, uint8_t* output, size_t size)
+	{
+		if (filter == SceneFilter::None || elementSize < 2u)
+		{
+			memcpy(output, input, size);
+			return;
+		}
+
+		const bool bDelta = filter == SceneFilter::ShuffleDelta;
+		const size_t count = size / elementSize;
+		const size_t blockElements = GetBlockElements(elementSize, FILTER_BLOCK_SIZE);
+
+		for (size_t first = 0; first < count; first += blockElements)
+		{
+			const size_t elements = std::min(blockElements, count - first);
+			const uint8_t* planes = input + first * elementSize;
+			uint8_t* block = output + first * elementSize;
+
+			for (uint32_t byte = 0; byte < elementSize; ++byte)
+			{
+				const uint8_t* plane = planes + byte * elements;
+				uint8_t* target = block + byte;
+				if (bDelta)
+				{
+					uint8_t previous = 0u;
+					for (size_t i = 0; i < elements; ++i)
+					{
+						previous = static_cast<uint8_t>(previous + plane[i]);
+						target[i * elementSize] = previous;
+					}
+				}
+				else
+				{
+					for (size_t i = 0; i < elements; ++i)
+					{
+						target[i * elementSize] = plane[i];
+					}
+				}
+			}
+		}
+
+		const size_t body = count * elementSize;
+		memcpy(output + body, input + body, size - body);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "SceneFile.hpp"
+
+namespace Velocity
+{
+	// The codecs and filters behind scene chunks
+	// Everything here is stateless and can be called from any thread
+	class SceneCodec
+	{
+	public:
+		// False for a codec this build doesnt know, as read from a corrupt or newer file
+		static bool IsAvailable(SceneCompression codec);
+
+		static const char* GetName(SceneCompression codec);
+		static const char* GetName(SceneFilter filter);
+
+		// Compresses size bytes into output. Returns false if the codec failed or the result wouldnt fit in maxSize
+		static bool Compress(SceneCompression codec, int level, const uint8_t* data, size_t size, size_t maxSize, std::string& output);
+
+		// Decompresses storedSize bytes into exactly size bytes of output
+		static bool Decompress(SceneCompression codec, const uint8_t* stored, size_t storedSize, uint8_t* output, size_t size);
+
+		// Filters size bytes of elementSize elements from input into output. The two cant overlap
+		// Elements are shuffled a block at a time so each pass stays in cache, a tail smaller than an element is copied as it is
+		static void Filter(SceneFilter filter, uint32_t elementSize, const uint8_t* input, uint8_t* output, size_t size);
+
+		// Undoes Filter
+		static void Unfilter(SceneFilter filter, uint32_t elementSize, const uint8_t* input, uint8_t* output, size_t size);
+
+	private:
+		// Source bytes shuffled together, blocks are whole elements so can be a little over
+		static constexpr size_t FILTER_BLOCK_SIZE = 256u * 1024u;
+	};
+}
@@ -0,0 +1,393 @@
+#include "velpch.h"
+
+#include "SceneFile.hpp"
+#include "SceneCodec.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <thread>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		// Table entries before SceneFile::FILTER_VERSION, without a filter or element size
+		struct SceneChunkEntryV1
+		{
+			SceneChunk			Type = SceneChunk::Scene;
+			SceneCompression	Compression = SceneCompression::None;
+			uint64_t			Offset = 0u;
+			uint64_t			StoredSize = 0u;
+			uint64_t			Size = 0u;
+			uint64_t			Checksum = 0u;
+		};
+	}
+
+	const char SceneFile::MAGIC[4] = { 'V','S','C','N' };
+
+	SceneFileWriter::~SceneFileWriter()
+	{
+		// Never finished, jobs hold their own chunk so they can be left to run out
+		if (m_Output.is_open())
+		{
+			m_Output.close();
+			std::error_code error;
+			std::filesystem::remove(m_TempPath, error);
+		}
+	}
+
+	bool SceneFileWriter::Begin(const std::string& filepath, const SceneSaveOptions& options)
+	{
+		m_Filepath = filepath;
+		m_Options = options;
+		for (auto* chunkOptions : { &m_Options.Data, &m_Options.Geometry, &m_Options.Pixels })
+		{
+			if (!SceneCodec::IsAvailable(chunkOptions->Codec))
+			{
+				VEL_CORE_WARN("{0} compression isnt available in this build, saving with snappy", SceneCodec::GetName(chunkOptions->Codec));
+				chunkOptions->Codec = SceneCompression::Snappy;
+			}
+		}
+
+		// Same temporary name scheme as the mesh cache
+		m_TempPath = filepath + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+		m_Output.open(m_TempPath, std::ios::binary | std::ios::trunc);
+		if (!m_Output.is_open())
+		{
+			VEL_CORE_ERROR("Failed to open {0} to save scene!", filepath);
+			m_Failed = true;
+			return false;
+		}
+
+		// The header is only known at the end, reserve its page for now
+		const SceneFile::Header placeholder = {};
+		m_Output.write(reinterpret_cast<const char*>(&placeholder), sizeof(placeholder));
+		m_Offset = sizeof(placeholder);
+		Pad();
+		return true;
+	}
+
+	void SceneFileWriter::AddChunk(SceneChunk type, std::shared_ptr<const void> owner, const void* data, size_t size, uint32_t elementSize)
+	{
+		if (m_Failed)
+		{
+			return;
+		}
+
+		auto chunk = std::make_shared<PendingChunk>();
+		chunk->Entry.Type = type;
+		chunk->Entry.Size = size;
+		chunk->Entry.ElementSize = elementSize;
+		chunk->Options = m_Options.Get(type);
+		chunk->Owner = std::move(owner);
+		chunk->Data = static_cast<const uint8_t*>(data);
+		if (!m_FreeBuffers.empty())
+		{
+			chunk->Stored = std::move(m_FreeBuffers.back());
+			m_FreeBuffers.pop_back();
+		}
+
+		// Saving from a worker compresses inline, waiting on the pool from inside it could starve it
+		Pending pending;
+		pending.Chunk = chunk;
+		if (ThreadPool::IsWorkerThread())
+		{
+			Compress(*chunk);
+		}
+		else
+		{
+			pending.Job = ThreadPool::Get().Enqueue([chunk]() { Compress(*chunk); });
+		}
+		m_Pending.push_back(std::move(pending));
+		m_PendingBytes += size;
+
+		// Whatever has finished at the front goes out now, so the disk is kept busy while later chunks compress
+		while (!m_Pending.empty() && !m_Failed && IsReady(m_Pending.front()))
+		{
+			WriteOldest();
+			m_Failed = !m_Output.good();
+		}
+
+		// Keep the working set bounded however big the scene is
+		while (m_PendingBytes > MAX_PENDING_BYTES && m_Pending.size() > 1u && !m_Failed)
+		{
+			WriteOldest();
+			m_Failed = !m_Output.good();
+		}
+	}
+
+	bool SceneFileWriter::IsReady(const Pending& pending)
+	{
+		return !pending.Job.valid() || pending.Job.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+
+	void SceneFileWriter::Compress(PendingChunk& chunk)
+	{
+		const auto size = static_cast<size_t>(chunk.Entry.Size);
+		const auto& options = chunk.Options;
+
+		// Filtered into a buffer of its own, the source belongs to the caller
+		const uint8_t* source = chunk.Data;
+		std::vector<uint8_t> filtered;
+		SceneFilter filter = SceneFilter::None;
+		if (options.Codec != SceneCompression::None && options.Filter != SceneFilter::None && chunk.Entry.ElementSize > 1u && size > 0u)
+		{
+			filtered.resize(size);
+			SceneCodec::Filter(options.Filter, chunk.Entry.ElementSize, chunk.Data, filtered.data(), size);
+			source = filtered.data();
+			filter = options.Filter;
+		}
+
+		// Not worth a decompress on load if it barely shrank, cooked textures mostly land here
+		const bool bCompressed = options.Codec != SceneCompression::None && size > 0u &&
+			SceneCodec::Compress(options.Codec, options.Level, source, size, size - size / 8u, chunk.Stored);
+
+		if (!bCompressed)
+		{
+			chunk.Stored.clear();
+			chunk.Entry.Compression = SceneCompression::None;
+			chunk.Entry.Filter = SceneFilter::None;
+			chunk.Entry.StoredSize = size;
+			chunk.Entry.Checksum = Hash::Bytes(chunk.Data, size);
+		}
+		else
+		{
+			chunk.Entry.Compression = options.Codec;
+			chunk.Entry.Filter = filter;
+			chunk.Entry.StoredSize = chunk.Stored.size();
+			chunk.Entry.Checksum = Hash::Bytes(chunk.Stored.data(), chunk.Stored.size());
+		}
+	}
+
+	void SceneFileWriter::WriteOldest()
+	{
+		auto pending = std::move(m_Pending.front());
+		m_Pending.pop_front();
+		if (pending.Job.valid())
+		{
+			pending.Job.get();
+		}
+
+		auto& chunk = *pending.Chunk;
+		chunk.Entry.Offset = m_Offset;
+
+		// Raw chunks go straight from the source memory
+		const char* stored = chunk.Entry.Compression == SceneCompression::None ? reinterpret_cast<const char*>(chunk.Data) : chunk.Stored.data();
+		m_Output.write(stored, static_cast<std::streamsize>(chunk.Entry.StoredSize));
+		m_Offset += chunk.Entry.StoredSize;
+		Pad();
+
+		m_Table.push_back(chunk.Entry);
+		m_PendingBytes -= static_cast<size_t>(chunk.Entry.Size);
+
+		// Let the source go now rather than when the writer does
+		chunk.Owner.reset();
+		m_FreeBuffers.push_back(std::move(chunk.Stored));
+	}
+
+	void SceneFileWriter::Pad()
+	{
+		static const char padding[SceneFile::CHUNK_ALIGNMENT] = {};
+		const auto gap = SceneFile::Align(m_Offset) - m_Offset;
+		m_Output.write(padding, static_cast<std::streamsize>(gap));
+		m_Offset += gap;
+	}
+
+	bool SceneFileWriter::Finish()
+	{
+		while (!m_Pending.empty() && !m_Failed)
+		{
+			WriteOldest();
+			m_Failed = !m_Output.good();
+		}
+
+		if (m_Failed)
+		{
+			m_Pending.clear();
+			return false;
+		}
+
+		SceneFile::Header header = {};
+		memcpy(header.Magic, SceneFile::MAGIC, sizeof(SceneFile::MAGIC));
+		header.Version = SceneFile::FORMAT_VERSION;
+		header.ChunkCount = static_cast<uint32_t>(m_Table.size());
+		header.EntrySize = sizeof(SceneChunkEntry);
+		header.TableOffset = m_Offset;
+
+		m_Output.write(reinterpret_cast<const char*>(m_Table.data()), static_cast<std::streamsize>(m_Table.size() * sizeof(SceneChunkEntry)));
+		m_Output.seekp(0);
+		m_Output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		m_Output.close();
+
+		std::error_code error;
+		if (m_Output.fail())
+		{
+			VEL_CORE_ERROR("Failed to write scene {0}!", m_Filepath);
+			std::filesystem::remove(m_TempPath, error);
+			return false;
+		}
+
+		std::filesystem::rename(m_TempPath, m_Filepath, error);
+		if (error)
+		{
+			VEL_CORE_ERROR("Failed to replace scene {0}: {1}", m_Filepath, error.message());
+			std::filesystem::remove(m_TempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	bool SceneFileReader::Open(const std::string& filepath)
+	{
+		m_Chunks.clear();
+		m_Version = 0u;
+		m_Legacy = false;
+
+		if (!m_File.Open(filepath))
+		{
+			VEL_CORE_ERROR("Failed to open scene {0}!", filepath);
+			return false;
+		}
+
+		SceneFile::Header header = {};
+		if (m_File.GetSize() < sizeof(header) || memcmp(m_File.GetData(), SceneFile::MAGIC, sizeof(SceneFile::MAGIC)) != 0)
+		{
+			m_Legacy = true;
+			return false;
+		}
+		memcpy(&header, m_File.GetData(), sizeof(header));
+
+		if (header.Version < SceneFile::MIN_VERSION || header.Version > SceneFile::FORMAT_VERSION)
+		{
+			VEL_CORE_ERROR("Scene {0} is version {1}, this build reads {2} to {3}", filepath, header.Version, SceneFile::MIN_VERSION, SceneFile::FORMAT_VERSION);
+			return false;
+		}
+
+		const bool bFiltered = header.Version >= SceneFile::FILTER_VERSION;
+		const size_t entrySize = bFiltered ? sizeof(SceneChunkEntry) : sizeof(SceneChunkEntryV1);
+		const uint64_t tableSize = static_cast<uint64_t>(header.ChunkCount) * entrySize;
+		if (header.EntrySize != entrySize || header.TableOffset > m_File.GetSize() || tableSize > m_File.GetSize() - header.TableOffset)
+		{
+			VEL_CORE_ERROR("Scene {0} is truncated!", filepath);
+			return false;
+		}
+
+		m_Chunks.resize(header.ChunkCount);
+		if (bFiltered)
+		{
+			memcpy(m_Chunks.data(), m_File.GetData() + header.TableOffset, static_cast<size_t>(tableSize));
+		}
+		else
+		{
+			// Older entries are widened, nothing in them was filtered
+			const uint8_t* table = m_File.GetData() + header.TableOffset;
+			for (size_t i = 0; i < m_Chunks.size(); ++i)
+			{
+				SceneChunkEntryV1 old;
+				memcpy(&old, table + i * sizeof(old), sizeof(old));
+				m_Chunks[i] = { old.Type, old.Compression, SceneFilter::None, 0u, old.Offset, old.StoredSize, old.Size, old.Checksum };
+			}
+		}
+
+		// Check every chunk sits inside the file before anything reads one
+		for (const auto& entry : m_Chunks)
+		{
+			if (entry.Offset > header.TableOffset || entry.StoredSize > header.TableOffset - entry.Offset ||
+				(entry.Compression == SceneCompression::None && entry.StoredSize != entry.Size) ||
+				entry.Compression > SceneCompression::Deflate || entry.Filter > SceneFilter::ShuffleDelta ||
+				(entry.Filter != SceneFilter::None && (entry.Compression == SceneCompression::None || entry.ElementSize < 2u)))
+			{
+				VEL_CORE_ERROR("Scene {0} has a corrupt table of contents!", filepath);
+				m_Chunks.clear();
+				return false;
+			}
+		}
+
+		m_Version = header.Version;
+		return true;
+	}
+
+	std::vector<const SceneChunkEntry*> SceneFileReader::Find(SceneChunk type) const
+	{
+		std::vector<const SceneChunkEntry*> results;
+		for (const auto& entry : m_Chunks)
+		{
+			if (entry.Type == type)
+			{
+				results.push_back(&entry);
+			}
+		}
+		return results;
+	}
+
+	const SceneChunkEntry* SceneFileReader::FindFirst(SceneChunk type) const
+	{
+		for (const auto& entry : m_Chunks)
+		{
+			if (entry.Type == type)
+			{
+				return &entry;
+			}
+		}
+		return nullptr;
+	}
+
+	bool SceneFileReader::Read(const SceneChunkEntry& entry, void* destination) const
+	{
+		const auto* stored = m_File.GetData() + entry.Offset;
+		if (Hash::Bytes(stored, static_cast<size_t>(entry.StoredSize)) != entry.Checksum)
+		{
+			VEL_CORE_WARN("Scene chunk at {0} failed its checksum", entry.Offset);
+			return false;
+		}
+
+		if (!SceneCodec::IsAvailable(entry.Compression))
+		{
+			VEL_CORE_WARN("Scene chunk at {0} uses {1} compression, which isnt available in this build", entry.Offset, SceneCodec::GetName(entry.Compression));
+			return false;
+		}
+
+		// Filtered chunks decompress to the side and unfilter into place
+		const auto size = static_cast<size_t>(entry.Size);
+		std::vector<uint8_t> filtered;
+		auto* output = static_cast<uint8_t*>(destination);
+		if (entry.Filter != SceneFilter::None)
+		{
+			filtered.resize(size);
+			output = filtered.data();
+		}
+
+		if (!SceneCodec::Decompress(entry.Compression, stored, static_cast<size_t>(entry.StoredSize), output, size))
+		{
+			VEL_CORE_WARN("Scene chunk at {0} doesnt match its table entry", entry.Offset);
+			return false;
+		}
+
+		if (entry.Filter != SceneFilter::None)
+		{
+			SceneCodec::Unfilter(entry.Filter, entry.ElementSize, filtered.data(), static_cast<uint8_t*>(destination), size);
+		}
+		return true;
+	}
+
+	const uint8_t* SceneFileReader::GetDirect(const SceneChunkEntry& entry) const
+	{
+		if (entry.Compression != SceneCompression::None)
+		{
+			return nullptr;
+		}
+
+		const auto* stored = m_File.GetData() + entry.Offset;
+		if (Hash::Bytes(stored, static_cast<size_t>(entry.StoredSize)) != entry.Checksum)
+		{
+			VEL_CORE_WARN("Scene chunk at {0} failed its checksum", entry.Offset);
+			return nullptr;
+		}
+		return stored;
+	}
+}
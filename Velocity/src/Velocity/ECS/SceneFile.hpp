@@ -0,0 +1,258 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <Velocity/Utility/MappedFile.hpp>
+
+namespace Velocity
+{
+	// What a chunk of a scene file holds. Chunks of the same type are kept in the order they were added
+	enum class SceneChunk : uint32_t
+	{
+		Scene,			// Name, camera, texture table and skybox size
+		Registry,		// entt snapshot
+		Renderables,	// Mesh ranges with their clusters and bounds
+		Vertices,
+		Indices,
+		Meshlets,
+		Texture,		// Raw RGBA8 pixels or a whole cooked file, one per texture
+		Materials,
+		SkyboxFace		// Raw RGBA8 pixels, six in face order
+	};
+
+	// How a chunk is stored. Chunks that dont shrink enough are stored as they are and can be used in place
+	enum class SceneCompression : uint32_t
+	{
+		None,
+		Snappy,		// Fast, for autosaves and everyday saves
+		Deflate		// zlib, slower but smaller, for archiving
+	};
+
+	// Rearranges a chunk of fixed size elements before compression so similar bytes sit together, see SceneCodec
+	// Only applied to compressed chunks, raw chunks are always stored as they are
+	enum class SceneFilter : uint32_t
+	{
+		None,
+		Shuffle,		// Byte planes, byte 0 of every element then byte 1 and so on. Suits floats
+		ShuffleDelta	// Byte planes stored as the difference to the previous byte. Suits pixels and indices
+	};
+
+	// One entry in the table of contents
+	struct SceneChunkEntry
+	{
+		SceneChunk			Type = SceneChunk::Scene;
+		SceneCompression	Compression = SceneCompression::None;
+		SceneFilter			Filter = SceneFilter::None;
+		uint32_t			ElementSize = 0u;	// Size of one element in the chunk, 0 if it isnt an array of them
+		uint64_t			Offset = 0u;		// From the start of the file, always CHUNK_ALIGNMENT aligned
+		uint64_t			StoredSize = 0u;
+		uint64_t			Size = 0u;			// Once decompressed
+		uint64_t			Checksum = 0u;		// Of the stored bytes
+	};
+
+	// Layout shared by the reader and the writer
+	// Header, then every chunk on its own page, then the table of contents. The header points at the table
+	class SceneFile
+	{
+	public:
+		// Bump whenever the header, the table or any chunk layout changes, and keep reading the old one
+		static constexpr uint32_t FORMAT_VERSION = 5u;
+
+		// Oldest version that can still be read
+		static constexpr uint32_t MIN_VERSION = 1u;
+
+		// Versions the layout changed at. Older files are read the way they were written
+		static constexpr uint32_t BLOCKS_VERSION = 2u;		// Components as blocks rather than entt's snapshot, with a bulk layout
+		static constexpr uint32_t SECTIONS_VERSION = 3u;	// Components in sections with their own versions, materials carry theirs and the bulk layout lost its version
+		static constexpr uint32_t FILTER_VERSION = 4u;		// Table entries record a filter and element size
+		static constexpr uint32_t ASSET_STORE_VERSION = 5u;	// Meshes, textures and the skybox may be in the AssetStore, the texture table carries their keys
+
+		// Page aligned so any chunk can be mapped or used straight from the mapping
+		static constexpr uint64_t CHUNK_ALIGNMENT = 4096u;
+
+		struct Header
+		{
+			char		Magic[4];
+			uint32_t	Version;
+			uint32_t	ChunkCount;
+			uint32_t	EntrySize;
+			uint64_t	TableOffset;
+		};
+
+		static const char MAGIC[4];
+
+		static uint64_t Align(uint64_t offset) { return (offset + CHUNK_ALIGNMENT - 1u) & ~(CHUNK_ALIGNMENT - 1u); }
+	};
+
+	// How one class of chunk is stored
+	struct SceneChunkOptions
+	{
+		SceneCompression	Codec = SceneCompression::Snappy;
+		int					Level = 0;		// Codec specific, 0 uses the codec's default. Snappy has no levels
+		SceneFilter			Filter = SceneFilter::None;
+	};
+
+	// Storage for each class of chunk, picked per save
+	struct SceneSaveOptions
+	{
+		SceneChunkOptions	Data = { SceneCompression::Snappy, 0, SceneFilter::None };			// Archives and cooked textures
+		SceneChunkOptions	Geometry = { SceneCompression::Snappy, 0, SceneFilter::Shuffle };		// Vertices, indices and meshlets
+		SceneChunkOptions	Pixels = { SceneCompression::Snappy, 0, SceneFilter::ShuffleDelta };	// Raw textures and skybox faces
+
+		const SceneChunkOptions& Get(SceneChunk type) const
+		{
+			switch (type)
+			{
+			case SceneChunk::Vertices:
+			case SceneChunk::Indices:
+			case SceneChunk::Meshlets:
+				return Geometry;
+			case SceneChunk::Texture:
+			case SceneChunk::SkyboxFace:
+				return Pixels;
+			default:
+				return Data;
+			}
+		}
+
+		// Same storage for every chunk
+		static SceneSaveOptions Uniform(SceneCompression codec, int level, bool bFilter)
+		{
+			SceneSaveOptions options;
+			options.Data = { codec, level, SceneFilter::None };
+			options.Geometry = { codec, level, bFilter ? SceneFilter::Shuffle : SceneFilter::None };
+			options.Pixels = { codec, level, bFilter ? SceneFilter::ShuffleDelta : SceneFilter::None };
+			return options;
+		}
+
+		// As quick as possible, for autosaves
+		static SceneSaveOptions Fast() { return Uniform(SceneCompression::Snappy, 0, false); }
+
+		// As small as possible, for scenes that are being put away
+		static SceneSaveOptions Archive() { return Uniform(SceneCompression::Deflate, 9, true); }
+	};
+
+	// Streams a scene file out chunk by chunk
+	// Chunks are compressed in parallel on the pool and written in the order they were added as soon as they are ready
+	// Only MAX_PENDING_BYTES of source data is held at once, adding more waits for the oldest to reach the disk
+	class SceneFileWriter
+	{
+	public:
+		SceneFileWriter() = default;
+		~SceneFileWriter();
+
+		SceneFileWriter(const SceneFileWriter&) = delete;
+		SceneFileWriter& operator=(const SceneFileWriter&) = delete;
+
+		// Writes to a temporary file next to filepath, which only replaces it once Finish succeeds
+		// Codecs that werent built in fall back to snappy
+		bool Begin(const std::string& filepath, const SceneSaveOptions& options = {});
+
+		// Queues a chunk that points into memory owner keeps alive until the chunk is on disk
+		// elementSize is the size of one element of an array, chunks are only filtered if it is more than a byte
+		void AddChunk(SceneChunk type, std::shared_ptr<const void> owner, const void* data, size_t size, uint32_t elementSize = 0u);
+
+		// Takes over a container of plain data, moved in so nothing is copied
+		template<typename Container>
+		void AddChunk(SceneChunk type, Container&& data, uint32_t elementSize = 0u)
+		{
+			static_assert(!std::is_lvalue_reference<Container>::value, "Move the data in, chunks keep it until written");
+			auto owned = std::make_shared<Container>(std::move(data));
+			AddChunk(type, owned, owned->data(), owned->size() * sizeof(typename Container::value_type), elementSize);
+		}
+
+		// Writes everything still pending and the table of contents then swaps the file in
+		bool Finish();
+
+	private:
+		// Source bytes held before AddChunk starts waiting on the disk
+		static constexpr size_t MAX_PENDING_BYTES = 256u * 1024u * 1024u;
+
+		struct PendingChunk
+		{
+			SceneChunkEntry			Entry;
+			SceneChunkOptions		Options;
+			std::shared_ptr<const void>	Owner;
+			const uint8_t*			Data = nullptr;
+			std::string				Stored;		// Compressed bytes, unused when stored as it is
+		};
+
+		struct Pending
+		{
+			std::shared_ptr<PendingChunk>	Chunk;
+			std::future<void>				Job;
+		};
+
+		// Filters and compresses, or falls back to raw storage, and checksums the result. Runs on a worker
+		static void Compress(PendingChunk& chunk);
+
+		// True once the chunk is compressed, or was compressed inline
+		static bool IsReady(const Pending& pending);
+
+		// Waits for the oldest chunk and writes it out
+		void WriteOldest();
+
+		// Zeros up to the next chunk boundary
+		void Pad();
+
+		std::string							m_Filepath;
+		std::string							m_TempPath;
+		std::ofstream						m_Output;
+		uint64_t							m_Offset = 0u;
+		bool								m_Failed = false;
+		SceneSaveOptions					m_Options;
+
+		std::deque<Pending>					m_Pending;
+		size_t								m_PendingBytes = 0u;
+
+		// Compression buffers are handed back once written so their memory is reused
+		std::vector<std::string>			m_FreeBuffers;
+
+		std::vector<SceneChunkEntry>		m_Table;
+	};
+
+	// Maps a scene file and reads chunks out of it on demand
+	// Reads are const and touch nothing but the mapping and the destination so chunks can be read from any thread
+	class SceneFileReader
+	{
+	public:
+		// Returns false if the file is missing, corrupt or not a chunked scene. See IsLegacy for the last one
+		bool Open(const std::string& filepath);
+
+		// The file exists but predates the chunked format, one snappy blob of the whole scene
+		bool IsLegacy() const { return m_Legacy; }
+
+		// What the file was written as, chunk layouts differ before SceneFile::FORMAT_VERSION
+		uint32_t GetVersion() const { return m_Version; }
+
+		// The mapped file, for legacy loading
+		const MappedFile& GetFile() const { return m_File; }
+
+		const std::vector<SceneChunkEntry>& GetChunks() const { return m_Chunks; }
+
+		// Every chunk of a type, in file order
+		std::vector<const SceneChunkEntry*> Find(SceneChunk type) const;
+
+		// First chunk of a type or nullptr
+		const SceneChunkEntry* FindFirst(SceneChunk type) const;
+
+		// Decompresses and unfilters a chunk into destination, which has to hold entry.Size bytes
+		bool Read(const SceneChunkEntry& entry, void* destination) const;
+
+		// Points at the chunk in the mapping if it is stored uncompressed, nullptr otherwise
+		const uint8_t* GetDirect(const SceneChunkEntry& entry) const;
+
+	private:
+		MappedFile						m_File;
+		std::vector<SceneChunkEntry>	m_Chunks;
+		uint32_t						m_Version = 0u;
+		bool							m_Legacy = false;
+	};
+}
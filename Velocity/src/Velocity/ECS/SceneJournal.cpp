@@ -0,0 +1,285 @@
+#include "velpch.h"
+
+#include "SceneJournal.hpp"
+#include "SceneCodec.hpp"
+
+#include <filesystem>
+#include <sstream>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/MappedFile.hpp>
+
+namespace Velocity
+{
+	const char SceneJournal::MAGIC[4] = { 'V','J','R','N' };
+
+	namespace
+	{
+		// Entity lists go as one block, entities are plain integers
+		void WriteEntities(cereal::BinaryOutputArchive& ar, const std::vector<entt::entity>& entities)
+		{
+			ar(static_cast<uint64_t>(entities.size()));
+			ar(cereal::binary_data(entities.data(), entities.size() * sizeof(entt::entity)));
+		}
+
+		void ReadEntities(cereal::BinaryInputArchive& ar, std::vector<entt::entity>& entities)
+		{
+			uint64_t count = 0u;
+			ar(count);
+			entities.resize(static_cast<size_t>(count));
+			ar(cereal::binary_data(entities.data(), entities.size() * sizeof(entt::entity)));
+		}
+
+		// Destroyed, then removals keyed by component id, then changes as component sections
+		// Sections are the same as the registry chunk so component versions upgrade the same way
+		void WriteDelta(cereal::BinaryOutputArchive& ar, const SceneDelta& delta)
+		{
+			WriteEntities(ar, delta.Destroyed);
+
+			ar(static_cast<uint32_t>(SceneComponents::SIZE));
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				ar(ComponentSerialiser::GetID<Component>());
+				WriteEntities(ar, delta.Get<Component>().Removed);
+			});
+
+			ComponentSerialiser::WriteLayout(ar, static_cast<uint32_t>(SceneComponents::SIZE));
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				const auto& changes = delta.Get<Component>();
+				ComponentSerialiser::WriteSection(ar, changes.Entities, changes.Components);
+			});
+		}
+
+		void ReadDelta(cereal::BinaryInputArchive& ar, SceneDelta& delta)
+		{
+			ReadEntities(ar, delta.Destroyed);
+
+			uint32_t removedCount = 0u;
+			ar(removedCount);
+			for (uint32_t i = 0; i < removedCount; ++i)
+			{
+				uint64_t id = 0u;
+				std::vector<entt::entity> removed;
+				ar(id);
+				ReadEntities(ar, removed);
+
+				// Components that no longer exist have nothing left to remove
+				SceneComponents::ForEach([&](auto tag)
+				{
+					using Component = typename decltype(tag)::Type;
+					if (id == ComponentSerialiser::GetID<Component>())
+					{
+						delta.Get<Component>().Removed = std::move(removed);
+					}
+				});
+			}
+
+			const uint32_t sectionCount = ComponentSerialiser::ReadLayout(ar);
+			for (uint32_t i = 0; i < sectionCount; ++i)
+			{
+				ComponentSerialiser::ReadSection(ar, [&delta](auto tag, entt::entity entity, auto& component)
+				{
+					auto& changes = delta.Get<typename decltype(tag)::Type>();
+					changes.Entities.push_back(entity);
+					changes.Components.push_back(std::move(component));
+				});
+			}
+		}
+	}
+
+	bool SceneJournal::Begin(const std::string& filepath, uint64_t baseKey)
+	{
+		m_Output.close();
+		m_Output.clear();
+		m_Size = 0u;
+		m_RecordCount = 0u;
+
+		m_Output.open(filepath, std::ios::binary | std::ios::trunc);
+		if (!m_Output.is_open())
+		{
+			VEL_CORE_ERROR("Failed to create scene journal {0}!", filepath);
+			return false;
+		}
+
+		Header header;
+		memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+		header.Version = FORMAT_VERSION;
+		header.BaseKey = baseKey;
+		m_Output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		m_Output.flush();
+		m_Size = sizeof(header);
+		return m_Output.good();
+	}
+
+	bool SceneJournal::Append(const SceneDelta& delta)
+	{
+		if (!m_Output.is_open())
+		{
+			return false;
+		}
+
+		std::ostringstream stream;
+		{
+			cereal::BinaryOutputArchive archive(stream);
+			WriteDelta(archive, delta);
+		}
+		const auto payload = stream.str();
+
+		// Deltas are small and written often, snappy is all they need
+		RecordHeader record;
+		record.Size = payload.size();
+		std::string compressed;
+		const std::string* stored = &payload;
+		if (SceneCodec::Compress(SceneCompression::Snappy, 0, reinterpret_cast<const uint8_t*>(payload.data()), payload.size(),
+			payload.size() - payload.size() / 8u, compressed))
+		{
+			record.Compression = SceneCompression::Snappy;
+			stored = &compressed;
+		}
+		record.StoredSize = stored->size();
+		record.Checksum = Hash::Bytes(stored->data(), stored->size());
+
+		// Flushed per record so a crash loses at most the one being written
+		m_Output.write(reinterpret_cast<const char*>(&record), sizeof(record));
+		m_Output.write(stored->data(), static_cast<std::streamsize>(stored->size()));
+		m_Output.flush();
+		if (!m_Output.good())
+		{
+			VEL_CORE_ERROR("Failed to append to scene journal!");
+			return false;
+		}
+
+		m_Size += sizeof(record) + stored->size();
+		++m_RecordCount;
+		return true;
+	}
+
+	uint64_t SceneJournal::GetBaseKey(const SceneFileReader& file)
+	{
+		// The checksums cover every stored byte, so hashing the table is enough
+		const auto& chunks = file.GetChunks();
+		return Hash::Bytes(chunks.data(), chunks.size() * sizeof(SceneChunkEntry), file.GetVersion());
+	}
+
+	bool SceneJournal::Replay(const std::string& filepath, uint64_t baseKey, const std::function<void(SceneDelta&)>& apply)
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(filepath, error))
+		{
+			return false;
+		}
+
+		MappedFile file;
+		if (!file.Open(filepath) || file.GetSize() < sizeof(Header))
+		{
+			return false;
+		}
+
+		Header header;
+		memcpy(&header, file.GetData(), sizeof(header));
+		if (memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != FORMAT_VERSION)
+		{
+			VEL_CORE_WARN("Ignoring scene journal {0}, it is from another version", filepath);
+			return false;
+		}
+		if (header.BaseKey != baseKey)
+		{
+			VEL_CORE_WARN("Ignoring scene journal {0}, the scene was saved since", filepath);
+			return false;
+		}
+
+		const auto* data = file.GetData();
+		const uint64_t size = file.GetSize();
+		uint64_t offset = sizeof(header);
+		uint32_t replayed = 0u;
+		std::vector<uint8_t> decompressed;
+		while (offset + sizeof(RecordHeader) <= size)
+		{
+			RecordHeader record;
+			memcpy(&record, data + offset, sizeof(record));
+			offset += sizeof(record);
+
+			// Everything after a torn or corrupt record is dropped, it was written against state that never made it
+			const auto* stored = data + offset;
+			if (record.StoredSize > size - offset || Hash::Bytes(stored, static_cast<size_t>(record.StoredSize)) != record.Checksum)
+			{
+				VEL_CORE_WARN("Scene journal {0} is cut short after {1} records", filepath, replayed);
+				break;
+			}
+			offset += record.StoredSize;
+
+			const uint8_t* payload = stored;
+			if (record.Compression != SceneCompression::None)
+			{
+				decompressed.resize(static_cast<size_t>(record.Size));
+				if (!SceneCodec::Decompress(record.Compression, stored, static_cast<size_t>(record.StoredSize), decompressed.data(), decompressed.size()))
+				{
+					VEL_CORE_WARN("Scene journal {0} is cut short after {1} records", filepath, replayed);
+					break;
+				}
+				payload = decompressed.data();
+			}
+
+			SceneDelta delta;
+			try
+			{
+				std::istringstream stream(std::string(reinterpret_cast<const char*>(payload), static_cast<size_t>(record.Size)));
+				cereal::BinaryInputArchive archive(stream);
+				ReadDelta(archive, delta);
+			}
+			catch (const cereal::Exception& exception)
+			{
+				VEL_CORE_WARN("Scene journal {0} has an unreadable record: {1}", filepath, exception.what());
+				break;
+			}
+
+			apply(delta);
+			++replayed;
+		}
+
+		if (replayed > 0u)
+		{
+			VEL_CORE_INFO("Replayed {0} changes from {1}", replayed, filepath);
+		}
+		return true;
+	}
+
+	void SceneJournal::Apply(entt::registry& registry, SceneDelta& delta)
+	{
+		for (auto entity : delta.Destroyed)
+		{
+			if (registry.valid(entity))
+			{
+				registry.destroy(entity);
+			}
+		}
+
+		SceneComponents::ForEach([&](auto tag)
+		{
+			using Component = typename decltype(tag)::Type;
+			auto& changes = delta.Get<Component>();
+
+			for (auto entity : changes.Removed)
+			{
+				if (registry.valid(entity) && registry.has<Component>(entity))
+				{
+					registry.remove<Component>(entity);
+				}
+			}
+
+			for (size_t i = 0; i < changes.Entities.size(); ++i)
+			{
+				auto entity = changes.Entities[i];
+				if (!registry.valid(entity))
+				{
+					entity = registry.create(entity);
+				}
+				registry.emplace_or_replace<Component>(entity, std::move(changes.Components[i]));
+			}
+		});
+	}
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include "ComponentRegistry.hpp"
+#include "SceneFile.hpp"
+
+namespace Velocity
+{
+	// What happened to one component type between two snapshots
+	template<typename Component>
+	struct ComponentChanges
+	{
+		// Added or changed, with their value at the snapshot
+		std::vector<entt::entity>	Entities;
+		std::vector<Component>		Components;
+
+		// Removed from entities that are still alive
+		std::vector<entt::entity>	Removed;
+	};
+
+	template<typename... Components>
+	struct SceneDeltaOf
+	{
+		std::tuple<ComponentChanges<Components>...>	Changes;
+
+		// Entities destroyed outright, played back before any change
+		std::vector<entt::entity>					Destroyed;
+
+		template<typename Component>
+		ComponentChanges<Component>& Get() { return std::get<ComponentChanges<Component>>(Changes); }
+
+		template<typename Component>
+		const ComponentChanges<Component>& Get() const { return std::get<ComponentChanges<Component>>(Changes); }
+
+		bool IsEmpty() const
+		{
+			return Destroyed.empty() && (... && (Get<Components>().Entities.empty() && Get<Components>().Removed.empty()));
+		}
+	};
+
+	// Every change to a scene's registry between two snapshots, see Scene::TakeDelta
+	using SceneDelta = SceneComponents::Apply<SceneDeltaOf>;
+
+	// Append only log of deltas against a full save, so an autosave only writes what changed
+	// Each record is checksummed and flushed on its own. A record torn by a crash fails its checksum on replay and
+	// is dropped along with anything after it
+	class SceneJournal
+	{
+	public:
+		SceneJournal() = default;
+
+		SceneJournal(const SceneJournal&) = delete;
+		SceneJournal& operator=(const SceneJournal&) = delete;
+
+		// Starts a new journal against the full save baseKey identifies, replacing any journal at filepath
+		bool Begin(const std::string& filepath, uint64_t baseKey);
+
+		// Serialises and appends one delta
+		bool Append(const SceneDelta& delta);
+
+		// Bytes and records written since Begin
+		uint64_t GetSize() const { return m_Size; }
+		uint32_t GetRecordCount() const { return m_RecordCount; }
+
+		// Identifies a full save so a journal is never played over a different one
+		static uint64_t GetBaseKey(const SceneFileReader& file);
+
+		// The journal that goes with a scene file
+		static std::string GetPath(const std::string& scenePath) { return scenePath + ".journal"; }
+
+		// Hands every intact record of the journal at filepath to apply in order
+		// Returns false if there is no journal for this base
+		static bool Replay(const std::string& filepath, uint64_t baseKey, const std::function<void(SceneDelta&)>& apply);
+
+		// Plays a delta onto a registry, recreating entities under their saved ids
+		static void Apply(entt::registry& registry, SceneDelta& delta);
+
+	private:
+		// Bump whenever the header, the record layout or the delta archive changes
+		static constexpr uint32_t FORMAT_VERSION = 1u;
+
+		static const char MAGIC[4];
+
+		struct Header
+		{
+			char		Magic[4];
+			uint32_t	Version;
+			uint64_t	BaseKey;
+		};
+
+		struct RecordHeader
+		{
+			uint64_t			StoredSize = 0u;
+			uint64_t			Size = 0u;
+			uint64_t			Checksum = 0u;		// Of the stored bytes
+			SceneCompression	Compression = SceneCompression::None;
+			uint32_t			Padding = 0u;
+		};
+
+		std::ofstream	m_Output;
+		uint64_t		m_Size = 0u;
+		uint32_t		m_RecordCount = 0u;
+	};
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include <Velocity/Renderer/BufferManager.hpp>
+
+#include "BulkSerialisation.hpp"
+
+// What the archived chunks of a scene file hold, shared by saving and loading
+
+namespace Velocity
+{
+	// A texture in the scene chunk's table. Its pixels or cooked file are in the asset store under Asset,
+	// or in the matching Texture chunk of the scene file if Asset is 0
+	struct SceneTexture
+	{
+		std::string	ReferenceName;
+		uint32_t	Width = 0u;
+		uint32_t	Height = 0u;
+		bool		Cooked = false;
+		uint64_t	Asset = 0u;
+
+		template<class Archive>
+		void serialize(Archive& ar)
+		{
+			ar(ReferenceName, Width, Height, Cooked, Asset);
+		}
+	};
+
+	// A texture in the scene chunk's table before the asset store, always in the scene file's texture chunks
+	struct EmbeddedSceneTexture
+	{
+		std::string	ReferenceName;
+		uint32_t	Width = 0u;
+		uint32_t	Height = 0u;
+		bool		Cooked = false;
+
+		template<class Archive>
+		void serialize(Archive& ar)
+		{
+			ar(ReferenceName, Width, Height, Cooked);
+		}
+	};
+
+	// A renderable with its clusters and bounds, so nothing is rebuilt from the geometry on load
+	struct SceneMesh
+	{
+		std::string					Name;
+		BufferManager::MeshIndexer	Indexer;
+
+		template<class Archive>
+		void serialize(Archive& ar)
+		{
+			ar(Name, BulkData(Indexer));
+		}
+	};
+
+	// A renderable as scenes from before the chunked format saved it, only the ranges
+	// Clusters and bounds are rebuilt from the geometry once it is loaded
+	struct LegacyMeshRange
+	{
+		uint32_t	VertexOffset = 0u;
+		uint32_t	VertexCount = 0u;
+		uint32_t	IndexStart = 0u;
+		uint32_t	IndexCount = 0u;
+
+		template<class Archive>
+		void serialize(Archive& ar)
+		{
+			ar(VertexOffset, VertexCount, IndexStart, IndexCount);
+		}
+	};
+
+	// A material as scenes from before packed material textures saved it, with a texture per map
+	// Ids are albedo, normal, height, metallic and roughness. Height is -1 when the material has none
+	struct LegacyMaterial
+	{
+		std::string				MaterialName;
+		std::array<int32_t, 5>	TextureIDs = { 0,0,0,0,0 };
+
+		template<class Archive>
+		void serialize(Archive& ar)
+		{
+			ar(MaterialName, TextureIDs);
+		}
+	};
+}
@@ -0,0 +1,745 @@
+#include "velpch.h"
+
+#include "SceneLoad.hpp"
+
+#include <cstdlib>
+#include <map>
+
+#include <cereal/types/unordered_map.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/memory.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "AssetStore.hpp"
+#include "Components.hpp"
+#include "Entity.hpp"
+#include "SceneArchive.hpp"
+#include "SceneJournal.hpp"
+#include "SceneLayout.hpp"
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Renderer/Renderer.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		// Where a chunk is read from, the scene file or an asset
+		struct ChunkSource
+		{
+			const SceneFileReader*	File = nullptr;
+			const SceneChunkEntry*	Entry = nullptr;
+		};
+
+		// nullptr if the chunk is corrupt
+		std::unique_ptr<CookedTexture> ReadCooked(const SceneFileReader& file, const SceneChunkEntry& entry)
+		{
+			// Cooked files are stored uncompressed so they deserialise straight out of the mapping
+			std::vector<uint8_t> buffer;
+			const uint8_t* bytes = file.GetDirect(entry);
+			if (!bytes)
+			{
+				buffer.resize(static_cast<size_t>(entry.Size));
+				bytes = file.Read(entry, buffer.data()) ? buffer.data() : nullptr;
+			}
+
+			auto cooked = std::make_unique<CookedTexture>();
+			if (!bytes || !CookedTexture::Deserialise(bytes, static_cast<size_t>(entry.Size), *cooked))
+			{
+				cooked.reset();
+			}
+			return cooked;
+		}
+
+		bool IsRawSize(const SceneChunkEntry& entry, int width, int height)
+		{
+			return entry.Size > 0u && entry.Size == static_cast<uint64_t>(width) * height * 4u;
+		}
+
+		// Reads a texture chunk the way the renderer's queue wants it. Safe on any thread
+		DecodedImage ReadTexture(const SceneFileReader& file, const SceneChunkEntry& entry, bool bCooked, int width, int height)
+		{
+			DecodedImage image;
+			if (bCooked)
+			{
+				image.Cooked = ReadCooked(file, entry);
+			}
+			else if (IsRawSize(entry, width, height))
+			{
+				// Handed to stbi_image_free once uploaded, which is free
+				image.Pixels = static_cast<stbi_uc*>(malloc(static_cast<size_t>(entry.Size)));
+				if (image.Pixels && file.Read(entry, image.Pixels))
+				{
+					image.Width = width;
+					image.Height = height;
+				}
+				else
+				{
+					free(image.Release());
+				}
+			}
+			return image;
+		}
+
+		// The materials chunk, upgrading materials saved at an older component version the way sections do
+		void ReadMaterials(cereal::BinaryInputArchive& archive, uint32_t fileVersion, std::unordered_map<std::string, PBRComponent>& materials)
+		{
+			using Traits = ComponentTraits<PBRComponent>;
+			uint32_t materialVersion = 1u;
+			if (fileVersion >= SceneFile::SECTIONS_VERSION)
+			{
+				archive(materialVersion);
+			}
+
+			if (materialVersion == Traits::VERSION)
+			{
+				archive(materials);
+				return;
+			}
+
+			// Same layout as cereal's map, a size then each name and material
+			cereal::size_type count = 0u;
+			archive(cereal::make_size_tag(count));
+			for (cereal::size_type i = 0; i < count; ++i)
+			{
+				std::string name;
+				PBRComponent material;
+				archive(name);
+				if (!Traits::LoadVersion(archive, material, materialVersion))
+				{
+					throw cereal::Exception(std::string("No upgrade for saved ") + Traits::NAME + " components");
+				}
+				materials[name] = std::move(material);
+			}
+		}
+
+		// Keeps a slot lined up when its texture is lost
+		DecodedImage WhitePixel()
+		{
+			DecodedImage image;
+			image.Pixels = static_cast<stbi_uc*>(malloc(4u));
+			memset(image.Pixels, 255, 4u);
+			image.Width = 1;
+			image.Height = 1;
+			return image;
+		}
+	}
+
+	SceneLoad::SceneLoad(const std::string& sceneFilepath, bool bBlocking) :
+		m_Filepath(sceneFilepath),
+		m_Staged(std::make_unique<Staged>())
+	{
+		m_Read = ThreadPool::Get().Enqueue([this, bBlocking]() { return Read(bBlocking); });
+	}
+
+	SceneLoad::~SceneLoad()
+	{
+		m_bCancel = true;
+		if (m_Read.valid())
+		{
+			m_Read.wait();
+		}
+	}
+
+	Scene* SceneLoad::Update()
+	{
+		if (m_State == State::Reading)
+		{
+			if (m_Read.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				return nullptr;
+			}
+
+			const bool bRead = m_Read.get();
+			if (m_bCancel)
+			{
+				VEL_CORE_INFO("Cancelled loading {0}", m_Filepath);
+				m_State = State::Cancelled;
+				m_Staged.reset();
+				return nullptr;
+			}
+			if (!bRead)
+			{
+				VEL_CORE_ERROR("Failed to load scene {0}", m_Filepath);
+				m_State = State::Failed;
+				m_Staged.reset();
+				return nullptr;
+			}
+
+			return Swap();
+		}
+
+		if (m_State == State::Activating)
+		{
+			Activate(ACTIVATION_BATCH_SIZE);
+		}
+		return nullptr;
+	}
+
+	Scene* SceneLoad::Finish()
+	{
+		if (m_Read.valid())
+		{
+			m_Read.wait();
+		}
+
+		Scene* scene = Update();
+		while (m_State == State::Activating)
+		{
+			Activate(m_Pending.size());
+		}
+
+		// Textures the read left for the queue
+		Renderer::GetRenderer()->FlushTextureLoads();
+		return scene;
+	}
+
+	float SceneLoad::GetProgress() const
+	{
+		// Activation is cheap next to reading
+		static constexpr float READ_SHARE = 0.9f;
+		switch (m_State)
+		{
+		case State::Reading:
+		{
+			const uint64_t total = m_BytesTotal;
+			return total > 0u ? READ_SHARE * static_cast<float>(static_cast<double>(m_BytesRead) / total) : 0.0f;
+		}
+		case State::Activating:
+			return READ_SHARE + (1.0f - READ_SHARE) * (m_Pending.empty() ? 1.0f : static_cast<float>(m_Activated) / m_Pending.size());
+		default:
+			return 1.0f;
+		}
+	}
+
+	bool SceneLoad::ReadAssetKeys(const std::string& sceneFilepath, std::vector<uint64_t>& outKeys)
+	{
+		SceneFileReader file;
+		if (!file.Open(sceneFilepath))
+		{
+			return file.IsLegacy();
+		}
+
+		// Everything was in the file before the store
+		if (file.GetVersion() < SceneFile::ASSET_STORE_VERSION)
+		{
+			return true;
+		}
+
+		SceneHeader header;
+		if (!ReadHeader(file, header))
+		{
+			return false;
+		}
+
+		for (const auto& texture : header.TextureTable)
+		{
+			if (texture.Asset != 0u)
+			{
+				outKeys.push_back(texture.Asset);
+			}
+		}
+		if (header.SkyboxAsset != 0u)
+		{
+			outKeys.push_back(header.SkyboxAsset);
+		}
+		for (const auto& mesh : header.MeshAssets)
+		{
+			outKeys.push_back(mesh.Key);
+		}
+		return true;
+	}
+
+	bool SceneLoad::ReadHeader(const SceneFileReader& file, SceneHeader& outHeader)
+	{
+		const uint32_t version = file.GetVersion();
+		return SceneArchive::Read(file, SceneChunk::Scene, [&](cereal::BinaryInputArchive& archive)
+			{
+				archive(outHeader.Name, outHeader.SceneCamera);
+
+				// The first version had no layout and was only ever read on the machine that wrote it
+				if (version >= SceneFile::SECTIONS_VERSION)
+				{
+					archive(outHeader.Layout);
+				}
+				else if (version >= SceneFile::BLOCKS_VERSION)
+				{
+					outHeader.Layout.LoadVersioned(archive);
+				}
+				archive(outHeader.VertexSize);
+
+				// Before the store every texture and all the geometry was in the file
+				if (version >= SceneFile::ASSET_STORE_VERSION)
+				{
+					archive(outHeader.TextureTable, outHeader.SkyboxWidth, outHeader.SkyboxHeight, outHeader.SkyboxAsset, outHeader.bStoredGeometry, outHeader.MeshAssets);
+				}
+				else
+				{
+					std::vector<EmbeddedSceneTexture> embedded;
+					archive(embedded, outHeader.SkyboxWidth, outHeader.SkyboxHeight);
+					for (auto& texture : embedded)
+					{
+						outHeader.TextureTable.push_back({ std::move(texture.ReferenceName), texture.Width, texture.Height, texture.Cooked, 0u });
+					}
+				}
+			});
+	}
+
+	bool SceneLoad::Read(bool bDecodeTextures)
+	{
+		auto& staged = *m_Staged;
+
+		auto file = std::make_shared<SceneFileReader>();
+		staged.File = file;
+		if (!file->Open(m_Filepath))
+		{
+			// Scenes from before the chunked format load in one go when swapped in
+			staged.bLegacy = file->IsLegacy();
+			return staged.bLegacy;
+		}
+
+		const uint32_t version = file->GetVersion();
+		SceneHeader header;
+		if (!ReadHeader(*file, header))
+		{
+			return false;
+		}
+		staged.Name = std::move(header.Name);
+		staged.SceneCamera = std::move(header.SceneCamera);
+		staged.SkyboxWidth = header.SkyboxWidth;
+		staged.SkyboxHeight = header.SkyboxHeight;
+
+		// Geometry and renderables are raw bytes so need the same byte order and layouts
+		if (!header.Layout.IsCompatible() || header.VertexSize != sizeof(Vertex) || !staged.SceneCamera)
+		{
+			VEL_CORE_ERROR("Scene {0} doesnt match this build", staged.Name);
+			return false;
+		}
+
+		// Everything is found and sized up front so progress has a total
+		uint64_t totalBytes = 0u;
+		auto openAsset = [&staged](uint64_t key)
+		{
+			auto asset = AssetStore::Open(key);
+			if (asset)
+			{
+				staged.Assets.push_back(asset);
+			}
+			return asset;
+		};
+
+		// Textures in the store come from their asset, the rest from the scene's texture chunks in table order
+		const auto textureChunks = file->Find(SceneChunk::Texture);
+		staged.Textures.resize(header.TextureTable.size());
+		size_t embeddedTextures = 0u;
+		for (size_t i = 0; i < header.TextureTable.size(); ++i)
+		{
+			const auto& info = header.TextureTable[i];
+			auto& texture = staged.Textures[i];
+			texture.ReferenceName = info.ReferenceName;
+			texture.Width = static_cast<int>(info.Width);
+			texture.Height = static_cast<int>(info.Height);
+			texture.bCooked = info.Cooked;
+
+			if (info.Asset == 0u)
+			{
+				if (embeddedTextures < textureChunks.size())
+				{
+					texture.File = file;
+					texture.Entry = *textureChunks[embeddedTextures];
+				}
+				++embeddedTextures;
+			}
+			else if (auto asset = openAsset(info.Asset))
+			{
+				if (const auto* entry = asset->FindFirst(SceneChunk::Texture))
+				{
+					texture.File = asset;
+					texture.Entry = *entry;
+					staged.TextureAssets[info.ReferenceName] = info.Asset;
+				}
+			}
+
+			if (bDecodeTextures && texture.File)
+			{
+				totalBytes += texture.Entry.Size;
+			}
+		}
+		if (embeddedTextures != textureChunks.size())
+		{
+			VEL_CORE_ERROR("Scene {0} has the wrong number of textures", staged.Name);
+			return false;
+		}
+
+		// A skybox missing faces is dropped when swapped in rather than failing the scene
+		std::vector<ChunkSource> faceSources;
+		const SceneFileReader* faceFile = header.SkyboxAsset != 0u ? openAsset(header.SkyboxAsset).get() : file.get();
+		if (faceFile && staged.SkyboxWidth > 0u)
+		{
+			const auto faceChunks = faceFile->Find(SceneChunk::SkyboxFace);
+			if (faceChunks.size() == 6u)
+			{
+				for (const auto* entry : faceChunks)
+				{
+					faceSources.push_back({ faceFile, entry });
+					totalBytes += entry->Size;
+				}
+				staged.SkyboxAsset = header.SkyboxAsset;
+			}
+		}
+
+		// Each mesh asset lands at the offsets it was packed at when saved, which the renderables already point at
+		struct MeshSource
+		{
+			const SceneFileReader*	File = nullptr;
+			const SceneChunkEntry*	Vertices = nullptr;
+			const SceneChunkEntry*	Indices = nullptr;
+			const SceneChunkEntry*	Meshlets = nullptr;
+			size_t					VertexStart = 0u;
+			size_t					IndexStart = 0u;
+			size_t					MeshletStart = 0u;
+		};
+
+		std::vector<MeshSource> sources;
+		std::map<std::pair<size_t, size_t>, size_t> sourceByRange;
+		size_t vertexCount = 0u;
+		size_t indexCount = 0u;
+		size_t meshletCount = 0u;
+		if (header.bStoredGeometry)
+		{
+			sources.resize(header.MeshAssets.size());
+			for (size_t i = 0; i < header.MeshAssets.size(); ++i)
+			{
+				const auto& stored = header.MeshAssets[i];
+				auto& source = sources[i];
+				source.File = openAsset(stored.Key).get();
+				if (source.File)
+				{
+					source.Vertices = source.File->FindFirst(SceneChunk::Vertices);
+					source.Indices = source.File->FindFirst(SceneChunk::Indices);
+					source.Meshlets = source.File->FindFirst(SceneChunk::Meshlets);
+				}
+
+				if (!source.Vertices || !source.Indices || !source.Meshlets ||
+					source.Vertices->Size != stored.VertexCount * sizeof(Vertex) ||
+					source.Indices->Size != stored.IndexCount * sizeof(uint32_t) ||
+					source.Meshlets->Size != stored.MeshletCount * sizeof(Meshlet))
+				{
+					VEL_CORE_ERROR("Mesh asset {0} is missing or corrupt", Hash::ToString(stored.Key));
+					return false;
+				}
+
+				source.VertexStart = vertexCount;
+				source.IndexStart = indexCount;
+				source.MeshletStart = meshletCount;
+				sourceByRange[{ vertexCount, indexCount }] = i;
+				vertexCount += stored.VertexCount;
+				indexCount += stored.IndexCount;
+				meshletCount += stored.MeshletCount;
+				totalBytes += source.Vertices->Size + source.Indices->Size + source.Meshlets->Size;
+			}
+		}
+		else
+		{
+			// Packed scenes carry the whole heap as three chunks
+			sources.resize(1u);
+			auto& source = sources.front();
+			source.File = file.get();
+			source.Vertices = file->FindFirst(SceneChunk::Vertices);
+			source.Indices = file->FindFirst(SceneChunk::Indices);
+			source.Meshlets = file->FindFirst(SceneChunk::Meshlets);
+			if (!source.Vertices || !source.Indices || !source.Meshlets ||
+				source.Vertices->Size % sizeof(Vertex) != 0u || source.Indices->Size % sizeof(uint32_t) != 0u || source.Meshlets->Size % sizeof(Meshlet) != 0u)
+			{
+				return false;
+			}
+			vertexCount = static_cast<size_t>(source.Vertices->Size / sizeof(Vertex));
+			indexCount = static_cast<size_t>(source.Indices->Size / sizeof(uint32_t));
+			meshletCount = static_cast<size_t>(source.Meshlets->Size / sizeof(Meshlet));
+			totalBytes += source.Vertices->Size + source.Indices->Size + source.Meshlets->Size;
+		}
+
+		const auto* registryChunk = file->FindFirst(SceneChunk::Registry);
+		totalBytes += registryChunk ? registryChunk->Size : 0u;
+		m_BytesTotal = totalBytes;
+
+		// Loads entity data into the staging registry. Components skip the snapshot so plain ones load as blocks
+		if (m_bCancel || !SceneArchive::Read(*file, SceneChunk::Registry, [&staged, version](cereal::BinaryInputArchive& archive) { SceneArchive::ReadRegistry(archive, staged.Registry, version); }))
+		{
+			return false;
+		}
+		m_BytesRead += registryChunk->Size;
+
+		// Changes autosaved on top of the file since it was written. These leave the scene dirty
+		SceneJournal::Replay(SceneJournal::GetPath(m_Filepath), SceneJournal::GetBaseKey(*file), [&staged](SceneDelta& delta)
+		{
+			SceneJournal::Apply(staged.Registry, delta);
+			staged.bReplayedJournal = true;
+		});
+
+		std::vector<SceneMesh> meshes;
+		if (!SceneArchive::Read(*file, SceneChunk::Renderables, [&meshes](cereal::BinaryInputArchive& archive) { archive(meshes); }) ||
+			!SceneArchive::Read(*file, SceneChunk::Materials, [&staged, version](cereal::BinaryInputArchive& archive) { ReadMaterials(archive, version, staged.Materials); }))
+		{
+			return false;
+		}
+		for (const auto& mesh : meshes)
+		{
+			staged.Renderables[mesh.Name] = mesh.Indexer;
+
+			// Remember where each renderable came from so saving again skips it
+			auto source = sourceByRange.find({ mesh.Indexer.VertexOffset, mesh.Indexer.IndexStart });
+			if (header.bStoredGeometry && source != sourceByRange.end())
+			{
+				staged.MeshAssets[mesh.Name] = header.MeshAssets[source->second];
+			}
+		}
+
+		// Geometry, skybox faces and texture pixels all decompress side by side, each straight into where it is kept
+		staged.Vertices.resize(vertexCount);
+		staged.Indices.resize(indexCount);
+		staged.Meshlets.resize(meshletCount);
+		const size_t textureJobs = bDecodeTextures ? staged.Textures.size() : 0u;
+		std::atomic<bool> bRead = true;
+		ThreadPool::Get().ParallelFor(sources.size() + faceSources.size() + textureJobs, [&](size_t i)
+		{
+			if (m_bCancel || !bRead)
+			{
+				return;
+			}
+
+			if (i < sources.size())
+			{
+				const auto& source = sources[i];
+				auto* meshMeshlets = staged.Meshlets.data() + source.MeshletStart;
+				if (!source.File->Read(*source.Vertices, staged.Vertices.data() + source.VertexStart) ||
+					!source.File->Read(*source.Indices, staged.Indices.data() + source.IndexStart) ||
+					!source.File->Read(*source.Meshlets, meshMeshlets))
+				{
+					bRead = false;
+					return;
+				}
+
+				// Stored relative to the mesh's own indices. Packed scenes start at 0 so are unchanged
+				const auto meshletsInMesh = static_cast<size_t>(source.Meshlets->Size / sizeof(Meshlet));
+				for (size_t meshlet = 0; meshlet < meshletsInMesh; ++meshlet)
+				{
+					meshMeshlets[meshlet].IndexStart += static_cast<uint32_t>(source.IndexStart);
+				}
+				m_BytesRead += source.Vertices->Size + source.Indices->Size + source.Meshlets->Size;
+				return;
+			}
+
+			i -= sources.size();
+			if (i < faceSources.size())
+			{
+				const auto& source = faceSources[i];
+				if (source.Entry->Size == static_cast<uint64_t>(staged.SkyboxWidth) * staged.SkyboxHeight * 4u)
+				{
+					staged.SkyboxFaces[i] = std::unique_ptr<stbi_uc>(new stbi_uc[source.Entry->Size]);
+					if (!source.File->Read(*source.Entry, staged.SkyboxFaces[i].get()))
+					{
+						staged.SkyboxFaces[i].reset();
+					}
+				}
+				m_BytesRead += source.Entry->Size;
+				return;
+			}
+
+			i -= faceSources.size();
+			auto& texture = staged.Textures[i];
+			if (texture.File)
+			{
+				m_BytesRead += texture.Entry.Size;
+				if (texture.bCooked)
+				{
+					texture.CookedData = ReadCooked(*texture.File, texture.Entry);
+					if (texture.CookedData)
+					{
+						return;
+					}
+				}
+				else if (IsRawSize(texture.Entry, texture.Width, texture.Height))
+				{
+					texture.Pixels = std::unique_ptr<stbi_uc>(new stbi_uc[texture.Entry.Size]);
+					if (texture.File->Read(texture.Entry, texture.Pixels.get()))
+					{
+						return;
+					}
+					texture.Pixels.reset();
+				}
+			}
+
+			// Keep the slot with a white pixel so later indices still line up
+			VEL_CORE_ERROR("Scene has a corrupt texture: {0}", texture.ReferenceName);
+			texture.Pixels = std::unique_ptr<stbi_uc>(new stbi_uc[4]{ 255, 255, 255, 255 });
+			texture.Width = 1;
+			texture.Height = 1;
+		});
+
+		return bRead && !m_bCancel;
+	}
+
+	Scene* SceneLoad::Swap()
+	{
+		auto& renderer = Renderer::GetRenderer();
+		auto& staged = *m_Staged;
+
+		// The old scene stops here
+		renderer->m_LogicalDevice->waitIdle();
+		auto* scene = new Scene();
+		r_Scene = scene;
+
+		if (staged.bLegacy)
+		{
+			if (!scene->LoadLegacy(staged.File->GetFile()))
+			{
+				VEL_CORE_ERROR("Failed to load scene {0}, starting a new one", m_Filepath);
+				delete scene;
+				r_Scene = scene = Scene::CreateBlank();
+			}
+			scene->ClearDirty();
+			m_State = State::Finished;
+			m_Staged.reset();
+			return scene;
+		}
+
+		renderer->ClearState();
+
+		renderer->m_Renderables = std::move(staged.Renderables);
+		const bool bGeometry = renderer->m_BufferManager->LoadGeometry(staged.Vertices.size(), staged.Indices.size(), staged.Meshlets.size(),
+			[&staged](Vertex* vertices, uint32_t* indices, Meshlet* meshlets)
+			{
+				const std::array<std::tuple<void*, const void*, size_t>, 3> parts = { {
+					{ vertices, staged.Vertices.data(), staged.Vertices.size() * sizeof(Vertex) },
+					{ indices, staged.Indices.data(), staged.Indices.size() * sizeof(uint32_t) },
+					{ meshlets, staged.Meshlets.data(), staged.Meshlets.size() * sizeof(Meshlet) } } };
+				ThreadPool::Get().ParallelFor(parts.size(), [&parts](size_t i) { memcpy(std::get<0>(parts[i]), std::get<1>(parts[i]), std::get<2>(parts[i])); });
+				return true;
+			});
+		if (!bGeometry)
+		{
+			// Too late to go back to the old scene, its state is gone
+			VEL_CORE_ERROR("Failed to load scene {0}, starting a new one", m_Filepath);
+			delete scene;
+			r_Scene = scene = Scene::CreateBlank();
+			m_State = State::Failed;
+			m_Staged.reset();
+			return scene;
+		}
+		staged.Vertices = {};
+		staged.Indices = {};
+		staged.Meshlets = {};
+
+		renderer->m_PBRMaterials = std::move(staged.Materials);
+
+		// Blocking loads decoded everything, so it goes up in one batch. Otherwise the texture queue reads each one on the
+		// pool and uploads it at the start of a frame once it fits the budget, slots show the default texture until then
+		if (std::all_of(staged.Textures.begin(), staged.Textures.end(), [](const StagedTexture& texture) { return texture.Pixels || texture.CookedData; }))
+		{
+			std::vector<Renderer::RawTexture> textures(staged.Textures.size());
+			for (size_t i = 0; i < textures.size(); ++i)
+			{
+				auto& texture = staged.Textures[i];
+				textures[i].ReferenceName = texture.ReferenceName;
+				textures[i].Pixels = std::move(texture.Pixels);
+				textures[i].Width = texture.Width;
+				textures[i].Height = texture.Height;
+				textures[i].Cooked = std::move(texture.CookedData);
+			}
+			renderer->CreateTextureBatch(textures);
+		}
+		else
+		{
+			for (const auto& texture : staged.Textures)
+			{
+				auto file = texture.File;
+				const auto entry = texture.Entry;
+				const bool bCooked = texture.bCooked;
+				const int width = texture.Width;
+				const int height = texture.Height;
+				const std::string name = texture.ReferenceName;
+				renderer->QueueTextureLoad(name, name, static_cast<size_t>(entry.Size), [file, entry, bCooked, width, height, name]()
+				{
+					auto image = file ? ReadTexture(*file, entry, bCooked, width, height) : DecodedImage();
+					if (image.IsValid())
+					{
+						return image;
+					}
+
+					VEL_CORE_ERROR("Scene has a corrupt texture: {0}", name);
+					return WhitePixel();
+				}, nullptr);
+			}
+		}
+
+		if (staged.SkyboxWidth > 0u)
+		{
+			if (std::all_of(staged.SkyboxFaces.begin(), staged.SkyboxFaces.end(), [](const std::unique_ptr<stbi_uc>& face) { return face != nullptr; }))
+			{
+				scene->m_Skybox = std::unique_ptr<Skybox>(renderer->CreateSkybox(staged.SkyboxFaces, static_cast<int>(staged.SkyboxWidth), static_cast<int>(staged.SkyboxHeight)));
+			}
+			else
+			{
+				VEL_CORE_WARN("Scene {0} has a corrupt skybox, loading without it", staged.Name);
+			}
+		}
+
+		scene->m_SceneName = std::move(staged.Name);
+		scene->m_SceneCamera = std::move(staged.SceneCamera);
+		scene->m_Assets = std::move(staged.Assets);
+		scene->m_MeshAssets = std::move(staged.MeshAssets);
+		scene->m_TextureAssets = std::move(staged.TextureAssets);
+		scene->m_SkyboxAsset = staged.SkyboxAsset;
+
+		// Matches the file, unless autosaved changes were played over it
+		scene->ClearDirty();
+		if (staged.bReplayedJournal)
+		{
+			scene->m_DirtyComponents.set();
+		}
+
+		m_Pending.reserve(staged.Registry.alive());
+		staged.Registry.each([this](auto entity) { m_Pending.push_back(entity); });
+		m_State = State::Activating;
+		Activate(ACTIVATION_BATCH_SIZE);
+
+		return scene;
+	}
+
+	void SceneLoad::Activate(size_t count)
+	{
+		auto& source = m_Staged->Registry;
+		auto& target = r_Scene->m_Registry;
+
+		// Arriving from the file isnt an edit
+		const auto dirty = r_Scene->m_DirtyComponents;
+
+		const size_t end = std::min(m_Activated + count, m_Pending.size());
+		for (; m_Activated < end; ++m_Activated)
+		{
+			const auto staged = m_Pending[m_Activated];
+
+			// Keeps its saved id unless an entity made since the swap has taken it
+			const auto entity = target.create(staged);
+			SceneComponents::ForEach([&](auto tag)
+			{
+				using Component = typename decltype(tag)::Type;
+				if (source.has<Component>(staged))
+				{
+					target.emplace<Component>(entity, std::move(source.get<Component>(staged)));
+				}
+			});
+			r_Scene->m_Entities.push_back({ entity, r_Scene });
+		}
+		r_Scene->m_DirtyComponents = dirty;
+
+		if (m_Activated == m_Pending.size())
+		{
+			m_State = State::Finished;
+			m_Staged.reset();
+		}
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <entt/entt.hpp>
+
+#include <Velocity/Renderer/BufferManager.hpp>
+#include <Velocity/Renderer/Texture.hpp>
+#include <Velocity/Utility/Camera.hpp>
+
+#include "Scene.hpp"
+#include "SceneFile.hpp"
+#include "SceneLayout.hpp"
+
+namespace Velocity
+{
+	// A scene loading in the background, see Scene::LoadSceneAsync
+	// The file is read, decompressed and its registry parsed on the worker pool while the current scene keeps rendering
+	// Update then swaps the renderer over in one frame. Geometry goes up in one staged copy, textures queue behind the
+	// texture load budget and pop in over the next frames, and entities are added a batch per frame
+	class SceneLoad
+	{
+	public:
+		enum class State
+		{
+			Reading,	// On the pool, the current scene is untouched
+			Activating,	// Swapped in, entities still arriving
+			Finished,
+			Failed,		// Nothing was swapped in
+			Cancelled
+		};
+
+		// Entities added to the scene per Update once it has been swapped in
+		static constexpr size_t ACTIVATION_BATCH_SIZE = 4096u;
+
+		// Starts reading straight away. Blocking loads decode every texture up front so Finish can upload them in one batch
+		explicit SceneLoad(const std::string& sceneFilepath, bool bBlocking = false);
+
+		// Cancels and waits for the read
+		~SceneLoad();
+
+		SceneLoad(const SceneLoad&) = delete;
+		SceneLoad& operator=(const SceneLoad&) = delete;
+
+		// Moves the load along, call once a frame on the main thread
+		// Returns the new scene on the frame it takes over the renderer and nullptr on every other. The old scene's renderer
+		// state is gone by then so swap it out straight away. The caller owns the scene
+		Scene* Update();
+
+		// Waits for the read and adds every entity now. Same return as Update, or nullptr if the scene was already handed out
+		Scene* Finish();
+
+		State GetState() const { return m_State; }
+		bool IsDone() const { return m_State == State::Finished || m_State == State::Failed || m_State == State::Cancelled; }
+
+		// 0 to 1. Reading is most of it, textures popping in afterwards arent counted
+		float GetProgress() const;
+
+		const std::string& GetFilepath() const { return m_Filepath; }
+
+		// Stops a load that hasnt been swapped in, the current scene carries on untouched
+		// Too late once it has, the rest of the entities still arrive
+		void Cancel() { m_bCancel = true; }
+
+		// Store keys of every asset a saved scene points at, for AssetStore::Collect
+		// Scenes from before the store and packs point at none. Returns false if the file cant be read
+		static bool ReadAssetKeys(const std::string& sceneFilepath, std::vector<uint64_t>& outKeys);
+
+	private:
+		// The scene chunk, read the same whatever version wrote it
+		struct SceneHeader
+		{
+			std::string								Name;
+			std::unique_ptr<Camera>					SceneCamera;
+			BulkLayout								Layout;
+			uint32_t								VertexSize = 0u;
+			std::vector<SceneTexture>				TextureTable;
+			uint32_t								SkyboxWidth = 0u;
+			uint32_t								SkyboxHeight = 0u;
+			uint64_t								SkyboxAsset = 0u;
+			bool									bStoredGeometry = false;
+			std::vector<Scene::StoredMesh>			MeshAssets;
+		};
+
+		// Returns false if the chunk is missing or corrupt
+		static bool ReadHeader(const SceneFileReader& file, SceneHeader& outHeader);
+
+		// A texture from the table, decoded here for blocking loads or read by the renderer's texture queue otherwise
+		struct StagedTexture
+		{
+			std::string								ReferenceName;
+			int										Width = 0;
+			int										Height = 0;
+			bool									bCooked = false;
+
+			// Missing from the store if File is null
+			std::shared_ptr<const SceneFileReader>	File;
+			SceneChunkEntry							Entry;
+
+			std::unique_ptr<stbi_uc>				Pixels;
+			std::unique_ptr<CookedTexture>			CookedData;
+		};
+
+		// Everything read out of the file before any of it touches the renderer
+		struct Staged
+		{
+			std::shared_ptr<const SceneFileReader>						File;
+			std::vector<std::shared_ptr<const SceneFileReader>>			Assets;
+			bool														bLegacy = false;
+
+			std::string													Name;
+			std::unique_ptr<Camera>										SceneCamera;
+			entt::registry												Registry;
+			bool														bReplayedJournal = false;
+
+			std::unordered_map<std::string, BufferManager::MeshIndexer>	Renderables;
+			std::vector<Vertex>											Vertices;
+			std::vector<uint32_t>										Indices;
+			std::vector<Meshlet>										Meshlets;
+			std::unordered_map<std::string, PBRComponent>				Materials;
+			std::vector<StagedTexture>									Textures;
+
+			std::array<std::unique_ptr<stbi_uc>, 6>						SkyboxFaces;
+			uint32_t													SkyboxWidth = 0u;
+			uint32_t													SkyboxHeight = 0u;
+
+			// Store keys for the scene so saving skips what it was loaded from
+			std::unordered_map<std::string, Scene::StoredMesh>			MeshAssets;
+			std::unordered_map<std::string, uint64_t>					TextureAssets;
+			uint64_t													SkyboxAsset = 0u;
+		};
+
+		// Runs on the pool. Returns false if the file is missing or corrupt, or the load was cancelled
+		bool Read(bool bDecodeTextures);
+
+		// Hands the staged data to the renderer and a new scene. Main thread only
+		Scene* Swap();
+
+		// Moves up to count staged entities into the scene
+		void Activate(size_t count);
+
+		std::string					m_Filepath;
+		std::unique_ptr<Staged>		m_Staged;
+		std::future<bool>			m_Read;
+		State						m_State = State::Reading;
+
+		// The scene once swapped in. Owned by whoever Update handed it to
+		Scene*						r_Scene = nullptr;
+		std::vector<entt::entity>	m_Pending;
+		size_t						m_Activated = 0u;
+
+		std::atomic<bool>			m_bCancel = false;
+		std::atomic<uint64_t>		m_BytesRead = 0u;
+		std::atomic<uint64_t>		m_BytesTotal = 0u;
+	};
+}
@@ -0,0 +1,607 @@
+#include "velpch.h"
+
+#include "BlockCompression.hpp"
+
+#include <cfloat>
+#include <climits>
+#include <cmath>
+
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		// BC7 4 bit index interpolation weights, out of 64
+		const uint32_t BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+		// BC1 palette position of each index, as a fraction of the way from colour 0 to colour 1
+		const float BC1_POSITIONS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		// Writes fields LSB first, the order every BC format uses. Output must start zeroed
+		struct BitWriter
+		{
+			uint8_t*	Output;
+			uint32_t	Position = 0u;
+
+			void Write(uint32_t value, uint32_t bits)
+			{
+				for (uint32_t i = 0; i < bits; ++i, ++Position)
+				{
+					if ((value >> i) & 1u)
+					{
+						Output[Position >> 3] |= static_cast<uint8_t>(1u << (Position & 7u));
+					}
+				}
+			}
+		};
+
+		float Clamp255(float value)
+		{
+			return std::min<float>(std::max<float>(value, 0.0f), 255.0f);
+		}
+
+		// Finds the principal axis of the block's colours through their mean
+		// Power iteration on the covariance matrix is plenty for 16 points
+		void FitLine(const float pixels[16][4], uint32_t channels, float mean[4], float axis[4])
+		{
+			float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+			float maximum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				mean[c] = 0.0f;
+				axis[c] = 0.0f;
+			}
+
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					mean[c] += pixels[i][c];
+					minimum[c] = std::min<float>(minimum[c], pixels[i][c]);
+					maximum[c] = std::max<float>(maximum[c], pixels[i][c]);
+				}
+			}
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				mean[c] /= 16.0f;
+			}
+
+			float covariance[4][4] = {};
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				for (uint32_t a = 0; a < channels; ++a)
+				{
+					for (uint32_t b = 0; b < channels; ++b)
+					{
+						covariance[a][b] += (pixels[i][a] - mean[a]) * (pixels[i][b] - mean[b]);
+					}
+				}
+			}
+
+			// Start along the bounding box diagonal
+			float vector[4] = {};
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				vector[c] = maximum[c] - minimum[c];
+			}
+
+			for (uint32_t iteration = 0; iteration < 8; ++iteration)
+			{
+				float next[4] = {};
+				float length = 0.0f;
+				for (uint32_t a = 0; a < channels; ++a)
+				{
+					for (uint32_t b = 0; b < channels; ++b)
+					{
+						next[a] += covariance[a][b] * vector[b];
+					}
+					length = std::max<float>(length, std::abs(next[a]));
+				}
+
+				// Flat block, nothing to fit
+				if (length < 1e-6f)
+				{
+					break;
+				}
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					vector[c] = next[c] / length;
+				}
+			}
+
+			float length = 0.0f;
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				length += vector[c] * vector[c];
+			}
+			length = std::sqrt(length);
+
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				axis[c] = length > 1e-6f ? vector[c] / length : 1.0f / std::sqrt(static_cast<float>(channels));
+			}
+		}
+
+		// Projects every pixel onto the line and returns the two extremes
+		void LineEndpoints(const float pixels[16][4], uint32_t channels, float start[4], float end[4])
+		{
+			float mean[4];
+			float axis[4];
+			FitLine(pixels, channels, mean, axis);
+
+			float minimum = FLT_MAX;
+			float maximum = -FLT_MAX;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				float t = 0.0f;
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					t += (pixels[i][c] - mean[c]) * axis[c];
+				}
+				minimum = std::min<float>(minimum, t);
+				maximum = std::max<float>(maximum, t);
+			}
+
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				start[c] = c < channels ? Clamp255(mean[c] + axis[c] * minimum) : 255.0f;
+				end[c] = c < channels ? Clamp255(mean[c] + axis[c] * maximum) : 255.0f;
+			}
+		}
+
+		// Best start/end for fixed palette positions, solved per channel with least squares
+		// Returns false if every pixel sits on the same position
+		bool SolveEndpoints(const float pixels[16][4], uint32_t channels, const float positions[16], float start[4], float end[4])
+		{
+			float aa = 0.0f;
+			float ab = 0.0f;
+			float bb = 0.0f;
+			float ax[4] = {};
+			float bx[4] = {};
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				const float a = 1.0f - positions[i];
+				const float b = positions[i];
+				aa += a * a;
+				ab += a * b;
+				bb += b * b;
+				for (uint32_t c = 0; c < channels; ++c)
+				{
+					ax[c] += a * pixels[i][c];
+					bx[c] += b * pixels[i][c];
+				}
+			}
+
+			const float determinant = aa * bb - ab * ab;
+			if (std::abs(determinant) < 1e-6f)
+			{
+				return false;
+			}
+
+			for (uint32_t c = 0; c < channels; ++c)
+			{
+				start[c] = Clamp255((bb * ax[c] - ab * bx[c]) / determinant);
+				end[c] = Clamp255((aa * bx[c] - ab * ax[c]) / determinant);
+			}
+			return true;
+		}
+
+		void LoadBlock(const uint8_t* block, float pixels[16][4])
+		{
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					pixels[i][c] = static_cast<float>(block[i * 4 + c]);
+				}
+			}
+		}
+
+#pragma region BC1
+
+		uint16_t Pack565(const float colour[4])
+		{
+			const uint32_t r = static_cast<uint32_t>(colour[0] * 31.0f / 255.0f + 0.5f);
+			const uint32_t g = static_cast<uint32_t>(colour[1] * 63.0f / 255.0f + 0.5f);
+			const uint32_t b = static_cast<uint32_t>(colour[2] * 31.0f / 255.0f + 0.5f);
+			return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+		}
+
+		void Unpack565(uint16_t packed, float colour[3])
+		{
+			const uint32_t r = (packed >> 11) & 31u;
+			const uint32_t g = (packed >> 5) & 63u;
+			const uint32_t b = packed & 31u;
+			colour[0] = static_cast<float>((r << 3) | (r >> 2));
+			colour[1] = static_cast<float>((g << 2) | (g >> 4));
+			colour[2] = static_cast<float>((b << 3) | (b >> 2));
+		}
+
+		// Picks the nearest palette entry for every pixel and returns the total error
+		float ChooseBC1Indices(const float pixels[16][4], uint16_t colour0, uint16_t colour1, uint32_t indices[16])
+		{
+			float palette[4][3];
+			Unpack565(colour0, palette[0]);
+			Unpack565(colour1, palette[1]);
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+
+			float total = 0.0f;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				float best = FLT_MAX;
+				for (uint32_t p = 0; p < 4; ++p)
+				{
+					float error = 0.0f;
+					for (uint32_t c = 0; c < 3; ++c)
+					{
+						const float difference = pixels[i][c] - palette[p][c];
+						error += difference * difference;
+					}
+					if (error < best)
+					{
+						best = error;
+						indices[i] = p;
+					}
+				}
+				total += best;
+			}
+			return total;
+		}
+
+		// Four colour mode only, BC3 always decodes its colour block that way
+		void EncodeColourBlock(const uint8_t* block, uint8_t* output)
+		{
+			float pixels[16][4];
+			LoadBlock(block, pixels);
+
+			float start[4];
+			float end[4];
+			LineEndpoints(pixels, 3, start, end);
+
+			// Pull the ends in a little, the extremes are rarely worth a whole palette entry each
+			for (uint32_t c = 0; c < 3; ++c)
+			{
+				const float inset = (end[c] - start[c]) / 16.0f;
+				start[c] += inset;
+				end[c] -= inset;
+			}
+
+			uint16_t colour0 = Pack565(end);
+			uint16_t colour1 = Pack565(start);
+			uint32_t indices[16];
+			float error = ChooseBC1Indices(pixels, colour0, colour1, indices);
+
+			// One refinement pass with the indices fixed
+			float positions[16];
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				positions[i] = BC1_POSITIONS[indices[i]];
+			}
+			if (SolveEndpoints(pixels, 3, positions, end, start))
+			{
+				uint32_t refinedIndices[16];
+				const uint16_t refined0 = Pack565(end);
+				const uint16_t refined1 = Pack565(start);
+				const float refinedError = ChooseBC1Indices(pixels, refined0, refined1, refinedIndices);
+				if (refinedError < error)
+				{
+					colour0 = refined0;
+					colour1 = refined1;
+					memcpy(indices, refinedIndices, sizeof(indices));
+				}
+			}
+
+			// colour0 > colour1 selects four colour mode in BC1. Swapping the colours swaps 0/1 and 2/3
+			if (colour0 < colour1)
+			{
+				std::swap(colour0, colour1);
+				for (auto& index : indices)
+				{
+					index ^= 1u;
+				}
+			}
+			else if (colour0 == colour1)
+			{
+				memset(indices, 0, sizeof(indices));
+			}
+
+			uint32_t packedIndices = 0u;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				packedIndices |= indices[i] << (i * 2u);
+			}
+
+			output[0] = static_cast<uint8_t>(colour0 & 0xFFu);
+			output[1] = static_cast<uint8_t>(colour0 >> 8);
+			output[2] = static_cast<uint8_t>(colour1 & 0xFFu);
+			output[3] = static_cast<uint8_t>(colour1 >> 8);
+			memcpy(output + 4, &packedIndices, sizeof(packedIndices));
+		}
+
+#pragma endregion
+
+#pragma region BC7
+
+		// Quantises an endpoint to 7 bits a channel plus the shared p bit that fits it best
+		void QuantiseBC7Endpoint(const float endpoint[4], uint32_t quantised[4], uint32_t& pBit)
+		{
+			float bestError = FLT_MAX;
+			for (uint32_t p = 0; p < 2; ++p)
+			{
+				uint32_t candidate[4];
+				float error = 0.0f;
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					const float value = std::round((endpoint[c] - static_cast<float>(p)) / 2.0f);
+					candidate[c] = static_cast<uint32_t>(std::min<float>(std::max<float>(value, 0.0f), 127.0f));
+					const float difference = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+					error += difference * difference;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					pBit = p;
+					memcpy(quantised, candidate, sizeof(candidate));
+				}
+			}
+		}
+
+		struct BC7Endpoints
+		{
+			uint32_t	Colour[2][4];
+			uint32_t	PBit[2];
+		};
+
+		BC7Endpoints QuantiseBC7(const float start[4], const float end[4])
+		{
+			BC7Endpoints endpoints;
+			QuantiseBC7Endpoint(start, endpoints.Colour[0], endpoints.PBit[0]);
+			QuantiseBC7Endpoint(end, endpoints.Colour[1], endpoints.PBit[1]);
+			return endpoints;
+		}
+
+		float ChooseBC7Indices(const float pixels[16][4], const BC7Endpoints& endpoints, uint32_t indices[16])
+		{
+			uint32_t ends[2][4];
+			for (uint32_t e = 0; e < 2; ++e)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					ends[e][c] = (endpoints.Colour[e][c] << 1) | endpoints.PBit[e];
+				}
+			}
+
+			float palette[16][4];
+			for (uint32_t w = 0; w < 16; ++w)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					palette[w][c] = static_cast<float>(((64u - BC7_WEIGHTS[w]) * ends[0][c] + BC7_WEIGHTS[w] * ends[1][c] + 32u) >> 6);
+				}
+			}
+
+			float total = 0.0f;
+			for (uint32_t i = 0; i < 16; ++i)
+			{
+				float best = FLT_MAX;
+				for (uint32_t w = 0; w < 16; ++w)
+				{
+					float error = 0.0f;
+					for (uint32_t c = 0; c < 4; ++c)
+					{
+						const float difference = pixels[i][c] - palette[w][c];
+						error += difference * difference;
+					}
+					if (error < best)
+					{
+						best = error;
+						indices[i] = w;
+					}
+				}
+				total += best;
+			}
+			return total;
+		}
+
+#pragma endregion
+	}
+
+	uint32_t BlockCompression::GetBlockSize(BlockFormat format)
+	{
+		return format == BlockFormat::BC1 || format == BlockFormat::BC4 ? 8u : 16u;
+	}
+
+	size_t BlockCompression::GetEncodedSize(BlockFormat format, uint32_t width, uint32_t height)
+	{
+		const size_t blocksX = (width + 3u) / 4u;
+		const size_t blocksY = (height + 3u) / 4u;
+		return blocksX * blocksY * GetBlockSize(format);
+	}
+
+	std::vector<uint8_t> BlockCompression::Encode(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format)
+	{
+		const uint32_t blocksX = (width + 3u) / 4u;
+		const uint32_t blocksY = (height + 3u) / 4u;
+		const uint32_t blockSize = GetBlockSize(format);
+
+		std::vector<uint8_t> output(static_cast<size_t>(blocksX) * blocksY * blockSize);
+
+		// A row of blocks per task keeps the tasks big enough to be worth handing out
+		ThreadPool::Get().ParallelFor(blocksY, [&](size_t blockY)
+		{
+			uint8_t block[64];
+			for (uint32_t blockX = 0; blockX < blocksX; ++blockX)
+			{
+				for (uint32_t y = 0; y < 4; ++y)
+				{
+					const uint32_t sourceY = std::min<uint32_t>(static_cast<uint32_t>(blockY) * 4u + y, height - 1u);
+					for (uint32_t x = 0; x < 4; ++x)
+					{
+						const uint32_t sourceX = std::min<uint32_t>(blockX * 4u + x, width - 1u);
+						memcpy(block + (y * 4u + x) * 4u, rgba + (static_cast<size_t>(sourceY) * width + sourceX) * 4u, 4u);
+					}
+				}
+
+				uint8_t* destination = output.data() + (blockY * blocksX + blockX) * blockSize;
+				switch (format)
+				{
+				case BlockFormat::BC1:
+					EncodeBC1(block, destination);
+					break;
+				case BlockFormat::BC3:
+					EncodeBC3(block, destination);
+					break;
+				case BlockFormat::BC4:
+					EncodeBC4(block, destination);
+					break;
+				case BlockFormat::BC5:
+					EncodeBC5(block, destination);
+					break;
+				case BlockFormat::BC7:
+					EncodeBC7(block, destination);
+					break;
+				}
+			}
+		});
+
+		return output;
+	}
+
+	void BlockCompression::EncodeBC1(const uint8_t* block, uint8_t* output)
+	{
+		EncodeColourBlock(block, output);
+	}
+
+	void BlockCompression::EncodeBC3(const uint8_t* block, uint8_t* output)
+	{
+		// Alpha block first, then colour
+		EncodeBC4(block, output, 3u);
+		EncodeColourBlock(block, output + 8);
+	}
+
+	void BlockCompression::EncodeBC4(const uint8_t* block, uint8_t* output, uint32_t channel)
+	{
+		uint32_t minimum = 255u;
+		uint32_t maximum = 0u;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			minimum = std::min<uint32_t>(minimum, block[i * 4 + channel]);
+			maximum = std::max<uint32_t>(maximum, block[i * 4 + channel]);
+		}
+
+		memset(output, 0, 8);
+		output[0] = static_cast<uint8_t>(maximum);
+		output[1] = static_cast<uint8_t>(minimum);
+
+		// Flat block, every index 0 already gives the value
+		if (maximum == minimum)
+		{
+			return;
+		}
+
+		// maximum > minimum selects the eight value mode
+		uint32_t palette[8];
+		palette[0] = maximum;
+		palette[1] = minimum;
+		for (uint32_t i = 1; i < 7; ++i)
+		{
+			palette[i + 1] = ((7u - i) * maximum + i * minimum + 3u) / 7u;
+		}
+
+		uint64_t packedIndices = 0u;
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			const int value = block[i * 4 + channel];
+			uint64_t bestIndex = 0u;
+			int bestError = INT_MAX;
+			for (uint32_t p = 0; p < 8; ++p)
+			{
+				const int error = std::abs(value - static_cast<int>(palette[p]));
+				if (error < bestError)
+				{
+					bestError = error;
+					bestIndex = p;
+				}
+			}
+			packedIndices |= bestIndex << (i * 3u);
+		}
+
+		for (uint32_t i = 0; i < 6; ++i)
+		{
+			output[2 + i] = static_cast<uint8_t>(packedIndices >> (i * 8u));
+		}
+	}
+
+	void BlockCompression::EncodeBC5(const uint8_t* block, uint8_t* output)
+	{
+		EncodeBC4(block, output, 0u);
+		EncodeBC4(block, output + 8, 1u);
+	}
+
+	void BlockCompression::EncodeBC7(const uint8_t* block, uint8_t* output)
+	{
+		float pixels[16][4];
+		LoadBlock(block, pixels);
+
+		float start[4];
+		float end[4];
+		LineEndpoints(pixels, 4, start, end);
+
+		BC7Endpoints endpoints = QuantiseBC7(start, end);
+		uint32_t indices[16];
+		float error = ChooseBC7Indices(pixels, endpoints, indices);
+
+		// Refine with the indices fixed, keep it only if it actually helped
+		float positions[16];
+		for (uint32_t i = 0; i < 16; ++i)
+		{
+			positions[i] = static_cast<float>(BC7_WEIGHTS[indices[i]]) / 64.0f;
+		}
+		if (SolveEndpoints(pixels, 4, positions, start, end))
+		{
+			uint32_t refinedIndices[16];
+			const BC7Endpoints refined = QuantiseBC7(start, end);
+			const float refinedError = ChooseBC7Indices(pixels, refined, refinedIndices);
+			if (refinedError < error)
+			{
+				endpoints = refined;
+				memcpy(indices, refinedIndices, sizeof(indices));
+			}
+		}
+
+		// The first index only gets 3 bits, so its top bit must be clear. Flip the line if it isnt
+		if (indices[0] & 8u)
+		{
+			std::swap(endpoints.Colour[0], endpoints.Colour[1]);
+			std::swap(endpoints.PBit[0], endpoints.PBit[1]);
+			for (auto& index : indices)
+			{
+				index = 15u - index;
+			}
+		}
+
+		memset(output, 0, 16);
+		BitWriter writer{ output };
+
+		// Mode 6
+		writer.Write(1u << 6, 7);
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			writer.Write(endpoints.Colour[0][c], 7);
+			writer.Write(endpoints.Colour[1][c], 7);
+		}
+		writer.Write(endpoints.PBit[0], 1);
+		writer.Write(endpoints.PBit[1], 1);
+
+		writer.Write(indices[0], 3);
+		for (uint32_t i = 1; i < 16; ++i)
+		{
+			writer.Write(indices[i], 4);
+		}
+	}
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Velocity
+{
+	// GPU block compressed formats the cooker can write
+	// Values are stored in cooked files so only ever add to the end
+	enum class BlockFormat : uint32_t
+	{
+		BC1 = 0,	// RGB, 8 bytes per block
+		BC3 = 1,	// RGBA, BC1 colour plus a BC4 alpha block
+		BC4 = 2,	// Single channel (red)
+		BC5 = 3,	// Two channels (red, green)
+		BC7 = 4		// RGBA, mode 6 only
+	};
+
+	// CPU encoders for 4x4 blocks
+	// Blocks are independent so the image encoders split rows of blocks across the worker pool
+	class BlockCompression
+	{
+	public:
+		// 8 or 16
+		static uint32_t GetBlockSize(BlockFormat format);
+
+		// Bytes needed for a width x height image, partial blocks are rounded up
+		static size_t GetEncodedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+		// Encodes a tightly packed RGBA8 image. Edge blocks repeat the last row/column
+		static std::vector<uint8_t> Encode(const uint8_t* rgba, uint32_t width, uint32_t height, BlockFormat format);
+
+		// Single block encoders. Input is 16 RGBA pixels in row order
+		static void EncodeBC1(const uint8_t* block, uint8_t* output);
+		static void EncodeBC3(const uint8_t* block, uint8_t* output);
+		static void EncodeBC4(const uint8_t* block, uint8_t* output, uint32_t channel = 0u);
+		static void EncodeBC5(const uint8_t* block, uint8_t* output);
+		static void EncodeBC7(const uint8_t* block, uint8_t* output);
+	};
+}
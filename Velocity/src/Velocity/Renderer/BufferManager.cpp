@@ -1,211 +1,366 @@
 #include "velpch.h"
 
+#include <cmath>
+#include <map>
+
 #include "BufferManager.hpp"
+#include "MeshProcessor.hpp"
+#include "ObjLoader.hpp"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <Velocity/Utility/AssetManifest.hpp>
+#include <Velocity/Utility/AssimpIOSystem.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+#include <Velocity/Utility/VirtualFileSystem.hpp>
+
 namespace Velocity
 {
-	BufferManager::BufferManager(vk::PhysicalDevice& pDevice, vk::UniqueDevice& device, vk::CommandPool& pool, vk::Queue& copyQueue)
+	namespace
+	{
+		bool IsObjFile(const std::string& filepath)
+		{
+			const auto dot = filepath.find_last_of('.');
+			if (dot == std::string::npos)
+			{
+				return false;
+			}
+
+			auto extension = filepath.substr(dot);
+			std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+			return extension == ".obj";
+		}
+	}
+
+	// The steps MeshProcessor runs, in assimp's terms
+	const unsigned int BufferManager::IMPORT_FLAGS =
+		aiProcess_Triangulate
+		| aiProcess_CalcTangentSpace
+		| aiProcess_FlipUVs
+		| aiProcess_GenNormals;
+
+	BufferManager::BufferManager(vk::PhysicalDevice& pDevice, vk::UniqueDevice& device, vk::CommandPool& pool, vk::Queue& copyQueue, uint32_t copyQueueIndex)
 	{
 		// Store refernces
 		r_PhysicalDevice = pDevice;
 		r_LogicalDevice = &device;
 		r_Pool = pool;
 		r_CopyQueue = copyQueue;
+		r_CopyQueueIndex = copyQueueIndex;
 
 		// Create buffer
 		m_VertexBuffer = std::make_unique<BaseBuffer>(
 			pDevice,
 			device,
 			DEFAULT_BUFFER_SIZE,
-			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
 			vk::MemoryPropertyFlagBits::eDeviceLocal
 		);
 
-		// Reserve cpu verts
-		m_Vertices.reserve(DEFAULT_BUFFER_SIZE / sizeof(Vertex));
-
 		// Create buffer
 		m_IndexBuffer = std::make_unique<BaseBuffer>(
 			pDevice,
 			device,
 			DEFAULT_BUFFER_SIZE,
-			vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+			vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eDeviceLocal
+		);
+
+		// The CPU copies grow with what is loaded rather than being reserved at the full buffer size
+
+		// Meshlets are only read by the cluster culling compute pass
+		m_MeshletBuffer = std::make_unique<BaseBuffer>(
+			pDevice,
+			device,
+			MESHLET_BUFFER_SIZE,
+			vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
 			vk::MemoryPropertyFlagBits::eDeviceLocal
 		);
-		
-		// Reserve cpu indicies
-		m_Indices.reserve(DEFAULT_BUFFER_SIZE / sizeof(uint32_t));
 		
 	}
 
 	BufferManager::MeshIndexer BufferManager::AddMesh(std::vector<Vertex>& verts, std::vector<uint32_t> indices)
+	{
+		return AddMesh(verts.data(), verts.size(), indices.data(), indices.size(), nullptr, 0u);
+	}
+
+	BufferManager::MeshIndexer BufferManager::AddMesh(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const Meshlet* meshlets, size_t meshletCount)
 	{
 		MeshIndexer newRenderable;
-		newRenderable.VertexOffset = static_cast<int32_t>(m_Vertices.size());
-		newRenderable.VertexCount = static_cast<uint32_t>(verts.size());
-		newRenderable.IndexStart = static_cast<uint32_t>(m_Indices.size());
-		newRenderable.IndexCount = static_cast<uint32_t>(indices.size());
+		newRenderable.VertexOffset = static_cast<int32_t>(m_VertexCount);
+		newRenderable.VertexCount = static_cast<uint32_t>(vertexCount);
+		newRenderable.IndexStart = static_cast<uint32_t>(m_IndexCount);
+		newRenderable.IndexCount = static_cast<uint32_t>(indexCount);
 
 		// Add the new verts and indices
-		m_Vertices.insert(m_Vertices.end(),verts.begin(), verts.end());
-		m_Indices.insert(m_Indices.end(), indices.begin(), indices.end());
-		// Update vertex buffer
+		if (m_KeepCPUCopy)
 		{
-			// Calculate the size of the new area
-			VkDeviceSize stagingSize = newRenderable.VertexCount * sizeof(Vertex);
+			m_Vertices.insert(m_Vertices.end(), vertices, vertices + vertexCount);
+			m_Indices.insert(m_Indices.end(), indices, indices + indexCount);
+		}
 
-			// Create a CPU staging buffer
-			std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
-				r_PhysicalDevice,
-				*r_LogicalDevice,
-				stagingSize,
-				vk::BufferUsageFlagBits::eTransferSrc,
-				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-				);
+		// Upload straight from the source, which may be a mapped cache blob
+		if (!UploadToBuffer(*m_VertexBuffer, vertices, vertexCount * sizeof(Vertex), newRenderable.VertexOffset * sizeof(Vertex)))
+		{
+			return MeshIndexer();	// Return an empty renderable. will crash anyway and be logged
+		}
 
-			// Copy to staging buffer
-			// 1. Map 2. Copy 3. Unmap
-			void* data;
-			vk::Result result = r_LogicalDevice->get().mapMemory(stagingBuffer->Memory.get(), 0, stagingSize, vk::MemoryMapFlags{}, &data);
-			if (result != vk::Result::eSuccess)
+		if (!UploadToBuffer(*m_IndexBuffer, indices, indexCount * sizeof(uint32_t), newRenderable.IndexStart * sizeof(uint32_t)))
+		{
+			return MeshIndexer();
+		}
+
+		m_VertexCount += vertexCount;
+		m_IndexCount += indexCount;
+
+		ComputeBounds(newRenderable, vertices);
+
+		// Cached meshes already carry their clusters, they just need moving to where the indices landed
+		if (meshletCount > 0u && (m_Meshlets.size() + meshletCount) * sizeof(Meshlet) <= MESHLET_BUFFER_SIZE)
+		{
+			newRenderable.MeshletStart = static_cast<uint32_t>(m_Meshlets.size());
+			newRenderable.MeshletCount = static_cast<uint32_t>(meshletCount);
+
+			m_Meshlets.insert(m_Meshlets.end(), meshlets, meshlets + meshletCount);
+			for (size_t i = newRenderable.MeshletStart; i < m_Meshlets.size(); ++i)
 			{
-				VEL_CORE_ASSERT(false, "Failed to map memory!");
-				VEL_CORE_ERROR("Failed to map memory!");
-				return MeshIndexer();	// Return an empty renderable. will crash anyway and be logged
+				m_Meshlets.at(i).IndexStart += newRenderable.IndexStart;
 			}
-			memcpy(data, &m_Vertices.at(newRenderable.VertexOffset), stagingSize);
-			r_LogicalDevice->get().unmapMemory(stagingBuffer->Memory.get());
 
-			// Copy to FAST buffer
-			{
-				TemporaryCommandBuffer bufferWrapper = TemporaryCommandBuffer(*r_LogicalDevice, r_Pool, r_CopyQueue);
-				auto& commandBuffer = bufferWrapper.GetBuffer();
+			UploadToBuffer(*m_MeshletBuffer, &m_Meshlets.at(newRenderable.MeshletStart), meshletCount * sizeof(Meshlet), newRenderable.MeshletStart * sizeof(Meshlet));
+		}
+		else
+		{
+			BuildMeshlets(newRenderable, vertices, indices);
+		}
+		
+		return newRenderable;
+	
+	}
 
-				vk::BufferCopy copyRegion = {
-					0,
-					newRenderable.VertexOffset * sizeof(Vertex),
-					stagingSize
-				};
+	BufferManager::MeshIndexer BufferManager::AddMesh(const std::string& filepath)
+	{
+		PreparedMesh prepared;
+		if (!ComputeSourceKey(filepath, prepared.Key))
+		{
+			return MeshIndexer();
+		}
 
-				commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), m_VertexBuffer->Buffer.get(), 1, &copyRegion);
-			}
+		// The same file loaded twice shares the geometry. Checked before importing so duplicates cost nothing
+		auto loaded = m_LoadedMeshes.find(prepared.Key);
+		if (loaded != m_LoadedMeshes.end())
+		{
+			return loaded->second;
 		}
 
-		// Update index buffer
+		if (!LoadOrImport(filepath, prepared))
 		{
-			// Calculate the size of the new area
-			VkDeviceSize stagingSize = newRenderable.IndexCount * sizeof(uint32_t);
+			return MeshIndexer();
+		}
 
-			// Create a CPU staging buffer
-			std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
-				r_PhysicalDevice,
-				*r_LogicalDevice,
-				stagingSize,
-				vk::BufferUsageFlagBits::eTransferSrc,
-				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-				);
+		return AddPreparedMesh(prepared);
+	}
 
-			// Copy to staging buffer
-			// 1. Map 2. Copy 3. Unmap
-			void* data;
-			vk::Result result = r_LogicalDevice->get().mapMemory(stagingBuffer->Memory.get(), 0, stagingSize, vk::MemoryMapFlags{}, &data);
-			if (result != vk::Result::eSuccess)
-			{
-				VEL_CORE_ERROR("Failed to map memory!");
-				VEL_CORE_ASSERT(false, "Failed to map memory!");
-				return MeshIndexer();	// Return an empty renderable. will crash anyway and be logged
-			}
-			memcpy(data, &m_Indices.at(newRenderable.IndexStart), stagingSize);
-			r_LogicalDevice->get().unmapMemory(stagingBuffer->Memory.get());
+	// Does all the CPU work of loading a mesh file. Safe to call from any thread
+	bool BufferManager::PrepareMesh(const std::string& filepath, PreparedMesh& outPrepared)
+	{
+		if (!ComputeSourceKey(filepath, outPrepared.Key))
+		{
+			return false;
+		}
 
-			// Copy to FAST buffer
-			{
-				TemporaryCommandBuffer bufferWrapper = TemporaryCommandBuffer(*r_LogicalDevice, r_Pool, r_CopyQueue);
-				auto& commandBuffer = bufferWrapper.GetBuffer();
+		return LoadOrImport(filepath, outPrepared);
+	}
 
-				vk::BufferCopy copyRegion = {
-					0,
-					newRenderable.IndexStart * sizeof(uint32_t),
-					stagingSize
-				};
+	// Adds a prepared mesh to the heap and uploads it. Main thread only
+	BufferManager::MeshIndexer BufferManager::AddPreparedMesh(PreparedMesh& prepared)
+	{
+		auto loaded = m_LoadedMeshes.find(prepared.Key);
+		if (loaded != m_LoadedMeshes.end())
+		{
+			return loaded->second;
+		}
 
-				commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), m_IndexBuffer->Buffer.get(), 1, &copyRegion);
-			}
+		MeshIndexer newRenderable;
+		if (prepared.FromCache)
+		{
+			const auto& cached = prepared.Cached;
+			newRenderable = AddMesh(cached.Vertices, cached.VertexCount, cached.Indices, cached.IndexCount, cached.Meshlets, cached.MeshletCount);
 		}
-		
+		else
+		{
+			const auto& mesh = prepared.Imported;
+			newRenderable = AddMesh(mesh.Vertices.data(), mesh.Vertices.size(), mesh.Indices.data(), mesh.Indices.size(), mesh.Meshlets.data(), mesh.Meshlets.size());
+		}
+
+		m_LoadedMeshes[prepared.Key] = newRenderable;
 		return newRenderable;
-	
 	}
 
-	BufferManager::MeshIndexer BufferManager::AddMesh(const std::string& filepath)
+	// Maps the source file and hashes it into a mesh cache key
+	bool BufferManager::ComputeSourceKey(const std::string& filepath, uint64_t& outKey)
 	{
-		// Create assimp importer
-		Assimp::Importer Importer;
+		// Cooked sources already have their hash in the manifest
+		uint64_t sourceHash = 0u;
+		if (AssetManifest::FindSourceHash(filepath, sourceHash))
+		{
+			outKey = ComputeMeshKey(sourceHash);
+			return true;
+		}
 
-		// Standard import flags
-		unsigned int assimpFlags =
-			aiProcess_Triangulate
-			| aiProcess_CalcTangentSpace
-			| aiProcess_FlipUVs
-			| aiProcess_GenNormals
-			| aiProcess_OptimizeMeshes;
+		// Map the source so it can be hashed without a copy
+		VirtualFileSystem::File source;
+		if (!VirtualFileSystem::Open(filepath, source))
+		{
+			VEL_CORE_ERROR("Failed to load model: {0}, Error: File not found", filepath);
+			VEL_CORE_ASSERT(false, "Failed to load model: {0}, Error: File not found", filepath);
+			return false;
+		}
 
-		// Load model
-		const auto* pScene = Importer.ReadFile(filepath.c_str(), assimpFlags);
+		outKey = ComputeMeshKey(Hash::Bytes(source.GetData(), source.GetSize()));
+		return true;
+	}
+
+	uint64_t BufferManager::ComputeMeshKey(uint64_t sourceHash)
+	{
+		return MeshCache::ComputeKey(sourceHash, IMPORT_FLAGS);
+	}
 
-		if (pScene == nullptr)
+	// Maps the cached blob for the key, or imports the file and fills the cache
+	bool BufferManager::LoadOrImport(const std::string& filepath, PreparedMesh& prepared)
+	{
+		// Second and later loads skip assimp entirely
+		if (MeshCache::Load(prepared.Key, prepared.Blob, prepared.Cached))
 		{
-			VEL_CORE_ERROR("Failed to load model: {0}, Error: {1}", filepath, Importer.GetErrorString());
-			VEL_CORE_ASSERT(false, "Failed to load model: {0}, Error: {1}", filepath, Importer.GetErrorString());
-			return MeshIndexer();
+			prepared.FromCache = true;
+			return true;
+		}
+
+		if (!ImportMesh(filepath, prepared.Imported))
+		{
+			return false;
+		}
+
+		MeshCache::Store(prepared.Key, prepared.Imported);
+		prepared.FromCache = false;
+		return true;
+	}
+
+	// Imports the file and converts the result to our vertex format, clusters and bounds
+	bool BufferManager::ImportMesh(const std::string& filepath, ImportedMesh& outMesh, const MeshImportOptions& options)
+	{
+		// One importer per thread. Importers arent thread safe but separate ones can run side by side
+		// Reads go through the VFS, the importer owns the handler
+		thread_local Assimp::Importer Importer;
+		if (!dynamic_cast<AssimpIOSystem*>(Importer.GetIOHandler()))
+		{
+			Importer.SetIOHandler(new AssimpIOSystem());
 		}
 
-		std::vector<Vertex>		m_ModelVertices;
-		std::vector<uint32_t>	m_ModelIndices;
+		// OBJ files are parsed straight out of the VFS on every core, from the pack or a mapping of the loose file
+		// Anything the fast path cant match assimp on goes through assimp instead
+		std::vector<std::unique_ptr<aiMesh>> objMeshes;
+		bool bFastObj = false;
+		if (options.FastObj && IsObjFile(filepath))
+		{
+			VirtualFileSystem::File source;
+			bFastObj = VirtualFileSystem::Open(filepath, source) && ObjLoader::Load(source.GetData(), source.GetSize(), objMeshes);
+		}
 
-		// For each mesh
-		for (size_t i = 0; i < pScene->mNumMeshes; ++i)
+		std::vector<const aiMesh*> meshes;
+		if (bFastObj)
 		{
-			// Get mesh
-			const auto& mesh = pScene->mMeshes[i];
-			for (size_t j = 0; j < mesh->mNumVertices; ++j)
+			for (const auto& mesh : objMeshes)
 			{
-				// Get vertex
-				const auto& rawVert = mesh->mVertices[j];
-				const auto& rawNorm = mesh->mNormals[j];
-				const auto& rawTangent = mesh->HasTangentsAndBitangents() ? mesh->mTangents[j] : aiVector3t<float>{};
-				const auto& rawUV = mesh->HasTextureCoords(0) ? mesh->mTextureCoords[0][j] : aiVector3t<float>{};
-				
+				meshes.push_back(mesh.get());
+			}
+		}
+		else
+		{
+			// Load model. Post processing is ours so it can run per mesh, see MeshProcessor
+			const auto* pScene = Importer.ReadFile(filepath.c_str(), 0u);
 
-				Vertex vert = {
-					{rawVert.x, rawVert.y, rawVert.z},
-					{rawNorm.x,rawNorm.y,rawNorm.z},
-					{rawTangent.x,rawTangent.y,rawTangent.z},
-					{rawUV.x, rawUV.y}
-				};
+			if (pScene == nullptr)
+			{
+				VEL_CORE_ERROR("Failed to load model: {0}, Error: {1}", filepath, Importer.GetErrorString());
+				VEL_CORE_ASSERT(false, "Failed to load model: {0}, Error: {1}", filepath, Importer.GetErrorString());
+				return false;
+			}
+
+			meshes.assign(pScene->mMeshes, pScene->mMeshes + pScene->mNumMeshes);
+		}
+
+		// Every sub mesh is processed on its own, so they can all go side by side
+		std::vector<std::vector<Vertex>> meshVertices(meshes.size());
+		std::vector<std::vector<uint32_t>> meshIndices(meshes.size());
+		auto processMesh = [&](size_t i)
+		{
+			MeshProcessor::Process(*meshes[i], meshVertices[i], meshIndices[i]);
+		};
 
-				m_ModelVertices.push_back(vert);
+		if (options.ParallelPostProcess)
+		{
+			ThreadPool::Get().ParallelFor(meshes.size(), processMesh);
+		}
+		else
+		{
+			for (size_t i = 0; i < meshes.size(); ++i)
+			{
+				processMesh(i);
 			}
+		}
+
+		// Everything has been copied out, dont hold the scene until the next import on this thread
+		Importer.FreeScene();
+		objMeshes.clear();
+
+		// Flatten in mesh order so the result is the same either way
+		size_t vertexCount = 0u;
+		size_t indexCount = 0u;
+		for (size_t i = 0; i < meshVertices.size(); ++i)
+		{
+			vertexCount += meshVertices[i].size();
+			indexCount += meshIndices[i].size();
+		}
 
+		outMesh.Vertices.reserve(vertexCount);
+		outMesh.Indices.reserve(indexCount);
+		for (size_t i = 0; i < meshVertices.size(); ++i)
+		{
+			// Indices of every sub mesh are local to that mesh, so shift them past the vertices before it
+			const auto baseVertex = static_cast<uint32_t>(outMesh.Vertices.size());
+			outMesh.Vertices.insert(outMesh.Vertices.end(), meshVertices[i].begin(), meshVertices[i].end());
+			for (const auto index : meshIndices[i])
+			{
+				outMesh.Indices.push_back(baseVertex + index);
+			}
+		}
 
-			for (size_t face = 0; face < mesh->mNumFaces; ++face)
+		// Bounds
+		if (!outMesh.Vertices.empty())
+		{
+			outMesh.BoundsMin = outMesh.Vertices.front().Position;
+			outMesh.BoundsMax = outMesh.Vertices.front().Position;
+			for (const auto& vertex : outMesh.Vertices)
 			{
-				// Get face
-				const auto& currFace = mesh ->mFaces[face];
-
-				// Load indices
-				for (unsigned int j = 0; j < currFace.mNumIndices; ++ j)
-				{
-					m_ModelIndices.push_back(currFace.mIndices[j]);
-				}
+				outMesh.BoundsMin = glm::min(outMesh.BoundsMin, vertex.Position);
+				outMesh.BoundsMax = glm::max(outMesh.BoundsMax, vertex.Position);
 			}
 		}
 
-		return AddMesh(m_ModelVertices, m_ModelIndices);	
+		// We dont generate LODs yet so the only level is the whole mesh
+		outMesh.LODs.push_back({ 0u, static_cast<uint32_t>(outMesh.Indices.size()), 0.0f, 0u });
+
+		// Cluster here so it ends up in the cache too
+		if (outMesh.Indices.size() / 3u >= MeshletBuilder::MIN_TRIANGLES_TO_CLUSTER)
+		{
+			MeshletBuilder::Build(outMesh.Vertices.data(), outMesh.Vertices.size(), outMesh.Indices.data(), outMesh.Indices.size(), 0u, outMesh.Meshlets);
+		}
+
+		return true;
 	}
 
 	// Binds the buffers
@@ -219,7 +374,11 @@ namespace Velocity
 	// Syncronises the buffer after a serialisation
 	void BufferManager::Sync()
 	{
+		m_VertexCount = m_Vertices.size();
+		m_IndexCount = m_Indices.size();
+
 		// Update vertex buffer
+		if (!m_Vertices.empty())
 		{
 			// Calculate size of area
 			VkDeviceSize stagingSize = m_Vertices.size() * sizeof(Vertex);
@@ -262,6 +421,7 @@ namespace Velocity
 		}
 
 		// Update index buffer
+		if (!m_Indices.empty())
 		{
 			// Calculate the size of the new area
 			VkDeviceSize stagingSize = m_Indices.size() * sizeof(uint32_t);
@@ -299,6 +459,389 @@ namespace Velocity
 				commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), m_IndexBuffer->Buffer.get(), 1, &copyRegion);
 			}
 		}
+
+		// Update meshlet buffer
+		if (!m_Meshlets.empty())
+		{
+			UploadToBuffer(*m_MeshletBuffer, m_Meshlets.data(), m_Meshlets.size() * sizeof(Meshlet), 0);
+		}
+
+		// The GPU has it all now
+		if (!m_KeepCPUCopy)
+		{
+			ToggleCPUCopy(false);
+		}
+	}
+
+	bool BufferManager::LoadGeometry(size_t vertexCount, size_t indexCount, size_t meshletCount, const std::function<bool(Vertex*, uint32_t*, Meshlet*)>& fill)
+	{
+		const VkDeviceSize vertexSize = vertexCount * sizeof(Vertex);
+		const VkDeviceSize indexSize = indexCount * sizeof(uint32_t);
+		const VkDeviceSize meshletSize = meshletCount * sizeof(Meshlet);
+		if (vertexSize > DEFAULT_BUFFER_SIZE || indexSize > DEFAULT_BUFFER_SIZE || meshletSize > MESHLET_BUFFER_SIZE)
+		{
+			VEL_CORE_ERROR("Scene geometry doesnt fit in the buffers!");
+			return false;
+		}
+
+		Clear();
+		m_Meshlets.resize(meshletCount);
+		if (m_KeepCPUCopy)
+		{
+			m_Vertices.resize(vertexCount);
+			m_Indices.resize(indexCount);
+		}
+
+		// One staging buffer for all three, each section 16 byte aligned
+		const VkDeviceSize indexOffset = (vertexSize + 15u) & ~static_cast<VkDeviceSize>(15u);
+		const VkDeviceSize meshletOffset = (indexOffset + indexSize + 15u) & ~static_cast<VkDeviceSize>(15u);
+		const VkDeviceSize stagingSize = std::max<VkDeviceSize>(meshletOffset + meshletSize, 16u);
+
+		std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
+			r_PhysicalDevice,
+			*r_LogicalDevice,
+			stagingSize,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+		void* data;
+		vk::Result result = r_LogicalDevice->get().mapMemory(stagingBuffer->Memory.get(), 0, stagingSize, vk::MemoryMapFlags{}, &data);
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to map memory!");
+			VEL_CORE_ASSERT(false, "Failed to map memory!");
+			return false;
+		}
+		auto* staging = static_cast<uint8_t*>(data);
+
+		// Staging memory is write only as far as we are concerned, the meshlets are always kept so they go to the CPU array
+		auto* vertices = m_KeepCPUCopy ? m_Vertices.data() : reinterpret_cast<Vertex*>(staging);
+		auto* indices = m_KeepCPUCopy ? m_Indices.data() : reinterpret_cast<uint32_t*>(staging + indexOffset);
+		if (!fill(vertices, indices, m_Meshlets.data()))
+		{
+			r_LogicalDevice->get().unmapMemory(stagingBuffer->Memory.get());
+			Clear();
+			return false;
+		}
+
+		if (m_KeepCPUCopy)
+		{
+			memcpy(staging, m_Vertices.data(), vertexSize);
+			memcpy(staging + indexOffset, m_Indices.data(), indexSize);
+		}
+		memcpy(staging + meshletOffset, m_Meshlets.data(), meshletSize);
+		r_LogicalDevice->get().unmapMemory(stagingBuffer->Memory.get());
+
+		{
+			TemporaryCommandBuffer bufferWrapper = TemporaryCommandBuffer(*r_LogicalDevice, r_Pool, r_CopyQueue);
+			auto& commandBuffer = bufferWrapper.GetBuffer();
+
+			if (vertexSize > 0u)
+			{
+				vk::BufferCopy copyRegion = { 0, 0, vertexSize };
+				commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), m_VertexBuffer->Buffer.get(), 1, &copyRegion);
+			}
+			if (indexSize > 0u)
+			{
+				vk::BufferCopy copyRegion = { indexOffset, 0, indexSize };
+				commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), m_IndexBuffer->Buffer.get(), 1, &copyRegion);
+			}
+			if (meshletSize > 0u)
+			{
+				vk::BufferCopy copyRegion = { meshletOffset, 0, meshletSize };
+				commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), m_MeshletBuffer->Buffer.get(), 1, &copyRegion);
+			}
+		}
+
+		m_VertexCount = vertexCount;
+		m_IndexCount = indexCount;
+		return true;
+	}
+
+	void BufferManager::ToggleCPUCopy(bool state)
+	{
+		m_KeepCPUCopy = state;
+		if (!m_KeepCPUCopy)
+		{
+			std::vector<Vertex>().swap(m_Vertices);
+			std::vector<uint32_t>().swap(m_Indices);
+		}
+	}
+
+	void BufferManager::ReadBack(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		if (m_Vertices.size() == m_VertexCount && m_Indices.size() == m_IndexCount)
+		{
+			vertices = m_Vertices;
+			indices = m_Indices;
+			return;
+		}
+
+		if (!ReadBackAsync()(vertices, indices))
+		{
+			vertices.clear();
+			indices.clear();
+		}
+	}
+
+	BufferManager::HeapReadbackJob BufferManager::ReadBackAsync()
+	{
+		// Both buffers land in the one staging buffer, indices straight after the vertices
+		const VkDeviceSize vertexBytes = m_VertexCount * sizeof(Vertex);
+		const VkDeviceSize indexBytes = m_IndexCount * sizeof(uint32_t);
+		auto readback = std::make_shared<StagingReadback>(r_PhysicalDevice, *r_LogicalDevice, r_CopyQueueIndex, vertexBytes + indexBytes);
+
+		auto& commandBuffer = readback->GetBuffer();
+		if (vertexBytes > 0u)
+		{
+			vk::BufferCopy copyRegion = { 0, 0, vertexBytes };
+			commandBuffer.copyBuffer(m_VertexBuffer->Buffer.get(), readback->GetStaging(), 1, &copyRegion);
+		}
+		if (indexBytes > 0u)
+		{
+			vk::BufferCopy copyRegion = { 0, vertexBytes, indexBytes };
+			commandBuffer.copyBuffer(m_IndexBuffer->Buffer.get(), readback->GetStaging(), 1, &copyRegion);
+		}
+		if (!readback->Submit())
+		{
+			readback.reset();
+		}
+
+		const size_t vertexCount = m_VertexCount;
+		const size_t indexCount = m_IndexCount;
+		return [readback, vertexCount, indexCount](std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+		{
+			const uint8_t* data = readback ? readback->Wait() : nullptr;
+			if (!data)
+			{
+				return false;
+			}
+
+			vertices.resize(vertexCount);
+			indices.resize(indexCount);
+			memcpy(vertices.data(), data, vertexCount * sizeof(Vertex));
+			memcpy(indices.data(), data + vertexCount * sizeof(Vertex), indexCount * sizeof(uint32_t));
+			return true;
+		};
+	}
+
+	size_t BufferManager::GetHostMemory() const
+	{
+		return m_Vertices.capacity() * sizeof(Vertex) + m_Indices.capacity() * sizeof(uint32_t) + m_Meshlets.capacity() * sizeof(Meshlet);
+	}
+
+	size_t BufferManager::GetDeviceMemory() const
+	{
+		return static_cast<size_t>(m_VertexBuffer->Size + m_IndexBuffer->Size + m_MeshletBuffer->Size);
+	}
+
+	// Regenerates the meshlets for every mesh after a serialisation
+	void BufferManager::RebuildMeshlets(std::unordered_map<std::string, MeshIndexer>& renderables)
+	{
+		m_Meshlets.clear();
+
+		for (auto& [name, mesh] : renderables)
+		{
+			mesh.MeshletStart = 0u;
+			mesh.MeshletCount = 0u;
+
+			ComputeBounds(mesh, &m_Vertices.at(mesh.VertexOffset));
+
+			if (mesh.IndexCount / 3u < MeshletBuilder::MIN_TRIANGLES_TO_CLUSTER)
+			{
+				continue;
+			}
+
+			mesh.MeshletStart = static_cast<uint32_t>(m_Meshlets.size());
+			MeshletBuilder::Build(&m_Vertices.at(mesh.VertexOffset), mesh.VertexCount, &m_Indices.at(mesh.IndexStart), mesh.IndexCount, mesh.IndexStart, m_Meshlets);
+			mesh.MeshletCount = static_cast<uint32_t>(m_Meshlets.size()) - mesh.MeshletStart;
+		}
+
+		// Sync will do the upload. Too many clusters just means some meshes draw whole
+		if (m_Meshlets.size() * sizeof(Meshlet) > MESHLET_BUFFER_SIZE)
+		{
+			VEL_CORE_WARN("Meshlet buffer is full! Large meshes will not be cluster culled");
+			m_Meshlets.clear();
+			for (auto& [name, mesh] : renderables)
+			{
+				mesh.MeshletStart = 0u;
+				mesh.MeshletCount = 0u;
+			}
+		}
+	}
+
+	bool BufferManager::Compact(std::unordered_map<std::string, MeshIndexer>& renderables)
+	{
+		// Ranges still in use by where they start. Renderables loaded from the same file share theirs
+		std::map<uint32_t, uint32_t> vertexRanges;
+		std::map<uint32_t, uint32_t> indexRanges;
+		std::map<uint32_t, MeshIndexer> meshletRanges;
+		for (const auto& [name, mesh] : renderables)
+		{
+			auto& vertexCount = vertexRanges[mesh.VertexOffset];
+			vertexCount = std::max(vertexCount, mesh.VertexCount);
+			auto& indexCount = indexRanges[mesh.IndexStart];
+			indexCount = std::max(indexCount, mesh.IndexCount);
+			if (mesh.MeshletCount > 0u)
+			{
+				meshletRanges[mesh.MeshletStart] = mesh;
+			}
+		}
+
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		ReadBack(vertices, indices);
+		auto fits = [](const std::map<uint32_t, uint32_t>& ranges, size_t size)
+		{
+			return std::all_of(ranges.begin(), ranges.end(), [size](const auto& range) { return static_cast<size_t>(range.first) + range.second <= size; });
+		};
+		if (!fits(vertexRanges, vertices.size()) || !fits(indexRanges, indices.size()))
+		{
+			VEL_CORE_ERROR("Couldnt read the geometry heap back to compact it!");
+			return false;
+		}
+
+		// Copied down in heap order so the meshes keep their relative placement
+		std::unordered_map<uint32_t, uint32_t> vertexMoves;
+		std::vector<Vertex> packedVertices;
+		for (const auto& [start, count] : vertexRanges)
+		{
+			vertexMoves[start] = static_cast<uint32_t>(packedVertices.size());
+			packedVertices.insert(packedVertices.end(), vertices.begin() + start, vertices.begin() + start + count);
+		}
+
+		std::unordered_map<uint32_t, uint32_t> indexMoves;
+		std::vector<uint32_t> packedIndices;
+		for (const auto& [start, count] : indexRanges)
+		{
+			// Indices are relative to the mesh's vertices so only where they start changes
+			indexMoves[start] = static_cast<uint32_t>(packedIndices.size());
+			packedIndices.insert(packedIndices.end(), indices.begin() + start, indices.begin() + start + count);
+		}
+
+		// Clusters point into the global index buffer, so they follow their mesh's indices
+		std::unordered_map<uint32_t, uint32_t> meshletMoves;
+		std::vector<Meshlet> packedMeshlets;
+		for (const auto& [start, mesh] : meshletRanges)
+		{
+			meshletMoves[start] = static_cast<uint32_t>(packedMeshlets.size());
+			for (uint32_t i = start; i < start + mesh.MeshletCount && i < m_Meshlets.size(); ++i)
+			{
+				Meshlet meshlet = m_Meshlets[i];
+				meshlet.IndexStart = meshlet.IndexStart - mesh.IndexStart + indexMoves[mesh.IndexStart];
+				packedMeshlets.push_back(meshlet);
+			}
+		}
+
+		// Returns false for a mesh whose ranges were dropped
+		auto relocate = [&](MeshIndexer& mesh)
+		{
+			auto vertexMove = vertexMoves.find(mesh.VertexOffset);
+			auto indexMove = indexMoves.find(mesh.IndexStart);
+			auto meshletMove = meshletMoves.find(mesh.MeshletStart);
+			if (vertexMove == vertexMoves.end() || indexMove == indexMoves.end() || (mesh.MeshletCount > 0u && meshletMove == meshletMoves.end()))
+			{
+				return false;
+			}
+
+			mesh.VertexOffset = vertexMove->second;
+			mesh.IndexStart = indexMove->second;
+			mesh.MeshletStart = mesh.MeshletCount > 0u ? meshletMove->second : 0u;
+			return true;
+		};
+
+		for (auto& [name, mesh] : renderables)
+		{
+			relocate(mesh);
+		}
+
+		// Files no longer in the heap load again from the mesh cache next time
+		for (auto it = m_LoadedMeshes.begin(); it != m_LoadedMeshes.end();)
+		{
+			it = relocate(it->second) ? std::next(it) : m_LoadedMeshes.erase(it);
+		}
+
+		m_Vertices = std::move(packedVertices);
+		m_Indices = std::move(packedIndices);
+		m_Meshlets = std::move(packedMeshlets);
+		Sync();
+
+		return true;
+	}
+
+	// Clusters the given mesh if it is big enough and records the range in the indexer
+	void BufferManager::BuildMeshlets(MeshIndexer& mesh, const Vertex* vertices, const uint32_t* indices)
+	{
+		if (mesh.IndexCount / 3u < MeshletBuilder::MIN_TRIANGLES_TO_CLUSTER)
+		{
+			return;
+		}
+
+		const auto firstMeshlet = m_Meshlets.size();
+		MeshletBuilder::Build(vertices, mesh.VertexCount, indices, mesh.IndexCount, mesh.IndexStart, m_Meshlets);
+
+		if (m_Meshlets.size() * sizeof(Meshlet) > MESHLET_BUFFER_SIZE)
+		{
+			VEL_CORE_WARN("Meshlet buffer is full! Mesh will not be cluster culled");
+			m_Meshlets.resize(firstMeshlet);
+			return;
+		}
+
+		mesh.MeshletStart = static_cast<uint32_t>(firstMeshlet);
+		mesh.MeshletCount = static_cast<uint32_t>(m_Meshlets.size() - firstMeshlet);
+
+		UploadToBuffer(*m_MeshletBuffer, &m_Meshlets.at(firstMeshlet), mesh.MeshletCount * sizeof(Meshlet), firstMeshlet * sizeof(Meshlet));
+	}
+
+	// Sets the bounding radius from the mesh's vertices
+	void BufferManager::ComputeBounds(MeshIndexer& mesh, const Vertex* vertices)
+	{
+		float radiusSquared = 0.0f;
+		for (uint32_t i = 0; i < mesh.VertexCount; ++i)
+		{
+			const glm::vec3& position = vertices[i].Position;
+			radiusSquared = std::max<float>(radiusSquared, glm::dot(position, position));
+		}
+		mesh.BoundingRadius = std::sqrt(radiusSquared);
+	}
+
+	// Copies data into a device local buffer through a temporary staging buffer
+	bool BufferManager::UploadToBuffer(BaseBuffer& destination, const void* source, VkDeviceSize size, VkDeviceSize destinationOffset)
+	{
+		std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
+			r_PhysicalDevice,
+			*r_LogicalDevice,
+			size,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+		void* data;
+		vk::Result result = r_LogicalDevice->get().mapMemory(stagingBuffer->Memory.get(), 0, size, vk::MemoryMapFlags{}, &data);
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to map memory!");
+			VEL_CORE_ASSERT(false, "Failed to map memory!");
+			return false;
+		}
+		memcpy(data, source, size);
+		r_LogicalDevice->get().unmapMemory(stagingBuffer->Memory.get());
+
+		{
+			TemporaryCommandBuffer bufferWrapper = TemporaryCommandBuffer(*r_LogicalDevice, r_Pool, r_CopyQueue);
+			auto& commandBuffer = bufferWrapper.GetBuffer();
+
+			vk::BufferCopy copyRegion = {
+				0,
+				destinationOffset,
+				size
+			};
+
+			commandBuffer.copyBuffer(stagingBuffer->Buffer.get(), destination.Buffer.get(), 1, &copyRegion);
+		}
+
+		return true;
 	}
 
 }
@@ -1,17 +1,33 @@
 #pragma once
 
+#include <functional>
+
 #include "BaseBuffer.hpp"
 #include "Vertex.hpp"
+#include "Meshlet.hpp"
+#include "MeshCache.hpp"
+#include "StagingReadback.hpp"
 
 #include <Velocity/ECS/Components.hpp>
 
 namespace Velocity
 {
+	// Picks the import path, the defaults are what normal loads use. The output is the same either way
+	struct MeshImportOptions
+	{
+		// Post process sub meshes on the thread pool rather than one after another
+		bool	ParallelPostProcess = true;
+
+		// Parse OBJ files with ObjLoader. Files it cant handle still go through assimp
+		bool	FastObj = true;
+	};
+
 	// Stores and sync all our the main buffers shared by the whole program
 	class BufferManager
 	{
 	public:
 		friend class Scene;	// Scene needs to access the arrays
+		friend class ClusterCuller;	// Culling reads the meshlet and index buffers directly
 		
 		struct MeshIndexer
 		{
@@ -20,41 +36,124 @@ namespace Velocity
 			uint32_t	IndexStart = 0u;
 			uint32_t	IndexCount = 0u;
 
+			// Only set for meshes big enough to be clustered. Saved with the ranges so loading doesnt rebuild them
+			uint32_t	MeshletStart = 0u;
+			uint32_t	MeshletCount = 0u;
+
+			// Furthest vertex from the model origin
+			float		BoundingRadius = 0.0f;
+
+			// Every field, the same bytes SceneMesh writes as one block
 			template<class Archive>
 			void save(Archive& ar) const
 			{
-				ar(VertexOffset, VertexCount, IndexStart, IndexCount);
+				ar(VertexOffset, VertexCount, IndexStart, IndexCount, MeshletStart, MeshletCount, BoundingRadius);
 			}
 
 			template<class Archive>
 			void load(Archive& ar)
 			{
-				ar(VertexOffset, VertexCount, IndexStart, IndexCount);
+				ar(VertexOffset, VertexCount, IndexStart, IndexCount, MeshletStart, MeshletCount, BoundingRadius);
 			}
 		
 		};
 		
-		// CopyQueue is 99.9% the Graphics Queue
-		BufferManager(vk::PhysicalDevice& pDevice, vk::UniqueDevice& device, vk::CommandPool& pool, vk::Queue& copyQueue);
+		// CopyQueue is 99.9% the Graphics Queue. copyQueueIndex is its family, read backs get their own pool on it
+		BufferManager(vk::PhysicalDevice& pDevice, vk::UniqueDevice& device, vk::CommandPool& pool, vk::Queue& copyQueue, uint32_t copyQueueIndex);
 
 		// TODO: Update as we change how this works
 		MeshIndexer AddMesh(std::vector<Vertex>& verts, std::vector<uint32_t> indices);
 
+		// Loads through the mesh cache. Loading the same file again returns the existing indexer
 		MeshIndexer AddMesh(const std::string& filepath);
 
+		// Result of the CPU side of loading a mesh file
+		struct PreparedMesh
+		{
+			uint64_t		Key = 0u;
+			bool			FromCache = false;
+
+			// Cache hits point into the mapped blob, misses own the freshly imported geometry
+			MappedFile		Blob;
+			CachedMeshView	Cached;
+			ImportedMesh	Imported;
+		};
+
+		// Does all the CPU work of loading a mesh file (hash, cache lookup, import). Safe to call from any thread
+		static bool PrepareMesh(const std::string& filepath, PreparedMesh& outPrepared);
+
+		// Imports the file and converts the result to our vertex format, clusters and bounds. Skips the mesh cache
+		static bool ImportMesh(const std::string& filepath, ImportedMesh& outMesh, const MeshImportOptions& options = MeshImportOptions());
+
+		// Mesh cache key for a source file with the given Hash::Bytes
+		static uint64_t ComputeMeshKey(uint64_t sourceHash);
+
+		// Adds a prepared mesh to the heap and uploads it. Main thread only
+		MeshIndexer AddPreparedMesh(PreparedMesh& prepared);
+
 		// Binds the buffers
 		void Bind(vk::CommandBuffer& commandBuffer);
 
 		// Clear the buffer
-		void Clear() { m_Vertices.clear(); m_Indices.clear(); }
+		void Clear() { m_Vertices.clear(); m_Indices.clear(); m_Meshlets.clear(); m_LoadedMeshes.clear(); m_VertexCount = 0u; m_IndexCount = 0u; }
 
 		// Syncronises the buffer after a serialisation
 		void Sync();
+
+		// Replaces the whole heap with geometry written by fill, for scene loads
+		// Fill is handed the upload staging memory directly, or the CPU copy when one is kept, so it can decompress in place
+		// Meshlets are taken as they are so the renderables must already point at them. Returns false if fill does
+		bool LoadGeometry(size_t vertexCount, size_t indexCount, size_t meshletCount, const std::function<bool(Vertex*, uint32_t*, Meshlet*)>& fill);
+
+		// With the copy off geometry only lives on the GPU once uploaded. Turning it off frees what is held now
+		void ToggleCPUCopy(bool state);
+
+		// Every vertex and index in the heap. Comes from the CPU copy if there is one, otherwise it is read back off the GPU
+		void ReadBack(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Fills the vectors once the copy back has finished. Returns false if it failed
+		using HeapReadbackJob = std::function<bool(std::vector<Vertex>&, std::vector<uint32_t>&)>;
+
+		// As ReadBack but always off the GPU and only started here. Main thread only, the job waits for it on any thread
+		HeapReadbackJob ReadBackAsync();
+
+		// Bytes held in system memory and allocated on the GPU
+		size_t GetHostMemory() const;
+		size_t GetDeviceMemory() const;
+
+		// Regenerates the meshlets and bounds for every mesh after a serialisation. Call before Sync
+		void RebuildMeshlets(std::unordered_map<std::string, MeshIndexer>& renderables);
+
+		// Packs the ranges the given renderables use to the front of the heap, dropping everything else, and reuploads it
+		// Renderables are updated to their new ranges. The GPU must be idle. Returns false and leaves the heap alone if it cant read it back
+		bool Compact(std::unordered_map<std::string, MeshIndexer>& renderables);
 	
 	private:
 
+		// Post processing applied on import, in assimp's terms. Part of the mesh cache key
+		static const unsigned int IMPORT_FLAGS;
+
+		// Appends geometry to the heap and uploads it. Meshlets are optional and relative to indices
+		MeshIndexer AddMesh(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, const Meshlet* meshlets, size_t meshletCount);
+
+		// Maps the source file and hashes it into a mesh cache key
+		static bool ComputeSourceKey(const std::string& filepath, uint64_t& outKey);
+
+		// Maps the cached blob for the key, or imports the file and fills the cache
+		static bool LoadOrImport(const std::string& filepath, PreparedMesh& prepared);
+
+		// Clusters the given mesh if it is big enough and records the range in the indexer
+		// Vertices and indices are the mesh's own, the heap may not hold a copy
+		void BuildMeshlets(MeshIndexer& mesh, const Vertex* vertices, const uint32_t* indices);
+
+		// Sets the bounding radius from the mesh's vertices
+		void ComputeBounds(MeshIndexer& mesh, const Vertex* vertices);
+
+		// Copies data into a device local buffer through a temporary staging buffer
+		bool UploadToBuffer(BaseBuffer& destination, const void* source, VkDeviceSize size, VkDeviceSize destinationOffset);
+
 		// By default allocate two 128mb buffers. This will change in the future as it needs too
-		const static VkDeviceSize DEFAULT_BUFFER_SIZE = static_cast<VkDeviceSize>(67108864u);
+		static constexpr VkDeviceSize DEFAULT_BUFFER_SIZE = static_cast<VkDeviceSize>(67108864u);
 
 		// A completely contiguous list of all vertices of all models
 		std::vector<Vertex> m_Vertices;
@@ -62,15 +161,33 @@ namespace Velocity
 		// As above with indicies
 		std::vector<uint32_t> m_Indices;
 
+		// How much of each GPU buffer is in use. Matches the CPU arrays unless the copy has been dropped
+		size_t m_VertexCount = 0u;
+		size_t m_IndexCount = 0u;
+
+		// Keeps m_Vertices and m_Indices filled after upload
+		bool m_KeepCPUCopy = true;
+
+		// Clusters of the large meshes. IndexStart values point into m_Indices
+		std::vector<Meshlet> m_Meshlets;
+
+		// Meshes already in the heap by mesh cache key, so duplicate loads share one indexer
+		std::unordered_map<uint64_t, MeshIndexer> m_LoadedMeshes;
+
+		// Enough for ~170k clusters, or ~21 million clustered triangles
+		static constexpr VkDeviceSize MESHLET_BUFFER_SIZE = static_cast<VkDeviceSize>(8388608u);
+
 		// The actual GPU memory buffers
 		std::unique_ptr<BaseBuffer> m_VertexBuffer;
 		std::unique_ptr<BaseBuffer> m_IndexBuffer;
+		std::unique_ptr<BaseBuffer> m_MeshletBuffer;
 	
 		// References to renderer
 		vk::PhysicalDevice r_PhysicalDevice;
 		vk::UniqueDevice* r_LogicalDevice;
 		vk::CommandPool r_Pool;
 		vk::Queue r_CopyQueue;
+		uint32_t r_CopyQueueIndex;
 	};
 
 };
\ No newline at end of file
@@ -0,0 +1,378 @@
+#include "velpch.h"
+
+#include "ClusterCuller.hpp"
+
+#include "Shader.hpp"
+
+namespace Velocity
+{
+	ClusterCuller::ClusterCuller(vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, BufferManager& bufferManager, size_t imageCount)
+	{
+		r_Device = &device;
+		r_PhysicalDevice = pDevice;
+		r_BufferManager = &bufferManager;
+
+		CreatePipeline();
+		CreateFrameResources(imageCount);
+	}
+
+	ClusterCuller::~ClusterCuller()
+	{
+		for (auto& frame : m_Frames)
+		{
+			r_Device->get().unmapMemory(frame.DrawCommands->Memory.get());
+			r_Device->get().unmapMemory(frame.Jobs->Memory.get());
+			r_Device->get().unmapMemory(frame.Frustum->Memory.get());
+		}
+	}
+
+	// Resets the jobs for this image and sets the frustum the clusters are tested against
+	void ClusterCuller::BeginFrame(uint32_t imageIndex, const glm::mat4& viewProjection, const glm::vec3& cameraPosition)
+	{
+		m_CurrentImage = imageIndex;
+		m_JobCount = 0u;
+		m_IndicesUsed = 0u;
+		m_GroupsUsed = 0u;
+		m_EntityJobs.clear();
+
+		// Pull the planes out of the view projection matrix (Gribb & Hartmann)
+		// The near plane uses the -1..1 form which is slightly loose for our 0..1 depth, but never culls something visible
+		auto row = [&viewProjection](int i) { return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]); };
+
+		auto& frustum = *m_Frames.at(imageIndex).MappedFrustum;
+		frustum.Planes = {
+			row(3) + row(0),
+			row(3) - row(0),
+			row(3) + row(1),
+			row(3) - row(1),
+			row(3) + row(2),
+			row(3) - row(2)
+		};
+
+		for (auto& plane : frustum.Planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+
+		frustum.CameraPosition = glm::vec4(cameraPosition, 1.0f);
+	}
+
+	// Queues a mesh to be culled for this entity. Returns false if the mesh should just be drawn whole
+	bool ClusterCuller::Submit(uint32_t entity, const glm::mat4& world, const BufferManager::MeshIndexer& mesh)
+	{
+		if (mesh.MeshletCount == 0u || m_JobCount >= MAX_JOBS)
+		{
+			return false;
+		}
+
+		// Out of space in the compacted buffer this frame
+		if ((m_IndicesUsed + mesh.IndexCount) * sizeof(uint32_t) > CULLED_INDEX_BUFFER_SIZE)
+		{
+			return false;
+		}
+
+		// Or out of workgroups for the dispatch
+		const uint32_t groups = (mesh.MeshletCount + WORKGROUP_SIZE - 1u) / WORKGROUP_SIZE;
+		if (m_GroupsUsed + groups > MAX_GROUPS)
+		{
+			return false;
+		}
+
+		auto& frame = m_Frames.at(m_CurrentImage);
+
+		// Radius scales with the largest axis. The cone only survives a uniform scale
+		glm::vec3 scale = {
+			glm::length(glm::vec3(world[0])),
+			glm::length(glm::vec3(world[1])),
+			glm::length(glm::vec3(world[2]))
+		};
+		float maxScale = glm::max(scale.x, glm::max(scale.y, scale.z));
+		float minScale = glm::min(scale.x, glm::min(scale.y, scale.z));
+
+		auto& job = frame.MappedJobs[m_JobCount];
+		job.World = world;
+		job.MeshletStart = mesh.MeshletStart;
+		job.MeshletCount = mesh.MeshletCount;
+		job.OutputStart = m_IndicesUsed;
+		job.MaxScale = maxScale;
+		job.ConeCulling = (maxScale - minScale) <= maxScale * 0.001f ? 1u : 0u;
+		job.FirstGroup = m_GroupsUsed;
+
+		// The shader only bumps the index count, everything else is known now
+		frame.MappedDrawCommands[m_JobCount] = vk::DrawIndexedIndirectCommand{
+			0u,
+			1u,
+			m_IndicesUsed,
+			static_cast<int32_t>(mesh.VertexOffset),
+			0u
+		};
+
+		m_EntityJobs[entity] = m_JobCount;
+		m_IndicesUsed += mesh.IndexCount;
+		m_GroupsUsed += groups;
+		++m_JobCount;
+
+		return true;
+	}
+
+	// Records one dispatch that culls every submitted job. Must be called outside of a render pass
+	void ClusterCuller::Dispatch(vk::CommandBuffer& commandBuffer)
+	{
+		if (m_JobCount == 0u)
+		{
+			return;
+		}
+
+		auto& frame = m_Frames.at(m_CurrentImage);
+
+		commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipeline.get());
+		commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_Layout.get(), 0, 1, &frame.Set, 0, nullptr);
+
+		// Workgroups find their job from each job's first group, so every job goes in one dispatch
+		commandBuffer.pushConstants(m_Layout.get(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(uint32_t), &m_JobCount);
+		commandBuffer.dispatch(m_GroupsUsed, 1, 1);
+
+		// Make the compacted indices and counts visible to the draws
+		vk::MemoryBarrier barrier = {
+			vk::AccessFlagBits::eShaderWrite,
+			vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eIndexRead
+		};
+
+		commandBuffer.pipelineBarrier(
+			vk::PipelineStageFlagBits::eComputeShader,
+			vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+			vk::DependencyFlags{},
+			1, &barrier,
+			0, nullptr,
+			0, nullptr
+		);
+	}
+
+	// Draws the surviving clusters of a submitted entity. Returns false if the entity wasnt submitted
+	bool ClusterCuller::Draw(vk::CommandBuffer& commandBuffer, uint32_t entity)
+	{
+		auto job = m_EntityJobs.find(entity);
+		if (job == m_EntityJobs.end())
+		{
+			return false;
+		}
+
+		auto& frame = m_Frames.at(m_CurrentImage);
+
+		commandBuffer.bindIndexBuffer(frame.CulledIndices->Buffer.get(), 0, vk::IndexType::eUint32);
+		commandBuffer.drawIndexedIndirect(frame.DrawCommands->Buffer.get(), job->second * sizeof(vk::DrawIndexedIndirectCommand), 1, sizeof(vk::DrawIndexedIndirectCommand));
+
+		// Put the shared index buffer back for everything else
+		commandBuffer.bindIndexBuffer(r_BufferManager->m_IndexBuffer->Buffer.get(), 0, vk::IndexType::eUint32);
+
+		return true;
+	}
+
+	void ClusterCuller::CreatePipeline()
+	{
+		// 0 meshlets, 1 source indices, 2 culled indices, 3 draw commands, 4 jobs, 5 frustum
+		std::array<vk::DescriptorSetLayoutBinding, 6> bindings;
+		for (uint32_t i = 0; i < 5; ++i)
+		{
+			bindings.at(i) = { i, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr };
+		}
+		bindings.at(5) = { 5, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr };
+
+		vk::DescriptorSetLayoutCreateInfo layoutInfo = {
+			vk::DescriptorSetLayoutCreateFlags{},
+			static_cast<uint32_t>(bindings.size()),
+			bindings.data()
+		};
+
+		try
+		{
+			m_DescriptorSetLayout = r_Device->get().createDescriptorSetLayoutUnique(layoutInfo);
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create cluster cull descriptor set layout! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create cluster cull descriptor set layout! Error: {0}", e.what());
+			return;
+		}
+
+		// Just the job count
+		vk::PushConstantRange pushRange = {
+			vk::ShaderStageFlagBits::eCompute,
+			0,
+			sizeof(uint32_t)
+		};
+
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo = {
+			vk::PipelineLayoutCreateFlags{},
+			1,
+			&m_DescriptorSetLayout.get(),
+			1,
+			&pushRange
+		};
+
+		try
+		{
+			m_Layout = r_Device->get().createPipelineLayoutUnique(pipelineLayoutInfo);
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create cluster cull pipeline layout! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create cluster cull pipeline layout! Error: {0}", e.what());
+			return;
+		}
+
+		vk::ShaderModule computeShaderModule = Shader::CreateShaderModule(*r_Device, "../Velocity/assets/shaders/clustercullcomp.spv");
+
+		vk::ComputePipelineCreateInfo pipelineInfo = {
+			vk::PipelineCreateFlags{},
+			vk::PipelineShaderStageCreateInfo{
+				vk::PipelineShaderStageCreateFlags{},
+				vk::ShaderStageFlagBits::eCompute,
+				computeShaderModule,
+				"main"
+			},
+			m_Layout.get()
+		};
+
+		try
+		{
+			auto result = r_Device->get().createComputePipelineUnique(nullptr, pipelineInfo);
+			m_Pipeline = std::move(result.value);
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create cluster cull pipeline! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create cluster cull pipeline! Error: {0}", e.what());
+		}
+
+		r_Device->get().destroyShaderModule(computeShaderModule);
+	}
+
+	void ClusterCuller::CreateFrameResources(size_t imageCount)
+	{
+		std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+			vk::DescriptorPoolSize{ vk::DescriptorType::eStorageBuffer, static_cast<uint32_t>(imageCount * 5) },
+			vk::DescriptorPoolSize{ vk::DescriptorType::eUniformBuffer, static_cast<uint32_t>(imageCount) }
+		};
+
+		vk::DescriptorPoolCreateInfo poolInfo = {
+			vk::DescriptorPoolCreateFlags{},
+			static_cast<uint32_t>(imageCount),
+			static_cast<uint32_t>(poolSizes.size()),
+			poolSizes.data()
+		};
+
+		try
+		{
+			m_DescriptorPool = r_Device->get().createDescriptorPoolUnique(poolInfo);
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create cluster cull descriptor pool! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create cluster cull descriptor pool! Error: {0}", e.what());
+			return;
+		}
+
+		m_Frames.resize(imageCount);
+		for (auto& frame : m_Frames)
+		{
+			frame.CulledIndices = std::make_unique<BaseBuffer>(
+				r_PhysicalDevice,
+				*r_Device,
+				CULLED_INDEX_BUFFER_SIZE,
+				vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndexBuffer,
+				vk::MemoryPropertyFlagBits::eDeviceLocal
+			);
+
+			frame.DrawCommands = std::make_unique<BaseBuffer>(
+				r_PhysicalDevice,
+				*r_Device,
+				MAX_JOBS * sizeof(vk::DrawIndexedIndirectCommand),
+				vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer,
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+			frame.Jobs = std::make_unique<BaseBuffer>(
+				r_PhysicalDevice,
+				*r_Device,
+				MAX_JOBS * sizeof(CullJob),
+				vk::BufferUsageFlagBits::eStorageBuffer,
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+			frame.Frustum = std::make_unique<BaseBuffer>(
+				r_PhysicalDevice,
+				*r_Device,
+				sizeof(CullFrustum),
+				vk::BufferUsageFlagBits::eUniformBuffer,
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+			// These are written every frame so just leave them mapped
+			void* data;
+			if (r_Device->get().mapMemory(frame.DrawCommands->Memory.get(), 0, VK_WHOLE_SIZE, vk::MemoryMapFlags{}, &data) != vk::Result::eSuccess)
+			{
+				VEL_CORE_ERROR("Failed to map memory!");
+				VEL_CORE_ASSERT(false, "Failed to map memory!");
+				return;
+			}
+			frame.MappedDrawCommands = static_cast<vk::DrawIndexedIndirectCommand*>(data);
+
+			if (r_Device->get().mapMemory(frame.Jobs->Memory.get(), 0, VK_WHOLE_SIZE, vk::MemoryMapFlags{}, &data) != vk::Result::eSuccess)
+			{
+				VEL_CORE_ERROR("Failed to map memory!");
+				VEL_CORE_ASSERT(false, "Failed to map memory!");
+				return;
+			}
+			frame.MappedJobs = static_cast<CullJob*>(data);
+
+			if (r_Device->get().mapMemory(frame.Frustum->Memory.get(), 0, VK_WHOLE_SIZE, vk::MemoryMapFlags{}, &data) != vk::Result::eSuccess)
+			{
+				VEL_CORE_ERROR("Failed to map memory!");
+				VEL_CORE_ASSERT(false, "Failed to map memory!");
+				return;
+			}
+			frame.MappedFrustum = static_cast<CullFrustum*>(data);
+
+			// Allocate and write the set once, none of the buffers ever move
+			vk::DescriptorSetAllocateInfo allocInfo = {
+				m_DescriptorPool.get(),
+				1,
+				&m_DescriptorSetLayout.get()
+			};
+
+			if (r_Device->get().allocateDescriptorSets(&allocInfo, &frame.Set) != vk::Result::eSuccess)
+			{
+				VEL_CORE_ERROR("Failed to allocate cluster cull descriptor set!");
+				VEL_CORE_ASSERT(false, "Failed to allocate cluster cull descriptor set!");
+				return;
+			}
+
+			std::array<vk::DescriptorBufferInfo, 6> bufferInfos = {
+				vk::DescriptorBufferInfo{ r_BufferManager->m_MeshletBuffer->Buffer.get(), 0, VK_WHOLE_SIZE },
+				vk::DescriptorBufferInfo{ r_BufferManager->m_IndexBuffer->Buffer.get(), 0, VK_WHOLE_SIZE },
+				vk::DescriptorBufferInfo{ frame.CulledIndices->Buffer.get(), 0, VK_WHOLE_SIZE },
+				vk::DescriptorBufferInfo{ frame.DrawCommands->Buffer.get(), 0, VK_WHOLE_SIZE },
+				vk::DescriptorBufferInfo{ frame.Jobs->Buffer.get(), 0, VK_WHOLE_SIZE },
+				vk::DescriptorBufferInfo{ frame.Frustum->Buffer.get(), 0, VK_WHOLE_SIZE }
+			};
+
+			std::array<vk::WriteDescriptorSet, 6> writes;
+			for (uint32_t i = 0; i < writes.size(); ++i)
+			{
+				writes.at(i) = vk::WriteDescriptorSet{
+					frame.Set,
+					i,
+					0,
+					1,
+					i == 5 ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer,
+					nullptr,
+					&bufferInfos.at(i),
+					nullptr
+				};
+			}
+
+			r_Device->get().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+	}
+}
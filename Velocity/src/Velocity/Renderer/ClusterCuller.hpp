@@ -0,0 +1,102 @@
+#pragma once
+
+#include <vulkan/vulkan.hpp>
+#include <glm/glm.hpp>
+
+#include "BaseBuffer.hpp"
+#include "BufferManager.hpp"
+
+namespace Velocity
+{
+	// Culls the meshlets of large meshes on the GPU with a compute pass
+	// Visible clusters have their indices compacted into a per frame index buffer which is then drawn with a single indirect call
+	// Only needs core Vulkan 1.0 compute so it runs anywhere, including software implementations
+	class ClusterCuller
+	{
+	public:
+		ClusterCuller(vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, BufferManager& bufferManager, size_t imageCount);
+
+		~ClusterCuller();
+
+		// Resets the jobs for this image and sets the frustum the clusters are tested against
+		void BeginFrame(uint32_t imageIndex, const glm::mat4& viewProjection, const glm::vec3& cameraPosition);
+
+		// Queues a mesh to be culled for this entity. Returns false if the mesh should just be drawn whole
+		bool Submit(uint32_t entity, const glm::mat4& world, const BufferManager::MeshIndexer& mesh);
+
+		// Records one dispatch that culls every submitted job. Must be called outside of a render pass
+		void Dispatch(vk::CommandBuffer& commandBuffer);
+
+		// Draws the surviving clusters of a submitted entity. Returns false if the entity wasnt submitted
+		bool Draw(vk::CommandBuffer& commandBuffer, uint32_t entity);
+
+	private:
+		// Matches CullJob in clustercull.comp
+		struct CullJob
+		{
+			glm::mat4	World;
+			uint32_t	MeshletStart;
+			uint32_t	MeshletCount;
+			uint32_t	OutputStart;
+			float		MaxScale;
+			uint32_t	ConeCulling;
+			uint32_t	FirstGroup;		// First workgroup of the dispatch that culls this job
+			uint32_t	Padding[2];
+		};
+
+		// Matches CullFrustum in clustercull.comp
+		struct CullFrustum
+		{
+			std::array<glm::vec4, 6>	Planes;
+			glm::vec4					CameraPosition;
+		};
+
+		// Per swapchain image as the last frame may still be reading its copy
+		struct FrameResources
+		{
+			std::unique_ptr<BaseBuffer>	CulledIndices;
+			std::unique_ptr<BaseBuffer>	DrawCommands;
+			std::unique_ptr<BaseBuffer>	Jobs;
+			std::unique_ptr<BaseBuffer>	Frustum;
+
+			// Host buffers stay mapped for the lifetime of the culler
+			vk::DrawIndexedIndirectCommand*	MappedDrawCommands = nullptr;
+			CullJob*						MappedJobs = nullptr;
+			CullFrustum*					MappedFrustum = nullptr;
+
+			vk::DescriptorSet				Set;
+		};
+
+		// Limits per frame. Anything past these is drawn without culling
+		static constexpr uint32_t MAX_JOBS = 4096u;
+		static constexpr VkDeviceSize CULLED_INDEX_BUFFER_SIZE = static_cast<VkDeviceSize>(33554432u);
+
+		// Smallest maxComputeWorkGroupCount[0] Vulkan allows, so the single dispatch always fits
+		static constexpr uint32_t MAX_GROUPS = 65535u;
+
+		// Local size of clustercull.comp
+		static constexpr uint32_t WORKGROUP_SIZE = 64u;
+
+		void CreatePipeline();
+		void CreateFrameResources(size_t imageCount);
+
+		// References
+		vk::UniqueDevice* r_Device;
+		vk::PhysicalDevice r_PhysicalDevice;
+		BufferManager* r_BufferManager;
+
+		vk::UniqueDescriptorSetLayout	m_DescriptorSetLayout;
+		vk::UniqueDescriptorPool		m_DescriptorPool;
+		vk::UniquePipelineLayout		m_Layout;
+		vk::UniquePipeline				m_Pipeline;
+
+		std::vector<FrameResources>		m_Frames;
+
+		// State of the frame being recorded
+		uint32_t									m_CurrentImage = 0u;
+		uint32_t									m_JobCount = 0u;
+		uint32_t									m_IndicesUsed = 0u;
+		uint32_t									m_GroupsUsed = 0u;
+		std::unordered_map<uint32_t, uint32_t>		m_EntityJobs;
+	};
+}
@@ -0,0 +1,175 @@
+#include "velpch.h"
+
+#include "CookedTexture.hpp"
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Utility/VirtualFileSystem.hpp>
+
+namespace Velocity
+{
+	const char* CookedTexture::EXTENSION = ".vtex";
+
+	namespace
+	{
+		const char FILE_MAGIC[4] = { 'V','T','E','X' };
+
+		// Anything deeper than this would be wider than vulkan allows anyway
+		const uint32_t MAX_MIP_COUNT = 32u;
+
+		// On disk layout, followed by MipCount FileMips then the block data 16 byte aligned
+		struct FileHeader
+		{
+			char		Magic[4];
+			uint32_t	Version;
+			uint32_t	Format;
+			uint32_t	Flags;
+			uint32_t	Width;
+			uint32_t	Height;
+			uint32_t	MipCount;
+			uint32_t	Padding;
+			uint64_t	DataSize;
+		};
+
+		struct FileMip
+		{
+			uint64_t	Offset;
+			uint64_t	Size;
+			uint32_t	Width;
+			uint32_t	Height;
+		};
+
+		const uint32_t FLAG_SRGB = 1u << 0;
+
+		uint64_t GetDataOffset(uint32_t mipCount)
+		{
+			const uint64_t offset = sizeof(FileHeader) + sizeof(FileMip) * mipCount;
+			return (offset + 15u) & ~static_cast<uint64_t>(15u);
+		}
+	}
+
+	vk::Format CookedTexture::GetVulkanFormat() const
+	{
+		switch (Format)
+		{
+		case BlockFormat::BC1:
+			return Srgb ? vk::Format::eBc1RgbSrgbBlock : vk::Format::eBc1RgbUnormBlock;
+		case BlockFormat::BC3:
+			return Srgb ? vk::Format::eBc3SrgbBlock : vk::Format::eBc3UnormBlock;
+		case BlockFormat::BC4:
+			return vk::Format::eBc4UnormBlock;
+		case BlockFormat::BC5:
+			return vk::Format::eBc5UnormBlock;
+		default:
+			return Srgb ? vk::Format::eBc7SrgbBlock : vk::Format::eBc7UnormBlock;
+		}
+	}
+
+	std::vector<uint8_t> CookedTexture::Serialise() const
+	{
+		FileHeader header = {};
+		memcpy(header.Magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+		header.Version = FORMAT_VERSION;
+		header.Format = static_cast<uint32_t>(Format);
+		header.Flags = Srgb ? FLAG_SRGB : 0u;
+		header.Width = Width;
+		header.Height = Height;
+		header.MipCount = static_cast<uint32_t>(Mips.size());
+		header.DataSize = Data.size();
+
+		const uint64_t dataOffset = GetDataOffset(header.MipCount);
+		std::vector<uint8_t> bytes(static_cast<size_t>(dataOffset) + Data.size(), 0u);
+
+		memcpy(bytes.data(), &header, sizeof(header));
+		for (size_t i = 0; i < Mips.size(); ++i)
+		{
+			const FileMip mip = { Mips[i].Offset, Mips[i].Size, Mips[i].Width, Mips[i].Height };
+			memcpy(bytes.data() + sizeof(FileHeader) + sizeof(FileMip) * i, &mip, sizeof(mip));
+		}
+		if (!Data.empty())
+		{
+			memcpy(bytes.data() + dataOffset, Data.data(), Data.size());
+		}
+
+		return bytes;
+	}
+
+	bool CookedTexture::Deserialise(const uint8_t* bytes, size_t size, CookedTexture& output)
+	{
+		if (size < sizeof(FileHeader))
+		{
+			return false;
+		}
+
+		FileHeader header;
+		memcpy(&header, bytes, sizeof(header));
+
+		if (memcmp(header.Magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0 || header.Version != FORMAT_VERSION ||
+			header.Format > static_cast<uint32_t>(BlockFormat::BC7) || header.MipCount == 0u || header.MipCount > MAX_MIP_COUNT)
+		{
+			return false;
+		}
+
+		const uint64_t dataOffset = GetDataOffset(header.MipCount);
+		if (dataOffset + header.DataSize > size)
+		{
+			return false;
+		}
+
+		output.Format = static_cast<BlockFormat>(header.Format);
+		output.Srgb = (header.Flags & FLAG_SRGB) != 0u;
+		output.Width = header.Width;
+		output.Height = header.Height;
+
+		output.Mips.resize(header.MipCount);
+		for (uint32_t i = 0; i < header.MipCount; ++i)
+		{
+			FileMip mip;
+			memcpy(&mip, bytes + sizeof(FileHeader) + sizeof(FileMip) * i, sizeof(mip));
+
+			// Every level has to sit inside the data and be the size its dimensions say
+			if (mip.Offset + mip.Size > header.DataSize || mip.Size != BlockCompression::GetEncodedSize(output.Format, mip.Width, mip.Height))
+			{
+				return false;
+			}
+			output.Mips[i] = { mip.Offset, mip.Size, mip.Width, mip.Height };
+		}
+
+		output.Data.assign(bytes + dataOffset, bytes + dataOffset + header.DataSize);
+		return true;
+	}
+
+	bool CookedTexture::Save(const std::string& filepath) const
+	{
+		std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+		if (!output.is_open())
+		{
+			return false;
+		}
+
+		const auto bytes = Serialise();
+		output.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+		return output.good();
+	}
+
+	bool CookedTexture::Load(const std::string& filepath, CookedTexture& output)
+	{
+		VirtualFileSystem::File file;
+		if (!VirtualFileSystem::Open(filepath, file))
+		{
+			return false;
+		}
+
+		if (!Deserialise(file.GetData(), file.GetSize(), output))
+		{
+			VEL_CORE_ERROR("Cooked texture {0} is corrupt or from an older version. Cook it again", filepath);
+			return false;
+		}
+		return true;
+	}
+
+	bool CookedTexture::IsCookedPath(const std::string& filepath)
+	{
+		const size_t length = strlen(EXTENSION);
+		return filepath.size() >= length && filepath.compare(filepath.size() - length, length, EXTENSION) == 0;
+	}
+}
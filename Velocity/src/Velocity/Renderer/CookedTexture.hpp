@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include "BlockCompression.hpp"
+
+namespace Velocity
+{
+	// One level of a cooked mip chain. Offset is from the start of Data
+	struct CookedMip
+	{
+		uint64_t	Offset = 0u;
+		uint64_t	Size = 0u;
+		uint32_t	Width = 0u;
+		uint32_t	Height = 0u;
+	};
+
+	// Block compressed texture with its whole mip chain, as written by the TextureCooker
+	// The blocks are uploaded as they are, no mips are generated at runtime
+	struct CookedTexture
+	{
+		// Bump whenever the file layout changes
+		static constexpr uint32_t FORMAT_VERSION = 1u;
+
+		// Extension cooked files are saved with
+		static const char* EXTENSION;
+
+		BlockFormat				Format = BlockFormat::BC7;
+		bool					Srgb = false;
+		uint32_t				Width = 0u;
+		uint32_t				Height = 0u;
+		std::vector<CookedMip>	Mips;
+		std::vector<uint8_t>	Data;
+
+		vk::Format GetVulkanFormat() const;
+
+		// The whole file as bytes. Scenes embed this directly
+		std::vector<uint8_t> Serialise() const;
+
+		// Returns false if the bytes arent a valid cooked texture
+		static bool Deserialise(const uint8_t* bytes, size_t size, CookedTexture& output);
+
+		bool Save(const std::string& filepath) const;
+		static bool Load(const std::string& filepath, CookedTexture& output);
+
+		// Checks the extension only
+		static bool IsCookedPath(const std::string& filepath);
+	};
+}
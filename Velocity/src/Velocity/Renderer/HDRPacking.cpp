@@ -0,0 +1,139 @@
+#include "velpch.h"
+
+#include "HDRPacking.hpp"
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEL_HDR_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		// Format constants from the Vulkan spec. 9 bit mantissas, exponent bias 15
+		const int32_t MANTISSA_BITS = 9;
+		const int32_t EXPONENT_BIAS = 15;
+		const int32_t MIN_EXPONENT = -EXPONENT_BIAS - 1;
+
+		// 2^(24 - exponent) built straight from the bits. Exponent is always 0..31 so it never leaves the normal range
+		float GetScale(int32_t exponent)
+		{
+			const uint32_t bits = static_cast<uint32_t>(127 + EXPONENT_BIAS + MANTISSA_BITS - exponent) << 23;
+			float scale;
+			memcpy(&scale, &bits, sizeof(scale));
+			return scale;
+		}
+	}
+
+	// (2^9 - 1) / 2^9 * 2^16
+	const float HDRPacking::MAX_VALUE = 65408.0f;
+
+	uint32_t HDRPacking::PackSharedExponent(float r, float g, float b)
+	{
+		// Written so NaN fails the comparison and lands on 0
+		r = r > 0.0f ? (r < MAX_VALUE ? r : MAX_VALUE) : 0.0f;
+		g = g > 0.0f ? (g < MAX_VALUE ? g : MAX_VALUE) : 0.0f;
+		b = b > 0.0f ? (b < MAX_VALUE ? b : MAX_VALUE) : 0.0f;
+
+		const float largest = std::max<float>(r, std::max<float>(g, b));
+
+		// floor(log2(largest)) is just the float's exponent. Zero and denormals clamp to the minimum
+		uint32_t bits;
+		memcpy(&bits, &largest, sizeof(bits));
+		const int32_t floorLog2 = std::max<int32_t>(MIN_EXPONENT, static_cast<int32_t>(bits >> 23) - 127);
+
+		// Rounding the largest channel can carry into a 10th bit, one more exponent step fixes it
+		int32_t exponent = floorLog2 + 1 + EXPONENT_BIAS;
+		if (static_cast<uint32_t>(largest * GetScale(exponent) + 0.5f) == (1u << MANTISSA_BITS))
+		{
+			++exponent;
+		}
+
+		const float scale = GetScale(exponent);
+		const uint32_t red = static_cast<uint32_t>(r * scale + 0.5f);
+		const uint32_t green = static_cast<uint32_t>(g * scale + 0.5f);
+		const uint32_t blue = static_cast<uint32_t>(b * scale + 0.5f);
+
+		return red | (green << 9) | (blue << 18) | (static_cast<uint32_t>(exponent) << 27);
+	}
+
+	void HDRPacking::UnpackSharedExponent(uint32_t packed, float* rgb)
+	{
+		const int32_t exponent = static_cast<int32_t>(packed >> 27);
+		const float scale = 1.0f / GetScale(exponent);
+		rgb[0] = static_cast<float>(packed & 0x1FFu) * scale;
+		rgb[1] = static_cast<float>((packed >> 9) & 0x1FFu) * scale;
+		rgb[2] = static_cast<float>((packed >> 18) & 0x1FFu) * scale;
+	}
+
+	void HDRPacking::PackSharedExponent(const float* rgb, uint32_t* output, size_t count)
+	{
+		size_t i = 0;
+
+#ifdef VEL_HDR_SSE2
+		// Same steps as the scalar version with one pixel per lane
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maxValue = _mm_set1_ps(MAX_VALUE);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128i minExponent = _mm_set1_epi32(MIN_EXPONENT);
+		const __m128i floatBias = _mm_set1_epi32(127);
+		const __m128i exponentOffset = _mm_set1_epi32(1 + EXPONENT_BIAS);
+		const __m128i scaleBias = _mm_set1_epi32(127 + EXPONENT_BIAS + MANTISSA_BITS);
+		const __m128i overflow = _mm_set1_epi32(1 << MANTISSA_BITS);
+
+		for (; i + 4u <= count; i += 4u)
+		{
+			const float* pixels = rgb + i * 3u;
+
+			// max_ps returns the second operand for NaN so this also clears them
+			__m128 r = _mm_min_ps(_mm_max_ps(_mm_setr_ps(pixels[0], pixels[3], pixels[6], pixels[9]), zero), maxValue);
+			__m128 g = _mm_min_ps(_mm_max_ps(_mm_setr_ps(pixels[1], pixels[4], pixels[7], pixels[10]), zero), maxValue);
+			__m128 b = _mm_min_ps(_mm_max_ps(_mm_setr_ps(pixels[2], pixels[5], pixels[8], pixels[11]), zero), maxValue);
+
+			const __m128 largest = _mm_max_ps(r, _mm_max_ps(g, b));
+
+			// No integer max in SSE2, select by hand
+			__m128i floorLog2 = _mm_sub_epi32(_mm_srli_epi32(_mm_castps_si128(largest), 23), floatBias);
+			const __m128i tooSmall = _mm_cmplt_epi32(floorLog2, minExponent);
+			floorLog2 = _mm_or_si128(_mm_and_si128(tooSmall, minExponent), _mm_andnot_si128(tooSmall, floorLog2));
+
+			__m128i exponent = _mm_add_epi32(floorLog2, exponentOffset);
+			__m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(scaleBias, exponent), 23));
+
+			// Compare mask is -1 where rounding carried, subtracting it bumps the exponent
+			const __m128i rounded = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(largest, scale), half));
+			exponent = _mm_sub_epi32(exponent, _mm_cmpeq_epi32(rounded, overflow));
+			scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_sub_epi32(scaleBias, exponent), 23));
+
+			const __m128i red = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(r, scale), half));
+			const __m128i green = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(g, scale), half));
+			const __m128i blue = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(b, scale), half));
+
+			__m128i packed = _mm_or_si128(red, _mm_slli_epi32(green, 9));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(blue, 18));
+			packed = _mm_or_si128(packed, _mm_slli_epi32(exponent, 27));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), packed);
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			output[i] = PackSharedExponent(rgb[i * 3u], rgb[i * 3u + 1u], rgb[i * 3u + 2u]);
+		}
+	}
+
+	void HDRPacking::PackSharedExponentImage(const float* rgb, uint32_t width, uint32_t height, uint32_t* output)
+	{
+		ThreadPool::Get().ParallelFor(height, [&](size_t y)
+		{
+			const size_t offset = y * width;
+			PackSharedExponent(rgb + offset * 3u, output + offset, width);
+		});
+	}
+}
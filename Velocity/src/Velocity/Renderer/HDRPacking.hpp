@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Velocity
+{
+	// Packs float HDR pixels into the 4 byte shared exponent format (VK_FORMAT_E5B9G9R9_UFLOAT_PACK32)
+	// Three 9 bit mantissas share one 5 bit exponent, a quarter of RGBA32F and plenty for lighting data
+	// Negative and NaN channels become 0, anything over MAX_VALUE is clamped
+	class HDRPacking
+	{
+	public:
+		// Largest value the format holds
+		static const float MAX_VALUE;
+
+		static uint32_t PackSharedExponent(float r, float g, float b);
+		static void UnpackSharedExponent(uint32_t packed, float* rgb);
+
+		// Packs count tightly packed RGB float pixels. Four at a time with SSE2 where it is available
+		static void PackSharedExponent(const float* rgb, uint32_t* output, size_t count);
+
+		// Packs a whole image with rows split across the worker pool. Output can be mapped GPU memory
+		static void PackSharedExponentImage(const float* rgb, uint32_t width, uint32_t height, uint32_t* output);
+	};
+}
@@ -2,987 +2,1182 @@
 
 #include "IBLMap.hpp"
 
-#include <glm/ext/matrix_clip_space.hpp>
-#include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <thread>
 
-
-#include "BaseBuffer.hpp"
+#include "HDRPacking.hpp"
 #include "Renderer.hpp"
 #include "Shader.hpp"
 #include "stb_image.h"
 #include "Texture.hpp"
 #include "Velocity/Core/Log.hpp"
+#include "Velocity/Utility/Hash.hpp"
+#include "Velocity/Utility/MappedFile.hpp"
+#include "Velocity/Utility/ThreadPool.hpp"
+#include "Velocity/Utility/VirtualFileSystem.hpp"
 
 namespace Velocity
 {
+	const char* IBLMap::CACHE_DIRECTORY = "../Velocity/cache/ibl/";
+
+	std::weak_ptr<IBLMap::BRDFLut> IBLMap::s_BRDFLut;
+
+	namespace
+	{
+		const char CACHE_MAGIC[4] = { 'V','I','B','L' };
+
+		// Followed by the environment mip 0, the irradiance map then every prefilter mip
+		struct CacheHeader
+		{
+			char			Magic[4];
+			uint32_t		Version;
+			uint64_t		Key;
+			uint64_t		DataSize;
+			SHCoefficients	IrradianceSH;
+		};
+
+		// Matches local_size in the ibl shaders
+		const uint32_t GROUP_SIZE = 8u;
+
+		// Bytes of one mip of a six face RGBA16F map
+		VkDeviceSize GetFaceBytes(uint32_t size)
+		{
+			return static_cast<VkDeviceSize>(size) * size * sizeof(uint16_t) * 4u * 6u;
+		}
+
+		vk::BufferImageCopy GetMapRegion(VkDeviceSize offset, uint32_t size, uint32_t mip)
+		{
+			return {
+				offset,
+				0,
+				0,
+				vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, mip, 0, 6 },
+				vk::Offset3D{ 0,0,0 },
+				vk::Extent3D{ size,size,1 }
+			};
+		}
+
+		void ImageBarrier(vk::CommandBuffer& buffer, vk::Image image, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+			vk::AccessFlags srcAccess, vk::AccessFlags dstAccess, vk::PipelineStageFlags srcStage, vk::PipelineStageFlags dstStage,
+			uint32_t baseMip, uint32_t mipCount, uint32_t layers = 6u)
+		{
+			vk::ImageMemoryBarrier barrier = {
+				srcAccess,
+				dstAccess,
+				oldLayout,
+				newLayout,
+				VK_QUEUE_FAMILY_IGNORED,
+				VK_QUEUE_FAMILY_IGNORED,
+				image,
+				vk::ImageSubresourceRange{ vk::ImageAspectFlagBits::eColor, baseMip, mipCount, 0, layers }
+			};
+
+			buffer.pipelineBarrier(srcStage, dstStage, vk::DependencyFlags{}, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		// Every finished map is read by the skybox and pbr passes as well as later ibl passes
+		const vk::PipelineStageFlags SAMPLED_STAGES = vk::PipelineStageFlagBits::eFragmentShader | vk::PipelineStageFlagBits::eComputeShader;
+
+		vk::UniqueSampler CreateSampler(vk::UniqueDevice& device, float maxLod)
+		{
+			vk::SamplerCreateInfo sampler = {
+				vk::SamplerCreateFlags{},
+				vk::Filter::eLinear,
+				vk::Filter::eLinear,
+				vk::SamplerMipmapMode::eLinear,
+				vk::SamplerAddressMode::eClampToEdge,
+				vk::SamplerAddressMode::eClampToEdge,
+				vk::SamplerAddressMode::eClampToEdge,
+				0.0f,
+				VK_TRUE,
+				1.0f,
+				VK_FALSE,
+				vk::CompareOp::eNever,
+				0.0f,
+				maxLod,
+				vk::BorderColor::eFloatOpaqueWhite,
+				VK_FALSE
+			};
+
+			vk::UniqueSampler result;
+			try
+			{
+				result = device->createSamplerUnique(sampler);
+			}
+			catch (vk::SystemError& e)
+			{
+				VEL_CORE_ERROR("Failed to create IBL sampler! Error: {0}", e.what());
+				VEL_CORE_ASSERT(false, "Failed to create IBL sampler! Error: {0}", e.what());
+			}
+			return result;
+		}
+
+		bool CreateImage(vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, const vk::ImageCreateInfo& info, vk::UniqueImage& image, vk::UniqueDeviceMemory& memory)
+		{
+			try
+			{
+				image = device->createImageUnique(info);
+
+				vk::MemoryRequirements memRequirements = device->getImageMemoryRequirements(image.get());
+				vk::MemoryAllocateInfo allocInfo = {
+					memRequirements.size,
+					BaseBuffer::FindMemoryType(pDevice, memRequirements.memoryTypeBits, vk::MemoryPropertyFlagBits::eDeviceLocal)
+				};
+				memory = device->allocateMemoryUnique(allocInfo);
+			}
+			catch (vk::SystemError& e)
+			{
+				VEL_CORE_ERROR("Failed to create IBL image! Error: {0}", e.what());
+				VEL_CORE_ASSERT(false, "Failed to create IBL image! Error: {0}", e.what());
+				return false;
+			}
+
+			device->bindImageMemory(image.get(), memory.get(), 0);
+			return true;
+		}
+	}
+
 	IBLMap::IBLMap(const std::string& filepath, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice,
-		vk::CommandPool& pool, uint32_t& graphicsQueueIndex, BufferManager& modelBuffer)
+		vk::CommandPool& pool, uint32_t& graphicsQueueIndex)
 	{
 		// Store references
 		r_Device = &device;
 		r_PhysicalDevice = pDevice;
 		r_CommandPool = &pool;
 		r_GraphicsQueueIndex = graphicsQueueIndex;
-		
-		#pragma region LOAD HDRI FILE
+		m_Filepath = filepath;
 
-		int width, height, nrComponents;
-		// Force an alpha channel
-		float* imgData = stbi_loadf(filepath.c_str(), &width, &height, &nrComponents, STBI_rgb_alpha);
+		// Shared exponent is a quarter of RGBA32F and every GPU can sample and filter it
+		vk::FormatProperties formatProperties = r_PhysicalDevice.getFormatProperties(HDRI_FORMAT);
+		if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+		{
+			VEL_CORE_ERROR("Failed to load HDRI file {0} (GPU doesn't support shared exponent images)", filepath);
+			VEL_CORE_ASSERT(false, "Failed to load HDRI file {0} (GPU doesn't support shared exponent images)", filepath);
+			m_Stage = Stage::Failed;
+			return;
+		}
 
-		if (!imgData)
+		// Only the header is read here, the worker decodes the rest if the cache misses
+		int width, height;
+		if (!Texture::GetInfo(filepath, width, height))
 		{
 			VEL_CORE_ERROR("Failed to open HDRI file {0}", filepath);
 			VEL_CORE_ASSERT(false, "Failed to load HDRI file");
+			m_Stage = Stage::Failed;
 			return;
 		}
+		m_SourceWidth = static_cast<uint32_t>(width);
+		m_SourceHeight = static_cast<uint32_t>(height);
+
+		CreatePipelineResources();
+
+		// The first map alive makes the LUT, the rest share it
+		m_BRDFLut = s_BRDFLut.lock();
+		if (!m_BRDFLut)
+		{
+			m_BRDFLut = std::make_shared<BRDFLut>();
+			s_BRDFLut = m_BRDFLut;
+			ComputeBRDF();
+		}
 
-		// Calculate size
-		const VkDeviceSize imageSize = width * height * (sizeof(float) * 4);
+		// Big enough for whichever the worker ends up filling it with
+		const VkDeviceSize imageSize = static_cast<VkDeviceSize>(width) * height * sizeof(uint32_t);
+		const VkDeviceSize stagingSize = std::max<VkDeviceSize>(imageSize, GetCacheSize());
 
-		// Create staging buffer
-		std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
+		m_StagingBuffer = std::make_unique<BaseBuffer>(
 			r_PhysicalDevice,
 			*r_Device,
-			imageSize,
+			stagingSize,
 			vk::BufferUsageFlagBits::eTransferSrc,
 			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
 		);
 
-		// Map data
 		void* data;
-		auto result = r_Device->get().mapMemory(stagingBuffer->Memory.get(), 0, imageSize, vk::MemoryMapFlags{}, &data);
+		auto result = r_Device->get().mapMemory(m_StagingBuffer->Memory.get(), 0, stagingSize, vk::MemoryMapFlags{}, &data);
 		if (result != vk::Result::eSuccess)
 		{
 			VEL_CORE_ERROR("Failed to load hdri: {0} (Failed to map memory)", filepath);
 			VEL_CORE_ASSERT(false, "Failed to load hdri: {0} (Failed to map memory)", filepath);
+			m_Stage = Stage::Failed;
+			ReleaseProcessResources();
 			return;
 		}
-		// Copy over image data
-		memcpy(data, imgData, imageSize);
+		m_StagingData = static_cast<uint8_t*>(data);
+
+		// Shared pointer so the task stays copyable
+		m_LoadResult = std::make_shared<LoadResult>();
+		auto loadResult = m_LoadResult;
+		uint8_t* staging = m_StagingData;
+		const uint32_t sourceWidth = m_SourceWidth;
+		const uint32_t sourceHeight = m_SourceHeight;
+		m_Job = ThreadPool::Get().Enqueue([filepath, sourceWidth, sourceHeight, staging, loadResult]()
+		{
+			Load(filepath, sourceWidth, sourceHeight, staging, *loadResult);
+		});
 
-		// Unmap
-		r_Device->get().unmapMemory(stagingBuffer->Memory.get());
+		Renderer::GetRenderer()->LoadMesh("../Velocity/assets/models/sphere.obj", "VEL_INTERNAL_Skybox");
 
-		// free stbi
-		stbi_image_free(static_cast<void*>(imgData));
-		
-		#pragma endregion
+		m_SphereMesh = MeshComponent{ "VEL_INTERNAL_Skybox" };
+	}
 
-		#pragma region CREATE VULKAN IMAGE
+	IBLMap::~IBLMap()
+	{
+		// Nothing can go while the worker or the GPU might still be using it
+		if (m_Job.valid())
+		{
+			m_Job.wait();
+		}
+		if (m_Fence)
+		{
+			auto result = r_Device->get().waitForFences(1, &m_Fence.get(), VK_TRUE, UINT64_MAX);
+		}
 
-		vk::ImageCreateInfo equirectangularImageInfo = {
-			vk::ImageCreateFlags{},
-			vk::ImageType::e2D,
-			vk::Format::eR32G32B32A32Sfloat,
-			vk::Extent3D{static_cast<uint32_t>(width),static_cast<uint32_t>(height),1},
-			1,
-			1,
-			vk::SampleCountFlagBits::e1,
-			vk::ImageTiling::eOptimal,
-			vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
-			vk::SharingMode::eExclusive,
-			{},
-			{},
-			vk::ImageLayout::eUndefined
-		};
+		ReleaseProcessResources();
 
-		// Local variable as we dont need this when the cubemaps are generated
-		vk::UniqueImage equirectangularImage;
+		if (m_ReadbackData)
+		{
+			r_Device->get().unmapMemory(m_ReadbackBuffer->Memory.get());
+		}
+		m_ReadbackBuffer.reset();
 
-		try
+		if (auto& renderer = Renderer::GetRenderer())
 		{
-			equirectangularImage = r_Device->get().createImageUnique(equirectangularImageInfo);
+			auto& pending = renderer->m_PendingIBLMaps;
+			pending.erase(std::remove(pending.begin(), pending.end(), this), pending.end());
 		}
-		catch(vk::SystemError& e)
+	}
+
+	bool IBLMap::Update(bool wait)
+	{
+		if (m_Stage == Stage::Loading)
 		{
-			VEL_CORE_ERROR("Failed to create HDR: {0} (Failed to create image) Error: {1}", filepath, e.what());
-			VEL_CORE_ASSERT(false,"Failed to create HDR: {0} (Failed to create image) Error: {1}", filepath, e.what());
-			return;
+			if (!wait && m_Job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				return true;
+			}
+			m_Job.get();
+
+			if (!m_LoadResult->Success)
+			{
+				m_Stage = Stage::Failed;
+				ReleaseProcessResources();
+				return false;
+			}
+
+			m_IrradianceSH = m_LoadResult->IrradianceSH;
+			m_HasIrradianceSH = true;
+
+			Process();
 		}
-		
-		#pragma endregion
 
-		#pragma region ALLOCATE MEMORY
+		if (m_Stage == Stage::Processing)
+		{
+			if (wait)
+			{
+				auto result = r_Device->get().waitForFences(1, &m_Fence.get(), VK_TRUE, UINT64_MAX);
+			}
+			else if (r_Device->get().getFenceStatus(m_Fence.get()) != vk::Result::eSuccess)
+			{
+				return true;
+			}
+
+			CreateDescriptorInfos();
 
-		vk::MemoryRequirements memRequirements = r_Device->get().getImageMemoryRequirements(equirectangularImage.get());
+			const bool cached = m_LoadResult->Cached;
+			const uint64_t key = m_LoadResult->Key;
+			const SHCoefficients irradianceSH = m_IrradianceSH;
 
-		vk::MemoryAllocateInfo allocInfo = {
-			memRequirements.size,
-			BaseBuffer::FindMemoryType(r_PhysicalDevice,memRequirements.memoryTypeBits,vk::MemoryPropertyFlagBits::eDeviceLocal)
-		};
+			// Submitted after the LUT so it is done too
+			ReleaseProcessResources();
 
-		vk::UniqueDeviceMemory imageMemory;
-		
-		try
+			if (cached)
+			{
+				VEL_CORE_INFO("Loaded HDR skybox {0} from the cache", m_Filepath);
+				m_Stage = Stage::Ready;
+				return false;
+			}
+
+			VEL_CORE_INFO("Created HDR skybox from file {0}", m_Filepath);
+
+			void* data;
+			auto result = r_Device->get().mapMemory(m_ReadbackBuffer->Memory.get(), 0, m_ReadbackBuffer->Size, vk::MemoryMapFlags{}, &data);
+			if (result != vk::Result::eSuccess)
+			{
+				VEL_CORE_WARN("Failed to cache HDR skybox {0} (Failed to map memory)", m_Filepath);
+				m_ReadbackBuffer.reset();
+				m_Stage = Stage::Ready;
+				return false;
+			}
+			m_ReadbackData = static_cast<uint8_t*>(data);
+
+			// Maps can be used straight away, the readback buffer just lives until the file is written
+			const uint8_t* readback = m_ReadbackData;
+			const size_t size = static_cast<size_t>(m_ReadbackBuffer->Size);
+			m_Job = ThreadPool::Get().Enqueue([key, irradianceSH, readback, size]()
+			{
+				StoreCache(key, irradianceSH, readback, size);
+			});
+			m_Stage = Stage::Caching;
+		}
+
+		if (m_Stage == Stage::Caching)
 		{
-			imageMemory = r_Device->get().allocateMemoryUnique(allocInfo);
+			if (!wait && m_Job.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+			{
+				return true;
+			}
+			m_Job.get();
+
+			r_Device->get().unmapMemory(m_ReadbackBuffer->Memory.get());
+			m_ReadbackData = nullptr;
+			m_ReadbackBuffer.reset();
+
+			m_Stage = Stage::Ready;
 		}
-		catch(vk::SystemError& e)
+
+		return false;
+	}
+
+	void IBLMap::Load(const std::string& filepath, uint32_t width, uint32_t height, uint8_t* staging, LoadResult& result)
+	{
+		VirtualFileSystem::File file;
+		if (!VirtualFileSystem::Open(filepath, file))
 		{
-			VEL_CORE_ERROR("Failed to load HDRI: {0} (Failed to create memory) Error: {1}", filepath, e.what());
-			VEL_CORE_ASSERT(false,"Failed to load HDRI: {0} (Failed to create memory) Error: {1}", filepath, e.what());
+			VEL_CORE_ERROR("Failed to open HDRI file {0}", filepath);
 			return;
 		}
-		
-		#pragma endregion
 
-		// Bind image and memory
-		r_Device->get().bindImageMemory(equirectangularImage.get(), imageMemory.get(), 0);
+		// Anything that changes what ends up in the maps goes in the key
+		uint64_t key = Hash::Bytes(file.GetData(), file.GetSize());
+		key = Hash::Combine(key, static_cast<uint32_t>(CACHE_VERSION));
+		key = Hash::Combine(key, static_cast<uint32_t>(ENVIRONMENT_SIZE));
+		key = Hash::Combine(key, static_cast<uint32_t>(IRRADIANCE_SIZE));
+		key = Hash::Combine(key, static_cast<uint32_t>(PREFILTER_SIZE));
+		key = Hash::Combine(key, static_cast<uint32_t>(PREFILTER_MIPS));
+		result.Key = key;
 
-		#pragma region PROCESS RAW TO VULKAN
 		{
-			vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
-			TemporaryCommandBuffer processBufferWrapper = TemporaryCommandBuffer(*r_Device, pool, queue);
-			auto& processBuffer = processBufferWrapper.GetBuffer();
-
-			// Set to dest optimal
-			Texture::TransitionImageLayout(
-				processBuffer, equirectangularImage.get(),
-				vk::Format::eR32G32B32A32Sfloat,
-				vk::ImageLayout::eUndefined,
-				vk::ImageLayout::eTransferDstOptimal,
-				1,
-				1
-			);
+			MappedFile cache;
+			if (cache.Open(GetCachePath(key)) && cache.GetSize() >= sizeof(CacheHeader))
+			{
+				CacheHeader header;
+				memcpy(&header, cache.GetData(), sizeof(CacheHeader));
 
-			// Copy
-			Texture::CopyBufferToImage(
-				processBuffer,equirectangularImage.get(),
-				stagingBuffer->Buffer.get(),
-				width,height,
-				1
-			);
+				if (memcmp(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 && header.Version == CACHE_VERSION && header.Key == key &&
+					header.DataSize == GetCacheSize() && cache.GetSize() >= sizeof(CacheHeader) + header.DataSize)
+				{
+					memcpy(staging, cache.GetData() + sizeof(CacheHeader), static_cast<size_t>(header.DataSize));
+					result.IrradianceSH = header.IrradianceSH;
+					result.Cached = true;
+					result.Success = true;
+					return;
+				}
 
-			// Set to shader sample
-			Texture::TransitionImageLayout(
-				processBuffer, equirectangularImage.get(),
-				vk::Format::eR32G32B32A32Sfloat,
-				vk::ImageLayout::eTransferDstOptimal,
-				vk::ImageLayout::eShaderReadOnlyOptimal,
-				1,
-				1
-			);
+				VEL_CORE_WARN("IBL cache {0} is out of date, rebuilding", Hash::ToString(key));
+			}
 		}
-		#pragma endregion
 
-		#pragma region CREATE IMAGE VIEW
+		// No alpha, the packed format doesnt have one
+		int decodedWidth, decodedHeight, nrComponents;
+		float* imgData = stbi_loadf_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &decodedWidth, &decodedHeight, &nrComponents, STBI_rgb);
 
-		vk::ImageViewCreateInfo viewInfo = {
-			vk::ImageViewCreateFlags{},
-			equirectangularImage.get(),
-			vk::ImageViewType::e2D,
-			vk::Format::eR32G32B32A32Sfloat,
-			{},
+		// The staging buffer was sized from the header
+		if (!imgData || static_cast<uint32_t>(decodedWidth) != width || static_cast<uint32_t>(decodedHeight) != height)
+		{
+			VEL_CORE_ERROR("Failed to decode HDRI file {0}", filepath);
+			stbi_image_free(static_cast<void*>(imgData));
+			return;
+		}
+
+		HDRPacking::PackSharedExponentImage(imgData, width, height, reinterpret_cast<uint32_t*>(staging));
+
+		// Cheap enough to always do, whoever uses the map picks between this and the irradiance cubemap
+		result.IrradianceSH = SphericalHarmonics::ProjectEquirectangular(imgData, width, height);
+		SphericalHarmonics::ConvolveIrradiance(result.IrradianceSH);
+
+		stbi_image_free(static_cast<void*>(imgData));
+
+		result.Success = true;
+	}
+
+	void IBLMap::StoreCache(uint64_t key, const SHCoefficients& irradianceSH, const uint8_t* data, size_t size)
+	{
+		CacheHeader header = {};
+		memcpy(header.Magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+		header.Version = CACHE_VERSION;
+		header.Key = key;
+		header.DataSize = size;
+		header.IrradianceSH = irradianceSH;
+
+		std::error_code error;
+		std::filesystem::create_directories(CACHE_DIRECTORY, error);
+
+		// Write to a temporary name first so a crash mid write never leaves a file that looks valid
+		const auto finalPath = GetCachePath(key);
+		const auto tempPath = finalPath + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+			if (!output.is_open())
 			{
-				vk::ImageAspectFlagBits::eColor,
-				0,1,0,1
+				VEL_CORE_WARN("Failed to write IBL cache {0}", finalPath);
+				return;
 			}
+			output.write(reinterpret_cast<const char*>(&header), sizeof(CacheHeader));
+			output.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+		}
+
+		std::filesystem::rename(tempPath, finalPath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+		}
+	}
+
+	size_t IBLMap::GetCacheSize()
+	{
+		VkDeviceSize size = GetFaceBytes(ENVIRONMENT_SIZE) + GetFaceBytes(IRRADIANCE_SIZE);
+		for (uint32_t mip = 0; mip < PREFILTER_MIPS; ++mip)
+		{
+			size += GetFaceBytes(PREFILTER_SIZE >> mip);
+		}
+		return static_cast<size_t>(size);
+	}
+
+	std::string IBLMap::GetCachePath(uint64_t key)
+	{
+		return std::string(CACHE_DIRECTORY) + Hash::ToString(key) + ".vibl";
+	}
+
+	void IBLMap::CreatePipelineResources()
+	{
+		// Every mip of the environment is read when convolving
+		m_Sampler = CreateSampler(*r_Device, static_cast<float>(ENVIRONMENT_MIPS));
+
+		#pragma region CREATE DESCRIPTORS
+
+		// 0 source, 1 target mip
+		std::array<vk::DescriptorSetLayoutBinding, 2> bindings = {
+			vk::DescriptorSetLayoutBinding{ 0, vk::DescriptorType::eCombinedImageSampler, 1, vk::ShaderStageFlagBits::eCompute, nullptr },
+			vk::DescriptorSetLayoutBinding{ 1, vk::DescriptorType::eStorageImage, 1, vk::ShaderStageFlagBits::eCompute, nullptr }
 		};
 
-		// Same as with image
-		vk::UniqueImageView equirectangularImageView;
+		vk::DescriptorSetLayoutCreateInfo layoutInfo = {
+			vk::DescriptorSetLayoutCreateFlags{},
+			static_cast<uint32_t>(bindings.size()),
+			bindings.data()
+		};
 
 		try
 		{
-			equirectangularImageView = r_Device->get().createImageViewUnique(viewInfo);
+			m_DescriptorSetLayout = r_Device->get().createDescriptorSetLayoutUnique(layoutInfo);
 		}
 		catch (vk::SystemError& e)
 		{
-			VEL_CORE_ERROR("Failed to create HDR: {0} (Failed to create image view) Error: {1}", filepath, e.what());
-			VEL_CORE_ASSERT(false, "Failed to create HDR: {0} (Failed to create image view) Error: {1}", filepath, e.what());
+			VEL_CORE_ERROR("Failed to create IBL descriptor set layout! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create IBL descriptor set layout! Error: {0}", e.what());
 			return;
 		}
 
-		
-		
-		#pragma endregion
+		// Conversion, irradiance, each prefilter mip and the LUT
+		const uint32_t setCount = 3u + PREFILTER_MIPS;
+		std::array<vk::DescriptorPoolSize, 2> poolSizes = {
+			vk::DescriptorPoolSize{ vk::DescriptorType::eCombinedImageSampler, setCount },
+			vk::DescriptorPoolSize{ vk::DescriptorType::eStorageImage, setCount }
+		};
 
-		#pragma region CREATE SAMPLER
-
-		vk::SamplerCreateInfo sampler = {
-			vk::SamplerCreateFlags{},
-			vk::Filter::eLinear,
-			vk::Filter::eLinear,
-			vk::SamplerMipmapMode::eLinear,
-			vk::SamplerAddressMode::eClampToEdge,
-			vk::SamplerAddressMode::eClampToEdge,
-			vk::SamplerAddressMode::eClampToEdge,
-			0.0f,
-			VK_TRUE,
-			1.0f,
-			VK_FALSE,
-			vk::CompareOp::eNever,
-			0.0f,
-			1.0f,
-			vk::BorderColor::eFloatOpaqueWhite,
-			VK_FALSE
+		vk::DescriptorPoolCreateInfo poolInfo = {
+			vk::DescriptorPoolCreateFlags{},
+			setCount,
+			static_cast<uint32_t>(poolSizes.size()),
+			poolSizes.data()
 		};
 
 		try
 		{
-			m_Sampler = r_Device->get().createSamplerUnique(sampler);
+			m_DescriptorPool = r_Device->get().createDescriptorPoolUnique(poolInfo);
 		}
 		catch (vk::SystemError& e)
 		{
-			VEL_CORE_ERROR("Failed to load HDRI: {0} (Failed to create sampler) Error: {1}", filepath, e.what());
-			VEL_CORE_ASSERT(false, "Failed to load HDRI: {0} (Failed to create sampler) Error: {1}", filepath, e.what());
+			VEL_CORE_ERROR("Failed to create IBL descriptor pool! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create IBL descriptor pool! Error: {0}", e.what());
 			return;
 		}
-		
+
 		#pragma endregion
 
-		// Convert the flat map into a cube map
-		EquirectangularToCubemap(equirectangularImageView, modelBuffer);
+		#pragma region CREATE PIPELINE LAYOUT
 
-		// Save data for renderer
-		m_EnviromentMapImageInfo = {
-			m_Sampler.get(),
-			m_EnviromentMapImageView,
-			vk::ImageLayout::eShaderReadOnlyOptimal
+		vk::PushConstantRange pushRange = {
+			vk::ShaderStageFlagBits::eCompute,
+			0,
+			sizeof(PassConstants)
 		};
 
-		m_EnviromentMapWriteSet = {
-			nullptr,
+		vk::PipelineLayoutCreateInfo pipelineLayoutInfo = {
+			vk::PipelineLayoutCreateFlags{},
 			1,
-			0,
+			&m_DescriptorSetLayout.get(),
 			1,
-			vk::DescriptorType::eCombinedImageSampler,
-			&m_EnviromentMapImageInfo,
-			nullptr,
-			nullptr
+			&pushRange
 		};
 
-		Renderer::GetRenderer()->LoadMesh("../Velocity/assets/models/sphere.obj", "VEL_INTERNAL_Skybox");
-
-		m_SphereMesh = MeshComponent{ "VEL_INTERNAL_Skybox" };
+		try
+		{
+			m_PipelineLayout = r_Device->get().createPipelineLayoutUnique(pipelineLayoutInfo);
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create IBL pipeline layout! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create IBL pipeline layout! Error: {0}", e.what());
+		}
 
-		VEL_CORE_INFO("Created HDR skybox from file {0}", filepath);
-		
+		#pragma endregion
 	}
 
-	IBLMap::~IBLMap()
+	vk::UniquePipeline IBLMap::CreatePipeline(const std::string& shader)
 	{
-		r_Device->get().destroyImage(m_EnviromentMapImage);
-		r_Device->get().destroyImageView(m_EnviromentMapImageView);
-		r_Device->get().freeMemory(m_EnviromentMapMemory);
+		vk::ShaderModule computeShaderModule = Shader::CreateShaderModule(*r_Device, "../Velocity/assets/shaders/ibl/" + shader);
+
+		vk::ComputePipelineCreateInfo pipelineInfo = {
+			vk::PipelineCreateFlags{},
+			vk::PipelineShaderStageCreateInfo{
+				vk::PipelineShaderStageCreateFlags{},
+				vk::ShaderStageFlagBits::eCompute,
+				computeShaderModule,
+				"main"
+			},
+			m_PipelineLayout.get()
+		};
+
+		vk::UniquePipeline pipeline;
+		try
+		{
+			auto result = r_Device->get().createComputePipelineUnique(nullptr, pipelineInfo);
+			pipeline = std::move(result.value);
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create IBL pipeline {0}! Error: {1}", shader, e.what());
+			VEL_CORE_ASSERT(false, "Failed to create IBL pipeline {0}! Error: {1}", shader, e.what());
+		}
+
+		r_Device->get().destroyShaderModule(computeShaderModule);
+		return pipeline;
 	}
 
-	void IBLMap::EquirectangularToCubemap(vk::UniqueImageView& equirectangularIV, BufferManager& modelBuffer)
+	vk::DescriptorSet IBLMap::CreateSet(vk::ImageView source, vk::ImageView target)
 	{
-		// This function is MASSIVE. Creates a pipeline to be used one time to perform this operation
-		// Firstly we create the image that will be the end result leaving it in transfer dst mod
-		// Then we create the pipeline with the flattocubemap shaders, rendering 6 passes to 6 framebuffers
-		// Then each framebuffer is copied to a layer of the end result
+		vk::DescriptorSet set;
+		vk::DescriptorSetAllocateInfo allocInfo = {
+			m_DescriptorPool.get(),
+			1,
+			&m_DescriptorSetLayout.get()
+		};
 
-		// Scale each side to 512. 
-		const uint32_t mapFaceSize = 512u;
+		auto result = r_Device->get().allocateDescriptorSets(&allocInfo, &set);
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to allocate IBL descriptor set");
+			VEL_CORE_ASSERT(false, "Failed to allocate IBL descriptor set");
+			return set;
+		}
 
-		#pragma region CREATE VULKAN IMAGE
+		vk::DescriptorImageInfo sourceInfo = { m_Sampler.get(), source, vk::ImageLayout::eShaderReadOnlyOptimal };
+		vk::DescriptorImageInfo targetInfo = { nullptr, target, vk::ImageLayout::eGeneral };
+
+		std::array<vk::WriteDescriptorSet, 2> writes = {
+			vk::WriteDescriptorSet{ set, 0, 0, 1, vk::DescriptorType::eCombinedImageSampler, &sourceInfo, nullptr, nullptr },
+			vk::WriteDescriptorSet{ set, 1, 0, 1, vk::DescriptorType::eStorageImage, &targetInfo, nullptr, nullptr }
+		};
+
+		// The LUT has nothing to sample
+		if (source)
+		{
+			r_Device->get().updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+		else
+		{
+			r_Device->get().updateDescriptorSets(1, &writes.at(1), 0, nullptr);
+		}
+
+		return set;
+	}
+
+	void IBLMap::CreateMap(uint32_t size, uint32_t mips, vk::UniqueImage& image, vk::UniqueDeviceMemory& memory, vk::UniqueImageView& view)
+	{
 		// Stored as a cube map (image with 6 array layers) with 16bit floating point values
-		// Down sample to 2k
 		vk::ImageCreateInfo imageInfo = {
 			vk::ImageCreateFlagBits::eCubeCompatible,
 			vk::ImageType::e2D,
-			vk::Format::eR16G16B16A16Sfloat,
-			vk::Extent3D{mapFaceSize,mapFaceSize,1},
-			1,
+			MAP_FORMAT,
+			vk::Extent3D{size,size,1},
+			mips,
 			6,
 			vk::SampleCountFlagBits::e1,
 			vk::ImageTiling::eOptimal,
-			vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled | vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst,
 			vk::SharingMode::eExclusive,
 			{},
 			{},
 			vk::ImageLayout::eUndefined
 		};
 
-		try
-		{
-			m_EnviromentMapImage = r_Device->get().createImage(imageInfo);
-		}
-		catch(vk::SystemError& e)
+		if (!CreateImage(*r_Device, r_PhysicalDevice, imageInfo, image, memory))
 		{
-			VEL_CORE_ERROR("Failed to convert HDRI to cubemap Error: {0}", e.what());
-			VEL_CORE_ASSERT(false,"Failed to convert HDRI to cubemap Error: {0}", e.what());
 			return;
 		}
-		#pragma endregion
-		
-		#pragma region ALLOCATE MEMORY
-		vk::MemoryRequirements memRequirements = r_Device->get().getImageMemoryRequirements(m_EnviromentMapImage);
 
-		vk::MemoryAllocateInfo allocInfo = {
-			memRequirements.size,
-			BaseBuffer::FindMemoryType(r_PhysicalDevice,memRequirements.memoryTypeBits,vk::MemoryPropertyFlagBits::eDeviceLocal)
+		vk::ImageViewCreateInfo viewInfo = {
+			vk::ImageViewCreateFlags{},
+			image.get(),
+			vk::ImageViewType::eCube,
+			MAP_FORMAT,
+			{},
+			{
+				vk::ImageAspectFlagBits::eColor,
+				0,mips,0,6
+			}
 		};
 
 		try
 		{
-			m_EnviromentMapMemory = r_Device->get().allocateMemory(allocInfo);
-
+			view = r_Device->get().createImageViewUnique(viewInfo);
 		}
 		catch (vk::SystemError& e)
 		{
-			VEL_CORE_ERROR("Failed to load hdri: Error: {0}", e.what());
-			VEL_CORE_ASSERT(false, "Failed to load hdri: Error: {0}", e.what());
-			return;
+			VEL_CORE_ERROR("Failed to create IBL cube view! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create IBL cube view! Error: {0}", e.what());
 		}
-		
-		#pragma endregion
+	}
 
-		// Bind
-		r_Device->get().bindImageMemory(m_EnviromentMapImage, m_EnviromentMapMemory, 0);
-		
-		#pragma region PROCESS RAW TO VULKAN TRANSFER DST
-		{
-			vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
-			TemporaryCommandBuffer processBufferWrapper = TemporaryCommandBuffer(*r_Device, *r_CommandPool, queue);
-			auto& processBuffer = processBufferWrapper.GetBuffer();
+	vk::ImageView IBLMap::CreateStorageView(vk::Image image, uint32_t mip, uint32_t layers)
+	{
+		vk::ImageViewCreateInfo viewInfo = {
+			vk::ImageViewCreateFlags{},
+			image,
+			vk::ImageViewType::e2DArray,
+			MAP_FORMAT,
+			{},
+			{
+				vk::ImageAspectFlagBits::eColor,
+				mip,1,0,layers
+			}
+		};
 
-			// Set this image to destination optimal
-			Texture::TransitionImageLayout(processBuffer, m_EnviromentMapImage, vk::Format::eR16G16B16A16Sfloat, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 1, 6);
+		try
+		{
+			m_StorageViews.push_back(r_Device->get().createImageViewUnique(viewInfo));
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to create IBL storage view! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create IBL storage view! Error: {0}", e.what());
+			return nullptr;
 		}
-		#pragma endregion
-
-		#pragma region CREATE PIPELINE (and associated)
-
-		#pragma region LOAD SHADERS
-		vk::ShaderModule vertShaderModule = Shader::CreateShaderModule(*r_Device, "../Velocity/assets/shaders/ibl/flattocubemapvert.spv");
-		vk::ShaderModule fragShaderModule = Shader::CreateShaderModule(*r_Device, "../Velocity/assets/shaders/ibl/flattocubemapfrag.spv");
-
-		vk::PipelineShaderStageCreateInfo vertexShaderStageInfo = {
-			vk::PipelineShaderStageCreateFlags{0u},
-			vk::ShaderStageFlagBits::eVertex,
-			vertShaderModule,
-			"main"
-		};
-		// 2. Fragment
-		vk::PipelineShaderStageCreateInfo fragmentShaderStageInfo = {
-			vk::PipelineShaderStageCreateFlags{0u},
-			vk::ShaderStageFlagBits::eFragment,
-			fragShaderModule,
-			"main"
-		};
-		// Combine into a contiguous structure
-		std::array<vk::PipelineShaderStageCreateInfo, 2u> shaderStages = { vertexShaderStageInfo, fragmentShaderStageInfo };
-		
-		#pragma endregion
 
-		#pragma region CREATE RENDER PASS
-		// Framebuffer will be attached and left read to transfer to image above
-		vk::AttachmentDescription attDesc = {
-			vk::AttachmentDescriptionFlags{},
-			vk::Format::eR16G16B16A16Sfloat,
-			vk::SampleCountFlagBits::e1,
-			vk::AttachmentLoadOp::eDontCare,
-			vk::AttachmentStoreOp::eStore,
-			vk::AttachmentLoadOp::eDontCare,
-			vk::AttachmentStoreOp::eDontCare,
-			vk::ImageLayout::eUndefined,
-			vk::ImageLayout::eTransferSrcOptimal
-		};
-		vk::AttachmentReference colorRef = { 0, vk::ImageLayout::eColorAttachmentOptimal };
+		return m_StorageViews.back().get();
+	}
 
-		// Define subpass
-		vk::SubpassDescription subpassDesc = {
-			vk::SubpassDescriptionFlags{},
-			vk::PipelineBindPoint::eGraphics,
-			0,
-			nullptr,
-			1,
-			&colorRef,
-			nullptr,
-			nullptr,
-			0,
-			nullptr
-		};
+	void IBLMap::Process()
+	{
+		CreateMap(ENVIRONMENT_SIZE, ENVIRONMENT_MIPS, m_EnviromentMapImage, m_EnviromentMapMemory, m_EnviromentMapImageView);
+		CreateMap(IRRADIANCE_SIZE, 1u, m_IrradianceMapImage, m_IrradianceMapMemory, m_IrradianceMapImageView);
+		CreateMap(PREFILTER_SIZE, PREFILTER_MIPS, m_PrefilterMapImage, m_PrefilterMapMemory, m_PrefilterMapImageView);
 
-		// Use subpass dependencies for layout transitions
-		std::array<vk::SubpassDependency, 2> dependencies;
-		// Transition from undefined to color attachment
-		dependencies.at(0) = {
-			VK_SUBPASS_EXTERNAL,
-			0,
-			vk::PipelineStageFlagBits::eBottomOfPipe,
-			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			vk::AccessFlagBits::eMemoryRead,
-			vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite,
-			vk::DependencyFlagBits::eByRegion
-		};
-		// Transition from color attachment to transfer src
-		dependencies.at(1) = {
-			0,
-			VK_SUBPASS_EXTERNAL,
-			vk::PipelineStageFlagBits::eColorAttachmentOutput,
-			vk::PipelineStageFlagBits::eTransfer,
-			vk::AccessFlagBits::eColorAttachmentRead | vk::AccessFlagBits::eColorAttachmentWrite,
-			vk::AccessFlags{},
-			vk::DependencyFlagBits::eByRegion
-		};
+		if (!m_EnviromentMapImageView || !m_IrradianceMapImageView || !m_PrefilterMapImageView)
+		{
+			m_Stage = Stage::Failed;
+			ReleaseProcessResources();
+			return;
+		}
 
-		// Create render pass
-		vk::RenderPassCreateInfo renderPassInfo = {
-			vk::RenderPassCreateFlags{},
-			1,
-			&attDesc,
-			1,
-			&subpassDesc,
-			2,
-			dependencies.data()
+		vk::CommandBufferAllocateInfo allocInfo = {
+			*r_CommandPool,
+			vk::CommandBufferLevel::ePrimary,
+			1
 		};
 
-		vk::RenderPass renderpass;
 		try
 		{
-			renderpass = r_Device->get().createRenderPass(renderPassInfo);
+			m_CommandBuffer = std::move(r_Device->get().allocateCommandBuffersUnique(allocInfo).front());
+			m_Fence = r_Device->get().createFenceUnique(vk::FenceCreateInfo{});
 		}
-		catch(vk::SystemError& e)
+		catch (vk::SystemError& e)
 		{
-			VEL_CORE_ERROR("Failed to load hdri: Error: {0}", e.what());
-			VEL_CORE_ASSERT(false, "Failed to load hdri: Error: {0}", e.what());
+			VEL_CORE_ERROR("Failed to process HDRI: {0} Error: {1}", m_Filepath, e.what());
+			VEL_CORE_ASSERT(false, "Failed to process HDRI: {0} Error: {1}", m_Filepath, e.what());
+			m_Stage = Stage::Failed;
+			ReleaseProcessResources();
 			return;
 		}
 
-		#pragma endregion
+		vk::CommandBuffer& buffer = m_CommandBuffer.get();
+		buffer.begin(vk::CommandBufferBeginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
 
-		#pragma region CREATE FRAMEBUFFER RESOURCES
-
-		std::array<vk::Image, 6>		framebufferImages;
-		std::array<vk::DeviceMemory, 6> framebufferMemories;
-		std::array<vk::ImageView, 6>	framebufferImageViews;
-		for (size_t i = 0; i < 6; ++i)
-		{
-			// Image
-			vk::ImageCreateInfo fbInfo = {
-				vk::ImageCreateFlags{},
-				vk::ImageType::e2D,
-				vk::Format::eR16G16B16A16Sfloat,
-				vk::Extent3D {
-					mapFaceSize,
-					mapFaceSize,
-					1
-				},
-				1,
-				1,
-				vk::SampleCountFlagBits::e1,
-				vk::ImageTiling::eOptimal,
-				vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc,
-				vk::SharingMode::eExclusive,
-				1,
-				&r_GraphicsQueueIndex,
-				vk::ImageLayout::eUndefined
-			};
-			try
-			{
-				framebufferImages.at(i) = r_Device->get().createImage(fbInfo);
-			}
-			catch (vk::SystemError& e)
+		if (m_LoadResult->Cached)
+		{
+			CopyBufferToMaps(buffer, m_StagingBuffer->Buffer.get());
+			GenerateEnvironmentMips(buffer, vk::ImageLayout::eTransferDstOptimal);
+		}
+		else
+		{
+			EquirectangularToCubemap(buffer);
+			if (m_Stage == Stage::Failed)
 			{
-				VEL_CORE_ERROR("An error occurred in creating the HDRI framebuffer images: {0}", e.what());
-				VEL_CORE_ASSERT(false, "Failed to create HDRI framebuffer images! Error {0}", e.what());
+				ReleaseProcessResources();
 				return;
 			}
-			
-			// Memory
-			memRequirements = r_Device->get().getImageMemoryRequirements(framebufferImages.at(i));
+			GenerateEnvironmentMips(buffer, vk::ImageLayout::eGeneral);
+		}
 
-			allocInfo = {
-				memRequirements.size,
-				BaseBuffer::FindMemoryType(r_PhysicalDevice,memRequirements.memoryTypeBits,vk::MemoryPropertyFlagBits::eDeviceLocal)
-			};
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, SAMPLED_STAGES, 0, ENVIRONMENT_MIPS);
 
-			try
-			{
-				framebufferMemories.at(i) = r_Device->get().allocateMemory(allocInfo);
-
-			}
-			catch (vk::SystemError& e)
-			{
-				VEL_CORE_ERROR("An error occurred in creating the hdri framebuffer images memory: {0}", e.what());
-				VEL_CORE_ASSERT(false, "Failed to create hdri framebuffer images memory! Error {0}", e.what());
-				return;
-			}
+		if (!m_LoadResult->Cached)
+		{
+			CreateIrradianceMap(buffer);
+			PrefilterCubemap(buffer);
+
+			// Pulled back so the next load can skip all of the above
+			m_ReadbackBuffer = std::make_unique<BaseBuffer>(
+				r_PhysicalDevice,
+				*r_Device,
+				GetCacheSize(),
+				vk::BufferUsageFlagBits::eTransferDst,
+				vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+			CopyMapsToBuffer(buffer, m_ReadbackBuffer->Buffer.get());
+		}
 
-			r_Device->get().bindImageMemory(framebufferImages.at(i), framebufferMemories.at(i), 0);
+		buffer.end();
 
-			// View
-			vk::ImageViewCreateInfo fbView = {
-				vk::ImageViewCreateFlags{},
-				framebufferImages.at(i),
-				vk::ImageViewType::e2D,
-				vk::Format::eR16G16B16A16Sfloat,
-				{},
-				{
-					vk::ImageAspectFlagBits::eColor,
-					0,
-					1,
-					0,
-					1
-				}
-			};
-			try
-			{
-				framebufferImageViews.at(i) = r_Device->get().createImageView(fbView);
+		vk::SubmitInfo submitInfo = {
+			{},{},{},1,&buffer,{},{}
+		};
 
-			}
-			catch (vk::SystemError& e)
-			{
-				VEL_CORE_ERROR("An error occurred in creating the hdri framebuffer image views: {0}", e.what());
-				VEL_CORE_ASSERT(false, "Failed to create framebuffer hdri image views! Error {0}", e.what());
-				return;
-			}
-			
+		vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
+		auto result = queue.submit(1, &submitInfo, m_Fence.get());
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to submit HDRI processing for {0}", m_Filepath);
+			VEL_CORE_ASSERT(false, "Failed to submit HDRI processing for {0}", m_Filepath);
+			m_Fence.reset();
+			m_Stage = Stage::Failed;
+			ReleaseProcessResources();
+			return;
 		}
-		
-		#pragma endregion
-
-		#pragma region CREATE FRAMEBUFFERS
 
-		std::array<vk::Framebuffer, 6> framebuffers;
-		for (size_t i = 0; i < 6; ++i)
-		{
-			vk::FramebufferCreateInfo framebufferInfo = {
-				vk::FramebufferCreateFlags{},
-				renderpass,
-				1,
-				&framebufferImageViews.at(i),
-				mapFaceSize,
-				mapFaceSize,
-				1
-			};
+		m_Stage = Stage::Processing;
+	}
 
-			try
-			{
-				framebuffers.at(i) = r_Device->get().createFramebuffer(framebufferInfo);
-			}
-			catch (vk::SystemError& e)
-			{
-				VEL_CORE_ERROR("Failed to create HDRI framebuffers! Error: {0}", e.what());
-				VEL_CORE_ASSERT(false, "Failed to create HDRI framebuffers: {0}", e.what());
-				return;
-			}
-		}
-		
-		
-		#pragma endregion
+	void IBLMap::EquirectangularToCubemap(vk::CommandBuffer& buffer)
+	{
+		#pragma region CREATE VULKAN IMAGE
 
-		#pragma region CREATE DESCRIPTORS
-		// Set layout
-		vk::DescriptorSetLayout descriptorSetLayout;
-		vk::DescriptorSetLayoutBinding descriptorSetLayoutBinding = {
-			0,
-			vk::DescriptorType::eCombinedImageSampler,
+		vk::ImageCreateInfo equirectangularImageInfo = {
+			vk::ImageCreateFlags{},
+			vk::ImageType::e2D,
+			HDRI_FORMAT,
+			vk::Extent3D{m_SourceWidth,m_SourceHeight,1},
 			1,
-			vk::ShaderStageFlagBits::eFragment,
-			nullptr
-		};
-		vk::DescriptorSetLayoutCreateInfo descriptorSetCreateInfo = {
-			vk::DescriptorSetLayoutCreateFlags{},
 			1,
-			&descriptorSetLayoutBinding
+			vk::SampleCountFlagBits::e1,
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled,
+			vk::SharingMode::eExclusive,
+			{},
+			{},
+			vk::ImageLayout::eUndefined
 		};
 
-		try
-		{
-			descriptorSetLayout = r_Device->get().createDescriptorSetLayout(descriptorSetCreateInfo);
-		}
-		catch (vk::SystemError& e)
+		if (!CreateImage(*r_Device, r_PhysicalDevice, equirectangularImageInfo, m_EquirectangularImage, m_EquirectangularMemory))
 		{
-			VEL_CORE_ERROR("Failed to create HDRI descriptor set layout. Error: {0}", e.what());
-			VEL_CORE_ASSERT(false, "Failed to create HDRI descriptor set layout", e.what());
+			m_Stage = Stage::Failed;
+			return;
 		}
 
-		// Pool
-		vk::DescriptorPoolSize poolSize = { vk::DescriptorType::eCombinedImageSampler,1 };
-		vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo = {
-			vk::DescriptorPoolCreateFlags{},
-			6,
-			1,
-			&poolSize
+		vk::ImageViewCreateInfo viewInfo = {
+			vk::ImageViewCreateFlags{},
+			m_EquirectangularImage.get(),
+			vk::ImageViewType::e2D,
+			HDRI_FORMAT,
+			{},
+			{
+				vk::ImageAspectFlagBits::eColor,
+				0,1,0,1
+			}
 		};
-		vk::DescriptorPool descriptorPool;
+
 		try
 		{
-			descriptorPool =
-				r_Device->get().createDescriptorPool(descriptorPoolCreateInfo);
+			m_EquirectangularImageView = r_Device->get().createImageViewUnique(viewInfo);
 		}
 		catch (vk::SystemError& e)
 		{
-			VEL_CORE_ERROR("Failed to create HDRI descriptor pool. Error: {0}", e.what());
-			VEL_CORE_ASSERT(false, "Failed to create HDRI descriptor pool", e.what());
+			VEL_CORE_ERROR("Failed to create HDR: {0} (Failed to create image view) Error: {1}", m_Filepath, e.what());
+			VEL_CORE_ASSERT(false, "Failed to create HDR: {0} (Failed to create image view) Error: {1}", m_Filepath, e.what());
+			m_Stage = Stage::Failed;
+			return;
 		}
 
-		// Sets
-		vk::DescriptorSet descriptorSet;
-		vk::DescriptorSetAllocateInfo descriptorSetAllocInfo = {
-			descriptorPool,
-			1,
-			&descriptorSetLayout
-		};
+		#pragma endregion
 
-		auto result = r_Device->get().allocateDescriptorSets(&descriptorSetAllocInfo, &descriptorSet);
+		#pragma region PROCESS RAW TO VULKAN
 
-		if (result != vk::Result::eSuccess)
-		{
-			VEL_CORE_ERROR("Failed to allocate HDRI descriptor set");
-			VEL_CORE_ASSERT(false, "Failed to allocate HDRI descriptor set");
-		}
+		Texture::TransitionImageLayout(buffer, m_EquirectangularImage.get(), HDRI_FORMAT, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal, 1, 1);
 
-		// Write set
-		vk::DescriptorImageInfo equirectangularInfo = {
-			m_Sampler.get(),
-			equirectangularIV.get(),
-			vk::ImageLayout::eShaderReadOnlyOptimal
-		};
-		
-		vk::WriteDescriptorSet writeSet = {
-			descriptorSet,0,0,
-			1,vk::DescriptorType::eCombinedImageSampler,
-			&equirectangularInfo,nullptr,nullptr
-		};
+		Texture::CopyBufferToImage(buffer, m_EquirectangularImage.get(), m_StagingBuffer->Buffer.get(), m_SourceWidth, m_SourceHeight, 1);
+
+		ImageBarrier(buffer, m_EquirectangularImage.get(), vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eComputeShader, 0, 1, 1);
 
-		r_Device->get().updateDescriptorSets(1, &writeSet, 0, nullptr);
-		
 		#pragma endregion
 
-		#pragma region PUSH CONSTANT RANGE
+		#pragma region FLAT TO CUBE
+
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+			vk::AccessFlags{}, vk::AccessFlagBits::eShaderWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, 0, 1);
+
+		m_Pipelines.push_back(CreatePipeline("equirecttocubecomp.spv"));
+		vk::DescriptorSet set = CreateSet(m_EquirectangularImageView.get(), CreateStorageView(m_EnviromentMapImage.get(), 0));
+
+		// Every face in one dispatch, z picks the face
+		const PassConstants constants = { 0.0f, ENVIRONMENT_SIZE };
+		buffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipelines.back().get());
+		buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_PipelineLayout.get(), 0, 1, &set, 0, nullptr);
+		buffer.pushConstants(m_PipelineLayout.get(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PassConstants), &constants);
+		buffer.dispatch(ENVIRONMENT_SIZE / GROUP_SIZE, ENVIRONMENT_SIZE / GROUP_SIZE, 6);
 
-		vk::PushConstantRange vertPushConstantRange = {
-			vk::ShaderStageFlagBits::eVertex,
-			0,
-			sizeof(glm::mat4) * 2
-		};
-		
 		#pragma endregion
+	}
 
-		#pragma region CREATE PIPELINE LAYOUT
-		vk::PipelineLayout pipelineLayout;
-		vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo = {
-			vk::PipelineLayoutCreateFlags{},
-			1,
-			&descriptorSetLayout,
-			1,
-			&vertPushConstantRange
-		};
+	void IBLMap::GenerateEnvironmentMips(vk::CommandBuffer& buffer, vk::ImageLayout mip0Layout)
+	{
+		const bool computed = mip0Layout == vk::ImageLayout::eGeneral;
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), mip0Layout, vk::ImageLayout::eTransferSrcOptimal,
+			computed ? vk::AccessFlagBits::eShaderWrite : vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+			computed ? vk::PipelineStageFlagBits::eComputeShader : vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, 0, 1);
 
-		try
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 1, ENVIRONMENT_MIPS - 1u);
+
+		// Each level is blitted from the one above, all six faces at once
+		for (uint32_t mip = 1; mip < ENVIRONMENT_MIPS; ++mip)
 		{
-			pipelineLayout = r_Device->get().createPipelineLayout(pipelineLayoutCreateInfo);
+			const int32_t sourceSize = static_cast<int32_t>(ENVIRONMENT_SIZE >> (mip - 1u));
+			const int32_t targetSize = std::max<int32_t>(sourceSize / 2, 1);
+
+			vk::ImageBlit blit = {
+				vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, mip - 1u, 0, 6 },
+				{ vk::Offset3D{ 0,0,0 }, vk::Offset3D{ sourceSize,sourceSize,1 } },
+				vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, mip, 0, 6 },
+				{ vk::Offset3D{ 0,0,0 }, vk::Offset3D{ targetSize,targetSize,1 } }
+			};
+
+			buffer.blitImage(
+				m_EnviromentMapImage.get(), vk::ImageLayout::eTransferSrcOptimal,
+				m_EnviromentMapImage.get(), vk::ImageLayout::eTransferDstOptimal,
+				1, &blit, vk::Filter::eLinear
+			);
+
+			ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+				vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
+				vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer, mip, 1);
 		}
-		catch(vk::SystemError& e)
+	}
+
+	void IBLMap::CreateIrradianceMap(vk::CommandBuffer& buffer)
+	{
+		ImageBarrier(buffer, m_IrradianceMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+			vk::AccessFlags{}, vk::AccessFlagBits::eShaderWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, 0, 1);
+
+		m_Pipelines.push_back(CreatePipeline("irradiancecomp.spv"));
+		vk::DescriptorSet set = CreateSet(m_EnviromentMapImageView.get(), CreateStorageView(m_IrradianceMapImage.get(), 0));
+
+		const PassConstants constants = { 0.0f, IRRADIANCE_SIZE };
+		buffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipelines.back().get());
+		buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_PipelineLayout.get(), 0, 1, &set, 0, nullptr);
+		buffer.pushConstants(m_PipelineLayout.get(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PassConstants), &constants);
+		buffer.dispatch(IRRADIANCE_SIZE / GROUP_SIZE, IRRADIANCE_SIZE / GROUP_SIZE, 6);
+	}
+
+	void IBLMap::PrefilterCubemap(vk::CommandBuffer& buffer)
+	{
+		ImageBarrier(buffer, m_PrefilterMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+			vk::AccessFlags{}, vk::AccessFlagBits::eShaderWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, 0, PREFILTER_MIPS);
+
+		m_Pipelines.push_back(CreatePipeline("prefiltercomp.spv"));
+		buffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipelines.back().get());
+
+		// Roughness goes linearly from 0 at the top mip to 1 at the last
+		for (uint32_t mip = 0; mip < PREFILTER_MIPS; ++mip)
 		{
-			VEL_CORE_ERROR("Failed to create HDRI pipeline layout! Error: {0}", e.what());
-			VEL_CORE_ASSERT(false, "Failed to create HDRI pipeline layout: {0}", e.what());
-			return;
+			const uint32_t size = PREFILTER_SIZE >> mip;
+			const PassConstants constants = { static_cast<float>(mip) / static_cast<float>(PREFILTER_MIPS - 1u), size };
+
+			vk::DescriptorSet set = CreateSet(m_EnviromentMapImageView.get(), CreateStorageView(m_PrefilterMapImage.get(), mip));
+			buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_PipelineLayout.get(), 0, 1, &set, 0, nullptr);
+			buffer.pushConstants(m_PipelineLayout.get(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PassConstants), &constants);
+
+			const uint32_t groups = (size + GROUP_SIZE - 1u) / GROUP_SIZE;
+			buffer.dispatch(groups, groups, 6);
 		}
-		
-		#pragma endregion
+	}
 
-		#pragma region FIXED FUNCTION
-		// Vert input
-		auto bindingDescription = Vertex::GetBindingDescription();
-		auto attribDescription = Vertex::GetAttributeDescriptions();
-		vk::PipelineVertexInputStateCreateInfo vertexInputInfo = {
-			vk::PipelineVertexInputStateCreateFlags{},
-			1,
-			&bindingDescription,
-			static_cast<uint32_t>(attribDescription.size()),
-			attribDescription.data()
-		};
-		// Input assembly
-		vk::PipelineInputAssemblyStateCreateInfo inputAssembly = {
-			vk::PipelineInputAssemblyStateCreateFlags{},
-			vk::PrimitiveTopology::eTriangleList,
-			VK_FALSE
-		};
-		// Viewport and scissor
-		vk::Viewport viewport = {
-			0.0f,0.0f,
-			mapFaceSize,mapFaceSize,
-			0.0f,1.0f
-		};
-		vk::Rect2D scissor = {
-			vk::Offset2D{0,0},
-			vk::Extent2D{mapFaceSize,mapFaceSize}
-		};
-		vk::PipelineViewportStateCreateInfo viewportState = {
-			vk::PipelineViewportStateCreateFlags{},
+	void IBLMap::ComputeBRDF()
+	{
+		vk::ImageCreateInfo imageInfo = {
+			vk::ImageCreateFlags{},
+			vk::ImageType::e2D,
+			MAP_FORMAT,
+			vk::Extent3D{BRDF_LUT_SIZE,BRDF_LUT_SIZE,1},
 			1,
-			&viewport,
 			1,
-			&scissor
-		};
-		// Rasterizer TODO: Check the culling and orientation
-		vk::PipelineRasterizationStateCreateInfo rasterizer = {
-			vk::PipelineRasterizationStateCreateFlags{},
-			VK_FALSE,
-			VK_FALSE,
-			vk::PolygonMode::eFill,
-			vk::CullModeFlagBits::eNone,
-			vk::FrontFace::eCounterClockwise,
-			VK_FALSE,
-			0.0f,0.0f,0.0f,1.0f
-		};
-		// Multisampling
-		vk::PipelineMultisampleStateCreateInfo multisampling = {
-			vk::PipelineMultisampleStateCreateFlags{},
 			vk::SampleCountFlagBits::e1,
-			VK_FALSE,
-			1.0f,
-			nullptr,
-			VK_FALSE,
-			VK_FALSE
-		};
-		// NO DEPTH
-		// Color blending
-		vk::PipelineColorBlendAttachmentState colorBlendAttachment = {
-			VK_FALSE,
-			vk::BlendFactor::eOne,
-			vk::BlendFactor::eZero,
-			vk::BlendOp::eAdd,
-			vk::BlendFactor::eOne,
-			vk::BlendFactor::eZero,
-			vk::BlendOp::eAdd
-		};
-		std::array<float, 4> blendConstants = { 0.0f,0.0f,0.0f,0.0f };
-		vk::PipelineColorBlendStateCreateInfo colorBlending = {
-			vk::PipelineColorBlendStateCreateFlags{},
-			VK_FALSE,
-			vk::LogicOp::eCopy,
-			1,
-			&colorBlendAttachment,
-			blendConstants
-		};
-
-		
-		
-		#pragma endregion
-
-		#pragma region CREATE PIPELINE
-
-		vk::GraphicsPipelineCreateInfo pipelineCI = {
-			vk::PipelineCreateFlags{},
-			2u,
-			shaderStages.data(),
-			&vertexInputInfo,
-			&inputAssembly,
-			nullptr,
-			&viewportState,
-			&rasterizer,
-			&multisampling,
-			nullptr,
-			&colorBlending,
-			nullptr,
-			pipelineLayout,
-			renderpass,
-			0,
-			nullptr
+			vk::ImageTiling::eOptimal,
+			vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eSampled,
+			vk::SharingMode::eExclusive,
+			{},
+			{},
+			vk::ImageLayout::eUndefined
 		};
-		vk::Pipeline pipeline;
-
-		result = r_Device->get().createGraphicsPipelines(nullptr, 1, &pipelineCI, nullptr, &pipeline);
 
-		if (result != vk::Result::eSuccess)
+		if (!CreateImage(*r_Device, r_PhysicalDevice, imageInfo, m_BRDFLut->Image, m_BRDFLut->Memory))
 		{
-			VEL_CORE_ERROR("Failed to create HDRI pipeline (Stage 1)");
-			VEL_CORE_ASSERT(false,"Failed to create HDRI pipeline (Stage 1)");
 			return;
 		}
-		
-		
-		#pragma endregion
-		
-		#pragma endregion
 
-		#pragma region FLAT TO CUBE
-		// Now we can actually do the rendering process
-		std::array<float, 4> clearColor = {
-			1.0f, 0.0f, 1.0f, 1.0f
+		vk::ImageViewCreateInfo viewInfo = {
+			vk::ImageViewCreateFlags{},
+			m_BRDFLut->Image.get(),
+			vk::ImageViewType::e2D,
+			MAP_FORMAT,
+			{},
+			{
+				vk::ImageAspectFlagBits::eColor,
+				0,1,0,1
+			}
 		};
-		vk::ClearValue clearColorVal = vk::ClearValue(clearColor);
-		// Create array of capture matricies
-		// Each pass uses the projection and one of the views
-		glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 512.0f);
-		captureProjection[1][1] *= -1.0f;
-		std::vector<glm::mat4> captureViews = {
-			// POSITIVE_Y
-			rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-			// NEGATIVE_Y
-			rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-			// POSITIVE_Z
-			rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-			// NEGATIVE_Z
-			rotate(glm::mat4(1.0f), glm::radians(180.0f), glm::vec3(0.0f, 0.0f, 1.0f)),
-			// POSITIVE_X
-			rotate(rotate(glm::mat4(1.0f), glm::radians(90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f)),
-			// NEGATIVE_X
-			rotate(rotate(glm::mat4(1.0f), glm::radians(-90.0f), glm::vec3(0.0f, 1.0f, 0.0f)), glm::radians(180.0f), glm::vec3(1.0f, 0.0f, 0.0f))
+
+		vk::CommandBufferAllocateInfo allocInfo = {
+			*r_CommandPool,
+			vk::CommandBufferLevel::ePrimary,
+			1
 		};
 
-		for (auto& v : captureViews)
+		try
 		{
-			v[0][2] *= -1.0f;
-			v[1][2] *= -1.0f;
-			v[2][2] *= -1.0f;
-			v[3][2] *= -1.0f;
+			m_BRDFLut->ImageView = r_Device->get().createImageViewUnique(viewInfo);
+			m_BRDFLut->CommandBuffer = std::move(r_Device->get().allocateCommandBuffersUnique(allocInfo).front());
+			m_BRDFLut->Fence = r_Device->get().createFenceUnique(vk::FenceCreateInfo{});
 		}
-		
-		// Scope the commandbuffer RAII object
+		catch (vk::SystemError& e)
 		{
-			vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
-			TemporaryCommandBuffer renderBufferWrapper = TemporaryCommandBuffer(*r_Device, *r_CommandPool, queue);
-			auto& renderBuffer = renderBufferWrapper.GetBuffer();
+			VEL_CORE_ERROR("Failed to create BRDF LUT! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to create BRDF LUT! Error: {0}", e.what());
+			return;
+		}
 
-			// Bind vertices
-			modelBuffer.Bind(renderBuffer);
+		// Its own sampler as it can outlive the map that made it
+		m_BRDFLut->Sampler = CreateSampler(*r_Device, 1.0f);
+		m_BRDFLut->ImageInfo = {
+			m_BRDFLut->Sampler.get(),
+			m_BRDFLut->ImageView.get(),
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		};
 
-			Renderer::GetRenderer()->LoadMesh("../Velocity/assets/models/cube.obj", "VEL_INTERNAL_Cube");
+		vk::CommandBuffer& buffer = m_BRDFLut->CommandBuffer.get();
+		buffer.begin(vk::CommandBufferBeginInfo{ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
 
-			auto mesh = Renderer::GetRenderer()->GetMeshList().find("VEL_INTERNAL_Cube")->second;
+		ImageBarrier(buffer, m_BRDFLut->Image.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+			vk::AccessFlags{}, vk::AccessFlagBits::eShaderWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader, 0, 1, 1);
 
-			// For each side
-			for (size_t i = 0; i < 6; ++i)
-			{
-				// Begin render pass
-				vk::RenderPassBeginInfo renderPassInfo = {
-					renderpass,
-					framebuffers.at(i),
-					vk::Rect2D{{0,0},vk::Extent2D{mapFaceSize,mapFaceSize}},
-					1,
-					&clearColorVal
-				};
-				renderBuffer.beginRenderPass(renderPassInfo, vk::SubpassContents::eInline);
+		m_Pipelines.push_back(CreatePipeline("brdflutcomp.spv"));
+		vk::DescriptorSet set = CreateSet(nullptr, CreateStorageView(m_BRDFLut->Image.get(), 0, 1));
 
-				// Bind pipeline
-				renderBuffer.bindPipeline(vk::PipelineBindPoint::eGraphics, pipeline);
+		const PassConstants constants = { 0.0f, BRDF_LUT_SIZE };
+		buffer.bindPipeline(vk::PipelineBindPoint::eCompute, m_Pipelines.back().get());
+		buffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, m_PipelineLayout.get(), 0, 1, &set, 0, nullptr);
+		buffer.pushConstants(m_PipelineLayout.get(), vk::ShaderStageFlagBits::eCompute, 0, sizeof(PassConstants), &constants);
+		buffer.dispatch(BRDF_LUT_SIZE / GROUP_SIZE, BRDF_LUT_SIZE / GROUP_SIZE, 1);
 
-				// Bind descriptor set for equirectangular map
-				renderBuffer.bindDescriptorSets(vk::PipelineBindPoint::eGraphics, pipelineLayout, 0, 1, &descriptorSet, 0, nullptr);
+		ImageBarrier(buffer, m_BRDFLut->Image.get(), vk::ImageLayout::eGeneral, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eComputeShader, SAMPLED_STAGES, 0, 1, 1);
 
-				// push matrices
-				renderBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, 0, sizeof(glm::mat4), value_ptr(captureProjection));
-				renderBuffer.pushConstants(pipelineLayout, vk::ShaderStageFlagBits::eVertex, sizeof(glm::mat4), sizeof(glm::mat4), value_ptr(captureViews[i]));
+		buffer.end();
 
-				// Draw cube
-				renderBuffer.drawIndexed(mesh.IndexCount, 1, mesh.IndexStart, mesh.VertexOffset,0);
-
-				// End render pass
-				renderBuffer.endRenderPass();
-				
-			}
-		}		
-		#pragma endregion
-
-		r_Device->get().waitIdle();
+		vk::SubmitInfo submitInfo = {
+			{},{},{},1,&buffer,{},{}
+		};
 
-		// At this point the 6 frame buffer images should each contain 1 face of the flattened map
-		// So we can copy it over
-		// Scope the buffer
+		// Doesnt need the HDRI so goes now, ahead of any map that will use it
+		vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
+		auto result = queue.submit(1, &submitInfo, m_BRDFLut->Fence.get());
+		if (result != vk::Result::eSuccess)
 		{
-			vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
-			TemporaryCommandBuffer renderBufferWrapper = TemporaryCommandBuffer(*r_Device, *r_CommandPool, queue);
-			auto& copyBuffer = renderBufferWrapper.GetBuffer();
-			
-			for (size_t i = 0; i < 6; ++i)
-			{
-				// Copy framebuffer to array layer
-				vk::ImageCopy faceCopy = {
-					vk::ImageSubresourceLayers{
-						vk::ImageAspectFlagBits::eColor,
-						0,
-						0,
-						1
-					},
-					vk::Offset3D{0,0,0},
-					vk::ImageSubresourceLayers{
-						vk::ImageAspectFlagBits::eColor,
-						0,
-						static_cast<uint32_t>(i),
-						1
-					},
-					vk::Offset3D{0,0,0},
-					vk::Extent3D{
-						mapFaceSize,
-						mapFaceSize,
-						1
-					}
-				};
-
-				copyBuffer.copyImage(
-					framebufferImages.at(i),
-					vk::ImageLayout::eTransferSrcOptimal,
-					m_EnviromentMapImage,
-					vk::ImageLayout::eTransferDstOptimal,
-					1,
-					&faceCopy
-				);
-			}
-
-			// Now the image has the full cubemap but needs to transitioned to shader read
-			Texture::TransitionImageLayout(
-				copyBuffer,
-				m_EnviromentMapImage,
-				vk::Format::eR16G16B16A16Sfloat,
-				vk::ImageLayout::eTransferDstOptimal,
-				vk::ImageLayout::eShaderReadOnlyOptimal,
-				1,
-				6
-			);
+			VEL_CORE_ERROR("Failed to submit BRDF LUT");
+			VEL_CORE_ASSERT(false, "Failed to submit BRDF LUT");
+			m_BRDFLut->Fence.reset();
 		}
+	}
 
-		// Delete all used resources
-		r_Device->get().destroyShaderModule(vertShaderModule);
-		r_Device->get().destroyShaderModule(fragShaderModule);
-		
-		r_Device->get().destroyPipeline(pipeline);
-		r_Device->get().destroyPipelineLayout(pipelineLayout);
-		r_Device->get().destroyRenderPass(renderpass);
-
-		for (int i = 0; i < 6; ++i)
+	void IBLMap::CopyMapsToBuffer(vk::CommandBuffer& buffer, vk::Buffer target)
+	{
+		// Environment mip 0 was last read by the convolution, only the execution has to wait
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlags{}, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, 0, 1);
+		ImageBarrier(buffer, m_IrradianceMapImage.get(), vk::ImageLayout::eGeneral, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, 0, 1);
+		ImageBarrier(buffer, m_PrefilterMapImage.get(), vk::ImageLayout::eGeneral, vk::ImageLayout::eTransferSrcOptimal,
+			vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eTransferRead,
+			vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eTransfer, 0, PREFILTER_MIPS);
+
+		VkDeviceSize offset = 0u;
+		vk::BufferImageCopy region = GetMapRegion(offset, ENVIRONMENT_SIZE, 0);
+		buffer.copyImageToBuffer(m_EnviromentMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, target, 1, &region);
+		offset += GetFaceBytes(ENVIRONMENT_SIZE);
+
+		region = GetMapRegion(offset, IRRADIANCE_SIZE, 0);
+		buffer.copyImageToBuffer(m_IrradianceMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, target, 1, &region);
+		offset += GetFaceBytes(IRRADIANCE_SIZE);
+
+		std::vector<vk::BufferImageCopy> regions;
+		for (uint32_t mip = 0; mip < PREFILTER_MIPS; ++mip)
 		{
-			r_Device->get().destroyImage(framebufferImages.at(i));
-			r_Device->get().destroyImageView(framebufferImageViews.at(i));
-			r_Device->get().freeMemory(framebufferMemories.at(i));
-
-			r_Device->get().destroyFramebuffer(framebuffers.at(i));
+			regions.push_back(GetMapRegion(offset, PREFILTER_SIZE >> mip, mip));
+			offset += GetFaceBytes(PREFILTER_SIZE >> mip);
 		}
+		buffer.copyImageToBuffer(m_PrefilterMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, target, static_cast<uint32_t>(regions.size()), regions.data());
+
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, SAMPLED_STAGES, 0, 1);
+		ImageBarrier(buffer, m_IrradianceMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, SAMPLED_STAGES, 0, 1);
+		ImageBarrier(buffer, m_PrefilterMapImage.get(), vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferRead, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, SAMPLED_STAGES, 0, PREFILTER_MIPS);
+
+		// Make the copies visible to the worker writing the cache once the fence signals
+		vk::MemoryBarrier hostBarrier = { vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eHostRead };
+		buffer.pipelineBarrier(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eHost, vk::DependencyFlags{}, 1, &hostBarrier, 0, nullptr, 0, nullptr);
+	}
 
-		r_Device->get().destroyDescriptorSetLayout(descriptorSetLayout);
-		r_Device->get().destroyDescriptorPool(descriptorPool);
+	void IBLMap::CopyBufferToMaps(vk::CommandBuffer& buffer, vk::Buffer source)
+	{
+		ImageBarrier(buffer, m_EnviromentMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 0, 1);
+		ImageBarrier(buffer, m_IrradianceMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 0, 1);
+		ImageBarrier(buffer, m_PrefilterMapImage.get(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+			vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite,
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer, 0, PREFILTER_MIPS);
+
+		VkDeviceSize offset = 0u;
+		vk::BufferImageCopy region = GetMapRegion(offset, ENVIRONMENT_SIZE, 0);
+		buffer.copyBufferToImage(source, m_EnviromentMapImage.get(), vk::ImageLayout::eTransferDstOptimal, 1, &region);
+		offset += GetFaceBytes(ENVIRONMENT_SIZE);
+
+		region = GetMapRegion(offset, IRRADIANCE_SIZE, 0);
+		buffer.copyBufferToImage(source, m_IrradianceMapImage.get(), vk::ImageLayout::eTransferDstOptimal, 1, &region);
+		offset += GetFaceBytes(IRRADIANCE_SIZE);
+
+		std::vector<vk::BufferImageCopy> regions;
+		for (uint32_t mip = 0; mip < PREFILTER_MIPS; ++mip)
+		{
+			regions.push_back(GetMapRegion(offset, PREFILTER_SIZE >> mip, mip));
+			offset += GetFaceBytes(PREFILTER_SIZE >> mip);
+		}
+		buffer.copyBufferToImage(source, m_PrefilterMapImage.get(), vk::ImageLayout::eTransferDstOptimal, static_cast<uint32_t>(regions.size()), regions.data());
+
+		// Environment mip 0 is left for GenerateEnvironmentMips
+		ImageBarrier(buffer, m_IrradianceMapImage.get(), vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, SAMPLED_STAGES, 0, 1);
+		ImageBarrier(buffer, m_PrefilterMapImage.get(), vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+			vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead,
+			vk::PipelineStageFlagBits::eTransfer, SAMPLED_STAGES, 0, PREFILTER_MIPS);
+	}
 
-		// Create image view for the cube map
-		vk::ImageViewCreateInfo finalViewInfo = {
-			vk::ImageViewCreateFlags{},
-			m_EnviromentMapImage,
-			vk::ImageViewType::eCube,
-			vk::Format::eR16G16B16A16Sfloat,
-			{},
+	void IBLMap::ReleaseProcessResources()
+	{
+		// The maps own pipelines may have recorded the LUT, so it has to be finished first
+		if (m_BRDFLut && !m_BRDFLut->Ready)
+		{
+			if (m_BRDFLut->Fence)
 			{
-				vk::ImageAspectFlagBits::eColor,
-				0,1,0,6
+				auto result = r_Device->get().waitForFences(1, &m_BRDFLut->Fence.get(), VK_TRUE, UINT64_MAX);
 			}
-		};
-		try
-		{
-			m_EnviromentMapImageView = r_Device->get().createImageView(finalViewInfo);
+			m_BRDFLut->CommandBuffer.reset();
+			m_BRDFLut->Fence.reset();
+			m_BRDFLut->Ready = true;
 		}
-		catch (vk::SystemError& e)
+
+		if (m_StagingData)
 		{
-			VEL_CORE_ERROR("Failed to load hdr skybox: {0} (Failed to create image view)");
-			VEL_CORE_ASSERT(false, "Failed to load hdr skybox: {0} (Failed to create image view)");
+			r_Device->get().unmapMemory(m_StagingBuffer->Memory.get());
+			m_StagingData = nullptr;
 		}
+		m_StagingBuffer.reset();
+
+		m_CommandBuffer.reset();
+		m_Fence.reset();
+		m_Pipelines.clear();
+		m_PipelineLayout.reset();
+		m_DescriptorPool.reset();
+		m_DescriptorSetLayout.reset();
+		m_StorageViews.clear();
+		m_EquirectangularImageView.reset();
+		m_EquirectangularImage.reset();
+		m_EquirectangularMemory.reset();
+		m_LoadResult.reset();
 	}
 
-	void IBLMap::CreateIrradianceMap()
+	void IBLMap::CreateDescriptorInfos()
 	{
-	}
+		// Save data for renderer
+		m_EnviromentMapImageInfo = {
+			m_Sampler.get(),
+			m_EnviromentMapImageView.get(),
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		};
 
-	void IBLMap::PrefilterCubemap()
-	{
-	}
+		m_EnviromentMapWriteSet = {
+			nullptr,
+			1,
+			0,
+			1,
+			vk::DescriptorType::eCombinedImageSampler,
+			&m_EnviromentMapImageInfo,
+			nullptr,
+			nullptr
+		};
 
-	void IBLMap::ComputeBRDF()
-	{
+		m_IrradianceMapImageInfo = {
+			m_Sampler.get(),
+			m_IrradianceMapImageView.get(),
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		};
+
+		m_PrefilterMapImageInfo = {
+			m_Sampler.get(),
+			m_PrefilterMapImageView.get(),
+			vk::ImageLayout::eShaderReadOnlyOptimal
+		};
 	}
 }
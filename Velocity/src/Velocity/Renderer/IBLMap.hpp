@@ -1,37 +1,121 @@
 #pragma once
 
+#include <future>
+#include <memory>
+
 #include<glm/glm.hpp>
 #include <glm/ext/matrix_transform.hpp>
 #include <vulkan/vulkan.hpp>
 
 
-#include "BufferManager.hpp"
+#include "BaseBuffer.hpp"
+#include "SphericalHarmonics.hpp"
 #include "Velocity/ECS/Components.hpp"
 
 namespace Velocity
 {
 	// Takes in a equirectangular HDRI image file and con-volutes into cubemaps (enviroment map, irradiance map, prefilter) and a brdfLUT
+	// Everything is done in compute, off the frame. The HDRI is read and hashed on a worker, the GPU work is submitted
+	// with a fence and picked up by Update. Results are cached on disk by the hash of the HDRI so reopening skips the convolution
 	class IBLMap
 	{
 		friend class Renderer;
 	public:
-		IBLMap(const std::string& filepath, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex, BufferManager& modelBuffer);
+		IBLMap(const std::string& filepath, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex);
 
 		~IBLMap();
+
+		// True once every map and the LUT can be sampled
+		bool IsReady() const { return m_Stage == Stage::Ready || m_Stage == Stage::Caching; }
+
+		// Sets are only valid once IsReady
+		const vk::DescriptorImageInfo& GetEnvironmentInfo() const { return m_EnviromentMapImageInfo; }
+		const vk::DescriptorImageInfo& GetIrradianceInfo() const { return m_IrradianceMapImageInfo; }
+		const vk::DescriptorImageInfo& GetPrefilterInfo() const { return m_PrefilterMapImageInfo; }
+		const vk::DescriptorImageInfo& GetBRDFInfo() const { return m_BRDFLut->ImageInfo; }
+
+		// Diffuse lighting as spherical harmonics, an alternative to sampling the irradiance map
+		// Available as soon as the HDRI is read, before the GPU maps are done
+		bool HasIrradianceSH() const { return m_HasIrradianceSH; }
+		const SHCoefficients& GetIrradianceSH() const { return m_IrradianceSH; }
+
+		// Roughness 1 samples this mip of the prefilter map
+		static uint32_t GetMaxPrefilterMip() { return PREFILTER_MIPS - 1u; }
+
 	private:
+		// Format the source HDRI is uploaded in, see HDRPacking
+		static constexpr vk::Format HDRI_FORMAT = vk::Format::eE5B9G9R9UfloatPack32;
+
+		// Every generated map, the LUT only needs two channels but storage support for RG16F isnt guaranteed
+		static constexpr vk::Format MAP_FORMAT = vk::Format::eR16G16B16A16Sfloat;
+
+		static constexpr uint32_t ENVIRONMENT_SIZE = 512u;
+		static constexpr uint32_t ENVIRONMENT_MIPS = 10u;
+		static constexpr uint32_t IRRADIANCE_SIZE = 32u;
+		static constexpr uint32_t PREFILTER_SIZE = 128u;
+		static constexpr uint32_t PREFILTER_MIPS = 5u;
+		static constexpr uint32_t BRDF_LUT_SIZE = 512u;
+
+		// Bump when anything that changes the cached maps changes
+		static constexpr uint32_t CACHE_VERSION = 2u;
+		static const char* CACHE_DIRECTORY;
+
+		// Where a map is in its life. Caching means it can be used and the results are being written out
+		enum class Stage
+		{
+			Loading,
+			Processing,
+			Caching,
+			Ready,
+			Failed
+		};
+
+		// Matches the push constants in ibl/common.glsl
+		struct PassConstants
+		{
+			float		Roughness;
+			uint32_t	Size;
+		};
+
+		// Filled in by the worker
+		struct LoadResult
+		{
+			uint64_t		Key = 0u;
+			bool			Cached = false;
+			bool			Success = false;
+			SHCoefficients	IrradianceSH = {};
+		};
+
+		// Generated once and shared by every map, it only depends on the BRDF
+		struct BRDFLut
+		{
+			vk::UniqueImage			Image;
+			vk::UniqueDeviceMemory	Memory;
+			vk::UniqueImageView		ImageView;
+			vk::UniqueSampler		Sampler;
+			vk::UniqueCommandBuffer	CommandBuffer;
+			vk::UniqueFence			Fence;
+			vk::DescriptorImageInfo	ImageInfo;
+			bool					Ready = false;
+		};
+		static std::weak_ptr<BRDFLut> s_BRDFLut;
+
 		// Store references
 		vk::UniqueDevice* r_Device;
 		vk::PhysicalDevice r_PhysicalDevice;
 		vk::CommandPool* r_CommandPool;
 		uint32_t r_GraphicsQueueIndex;
 
+		std::string m_Filepath;
+		Stage m_Stage = Stage::Loading;
+
 		// Store the sampler as it will be used for all processes
 		vk::UniqueSampler m_Sampler;
 
 		// ENVIRONMENT MAP (Radiance)
-		vk::Image			m_EnviromentMapImage;
-		vk::DeviceMemory	m_EnviromentMapMemory;
-		vk::ImageView		m_EnviromentMapImageView;
+		vk::UniqueImage			m_EnviromentMapImage;
+		vk::UniqueDeviceMemory	m_EnviromentMapMemory;
+		vk::UniqueImageView		m_EnviromentMapImageView;
 
 		vk::DescriptorImageInfo m_EnviromentMapImageInfo;
 		vk::WriteDescriptorSet	m_EnviromentMapWriteSet;
@@ -39,26 +123,103 @@ namespace Velocity
 		// TEMPORARY
 		const glm::mat4 m_SkyboxMatrix = scale(glm::mat4(1.0f), glm::vec3(1000.0f, 1000.0f, 1000.0f));
 		MeshComponent m_SphereMesh;
-		
+
 		// IRRADIANCE MAP
+		vk::UniqueImage			m_IrradianceMapImage;
+		vk::UniqueDeviceMemory	m_IrradianceMapMemory;
+		vk::UniqueImageView		m_IrradianceMapImageView;
+		vk::DescriptorImageInfo m_IrradianceMapImageInfo;
 
 		// PREFILTER MAP
+		vk::UniqueImage			m_PrefilterMapImage;
+		vk::UniqueDeviceMemory	m_PrefilterMapMemory;
+		vk::UniqueImageView		m_PrefilterMapImageView;
+		vk::DescriptorImageInfo m_PrefilterMapImageInfo;
 
 		// BRDF LUT
-
-		// Preprocess methods - These will be run in constructor
-
-		// Turns the flat image into a 6 layer image (like Skybox)
-		void EquirectangularToCubemap(vk::UniqueImageView& equirectangularIV, BufferManager& modelBuffer);
+		std::shared_ptr<BRDFLut> m_BRDFLut;
+
+		// SPHERICAL HARMONICS
+		SHCoefficients	m_IrradianceSH = {};
+		bool			m_HasIrradianceSH = false;
+
+		// Only alive while the maps are being built
+		std::future<void>					m_Job;
+		std::shared_ptr<LoadResult>			m_LoadResult;
+		uint32_t							m_SourceWidth = 0u;
+		uint32_t							m_SourceHeight = 0u;
+		std::unique_ptr<BaseBuffer>			m_StagingBuffer;
+		uint8_t*							m_StagingData = nullptr;
+		std::unique_ptr<BaseBuffer>			m_ReadbackBuffer;
+		uint8_t*							m_ReadbackData = nullptr;
+		vk::UniqueImage						m_EquirectangularImage;
+		vk::UniqueDeviceMemory				m_EquirectangularMemory;
+		vk::UniqueImageView					m_EquirectangularImageView;
+		std::vector<vk::UniqueImageView>	m_StorageViews;
+		vk::UniqueDescriptorSetLayout		m_DescriptorSetLayout;
+		vk::UniqueDescriptorPool			m_DescriptorPool;
+		vk::UniquePipelineLayout			m_PipelineLayout;
+		std::vector<vk::UniquePipeline>		m_Pipelines;
+		vk::UniqueCommandBuffer				m_CommandBuffer;
+		vk::UniqueFence						m_Fence;
+
+		// Moves the map along when its worker or the GPU is done. Waits for both if wait is true
+		// Called by the renderer each frame, returns false once there is nothing left to do
+		bool Update(bool wait);
+
+		// Reads and hashes the HDRI, then fills the staging buffer from the cache or by decoding the HDRI
+		// Runs on a worker so only touches memory that was mapped for it
+		static void Load(const std::string& filepath, uint32_t width, uint32_t height, uint8_t* staging, LoadResult& result);
+
+		// Writes the read back maps and the harmonics out under key. Runs on a worker
+		static void StoreCache(uint64_t key, const SHCoefficients& irradianceSH, const uint8_t* data, size_t size);
+
+		// Bytes of every map the cache holds, mips in order
+		static size_t GetCacheSize();
+		static std::string GetCachePath(uint64_t key);
+
+		// Preprocess methods - These are recorded into one command buffer once the worker is done
+
+		// Shared layout, pool and sampler for every pass
+		void CreatePipelineResources();
+		vk::UniquePipeline CreatePipeline(const std::string& shader);
+
+		// One set per pass, source sampled through binding 0 and the mip being written bound as storage at 1
+		vk::DescriptorSet CreateSet(vk::ImageView source, vk::ImageView target);
+
+		// Cube compatible image with a sampling view over every mip
+		void CreateMap(uint32_t size, uint32_t mips, vk::UniqueImage& image, vk::UniqueDeviceMemory& memory, vk::UniqueImageView& view);
+
+		// View of a single mip as a 2D array so each face can be written from compute
+		vk::ImageView CreateStorageView(vk::Image image, uint32_t mip, uint32_t layers = 6u);
+
+		// Records and submits everything once the worker is done, either uploading the cache or building the maps
+		void Process();
+
+		// Turns the flat image into a 6 layer image (like Skybox) in one dispatch
+		void EquirectangularToCubemap(vk::CommandBuffer& buffer);
+
+		// Fills the rest of the environment mips from mip 0 for filtered sampling. Leaves every mip in transfer src
+		// Mip 0 is either in general from the conversion or transfer dst from a cache upload
+		void GenerateEnvironmentMips(vk::CommandBuffer& buffer, vk::ImageLayout mip0Layout);
 
 		// Convolutes the cubemap to create an irradiance map
-		void CreateIrradianceMap();
+		void CreateIrradianceMap(vk::CommandBuffer& buffer);
 
 		// Prefilters the cubemap at multiple mip levels
-		void PrefilterCubemap();
+		void PrefilterCubemap(vk::CommandBuffer& buffer);
 
-		// Calculates the 2D BRDF LUT for specular IBL
+		// Calculates the 2D BRDF LUT for specular IBL. Submitted straight away as it doesnt need the HDRI
 		void ComputeBRDF();
-		
+
+		// Copies between the maps and a buffer laid out like the cache
+		void CopyMapsToBuffer(vk::CommandBuffer& buffer, vk::Buffer target);
+		void CopyBufferToMaps(vk::CommandBuffer& buffer, vk::Buffer source);
+
+		// Frees everything only needed while building. The readback buffer is left for the cache write
+		void ReleaseProcessResources();
+
+		// Fills in the image infos once the maps are done
+		void CreateDescriptorInfos();
 	};
 }
@@ -0,0 +1,149 @@
+#include "velpch.h"
+
+#include "MeshCache.hpp"
+
+#include <filesystem>
+#include <thread>
+
+#include <assimp/version.h>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Utility/Hash.hpp>
+
+namespace Velocity
+{
+	const char* MeshCache::CACHE_DIRECTORY = "../Velocity/cache/meshes/";
+
+	namespace
+	{
+		const char BLOB_MAGIC[4] = { 'V','M','S','H' };
+
+		uint64_t AlignSection(uint64_t offset)
+		{
+			return (offset + 15u) & ~static_cast<uint64_t>(15u);
+		}
+	}
+
+	uint64_t MeshCache::ComputeKey(uint64_t sourceHash, unsigned int importFlags)
+	{
+		uint64_t key = Hash::Combine(sourceHash, importFlags);
+		key = Hash::Combine(key, aiGetVersionMajor());
+		key = Hash::Combine(key, aiGetVersionMinor());
+		key = Hash::Combine(key, aiGetVersionRevision());
+		key = Hash::Combine(key, FORMAT_VERSION);
+		return key;
+	}
+
+	bool MeshCache::Load(uint64_t key, MappedFile& blob, CachedMeshView& outView)
+	{
+		if (!blob.Open(GetBlobPath(key)))
+		{
+			return false;
+		}
+
+		if (blob.GetSize() < sizeof(Header))
+		{
+			VEL_CORE_WARN("Mesh cache blob {0} is truncated, re-importing", Hash::ToString(key));
+			blob.Close();
+			return false;
+		}
+
+		Header header;
+		memcpy(&header, blob.GetData(), sizeof(Header));
+
+		if (memcmp(header.Magic, BLOB_MAGIC, sizeof(BLOB_MAGIC)) != 0 || header.Version != FORMAT_VERSION || header.Key != key || header.VertexSize != sizeof(Vertex))
+		{
+			blob.Close();
+			return false;
+		}
+
+		// Make sure every section sits inside the file before handing out pointers
+		auto fits = [&blob](uint64_t offset, uint64_t size) { return offset + size <= blob.GetSize(); };
+		if (!fits(header.VertexOffset, header.VertexCount * sizeof(Vertex)) ||
+			!fits(header.IndexOffset, header.IndexCount * sizeof(uint32_t)) ||
+			!fits(header.MeshletOffset, header.MeshletCount * sizeof(Meshlet)) ||
+			!fits(header.LODOffset, header.LODCount * sizeof(MeshLOD)))
+		{
+			VEL_CORE_WARN("Mesh cache blob {0} is corrupt, re-importing", Hash::ToString(key));
+			blob.Close();
+			return false;
+		}
+
+		const auto* base = blob.GetData();
+		outView.Vertices = reinterpret_cast<const Vertex*>(base + header.VertexOffset);
+		outView.VertexCount = header.VertexCount;
+		outView.Indices = reinterpret_cast<const uint32_t*>(base + header.IndexOffset);
+		outView.IndexCount = header.IndexCount;
+		outView.Meshlets = reinterpret_cast<const Meshlet*>(base + header.MeshletOffset);
+		outView.MeshletCount = header.MeshletCount;
+		outView.LODs = reinterpret_cast<const MeshLOD*>(base + header.LODOffset);
+		outView.LODCount = header.LODCount;
+		outView.BoundsMin = { header.BoundsMin[0], header.BoundsMin[1], header.BoundsMin[2] };
+		outView.BoundsMax = { header.BoundsMax[0], header.BoundsMax[1], header.BoundsMax[2] };
+
+		return true;
+	}
+
+	bool MeshCache::Store(uint64_t key, const ImportedMesh& mesh)
+	{
+		Header header = {};
+		memcpy(header.Magic, BLOB_MAGIC, sizeof(BLOB_MAGIC));
+		header.Version = FORMAT_VERSION;
+		header.Key = key;
+		header.VertexSize = sizeof(Vertex);
+		header.VertexCount = static_cast<uint32_t>(mesh.Vertices.size());
+		header.IndexCount = static_cast<uint32_t>(mesh.Indices.size());
+		header.MeshletCount = static_cast<uint32_t>(mesh.Meshlets.size());
+		header.LODCount = static_cast<uint32_t>(mesh.LODs.size());
+		for (int i = 0; i < 3; ++i)
+		{
+			header.BoundsMin[i] = mesh.BoundsMin[i];
+			header.BoundsMax[i] = mesh.BoundsMax[i];
+		}
+
+		header.VertexOffset = AlignSection(sizeof(Header));
+		header.IndexOffset = AlignSection(header.VertexOffset + mesh.Vertices.size() * sizeof(Vertex));
+		header.MeshletOffset = AlignSection(header.IndexOffset + mesh.Indices.size() * sizeof(uint32_t));
+		header.LODOffset = AlignSection(header.MeshletOffset + mesh.Meshlets.size() * sizeof(Meshlet));
+		const uint64_t totalSize = header.LODOffset + mesh.LODs.size() * sizeof(MeshLOD);
+
+		// Build the whole blob then write once
+		std::vector<char> blob(totalSize, 0);
+		memcpy(blob.data(), &header, sizeof(Header));
+		memcpy(blob.data() + header.VertexOffset, mesh.Vertices.data(), mesh.Vertices.size() * sizeof(Vertex));
+		memcpy(blob.data() + header.IndexOffset, mesh.Indices.data(), mesh.Indices.size() * sizeof(uint32_t));
+		memcpy(blob.data() + header.MeshletOffset, mesh.Meshlets.data(), mesh.Meshlets.size() * sizeof(Meshlet));
+		memcpy(blob.data() + header.LODOffset, mesh.LODs.data(), mesh.LODs.size() * sizeof(MeshLOD));
+
+		std::error_code error;
+		std::filesystem::create_directories(CACHE_DIRECTORY, error);
+
+		// Write to a temporary name first so a crash mid write never leaves a blob that looks valid
+		const auto finalPath = GetBlobPath(key);
+		// The thread id keeps two workers importing the same file from sharing a temp file
+		const auto tempPath = finalPath + "." + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id())) + ".tmp";
+		{
+			std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+			if (!output.is_open())
+			{
+				VEL_CORE_WARN("Failed to write mesh cache blob {0}", finalPath);
+				return false;
+			}
+			output.write(blob.data(), static_cast<std::streamsize>(blob.size()));
+		}
+
+		std::filesystem::rename(tempPath, finalPath, error);
+		if (error)
+		{
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		return true;
+	}
+
+	std::string MeshCache::GetBlobPath(uint64_t key)
+	{
+		return std::string(CACHE_DIRECTORY) + Hash::ToString(key) + ".velmesh";
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+#include "Meshlet.hpp"
+
+#include <Velocity/Utility/MappedFile.hpp>
+
+namespace Velocity
+{
+	// A range of the index list drawn at a given level of detail
+	struct MeshLOD
+	{
+		uint32_t	IndexStart = 0u;
+		uint32_t	IndexCount = 0u;
+		// Projected size below which the next LOD should be used. 0 for the last one
+		float		ScreenSize = 0.0f;
+		uint32_t	Padding = 0u;
+	};
+
+	// Geometry after import and post processing, in the exact form the buffer manager stores it
+	// Meshlet IndexStart values are relative to Indices
+	struct ImportedMesh
+	{
+		std::vector<Vertex>		Vertices;
+		std::vector<uint32_t>	Indices;
+		std::vector<Meshlet>	Meshlets;
+		std::vector<MeshLOD>	LODs;
+		glm::vec3				BoundsMin = glm::vec3(0.0f);
+		glm::vec3				BoundsMax = glm::vec3(0.0f);
+	};
+
+	// Points straight into a mapped cache blob. Only valid while the MappedFile is alive
+	struct CachedMeshView
+	{
+		const Vertex*	Vertices = nullptr;
+		uint32_t		VertexCount = 0u;
+		const uint32_t*	Indices = nullptr;
+		uint32_t		IndexCount = 0u;
+		const Meshlet*	Meshlets = nullptr;
+		uint32_t		MeshletCount = 0u;
+		const MeshLOD*	LODs = nullptr;
+		uint32_t		LODCount = 0u;
+		glm::vec3		BoundsMin = glm::vec3(0.0f);
+		glm::vec3		BoundsMax = glm::vec3(0.0f);
+	};
+
+	// Content addressed cache of imported meshes
+	// The key covers the source bytes, the import flags and the assimp version, so a stale blob can never be hit
+	class MeshCache
+	{
+	public:
+		// Bump whenever the blob layout, Vertex, Meshlet or the import post processing change
+		static constexpr uint32_t FORMAT_VERSION = 2u;
+
+		// Where blobs are written. Safe to delete at any time
+		static const char* CACHE_DIRECTORY;
+
+		// Source hash is Hash::Bytes of the whole file, which the asset manifest records so it can be skipped
+		static uint64_t ComputeKey(uint64_t sourceHash, unsigned int importFlags);
+
+		// Maps the blob for this key. Returns false if there isnt a valid one
+		static bool Load(uint64_t key, MappedFile& blob, CachedMeshView& outView);
+
+		// Writes the blob for this key. Failing to write only costs a re-import next time
+		static bool Store(uint64_t key, const ImportedMesh& mesh);
+
+	private:
+		// On disk header. Every section is 16 byte aligned
+		struct Header
+		{
+			char		Magic[4];
+			uint32_t	Version;
+			uint64_t	Key;
+			uint32_t	VertexSize;
+			uint32_t	VertexCount;
+			uint32_t	IndexCount;
+			uint32_t	MeshletCount;
+			uint32_t	LODCount;
+			float		BoundsMin[3];
+			float		BoundsMax[3];
+			uint32_t	Padding;
+			uint64_t	VertexOffset;
+			uint64_t	IndexOffset;
+			uint64_t	MeshletOffset;
+			uint64_t	LODOffset;
+		};
+
+		static std::string GetBlobPath(uint64_t key);
+	};
+}
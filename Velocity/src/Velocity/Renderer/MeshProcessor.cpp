@@ -0,0 +1,247 @@
+#include "velpch.h"
+
+#include "MeshProcessor.hpp"
+
+#include <cfloat>
+
+#include <assimp/mesh.h>
+
+namespace Velocity
+{
+	void MeshProcessor::Process(const aiMesh& mesh, std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices)
+	{
+		const bool hasNormals = mesh.HasNormals();
+		const bool hasUVs = mesh.HasTextureCoords(0);
+
+		outVertices.resize(mesh.mNumVertices);
+		for (size_t i = 0; i < mesh.mNumVertices; ++i)
+		{
+			const auto& rawVert = mesh.mVertices[i];
+			const auto& rawNorm = hasNormals ? mesh.mNormals[i] : aiVector3D{};
+			const auto& rawUV = hasUVs ? mesh.mTextureCoords[0][i] : aiVector3D{};
+
+			// Vulkan samples with v pointing down, most formats store it pointing up
+			outVertices[i] = {
+				{ rawVert.x, rawVert.y, rawVert.z },
+				{ rawNorm.x, rawNorm.y, rawNorm.z },
+				{ 0.0f, 0.0f, 0.0f },
+				{ rawUV.x, hasUVs ? 1.0f - rawUV.y : 0.0f }
+			};
+		}
+
+		outIndices.clear();
+		outIndices.reserve(static_cast<size_t>(mesh.mNumFaces) * 3u);
+		for (size_t face = 0; face < mesh.mNumFaces; ++face)
+		{
+			Triangulate(mesh, mesh.mFaces[face], outIndices);
+		}
+
+		if (!hasNormals)
+		{
+			GenerateFlatNormals(outVertices, outIndices);
+		}
+
+		// Without uvs there is no direction to align to, the shader falls back to the vertex normal
+		if (hasUVs)
+		{
+			ComputeTangents(outVertices, outIndices);
+		}
+	}
+
+	void MeshProcessor::Triangulate(const aiMesh& mesh, const aiFace& face, std::vector<uint32_t>& outIndices)
+	{
+		const unsigned int count = face.mNumIndices;
+
+		// Points and lines
+		if (count < 3u)
+		{
+			return;
+		}
+
+		if (count == 3u)
+		{
+			outIndices.insert(outIndices.end(), face.mIndices, face.mIndices + 3u);
+			return;
+		}
+
+		auto position = [&mesh](uint32_t index) { return glm::vec3(mesh.mVertices[index].x, mesh.mVertices[index].y, mesh.mVertices[index].z); };
+
+		// Newell's method, stays stable for non planar and concave polygons
+		glm::vec3 normal = { 0.0f,0.0f,0.0f };
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			const glm::vec3 current = position(face.mIndices[i]);
+			const glm::vec3 next = position(face.mIndices[(i + 1u) % count]);
+			normal.x += (current.y - next.y) * (current.z + next.z);
+			normal.y += (current.z - next.z) * (current.x + next.x);
+			normal.z += (current.x - next.x) * (current.y + next.y);
+		}
+
+		// Drop the dominant axis and flip so the polygon winds counter clockwise in 2D
+		const glm::vec3 absNormal = glm::abs(normal);
+		const int axis = absNormal.x > absNormal.y ? (absNormal.x > absNormal.z ? 0 : 2) : (absNormal.y > absNormal.z ? 1 : 2);
+		const float winding = normal[axis] < 0.0f ? -1.0f : 1.0f;
+
+		// Scratch space reused across faces, most polygons are quads
+		thread_local std::vector<glm::vec2> points;
+		thread_local std::vector<uint32_t> corners;
+		points.resize(count);
+		for (unsigned int i = 0; i < count; ++i)
+		{
+			const glm::vec3 point = position(face.mIndices[i]);
+			points[i] = glm::vec2(point[(axis + 1) % 3], point[(axis + 2) % 3] * winding);
+		}
+
+		// Degenerate polygons have no plane to clip in, fan them like assimp does
+		corners.clear();
+		if (absNormal[axis] > FLT_MIN)
+		{
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				corners.push_back(i);
+			}
+		}
+
+		auto cross = [](const glm::vec2& a, const glm::vec2& b, const glm::vec2& c) { return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x); };
+
+		while (corners.size() > 3u)
+		{
+			const size_t size = corners.size();
+			bool clipped = false;
+
+			for (size_t i = 0; i < size && !clipped; ++i)
+			{
+				const uint32_t prev = corners[(i + size - 1u) % size];
+				const uint32_t current = corners[i];
+				const uint32_t next = corners[(i + 1u) % size];
+
+				// Reflex or flat corners cant be ears
+				if (cross(points[prev], points[current], points[next]) <= 0.0f)
+				{
+					continue;
+				}
+
+				// Nor can corners whose triangle contains another vertex of what is left
+				bool bEar = true;
+				for (const auto other : corners)
+				{
+					if (other == prev || other == current || other == next)
+					{
+						continue;
+					}
+
+					if (cross(points[prev], points[current], points[other]) >= 0.0f &&
+						cross(points[current], points[next], points[other]) >= 0.0f &&
+						cross(points[next], points[prev], points[other]) >= 0.0f)
+					{
+						bEar = false;
+						break;
+					}
+				}
+
+				if (bEar)
+				{
+					outIndices.push_back(face.mIndices[prev]);
+					outIndices.push_back(face.mIndices[current]);
+					outIndices.push_back(face.mIndices[next]);
+					corners.erase(corners.begin() + i);
+					clipped = true;
+				}
+			}
+
+			// Self intersecting, fan what is left
+			if (!clipped)
+			{
+				break;
+			}
+		}
+
+		if (corners.size() == 3u)
+		{
+			outIndices.push_back(face.mIndices[corners[0]]);
+			outIndices.push_back(face.mIndices[corners[1]]);
+			outIndices.push_back(face.mIndices[corners[2]]);
+			return;
+		}
+
+		if (corners.empty())
+		{
+			for (unsigned int i = 0; i < count; ++i)
+			{
+				corners.push_back(i);
+			}
+		}
+		for (size_t i = 1; i + 1u < corners.size(); ++i)
+		{
+			outIndices.push_back(face.mIndices[corners[0]]);
+			outIndices.push_back(face.mIndices[corners[i]]);
+			outIndices.push_back(face.mIndices[corners[i + 1u]]);
+		}
+	}
+
+	void MeshProcessor::GenerateFlatNormals(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+	{
+		std::vector<Vertex> flat;
+		flat.reserve(indices.size());
+
+		for (size_t tri = 0; tri + 2u < indices.size(); tri += 3u)
+		{
+			const Vertex& a = vertices[indices[tri]];
+			const Vertex& b = vertices[indices[tri + 1u]];
+			const Vertex& c = vertices[indices[tri + 2u]];
+
+			glm::vec3 normal = glm::cross(b.Position - a.Position, c.Position - a.Position);
+			const float length = glm::length(normal);
+			normal = length > FLT_MIN ? normal / length : glm::vec3(0.0f, 0.0f, 0.0f);
+
+			for (const Vertex* vertex : { &a,&b,&c })
+			{
+				flat.push_back(*vertex);
+				flat.back().Normal = normal;
+			}
+		}
+
+		vertices.swap(flat);
+		for (size_t i = 0; i < indices.size(); ++i)
+		{
+			indices[i] = static_cast<uint32_t>(i);
+		}
+	}
+
+	void MeshProcessor::ComputeTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	{
+		std::vector<glm::vec3> tangents(vertices.size(), glm::vec3(0.0f, 0.0f, 0.0f));
+
+		for (size_t tri = 0; tri + 2u < indices.size(); tri += 3u)
+		{
+			const Vertex& a = vertices[indices[tri]];
+			const Vertex& b = vertices[indices[tri + 1u]];
+			const Vertex& c = vertices[indices[tri + 2u]];
+
+			const glm::vec3 edge1 = b.Position - a.Position;
+			const glm::vec3 edge2 = c.Position - a.Position;
+			const glm::vec2 deltaUV1 = b.UV - a.UV;
+			const glm::vec2 deltaUV2 = c.UV - a.UV;
+
+			// Triangles with collapsed uvs say nothing about the direction
+			const float determinant = deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y;
+			if (std::abs(determinant) <= FLT_MIN)
+			{
+				continue;
+			}
+
+			const glm::vec3 tangent = (edge1 * deltaUV2.y - edge2 * deltaUV1.y) / determinant;
+			tangents[indices[tri]] += tangent;
+			tangents[indices[tri + 1u]] += tangent;
+			tangents[indices[tri + 2u]] += tangent;
+		}
+
+		for (size_t i = 0; i < vertices.size(); ++i)
+		{
+			const glm::vec3& normal = vertices[i].Normal;
+			const glm::vec3 tangent = tangents[i] - normal * glm::dot(normal, tangents[i]);
+			const float length = glm::length(tangent);
+			vertices[i].Tangent = length > FLT_MIN ? tangent / length : glm::vec3(0.0f, 0.0f, 0.0f);
+		}
+	}
+}
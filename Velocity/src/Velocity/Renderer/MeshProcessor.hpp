@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vector>
+
+#include "Vertex.hpp"
+
+struct aiMesh;
+struct aiFace;
+
+namespace Velocity
+{
+	// The per mesh post processing imports used to ask assimp for, done on our side so sub meshes can run side by side
+	// Only ever reads the one aiMesh it is given, so any number can run at once on the same scene. Static helpers only
+	class MeshProcessor
+	{
+	public:
+		// Triangulates, generates flat normals if the mesh has none, flips the uvs and computes tangents
+		// Lines and points are dropped. Indices are local to the mesh. The result only depends on the mesh
+		static void Process(const aiMesh& mesh, std::vector<Vertex>& outVertices, std::vector<uint32_t>& outIndices);
+
+	private:
+		// Appends the triangles of one face. Polygons are ear clipped in their own plane so concave ones come out right
+		static void Triangulate(const aiMesh& mesh, const aiFace& face, std::vector<uint32_t>& outIndices);
+
+		// Gives every triangle its own three vertices with the face normal, for meshes without normals
+		static void GenerateFlatNormals(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+		// Accumulates the uv aligned tangent of every triangle into its vertices, then makes them perpendicular to the normal
+		static void ComputeTangents(std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	};
+}
@@ -0,0 +1,133 @@
+#include "velpch.h"
+
+#include "Meshlet.hpp"
+
+#include <cfloat>
+
+namespace Velocity
+{
+	void MeshletBuilder::Build(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t indexBase, std::vector<Meshlet>& outMeshlets)
+	{
+		// Stores the last cluster that touched each vertex so shared vertices are only counted once
+		std::vector<uint32_t> lastCluster(vertexCount, UINT32_MAX);
+
+		std::vector<uint32_t> localVertices;
+		localVertices.reserve(MAX_VERTICES);
+
+		uint32_t clusterID = 0u;
+
+		Meshlet current;
+		current.IndexStart = indexBase;
+
+		// Clusters are contiguous runs of the existing index list, so the index buffer itself is left untouched
+		for (size_t tri = 0; tri + 2 < indexCount; tri += 3)
+		{
+			const uint32_t a = indices[tri];
+			const uint32_t b = indices[tri + 1];
+			const uint32_t c = indices[tri + 2];
+
+			uint32_t newVertices = 0u;
+			newVertices += lastCluster.at(a) != clusterID ? 1u : 0u;
+			newVertices += lastCluster.at(b) != clusterID && b != a ? 1u : 0u;
+			newVertices += lastCluster.at(c) != clusterID && c != a && c != b ? 1u : 0u;
+
+			// Close the cluster if this triangle would not fit
+			if (localVertices.size() + newVertices > MAX_VERTICES || (current.IndexCount / 3u) + 1u > MAX_TRIANGLES)
+			{
+				ComputeBounds(vertices, indices + (current.IndexStart - indexBase), current, localVertices);
+				outMeshlets.push_back(current);
+
+				++clusterID;
+				localVertices.clear();
+
+				current = Meshlet();
+				current.IndexStart = indexBase + static_cast<uint32_t>(tri);
+			}
+
+			for (auto vertex : { a,b,c })
+			{
+				if (lastCluster.at(vertex) != clusterID)
+				{
+					lastCluster.at(vertex) = clusterID;
+					localVertices.push_back(vertex);
+				}
+			}
+
+			current.IndexCount += 3u;
+		}
+
+		// Flush the last one
+		if (current.IndexCount > 0u)
+		{
+			ComputeBounds(vertices, indices + (current.IndexStart - indexBase), current, localVertices);
+			outMeshlets.push_back(current);
+		}
+	}
+
+	void MeshletBuilder::ComputeBounds(const Vertex* vertices, const uint32_t* indices, Meshlet& meshlet, const std::vector<uint32_t>& localVertices)
+	{
+		// Sphere. Centre of the AABB is good enough and much cheaper than a minimal sphere
+		glm::vec3 minPosition = glm::vec3(FLT_MAX);
+		glm::vec3 maxPosition = glm::vec3(-FLT_MAX);
+		for (auto vertex : localVertices)
+		{
+			minPosition = glm::min(minPosition, vertices[vertex].Position);
+			maxPosition = glm::max(maxPosition, vertices[vertex].Position);
+		}
+
+		meshlet.Center = (minPosition + maxPosition) * 0.5f;
+		meshlet.Radius = 0.0f;
+		for (auto vertex : localVertices)
+		{
+			meshlet.Radius = glm::max(meshlet.Radius, glm::length(vertices[vertex].Position - meshlet.Center));
+		}
+
+		// Cone. Face normals are flipped to agree with the vertex normals so winding order doesnt matter
+		std::array<glm::vec3, MAX_TRIANGLES> faceNormals;
+		uint32_t faceCount = 0u;
+		glm::vec3 axis = glm::vec3(0.0f);
+
+		for (uint32_t i = 0; i < meshlet.IndexCount; i += 3)
+		{
+			const auto& v0 = vertices[indices[i]];
+			const auto& v1 = vertices[indices[i + 1]];
+			const auto& v2 = vertices[indices[i + 2]];
+
+			glm::vec3 normal = glm::cross(v1.Position - v0.Position, v2.Position - v0.Position);
+			float length = glm::length(normal);
+			if (length <= 0.0f)
+			{
+				// Degenerate triangle, can't face anywhere
+				continue;
+			}
+			normal /= length;
+
+			if (glm::dot(normal, v0.Normal + v1.Normal + v2.Normal) < 0.0f)
+			{
+				normal = -normal;
+			}
+
+			faceNormals.at(faceCount++) = normal;
+			axis += normal;
+		}
+
+		float axisLength = glm::length(axis);
+		if (faceCount == 0u || axisLength < 1e-6f)
+		{
+			meshlet.ConeAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+			meshlet.ConeCutoff = 1.0f;
+			return;
+		}
+		axis /= axisLength;
+
+		float minDot = 1.0f;
+		for (uint32_t i = 0; i < faceCount; ++i)
+		{
+			minDot = glm::min(minDot, glm::dot(faceNormals.at(i), axis));
+		}
+
+		// Store the sine of the cone angle so the shader test is a single dot product
+		meshlet.ConeAxis = axis;
+		meshlet.ConeCutoff = minDot <= 0.0f ? 1.0f : glm::sqrt(1.0f - minDot * minDot);
+	}
+}
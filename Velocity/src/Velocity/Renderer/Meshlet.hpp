@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Vertex.hpp"
+
+namespace Velocity
+{
+	// A small cluster of triangles cut from a larger mesh
+	// Layout matches the std430 struct in clustercull.comp so it can be copied straight to the GPU
+	struct Meshlet
+	{
+		// Bounding sphere in object space
+		glm::vec3	Center = { 0.0f,0.0f,0.0f };
+		float		Radius = 0.0f;
+
+		// Normal cone. Cutoff of 1 means the cone is too wide to ever backface cull
+		glm::vec3	ConeAxis = { 0.0f,0.0f,0.0f };
+		float		ConeCutoff = 1.0f;
+
+		// Range inside the global index buffer
+		uint32_t	IndexStart = 0u;
+		uint32_t	IndexCount = 0u;
+
+		uint32_t	Padding[2] = { 0u,0u };
+	};
+
+	// Splits index lists into meshlets. Static helpers only
+	class MeshletBuilder
+	{
+	public:
+		// Same limits the mesh shading vendors recommend. Keeps a cluster inside one small workgroup of work
+		static constexpr uint32_t MAX_VERTICES = 64u;
+		static constexpr uint32_t MAX_TRIANGLES = 124u;
+
+		// Meshes under this are cheaper to draw whole than to cull
+		static constexpr uint32_t MIN_TRIANGLES_TO_CLUSTER = 4096u;
+
+		// Greedily walks the index list and appends the clusters to outMeshlets
+		// Indices are relative to vertices, indexBase is where indices[0] lives in the global index buffer
+		static void Build(const Vertex* vertices, size_t vertexCount, const uint32_t* indices, size_t indexCount, uint32_t indexBase, std::vector<Meshlet>& outMeshlets);
+
+	private:
+		// Fills in the sphere and cone of a finished cluster
+		static void ComputeBounds(const Vertex* vertices, const uint32_t* indices, Meshlet& meshlet, const std::vector<uint32_t>& localVertices);
+	};
+}
@@ -0,0 +1,735 @@
+#include "velpch.h"
+
+#include "ObjLoader.hpp"
+
+#include <cmath>
+
+#include <assimp/fast_atof.h>
+#include <assimp/mesh.h>
+
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		constexpr uint32_t NO_INDEX = UINT32_MAX;
+
+		// Assimp rejects anything smaller
+		constexpr size_t MIN_FILE_SIZE = 16u;
+
+		// Name assimp gives the object faces land in when the file never names one
+		const char* DEFAULT_OBJECT_NAME = "defaultobject";
+
+		// An o, g or usemtl line. These decide which mesh faces go to, so they are replayed in file order after parsing
+		struct Statement
+		{
+			enum class Type { Object, Group, Material };
+
+			Type		Kind = Type::Object;
+			uint32_t	FaceIndex = 0u;		// Faces in the chunk before this line
+			std::string	Name;
+		};
+
+		// Everything parsed out of one run of whole lines
+		// Indices are already absolute, files using relative ones go through assimp
+		struct Chunk
+		{
+			const char*	Begin = nullptr;
+			const char*	End = nullptr;
+
+			std::vector<aiVector3D>	Positions;
+			std::vector<aiVector3D>	TexCoords;
+			std::vector<aiVector3D>	Normals;
+			unsigned int			TexCoordDim = 0u;
+
+			// Position, uv and normal index of every face corner. NO_INDEX when the face doesnt give one
+			std::vector<uint32_t>	Corners;
+			// First corner of every face, plus one past the end
+			std::vector<uint32_t>	FaceStarts = { 0u };
+
+			std::vector<Statement>	Statements;
+
+			// One past the largest index used. Checked once the totals are known
+			uint32_t	PositionLimit = 0u;
+			uint32_t	TexCoordLimit = 0u;
+			uint32_t	NormalLimit = 0u;
+
+			// A face gave a uv index before this chunk read any uvs. Assimp reads those differently if the file has none yet
+			bool		bUVBeforeTexCoords = false;
+			bool		bUnsupported = false;
+
+			// Scratch for the face being parsed
+			std::vector<uint32_t>	FaceIndices[3];
+		};
+
+		// Run of faces from one chunk that all land in the same mesh
+		struct Segment
+		{
+			uint32_t	ChunkIndex = 0u;
+			uint32_t	FaceBegin = 0u;
+			uint32_t	FaceEnd = 0u;
+		};
+
+		struct MeshBuild
+		{
+			std::string				Material;
+			bool					bHasMaterial = false;
+			std::vector<Segment>	Segments;
+		};
+
+		struct ObjectBuild
+		{
+			std::string				Name;
+			std::vector<uint32_t>	Meshes;
+		};
+
+		bool IsSpace(char c)
+		{
+			return c == ' ' || c == '\t';
+		}
+
+		// Same set assimp splits lines on
+		bool IsLineEnd(char c)
+		{
+			return c == '\n' || c == '\r' || c == '\0' || c == '\f';
+		}
+
+		const char* SkipSpaces(const char* p, const char* end)
+		{
+			while (p < end && IsSpace(*p))
+			{
+				++p;
+			}
+			return p;
+		}
+
+		const char* TokenEnd(const char* p, const char* end)
+		{
+			while (p < end && !IsSpace(*p))
+			{
+				++p;
+			}
+			return p;
+		}
+
+		// Skips the current token and the spaces after it
+		const char* NextToken(const char* p, const char* end)
+		{
+			return SkipSpaces(TokenEnd(p, end), end);
+		}
+
+		bool TokenEquals(const char* begin, const char* end, const char* token)
+		{
+			const size_t length = strlen(token);
+			return static_cast<size_t>(end - begin) == length && memcmp(begin, token, length) == 0;
+		}
+
+		// Counts the tokens that look like numbers, the way assimp decides how many components a v or vt line has
+		size_t CountComponents(const char* p, const char* end)
+		{
+			size_t count = 0u;
+			p = SkipSpaces(p, end);
+			while (p < end)
+			{
+				const bool bNanOrInf = end - p >= 3 && (Assimp::ASSIMP_strincmp(p, "nan", 3) == 0 || Assimp::ASSIMP_strincmp(p, "inf", 3) == 0);
+				if ((*p >= '0' && *p <= '9') || *p == '-' || *p == '+' || bNanOrInf)
+				{
+					++count;
+				}
+				p = SkipSpaces(TokenEnd(p, end), end);
+			}
+			return count;
+		}
+
+		// Lines always end in a line end character so fast_atof stops inside the line. Throws on garbage like assimp
+		const char* ReadFloat(const char* p, const char* end, ai_real& out)
+		{
+			p = SkipSpaces(p, end);
+			out = Assimp::fast_atof(p);
+			return TokenEnd(p, end);
+		}
+
+		void ParseFace(Chunk& chunk, const char* p, const char* end)
+		{
+			p = NextToken(p, end);
+			if (p == end)
+			{
+				return;
+			}
+
+			for (auto& indices : chunk.FaceIndices)
+			{
+				indices.clear();
+			}
+
+			size_t slot = 0u;
+			while (p < end)
+			{
+				if (*p == '/')
+				{
+					++slot;
+					++p;
+					continue;
+				}
+				if (IsSpace(*p))
+				{
+					slot = 0u;
+					++p;
+					continue;
+				}
+
+				// Assimp misreads signs and leading zeros and throws on zero, leave all of those to it
+				if (*p < '1' || *p > '9' || slot > 2u)
+				{
+					chunk.bUnsupported = true;
+					return;
+				}
+
+				uint64_t value = 0u;
+				while (p < end && *p >= '0' && *p <= '9')
+				{
+					value = value * 10u + static_cast<uint64_t>(*p - '0');
+					if (value > static_cast<uint64_t>(INT32_MAX))
+					{
+						chunk.bUnsupported = true;
+						return;
+					}
+					++p;
+				}
+
+				if (slot == 1u && chunk.TexCoords.empty())
+				{
+					chunk.bUVBeforeTexCoords = true;
+				}
+
+				// OBJ indices are 1 based
+				chunk.FaceIndices[slot].push_back(static_cast<uint32_t>(value - 1u));
+			}
+
+			const auto& positions = chunk.FaceIndices[0];
+			const auto& texCoords = chunk.FaceIndices[1];
+			const auto& normals = chunk.FaceIndices[2];
+			if (positions.empty())
+			{
+				return;
+			}
+
+			// Assimp pairs them up by position in the list, which only lines up when every corner gives the same parts
+			if ((!texCoords.empty() && texCoords.size() != positions.size()) || (!normals.empty() && normals.size() != positions.size()) ||
+				chunk.Corners.size() + positions.size() * 3u > UINT32_MAX)
+			{
+				chunk.bUnsupported = true;
+				return;
+			}
+
+			for (size_t i = 0; i < positions.size(); ++i)
+			{
+				const uint32_t texCoord = texCoords.empty() ? NO_INDEX : texCoords[i];
+				const uint32_t normal = normals.empty() ? NO_INDEX : normals[i];
+				chunk.Corners.push_back(positions[i]);
+				chunk.Corners.push_back(texCoord);
+				chunk.Corners.push_back(normal);
+
+				chunk.PositionLimit = std::max(chunk.PositionLimit, positions[i] + 1u);
+				chunk.TexCoordLimit = texCoord != NO_INDEX ? std::max(chunk.TexCoordLimit, texCoord + 1u) : chunk.TexCoordLimit;
+				chunk.NormalLimit = normal != NO_INDEX ? std::max(chunk.NormalLimit, normal + 1u) : chunk.NormalLimit;
+			}
+			chunk.FaceStarts.push_back(static_cast<uint32_t>(chunk.Corners.size() / 3u));
+		}
+
+		// Mirrors the line switch in assimp's ObjFileParser. end points at the line end character
+		void ParseLine(Chunk& chunk, const char* begin, const char* end)
+		{
+			if (begin == end)
+			{
+				return;
+			}
+
+			const uint32_t faceIndex = static_cast<uint32_t>(chunk.FaceStarts.size() - 1u);
+
+			switch (*begin)
+			{
+			case 'v':
+			{
+				const char* p = begin + 1;
+				if (p < end && IsSpace(*p))
+				{
+					// Homogeneous positions and vertex colours are left to assimp, other counts it skips too
+					const size_t components = CountComponents(p, end);
+					if (components == 4u || components == 6u)
+					{
+						chunk.bUnsupported = true;
+					}
+					else if (components == 3u)
+					{
+						aiVector3D position;
+						p = ReadFloat(p, end, position.x);
+						p = ReadFloat(p, end, position.y);
+						ReadFloat(p, end, position.z);
+						chunk.Positions.push_back(position);
+					}
+				}
+				else if (p < end && *p == 't')
+				{
+					++p;
+					const size_t components = CountComponents(p, end);
+					if (components != 2u && components != 3u)
+					{
+						chunk.bUnsupported = true;
+						break;
+					}
+
+					aiVector3D texCoord;
+					p = ReadFloat(p, end, texCoord.x);
+					p = ReadFloat(p, end, texCoord.y);
+					if (components == 3u)
+					{
+						ReadFloat(p, end, texCoord.z);
+					}
+
+					// Assimp zeroes nan and inf uvs
+					texCoord.x = std::isfinite(texCoord.x) ? texCoord.x : 0.0f;
+					texCoord.y = std::isfinite(texCoord.y) ? texCoord.y : 0.0f;
+					texCoord.z = std::isfinite(texCoord.z) ? texCoord.z : 0.0f;
+
+					chunk.TexCoords.push_back(texCoord);
+					chunk.TexCoordDim = std::max(chunk.TexCoordDim, static_cast<unsigned int>(components));
+				}
+				else if (p < end && *p == 'n')
+				{
+					++p;
+					aiVector3D normal;
+					p = ReadFloat(p, end, normal.x);
+					p = ReadFloat(p, end, normal.y);
+					ReadFloat(p, end, normal.z);
+					chunk.Normals.push_back(normal);
+				}
+				break;
+			}
+			case 'f':
+			{
+				ParseFace(chunk, begin, end);
+				break;
+			}
+			case 'p':
+			case 'l':
+			{
+				chunk.bUnsupported = true;
+				break;
+			}
+			case 'u':
+			{
+				if (TokenEquals(begin, TokenEnd(begin, end), "usemtl"))
+				{
+					const char* nameBegin = NextToken(begin, end);
+					const char* nameEnd = end;
+					while (nameEnd > nameBegin && IsSpace(nameEnd[-1]))
+					{
+						--nameEnd;
+					}
+					chunk.Statements.push_back({ Statement::Type::Material, faceIndex, std::string(nameBegin, nameEnd) });
+				}
+				break;
+			}
+			case 'g':
+			{
+				// Assimp keeps the trailing spaces in group names
+				chunk.Statements.push_back({ Statement::Type::Group, faceIndex, std::string(NextToken(begin, end), end) });
+				break;
+			}
+			case 'o':
+			{
+				const char* nameBegin = NextToken(begin, end);
+				const char* nameEnd = TokenEnd(nameBegin, end);
+				if (nameBegin != nameEnd)
+				{
+					chunk.Statements.push_back({ Statement::Type::Object, faceIndex, std::string(nameBegin, nameEnd) });
+				}
+				break;
+			}
+			default:
+			{
+				// Comments, smoothing groups, material libraries and anything unknown
+				break;
+			}
+			}
+		}
+
+		void ParseChunk(Chunk& chunk, const char* fileEnd)
+		{
+			// Line continuations can join lines across chunks
+			if (memchr(chunk.Begin, '\\', chunk.End - chunk.Begin) != nullptr)
+			{
+				chunk.bUnsupported = true;
+				return;
+			}
+
+			const char* line = chunk.Begin;
+			while (line < chunk.End && !chunk.bUnsupported)
+			{
+				const char* lineEnd = line;
+				while (lineEnd < chunk.End && !IsLineEnd(*lineEnd))
+				{
+					++lineEnd;
+				}
+
+				// The last line of a file might not have a line end for the parsers to stop on
+				if (lineEnd == fileEnd)
+				{
+					const std::string lastLine(line, lineEnd);
+					ParseLine(chunk, lastLine.c_str(), lastLine.c_str() + lastLine.size());
+					break;
+				}
+
+				ParseLine(chunk, line, lineEnd);
+				line = lineEnd + 1;
+			}
+		}
+
+		// Applies the state lines in file order and works out which faces end up in which mesh
+		// Follows ObjFileParser's object and mesh rules exactly, including reusing objects on o but never on g
+		class MeshAssigner
+		{
+		public:
+			void AddFaces(uint32_t chunkIndex, uint32_t faceBegin, uint32_t faceEnd)
+			{
+				if (faceBegin == faceEnd)
+				{
+					return;
+				}
+
+				if (m_CurrentObject == NO_INDEX)
+				{
+					CreateObject(DEFAULT_OBJECT_NAME);
+				}
+				if (m_CurrentMesh == NO_INDEX)
+				{
+					CreateMesh();
+				}
+
+				auto& segments = m_Meshes[m_CurrentMesh].Segments;
+				if (!segments.empty() && segments.back().ChunkIndex == chunkIndex && segments.back().FaceEnd == faceBegin)
+				{
+					segments.back().FaceEnd = faceEnd;
+				}
+				else
+				{
+					segments.push_back({ chunkIndex, faceBegin, faceEnd });
+				}
+			}
+
+			void Apply(const Statement& statement)
+			{
+				switch (statement.Kind)
+				{
+				case Statement::Type::Object:
+				{
+					const auto existing = std::find_if(m_Objects.begin(), m_Objects.end(), [&statement](const ObjectBuild& object) { return object.Name == statement.Name; });
+					if (existing != m_Objects.end())
+					{
+						m_CurrentObject = static_cast<uint32_t>(existing - m_Objects.begin());
+					}
+					else
+					{
+						CreateObject(statement.Name);
+					}
+					break;
+				}
+				case Statement::Type::Group:
+				{
+					if (statement.Name != m_ActiveGroup)
+					{
+						CreateObject(statement.Name);
+						m_ActiveGroup = statement.Name;
+					}
+					break;
+				}
+				case Statement::Type::Material:
+				{
+					if (statement.Name.empty() || (m_bHasMaterial && m_CurrentMaterial == statement.Name))
+					{
+						break;
+					}
+
+					m_CurrentMaterial = statement.Name;
+					m_bHasMaterial = true;
+
+					// Only one material per mesh, but a mesh with no faces yet can just switch
+					bool bNewMesh = m_CurrentMesh == NO_INDEX;
+					if (!bNewMesh)
+					{
+						const auto& mesh = m_Meshes[m_CurrentMesh];
+						bNewMesh = mesh.bHasMaterial && mesh.Material != statement.Name && !mesh.Segments.empty();
+					}
+					if (bNewMesh)
+					{
+						CreateMesh();
+					}
+
+					m_Meshes[m_CurrentMesh].Material = statement.Name;
+					m_Meshes[m_CurrentMesh].bHasMaterial = true;
+					break;
+				}
+				}
+			}
+
+			// Meshes that got faces, in the order assimp puts them in the scene
+			std::vector<const MeshBuild*> GetMeshes() const
+			{
+				std::vector<const MeshBuild*> meshes;
+				for (const auto& object : m_Objects)
+				{
+					for (const auto meshIndex : object.Meshes)
+					{
+						if (!m_Meshes[meshIndex].Segments.empty())
+						{
+							meshes.push_back(&m_Meshes[meshIndex]);
+						}
+					}
+				}
+				return meshes;
+			}
+
+		private:
+			void CreateObject(const std::string& name)
+			{
+				m_Objects.push_back({ name, {} });
+				m_CurrentObject = static_cast<uint32_t>(m_Objects.size() - 1u);
+
+				CreateMesh();
+				if (m_bHasMaterial)
+				{
+					m_Meshes[m_CurrentMesh].Material = m_CurrentMaterial;
+					m_Meshes[m_CurrentMesh].bHasMaterial = true;
+				}
+			}
+
+			// Meshes made before any object are never reachable from the scene, same as in assimp
+			void CreateMesh()
+			{
+				m_Meshes.emplace_back();
+				m_CurrentMesh = static_cast<uint32_t>(m_Meshes.size() - 1u);
+				if (m_CurrentObject != NO_INDEX)
+				{
+					m_Objects[m_CurrentObject].Meshes.push_back(m_CurrentMesh);
+				}
+			}
+
+			std::vector<MeshBuild>		m_Meshes;
+			std::vector<ObjectBuild>	m_Objects;
+
+			uint32_t	m_CurrentObject = NO_INDEX;
+			uint32_t	m_CurrentMesh = NO_INDEX;
+			std::string	m_CurrentMaterial;
+			bool		m_bHasMaterial = false;
+			std::string	m_ActiveGroup;
+		};
+
+		// Every corner becomes its own vertex, like assimp's OBJ importer
+		std::unique_ptr<aiMesh> BuildMesh(const MeshBuild& build, const std::vector<Chunk>& chunks, const std::vector<aiVector3D>& positions,
+			const std::vector<aiVector3D>& texCoords, const std::vector<aiVector3D>& normals, unsigned int texCoordDim)
+		{
+			uint32_t faceCount = 0u;
+			uint32_t cornerCount = 0u;
+			bool bHasTexCoords = false;
+			bool bHasNormals = false;
+			for (const auto& segment : build.Segments)
+			{
+				const auto& chunk = chunks[segment.ChunkIndex];
+				faceCount += segment.FaceEnd - segment.FaceBegin;
+				cornerCount += chunk.FaceStarts[segment.FaceEnd] - chunk.FaceStarts[segment.FaceBegin];
+
+				for (uint32_t face = segment.FaceBegin; face < segment.FaceEnd; ++face)
+				{
+					const uint32_t* corner = chunk.Corners.data() + static_cast<size_t>(chunk.FaceStarts[face]) * 3u;
+					bHasTexCoords |= corner[1] != NO_INDEX;
+					bHasNormals |= corner[2] != NO_INDEX;
+				}
+			}
+			bHasTexCoords &= !texCoords.empty();
+			bHasNormals &= !normals.empty();
+
+			auto mesh = std::make_unique<aiMesh>();
+			mesh->mNumVertices = cornerCount;
+			mesh->mVertices = new aiVector3D[cornerCount];
+			if (bHasNormals)
+			{
+				mesh->mNormals = new aiVector3D[cornerCount];
+			}
+			if (bHasTexCoords)
+			{
+				mesh->mNumUVComponents[0] = texCoordDim;
+				mesh->mTextureCoords[0] = new aiVector3D[cornerCount];
+			}
+			mesh->mNumFaces = faceCount;
+			mesh->mFaces = new aiFace[faceCount];
+
+			uint32_t vertex = 0u;
+			aiFace* outFace = mesh->mFaces;
+			for (const auto& segment : build.Segments)
+			{
+				const auto& chunk = chunks[segment.ChunkIndex];
+				for (uint32_t face = segment.FaceBegin; face < segment.FaceEnd; ++face, ++outFace)
+				{
+					const uint32_t first = chunk.FaceStarts[face];
+					const uint32_t count = chunk.FaceStarts[face + 1u] - first;
+
+					outFace->mNumIndices = count;
+					outFace->mIndices = new unsigned int[count];
+					mesh->mPrimitiveTypes |= count > 3u ? aiPrimitiveType_POLYGON : aiPrimitiveType_TRIANGLE;
+
+					const uint32_t* corner = chunk.Corners.data() + static_cast<size_t>(first) * 3u;
+					for (uint32_t i = 0; i < count; ++i, corner += 3, ++vertex)
+					{
+						outFace->mIndices[i] = vertex;
+						mesh->mVertices[vertex] = positions[corner[0]];
+						if (bHasTexCoords && corner[1] != NO_INDEX)
+						{
+							mesh->mTextureCoords[0][vertex] = texCoords[corner[1]];
+						}
+						if (bHasNormals && corner[2] != NO_INDEX)
+						{
+							mesh->mNormals[vertex] = normals[corner[2]];
+						}
+					}
+				}
+			}
+
+			return mesh;
+		}
+
+		// Joins one vertex attribute from every chunk into a single array
+		void Concatenate(const std::vector<Chunk>& chunks, std::vector<aiVector3D> Chunk::* member, std::vector<aiVector3D>& out)
+		{
+			std::vector<size_t> offsets(chunks.size() + 1u, 0u);
+			for (size_t i = 0; i < chunks.size(); ++i)
+			{
+				offsets[i + 1u] = offsets[i] + (chunks[i].*member).size();
+			}
+
+			out.resize(offsets.back());
+			ThreadPool::Get().ParallelFor(chunks.size(), [&](size_t i)
+			{
+				const auto& source = chunks[i].*member;
+				std::copy(source.begin(), source.end(), out.begin() + offsets[i]);
+			});
+		}
+	}
+
+	bool ObjLoader::Load(const uint8_t* data, size_t size, std::vector<std::unique_ptr<aiMesh>>& outMeshes)
+	{
+		if (data == nullptr || size < MIN_FILE_SIZE)
+		{
+			return false;
+		}
+
+		const char* text = reinterpret_cast<const char*>(data);
+		const char* fileEnd = text + size;
+
+		// A few chunks per thread so uneven ones even out
+		const size_t chunkCount = std::max<size_t>(1u, std::min<size_t>(size / MIN_CHUNK_SIZE, (ThreadPool::Get().GetThreadCount() + 1u) * 4u));
+
+		// Cut just after a line break so no line is split between chunks
+		std::vector<Chunk> chunks(chunkCount);
+		const char* chunkBegin = text;
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			const char* chunkEnd = i + 1u == chunkCount ? fileEnd : std::max(chunkBegin, text + size / chunkCount * (i + 1u));
+			while (chunkEnd < fileEnd && chunkEnd > text && chunkEnd[-1] != '\n')
+			{
+				++chunkEnd;
+			}
+
+			chunks[i].Begin = chunkBegin;
+			chunks[i].End = chunkEnd;
+			chunkBegin = chunkEnd;
+		}
+
+		// Malformed numbers throw out of fast_atof, assimp fails on those too so let it report the error
+		try
+		{
+			ThreadPool::Get().ParallelFor(chunkCount, [&](size_t i) { ParseChunk(chunks[i], fileEnd); });
+		}
+		catch (const std::invalid_argument&)
+		{
+			return false;
+		}
+
+		uint64_t positionTotal = 0u;
+		uint64_t texCoordTotal = 0u;
+		uint64_t normalTotal = 0u;
+		unsigned int texCoordDim = 0u;
+		for (const auto& chunk : chunks)
+		{
+			if (chunk.bUnsupported || (chunk.bUVBeforeTexCoords && texCoordTotal == 0u))
+			{
+				return false;
+			}
+
+			positionTotal += chunk.Positions.size();
+			texCoordTotal += chunk.TexCoords.size();
+			normalTotal += chunk.Normals.size();
+			texCoordDim = std::max(texCoordDim, chunk.TexCoordDim);
+		}
+
+		// Assimp throws on bad positions and quietly drops bad uvs or normals for the whole mesh, leave both to it
+		for (const auto& chunk : chunks)
+		{
+			if (chunk.PositionLimit > positionTotal || chunk.TexCoordLimit > texCoordTotal || chunk.NormalLimit > normalTotal)
+			{
+				return false;
+			}
+		}
+
+		MeshAssigner assigner;
+		for (uint32_t i = 0; i < chunkCount; ++i)
+		{
+			uint32_t faceCursor = 0u;
+			for (const auto& statement : chunks[i].Statements)
+			{
+				assigner.AddFaces(i, faceCursor, statement.FaceIndex);
+				faceCursor = statement.FaceIndex;
+				assigner.Apply(statement);
+			}
+			assigner.AddFaces(i, faceCursor, static_cast<uint32_t>(chunks[i].FaceStarts.size() - 1u));
+		}
+
+		const auto meshes = assigner.GetMeshes();
+
+		// Files with no faces come out of assimp as a point cloud
+		if (meshes.empty())
+		{
+			return false;
+		}
+
+		for (const auto* mesh : meshes)
+		{
+			uint64_t cornerCount = 0u;
+			for (const auto& segment : mesh->Segments)
+			{
+				cornerCount += chunks[segment.ChunkIndex].FaceStarts[segment.FaceEnd] - chunks[segment.ChunkIndex].FaceStarts[segment.FaceBegin];
+			}
+			if (cornerCount > AI_MAX_VERTICES)
+			{
+				return false;
+			}
+		}
+
+		std::vector<aiVector3D> positions;
+		std::vector<aiVector3D> texCoords;
+		std::vector<aiVector3D> normals;
+		Concatenate(chunks, &Chunk::Positions, positions);
+		Concatenate(chunks, &Chunk::TexCoords, texCoords);
+		Concatenate(chunks, &Chunk::Normals, normals);
+
+		outMeshes.clear();
+		outMeshes.resize(meshes.size());
+		ThreadPool::Get().ParallelFor(meshes.size(), [&](size_t i)
+		{
+			outMeshes[i] = BuildMesh(*meshes[i], chunks, positions, texCoords, normals, texCoordDim);
+		});
+
+		return true;
+	}
+}
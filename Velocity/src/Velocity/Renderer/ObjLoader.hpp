@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+struct aiMesh;
+
+namespace Velocity
+{
+	// Parses OBJ files straight out of memory on every core. Static helpers only
+	// Builds the same meshes assimp's OBJ importer would, so everything after it is shared with the assimp path
+	class ObjLoader
+	{
+	public:
+		// Each chunk is at least this big, smaller files are parsed on one thread
+		static constexpr size_t MIN_CHUNK_SIZE = 1048576u;
+
+		// Fills outMeshes with one aiMesh per OBJ mesh, in the order assimp would create them
+		// Returns false for anything it cant match assimp on (line continuations, relative indices, lines, points...)
+		// The caller should import the file through assimp then
+		static bool Load(const uint8_t* data, size_t size, std::vector<std::unique_ptr<aiMesh>>& outMeshes);
+	};
+}
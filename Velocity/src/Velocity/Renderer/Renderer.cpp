@@ -2,6 +2,9 @@
 
 #include "Renderer.hpp"
 
+#include <cfloat>
+#include <cmath>
+
 #include <Velocity/Core/Log.hpp>
 
 #include <Velocity/Core/Window.hpp>
@@ -13,9 +16,13 @@
 #include <Velocity/Renderer/Vertex.hpp>
 #include <Velocity/Renderer/BufferManager.hpp>
 #include <Velocity/Renderer/Texture.hpp>
+#include <Velocity/Renderer/TextureCooker.hpp>
 #include <Velocity/Renderer/Skybox.hpp>
+#include <Velocity/Renderer/ClusterCuller.hpp>
 
 #include <Velocity/Utility/Camera.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+#include <Velocity/Utility/VirtualFileSystem.hpp>
 
 #include "Velocity/ECS/Scene.hpp"
 #include "Velocity/ECS/Entity.hpp"
@@ -56,6 +63,7 @@ namespace Velocity
 		CreateFramebuffers();
 		CreateBufferManager();
 		CreateUniformBuffers();
+		CreateClusterCuller();
 		CreateDescriptorPool();
 		CreateDescriptorSets();
 		CreateCommandBuffers();
@@ -75,6 +83,36 @@ namespace Velocity
 		m_ActiveScene = scene;
 	}
 
+	// Imports a batch of meshes on the worker pool
+	std::vector<std::shared_future<BufferManager::MeshIndexer>> Renderer::LoadMeshesAsync(const std::vector<std::pair<std::string, std::string>>& meshes, MeshLoadedCallback onLoaded)
+	{
+		std::vector<std::shared_future<BufferManager::MeshIndexer>> results;
+		results.reserve(meshes.size());
+
+		for (const auto& [filepath, referenceName] : meshes)
+		{
+			PendingMeshLoad load;
+			load.ReferenceName = referenceName;
+			load.OnLoaded = onLoaded;
+
+			// Everything up to the upload runs on a worker with its own importer
+			load.Import = ThreadPool::Get().Enqueue([filepath]()
+			{
+				auto prepared = std::make_unique<BufferManager::PreparedMesh>();
+				if (!BufferManager::PrepareMesh(filepath, *prepared))
+				{
+					prepared.reset();
+				}
+				return prepared;
+			});
+
+			results.push_back(load.Result.get_future().share());
+			m_PendingMeshLoads.push_back(std::move(load));
+		}
+
+		return results;
+	}
+
 	// Submits a renderer command to be done
 	// Returns a new texture.
 	uint32_t Renderer::CreateTexture(const std::string& filepath, const std::string& referenceName)
@@ -84,6 +122,7 @@ namespace Velocity
 		auto newIndex = static_cast<uint32_t>(m_Textures.size()) - 1u;
 		// Update the texture info
 		m_TextureInfos.at(newIndex).imageView = m_Textures.back().second->m_ImageView.get();
+		TrackTextureResidency(newIndex);
 
 		m_LogicalDevice->waitIdle();
 
@@ -98,23 +137,132 @@ namespace Velocity
 		return newIndex;
 
 	}
+	std::vector<uint32_t> Renderer::CreateTextures(const std::vector<std::pair<std::string, std::string>>& textures)
+	{
+		std::vector<DecodedImage> images(textures.size());
+		ThreadPool::Get().ParallelFor(textures.size(), [&images, &textures](size_t i)
+		{
+			images[i] = Texture::Decode(textures[i].first);
+		});
+
+		auto indices = FindQueueFamilies(m_PhysicalDevice);
+
+		std::vector<uint32_t> results(textures.size(), 0u);
+		std::vector<size_t> loaded;
+		std::vector<std::pair<std::string, Texture*>> batch;
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			if (!images[i].IsValid())
+			{
+				// Leave it on the default texture
+				VEL_CORE_ERROR("Failed to load texture file: {0}", textures[i].first);
+				VEL_CORE_ASSERT(false, "Failed to load texture file: {0}", textures[i].first);
+				continue;
+			}
+
+			loaded.push_back(i);
+			batch.push_back({ textures[i].second, new Texture(std::move(images[i]), textures[i].first, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value(), false) });
+		}
+
+		auto batchIndices = RegisterTextureBatch(batch);
+		for (size_t i = 0; i < loaded.size(); ++i)
+		{
+			results[loaded[i]] = batchIndices[i];
+		}
+
+		return results;
+	}
+
+	// Decodes on the worker pool, the slot is patched once the upload is done
+	uint32_t Renderer::CreateTextureAsync(const std::string& filepath, const std::string& referenceName, TextureLoadedCallback onLoaded)
+	{
+		// Only reads the header, gives us the decoded size for the budget
+		// Cooked files go to the GPU as they are so their size is just the file size
+		int width = 0, height = 0;
+		uint64_t fileSize = 0u;
+		const bool isCooked = CookedTexture::IsCookedPath(filepath);
+		const bool found = isCooked ? VirtualFileSystem::GetFileSize(filepath, fileSize) : Texture::GetInfo(filepath, width, height);
+		if (!found)
+		{
+			VEL_CORE_ERROR("Failed to load texture file: {0}", filepath);
+			VEL_CORE_ASSERT(false, "Failed to load texture file: {0}", filepath);
+			return 0;
+		}
+
+		const size_t bytes = isCooked ? static_cast<size_t>(fileSize) : static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
+		return QueueTextureLoad(filepath, referenceName, bytes, nullptr, onLoaded);
+	}
+
+	// Points a new slot at the default texture and queues the load behind the budget
+	uint32_t Renderer::QueueTextureLoad(const std::string& filepath, const std::string& referenceName, size_t bytes, std::function<DecodedImage()> load, TextureLoadedCallback onLoaded)
+	{
+		// Point the new slot at the default texture until the real one arrives
+		// m_TextureInfos already holds the default image view for unused slots
+		m_Textures.push_back({ referenceName, m_DefaultBindingTexture });
+		m_TextureGUIIDs.push_back(m_TextureGUIIDs.front());
+		const auto newIndex = static_cast<uint32_t>(m_Textures.size()) - 1u;
+
+		PendingTextureLoad pending;
+		pending.Index = newIndex;
+		pending.Filepath = filepath;
+		pending.Bytes = bytes;
+		pending.Load = std::move(load);
+		pending.OnLoaded = onLoaded;
+		m_PendingTextureLoads.push_back(std::move(pending));
+
+		StartTextureDecodes();
+
+		return newIndex;
+	}
+
 	// Returns a material component
 	PBRComponent Renderer::CreatePBRMaterial(const std::string& basefilepath, const std::string& extension, const std::string& referenceName, bool heightMapped)
 	{
 		PBRComponent newComponent;
 		// Mark them as internal in the texture array so they arent displayed for non PBR texture adding
-		newComponent.AlbedoID() = static_cast<int32_t>(CreateTexture(basefilepath + "_albedo" + extension, "VEL_INTERNAL_" + referenceName + "_albedo"));
-		newComponent.NormalID() = static_cast<int32_t>(CreateTexture(basefilepath + "_normal" + extension, "VEL_INTERNAL_" + referenceName + "_normal"));
-		if (heightMapped)
+		// The maps decode side by side on the pool and pop in as they finish
+		// Cooked versions are used instead when they are up to date
+		newComponent.AlbedoID() = static_cast<int32_t>(CreateTextureAsync(TextureCooker::FindCooked(basefilepath + "_albedo" + extension), "VEL_INTERNAL_" + referenceName + "_albedo"));
+		newComponent.NormalID() = static_cast<int32_t>(CreateTextureAsync(TextureCooker::FindCooked(basefilepath + "_normal" + extension), "VEL_INTERNAL_" + referenceName + "_normal"));
+
+		// Occlusion, roughness, metallic and height share one texture
+		// The first load packs and cooks it on the pool, after that the cooked file is read straight back
+		const MaterialMaps maps = TextureCooker::GetMaterialMaps(basefilepath, extension);
+		const std::string packedPath = TextureCooker::GetPackedPath(basefilepath);
+		const std::vector<std::string> sources = { maps.Occlusion, maps.Roughness, maps.Metallic, maps.Height };
+		const std::string packedName = "VEL_INTERNAL_" + referenceName + "_packed";
+
+		if (TextureCooker::IsUpToDate(packedPath, sources))
 		{
-			newComponent.HeightID() = static_cast<int32_t>(CreateTexture(basefilepath + "_height" + extension, "VEL_INTERNAL_" + referenceName + "_height"));
+			newComponent.PackedID() = static_cast<int32_t>(CreateTextureAsync(packedPath, packedName));
 		}
 		else
 		{
-			newComponent.HeightID() = -1;
+			// Budget it by what the sources decode to, thats the peak while packing
+			size_t bytes = 0u;
+			for (const auto& source : sources)
+			{
+				int width = 0, height = 0;
+				if (!source.empty() && Texture::GetInfo(source, width, height))
+				{
+					bytes += static_cast<size_t>(width) * static_cast<size_t>(height) * 4u;
+				}
+			}
+
+			newComponent.PackedID() = static_cast<int32_t>(QueueTextureLoad(packedPath, packedName, bytes, [maps, packedPath]()
+			{
+				DecodedImage image;
+				image.Cooked = std::make_unique<CookedTexture>();
+				if (!TextureCooker::CookMaterial(maps, packedPath, *image.Cooked))
+				{
+					image.Cooked.reset();
+				}
+				return image;
+			}, nullptr));
 		}
-		newComponent.MetallicID() = static_cast<int32_t>(CreateTexture(basefilepath + "_metallic" + extension, "VEL_INTERNAL_" + referenceName + "_metallic"));
-		newComponent.RoughnessID() = static_cast<int32_t>(CreateTexture(basefilepath + "_roughness" + extension, "VEL_INTERNAL_" + referenceName + "_roughness"));
+
+		// The height channel is only read when asked for and when there was a map to fill it
+		newComponent.HeightMapped = heightMapped && !maps.Height.empty() ? 1 : 0;
 
 		newComponent.MaterialName = referenceName;
 		
@@ -130,14 +278,21 @@ namespace Velocity
 	Skybox* Renderer::CreateSkybox(const std::string& baseFilepath, const std::string& extension)
 	{
 		auto indices = FindQueueFamilies(m_PhysicalDevice);
-		return new Skybox(baseFilepath, extension, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value());
+		auto* skybox = new Skybox(baseFilepath, extension, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value());
+		if (!m_KeepCPUCopies)
+		{
+			skybox->ReleaseCPUCopy();
+		}
+		return skybox;
 	}
 
 	// Returns a HDR Skybox
 	IBLMap* Renderer::CreateHDRSkybox(const std::string& filepath)
 	{
 		auto indices = FindQueueFamilies(m_PhysicalDevice);
-		return new IBLMap(filepath, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value(),*m_BufferManager.get());
+		auto* map = new IBLMap(filepath, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value());
+		m_PendingIBLMaps.push_back(map);
+		return map;
 	}
 
 	#pragma endregion 
@@ -146,6 +301,16 @@ namespace Velocity
 	// Called by application in the run loop
 	void Renderer::Render()
 	{
+		// Pull in any meshes and textures that finished loading since last frame
+		ProcessPendingMeshLoads(false);
+		ProcessPendingTextureLoads(false);
+
+		// Stream mips in and out based on what was drawn last frame
+		UpdateTextureResidency();
+
+		// Pick up HDR skyboxes that finished building
+		UpdateIBLMaps(false);
+
 		// Wait on fences
 		// TODO: check result
 		auto result = m_LogicalDevice->waitForFences(1, &m_Syncronizer.InFlightFences.at(m_CurrentFrame).get(), VK_TRUE, UINT64_MAX);
@@ -323,6 +488,7 @@ namespace Velocity
 		CreateFramebufferResources();
 		CreateFramebuffers();
 		CreateUniformBuffers();
+		CreateClusterCuller();
 		CreateDescriptorPool();
 		CreateDescriptorSets();
 		CreateCommandBuffers();
@@ -890,7 +1056,7 @@ namespace Velocity
 		vk::PushConstantRange pbrConstantRange = {
 			vk::ShaderStageFlagBits::eFragment,
 			0,
-			sizeof(glm::mat4) + (sizeof(uint32_t) * 5) + sizeof(glm::vec3) + (sizeof(bool) * 4)
+			sizeof(glm::mat4) + (sizeof(uint32_t) * 4) + sizeof(glm::vec3) + (sizeof(bool) * 4)
 		};
 
 
@@ -1636,7 +1802,8 @@ namespace Velocity
 	// Creates the vertex and index buffers we need
 	void Renderer::CreateBufferManager()
 	{
-		m_BufferManager = std::make_unique<BufferManager>(m_PhysicalDevice, m_LogicalDevice, m_CommandPool.get(), m_GraphicsQueue);
+		auto indices = FindQueueFamilies(m_PhysicalDevice);
+		m_BufferManager = std::make_unique<BufferManager>(m_PhysicalDevice, m_LogicalDevice, m_CommandPool.get(), m_GraphicsQueue, indices.GraphicsFamily.value());
 	}
 
 	// Allocates one command buffer per framebuffer
@@ -1936,6 +2103,16 @@ namespace Velocity
 		}
 	}
 
+	// Creates the compute pass that culls the clusters of large meshes
+	void Renderer::CreateClusterCuller()
+	{
+		// Buffers are per swapchain image so this needs remaking on resize
+		m_ClusterCuller.reset();
+		m_ClusterCuller = std::make_unique<ClusterCuller>(m_LogicalDevice, m_PhysicalDevice, *m_BufferManager, m_Swapchain->GetImages().size());
+
+		VEL_CORE_INFO("Created cluster culler!");
+	}
+
 	// Creates all required sync primitives
 	void Renderer::CreateSyncronizer()
 	{
@@ -2146,6 +2323,27 @@ namespace Velocity
 			vk::ClearColorValue(depthClear)
 		};
 
+		// Cull the clusters of large meshes before the pass starts. Compute cant run inside a render pass
+		if (m_ActiveScene && m_EnableClusterCulling)
+		{
+			auto* camera = m_ActiveScene->m_SceneCamera.get();
+			m_ClusterCuller->BeginFrame(m_CurrentImage, camera->GetProjectionMatrix() * camera->GetViewMatrix(), camera->GetPosition());
+
+			auto texturedView = m_ActiveScene->m_Registry.view<TransformComponent, MeshComponent, TextureComponent>();
+			for (auto [entity, transform, mesh, texture] : texturedView.each())
+			{
+				m_ClusterCuller->Submit(static_cast<uint32_t>(entity), transform.GetTransform(), m_Renderables[mesh.MeshReference]);
+			}
+
+			auto pbrView = m_ActiveScene->m_Registry.view<TransformComponent, MeshComponent, PBRComponent>();
+			for (auto [entity, transform, mesh, pbr] : pbrView.each())
+			{
+				m_ClusterCuller->Submit(static_cast<uint32_t>(entity), transform.GetTransform(), m_Renderables[mesh.MeshReference]);
+			}
+
+			m_ClusterCuller->Dispatch(cmdBuffer.get());
+		}
+
 		// Begin render pass
 		vk::RenderPassBeginInfo renderPassInfo = {
 			m_TexturedPipeline->GetRenderPass().get(),
@@ -2208,7 +2406,18 @@ namespace Velocity
 				cmdBuffer->pushConstants(m_TexturedPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(glm::mat4), glm::value_ptr(transform.GetTransform()));
 				cmdBuffer->pushConstants(m_TexturedPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4), sizeof(uint32_t), &texture.TextureID);
 				cmdBuffer->pushConstants(m_TexturedPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4) + sizeof(uint32_t), sizeof(glm::vec3), value_ptr(m_ActiveScene->m_SceneCamera->GetPosition()));
-				cmdBuffer->drawIndexed(renderable.IndexCount, 1, renderable.IndexStart, renderable.VertexOffset, 0);
+
+				// Lets residency know which mip this texture needs
+				if (m_EnableTextureStreaming)
+				{
+					m_TextureResidency.Request(texture.TextureID, GetScreenSize(transform.GetTransform(), renderable));
+				}
+
+				// Clustered meshes draw only what survived culling
+				if (!m_EnableClusterCulling || !m_ClusterCuller->Draw(cmdBuffer.get(), static_cast<uint32_t>(entity)))
+				{
+					cmdBuffer->drawIndexed(renderable.IndexCount, 1, renderable.IndexStart, renderable.VertexOffset, 0);
+				}
 			}
 
 			// When we use lights
@@ -2256,18 +2465,30 @@ namespace Velocity
 				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(glm::mat4), glm::value_ptr(transform.GetTransform()));
 
 				// PBR has multiple texture indexes
-				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4), pbr.GetSize(), pbr.GetPointer());
+				const auto material = pbr.GetPushConstants();
+				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4), static_cast<uint32_t>(sizeof(material)), material.data());
 
 				// Camera now pushed later in constant range
-				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4) + (sizeof(uint32_t) * 5), sizeof(glm::vec3), value_ptr(m_ActiveScene->m_SceneCamera->GetPosition()));
+				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4) + (sizeof(uint32_t) * 4), sizeof(glm::vec3), value_ptr(m_ActiveScene->m_SceneCamera->GetPosition()));
 
 				// Push if skybox has been set
 				bool hasSkybox[4] = { false,false,false,false };
 				hasSkybox[0] = m_ActiveScene->GetSkybox() ? true : false;
 				
-				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4) + (sizeof(uint32_t) * 5) + sizeof(glm::vec3), (sizeof(bool) * 4), &hasSkybox[0]);
+				cmdBuffer->pushConstants(m_PBRPipeline->GetLayout().get(), vk::ShaderStageFlagBits::eFragment, sizeof(glm::mat4) + (sizeof(uint32_t) * 4) + sizeof(glm::vec3), (sizeof(bool) * 4), &hasSkybox[0]);
+
+				if (m_EnableTextureStreaming)
+				{
+					const float screenSize = GetScreenSize(transform.GetTransform(), renderable);
+					m_TextureResidency.Request(static_cast<uint32_t>(pbr.AlbedoID()), screenSize);
+					m_TextureResidency.Request(static_cast<uint32_t>(pbr.NormalID()), screenSize);
+					m_TextureResidency.Request(static_cast<uint32_t>(pbr.PackedID()), screenSize);
+				}
 				
-				cmdBuffer->drawIndexed(renderable.IndexCount, 1, renderable.IndexStart, renderable.VertexOffset, 0);
+				if (!m_EnableClusterCulling || !m_ClusterCuller->Draw(cmdBuffer.get(), static_cast<uint32_t>(entity)))
+				{
+					cmdBuffer->drawIndexed(renderable.IndexCount, 1, renderable.IndexStart, renderable.VertexOffset, 0);
+				}
 
 			}
 		}
@@ -2540,6 +2761,7 @@ namespace Velocity
 					tc.Translation = translation;
 					tc.Rotation += deltaRotation;
 					tc.Scale = scale;
+					m_GizmoEntity->NotifyChanged<TransformComponent>();
 					
 					
 				} 
@@ -2571,6 +2793,7 @@ namespace Velocity
 				if (ImGuizmo::IsUsing())
 				{
 					m_GizmoEntity->GetComponent<PointLightComponent>().Position = tempTransform[3];
+					m_GizmoEntity->NotifyChanged<PointLightComponent>();
 				}
 				
 			}
@@ -2751,7 +2974,8 @@ namespace Velocity
 		int i = 0;
 		for (const auto& queueFamily : queueFamilies)
 		{
-			if (queueFamily.queueFlags & vk::QueueFlagBits::eGraphics)
+			// Cluster culling is recorded into the graphics command buffers so we need compute on the same queue
+			if ((queueFamily.queueFlags & vk::QueueFlagBits::eGraphics) && (queueFamily.queueFlags & vk::QueueFlagBits::eCompute))
 			{
 				indices.GraphicsFamily = i;
 			}
@@ -2822,11 +3046,392 @@ namespace Velocity
 				m_Lights.Lights[m_Lights.ActiveLightCount] = pointLight;
 				m_Lights.ActiveLightCount += 1u;
 			}
+
+			// Diffuse ambient comes from these rather than sampling the skybox
+			m_Lights.IrradianceSH = m_ActiveScene->m_Skybox ? m_ActiveScene->m_Skybox->GetIrradianceSH() : SHCoefficients{};
 		}
 	}
 
 	#pragma endregion
 
+	// Adds finished imports to the heap. Waits for all of them if wait is true
+	void Renderer::ProcessPendingMeshLoads(bool wait)
+	{
+		do
+		{
+			// Callbacks can queue more loads, so take the list before walking it
+			std::vector<PendingMeshLoad> loads;
+			loads.swap(m_PendingMeshLoads);
+
+			for (auto& load : loads)
+			{
+				if (!wait && load.Import.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					m_PendingMeshLoads.push_back(std::move(load));
+					continue;
+				}
+
+				auto prepared = load.Import.get();
+				if (!prepared)
+				{
+					// Import already logged why
+					load.Result.set_value(BufferManager::MeshIndexer());
+					continue;
+				}
+
+				// Buffer manager and queue arent thread safe so this part is serialised here
+				auto mesh = m_BufferManager->AddPreparedMesh(*prepared);
+				m_Renderables.insert({ load.ReferenceName, mesh });
+
+				if (load.OnLoaded)
+				{
+					load.OnLoaded(load.ReferenceName, mesh);
+				}
+
+				load.Result.set_value(mesh);
+			}
+		}
+		while (wait && !m_PendingMeshLoads.empty());
+	}
+
+	// Waits out running imports and throws the results away
+	void Renderer::DiscardPendingMeshLoads()
+	{
+		for (auto& load : m_PendingMeshLoads)
+		{
+			load.Import.wait();
+			load.Result.set_value(BufferManager::MeshIndexer());
+		}
+		m_PendingMeshLoads.clear();
+	}
+
+	// Uploads finished decodes and points their slots at them. Waits for all of them if wait is true
+	void Renderer::ProcessPendingTextureLoads(bool wait)
+	{
+		std::vector<std::pair<TextureLoadedCallback, uint32_t>> callbacks;
+		bool patched = false;
+
+		do
+		{
+			StartTextureDecodes();
+
+			for (auto& load : m_PendingTextureLoads)
+			{
+				if (!load.Started || !load.Decode.valid())
+				{
+					continue;
+				}
+				if (!wait && load.Decode.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+				{
+					continue;
+				}
+
+				auto image = load.Decode.get();
+				m_TextureBytesInFlight -= load.Bytes;
+
+				if (!image.IsValid())
+				{
+					// Slot just keeps showing the default texture
+					VEL_CORE_ERROR("Failed to load texture file: {0}", load.Filepath);
+					continue;
+				}
+
+				// Upload has to happen here, vulkan stays on the main thread
+				auto indices = FindQueueFamilies(m_PhysicalDevice);
+				auto* texture = new Texture(std::move(image), load.Filepath, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value());
+
+				m_Textures.at(load.Index).second = texture;
+				m_TextureInfos.at(load.Index).imageView = texture->m_ImageView.get();
+				TrackTextureResidency(load.Index);
+				m_TextureGUIIDs.at(load.Index) = (ImTextureID)ImGui_ImplVulkan_AddTexture(m_TextureSampler.get(), texture->m_ImageView.get(), (VkImageLayout)texture->m_CurrentLayout);
+
+				patched = true;
+				if (load.OnLoaded)
+				{
+					callbacks.push_back({ load.OnLoaded, load.Index });
+				}
+			}
+
+			// Drop everything that has been handled
+			m_PendingTextureLoads.erase(std::remove_if(m_PendingTextureLoads.begin(), m_PendingTextureLoads.end(), [](const PendingTextureLoad& load)
+			{
+				return load.Started && !load.Decode.valid();
+			}), m_PendingTextureLoads.end());
+
+			// Patch the descriptors once for every texture that landed rather than per texture
+			if (patched)
+			{
+				patched = false;
+
+				// Sets may be in use by frames in flight
+				m_LogicalDevice->waitIdle();
+				for (auto writes : m_DescriptorWrites)
+				{
+					m_LogicalDevice->updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+				}
+			}
+		}
+		while (wait && !m_PendingTextureLoads.empty());
+
+		for (auto& [callback, index] : callbacks)
+		{
+			callback(m_Textures.at(index).first, index);
+		}
+	}
+
+	// Starts queued decodes in order while they fit in the budget
+	void Renderer::StartTextureDecodes()
+	{
+		for (auto& load : m_PendingTextureLoads)
+		{
+			if (load.Started)
+			{
+				continue;
+			}
+
+			// Always let one through so a texture bigger than the whole budget still loads
+			if (m_TextureBytesInFlight > 0u && m_TextureBytesInFlight + load.Bytes > m_TextureLoadBudget)
+			{
+				break;
+			}
+
+			m_TextureBytesInFlight += load.Bytes;
+			load.Started = true;
+			if (load.Load)
+			{
+				load.Decode = ThreadPool::Get().Enqueue(load.Load);
+			}
+			else
+			{
+				load.Decode = ThreadPool::Get().Enqueue([filepath = load.Filepath]()
+				{
+					return Texture::Decode(filepath);
+				});
+			}
+		}
+	}
+
+	// Waits out running decodes and throws the pixels away
+	void Renderer::DiscardPendingTextureLoads()
+	{
+		for (auto& load : m_PendingTextureLoads)
+		{
+			if (load.Started && load.Decode.valid())
+			{
+				load.Decode.wait();
+			}
+		}
+		m_PendingTextureLoads.clear();
+		m_TextureBytesInFlight = 0u;
+	}
+
+	// Starts managing the mips of a slot that now holds a real texture, or drops its CPU copy when copies are off
+	void Renderer::TrackTextureResidency(uint32_t index)
+	{
+		Texture* texture = m_Textures.at(index).second;
+		if (index == 0u || texture == m_DefaultBindingTexture)
+		{
+			return;
+		}
+
+		// Nothing left to stream back in from, so it stays fully resident
+		if (!m_KeepCPUCopies)
+		{
+			texture->ReleaseCPUCopy();
+			return;
+		}
+		m_TextureResidency.Track(index, texture->GetWidth(), texture->GetHeight(), texture->GetMipSizes(), texture->GetResidentMip());
+	}
+
+	std::vector<uint32_t> Renderer::CompactTextures(const std::vector<bool>& used)
+	{
+		// Frames in flight may still sample what is about to be deleted
+		m_LogicalDevice->waitIdle();
+
+		std::vector<uint32_t> newIndices(m_Textures.size(), TextureResidency::NO_SLOT);
+		size_t next = 0u;
+		for (size_t i = 0; i < m_Textures.size(); ++i)
+		{
+			if (i == 0u || (i < used.size() && used[i]))
+			{
+				newIndices[i] = static_cast<uint32_t>(next);
+				m_Textures[next] = m_Textures[i];
+				m_TextureInfos.at(next) = m_TextureInfos.at(i);
+				m_TextureGUIIDs[next] = m_TextureGUIIDs[i];
+				++next;
+				continue;
+			}
+
+			// Slots that never finished loading share the default texture and its gui set
+			if (m_Textures[i].second != m_DefaultBindingTexture)
+			{
+				delete m_Textures[i].second;
+			}
+			if (m_TextureGUIIDs[i] != m_TextureGUIIDs.front())
+			{
+				const vk::DescriptorSet guiSet(reinterpret_cast<VkDescriptorSet>(m_TextureGUIIDs[i]));
+				m_LogicalDevice->freeDescriptorSets(m_ImGuiDescriptorPool, guiSet);
+			}
+		}
+
+		m_Textures.resize(next);
+		m_TextureGUIIDs.resize(next);
+		for (size_t i = next; i < m_TextureInfos.size(); ++i)
+		{
+			m_TextureInfos[i].imageView = m_DefaultBindingTexture->m_ImageView.get();
+		}
+		m_TextureResidency.Remap(newIndices);
+
+		// Only the texture array changed, both the textured and pbr sets read it
+		for (size_t i = 0; i < m_DescriptorWrites.size(); ++i)
+		{
+			std::array<vk::WriteDescriptorSet, 2> writes = { m_DescriptorWrites.at(i).at(2), m_PBRDescriptorWrites.at(i).at(3) };
+			m_LogicalDevice->updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+
+		return newIndices;
+	}
+
+	void Renderer::ToggleCPUCopies(bool state)
+	{
+		m_KeepCPUCopies = state;
+		m_BufferManager->ToggleCPUCopy(state);
+		if (m_KeepCPUCopies)
+		{
+			return;
+		}
+
+		// What is already loaded lets go now too
+		for (uint32_t i = 1; i < static_cast<uint32_t>(m_Textures.size()); ++i)
+		{
+			Texture* texture = m_Textures.at(i).second;
+			if (texture != m_DefaultBindingTexture && texture->GetResidentMip() == 0u)
+			{
+				m_TextureResidency.Untrack(i);
+				texture->ReleaseCPUCopy();
+			}
+		}
+
+		if (m_ActiveScene && m_ActiveScene->m_Skybox)
+		{
+			m_ActiveScene->m_Skybox->ReleaseCPUCopy();
+		}
+	}
+
+	Renderer::MemoryUsage Renderer::GetMemoryUsage() const
+	{
+		MemoryUsage usage;
+		usage.GeometryHost = m_BufferManager->GetHostMemory();
+		usage.GeometryDevice = m_BufferManager->GetDeviceMemory();
+
+		// Slots waiting on a load share the default texture, it only counts once
+		for (size_t i = 0; i < m_Textures.size(); ++i)
+		{
+			const Texture* texture = m_Textures.at(i).second;
+			if (i > 0u && texture == m_DefaultBindingTexture)
+			{
+				continue;
+			}
+
+			usage.TextureHost += texture->GetHostMemory();
+
+			const auto mipSizes = texture->GetMipSizes();
+			for (size_t level = texture->GetResidentMip(); level < mipSizes.size(); ++level)
+			{
+				usage.TextureDevice += mipSizes[level];
+			}
+		}
+
+		if (m_ActiveScene && m_ActiveScene->m_Skybox)
+		{
+			usage.SkyboxHost = m_ActiveScene->m_Skybox->GetHostMemory();
+			usage.SkyboxDevice = m_ActiveScene->m_Skybox->GetDeviceMemory();
+		}
+
+		return usage;
+	}
+
+	// Applies what residency decided between frames
+	// Every change goes up in one batch, then all the views are swapped before anything is recorded with them
+	void Renderer::UpdateTextureResidency()
+	{
+		if (!m_EnableTextureStreaming)
+		{
+			return;
+		}
+
+		const auto changes = m_TextureResidency.Update();
+		if (changes.empty())
+		{
+			return;
+		}
+
+		std::vector<std::pair<Texture*, uint32_t>> textures;
+		textures.reserve(changes.size());
+		for (const auto& change : changes)
+		{
+			textures.push_back({ m_Textures.at(change.Index).second, change.ResidentMip });
+		}
+
+		// Leaves the queue idle so nothing in flight still points at the old views
+		Texture::SetResidentMips(textures);
+
+		for (const auto& change : changes)
+		{
+			Texture* texture = m_Textures.at(change.Index).second;
+			m_TextureInfos.at(change.Index).imageView = texture->m_ImageView.get();
+
+			// The old gui set points at a view that is gone
+			auto& guiID = m_TextureGUIIDs.at(change.Index);
+			if (guiID != m_TextureGUIIDs.front())
+			{
+				const vk::DescriptorSet oldSet(reinterpret_cast<VkDescriptorSet>(guiID));
+				m_LogicalDevice->freeDescriptorSets(m_ImGuiDescriptorPool, oldSet);
+			}
+			guiID = (ImTextureID)ImGui_ImplVulkan_AddTexture(m_TextureSampler.get(), texture->m_ImageView.get(), (VkImageLayout)texture->m_CurrentLayout);
+		}
+
+		// Only the texture array changed, both the textured and pbr sets read it
+		for (size_t i = 0; i < m_DescriptorWrites.size(); ++i)
+		{
+			std::array<vk::WriteDescriptorSet, 2> writes = { m_DescriptorWrites.at(i).at(2), m_PBRDescriptorWrites.at(i).at(3) };
+			m_LogicalDevice->updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+	}
+
+	void Renderer::UpdateIBLMaps(bool wait)
+	{
+		// Update returns false once a map is built and cached, or gave up
+		m_PendingIBLMaps.erase(std::remove_if(m_PendingIBLMaps.begin(), m_PendingIBLMaps.end(), [wait](IBLMap* map)
+		{
+			return !map->Update(wait);
+		}), m_PendingIBLMaps.end());
+	}
+
+	// Rough diameter in pixels of the mesh's bounding sphere
+	float Renderer::GetScreenSize(const glm::mat4& world, const BufferManager::MeshIndexer& mesh)
+	{
+		// Unknown bounds, ask for everything
+		if (mesh.BoundingRadius <= 0.0f || !m_ActiveScene || !m_ActiveScene->m_SceneCamera)
+		{
+			return FLT_MAX;
+		}
+
+		const float scale = std::max<float>(std::max<float>(glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1]))), glm::length(glm::vec3(world[2])));
+		const float radius = mesh.BoundingRadius * scale;
+
+		auto* camera = m_ActiveScene->m_SceneCamera.get();
+		const float distance = glm::length(camera->GetPosition() - glm::vec3(world[3])) - radius;
+		if (distance <= camera->GetNearClip())
+		{
+			return FLT_MAX;
+		}
+
+		// Camera fov is horizontal
+		const float pixelsPerUnit = static_cast<float>(m_Swapchain->GetExtent().width) / (2.0f * distance * std::tan(camera->GetFOV() * 0.5f));
+		return 2.0f * radius * pixelsPerUnit;
+	}
+
 	void Renderer::CreateTexture(std::unique_ptr<stbi_uc> pixels, int width, int height, const std::string& referenceName)
 	{
 		auto indices = FindQueueFamilies(m_PhysicalDevice);
@@ -2834,6 +3439,7 @@ namespace Velocity
 		auto newIndex = static_cast<uint32_t>(m_Textures.size()) - 1u;
 		// Update the texture info
 		m_TextureInfos.at(newIndex).imageView = m_Textures.back().second->m_ImageView.get();
+		TrackTextureResidency(newIndex);
 
 		m_LogicalDevice->waitIdle();
 
@@ -2848,11 +3454,78 @@ namespace Velocity
 
 	}
 
+	std::vector<uint32_t> Renderer::CreateTextureBatch(std::vector<RawTexture>& textures)
+	{
+		auto indices = FindQueueFamilies(m_PhysicalDevice);
+
+		std::vector<std::pair<std::string, Texture*>> batch;
+		batch.reserve(textures.size());
+		for (auto& raw : textures)
+		{
+			if (raw.Cooked)
+			{
+				DecodedImage image;
+				image.Cooked = std::move(raw.Cooked);
+				batch.push_back({ raw.ReferenceName, new Texture(std::move(image), "Cooked from serialisation", m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value(), false) });
+				continue;
+			}
+
+			batch.push_back({ raw.ReferenceName, new Texture(std::move(raw.Pixels), raw.Width, raw.Height, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value(), false) });
+		}
+
+		return RegisterTextureBatch(batch);
+	}
+
+	std::vector<uint32_t> Renderer::RegisterTextureBatch(const std::vector<std::pair<std::string, Texture*>>& textures)
+	{
+		std::vector<uint32_t> results;
+		if (textures.empty())
+		{
+			return results;
+		}
+
+		std::vector<Texture*> uploads;
+		uploads.reserve(textures.size());
+		for (auto& texture : textures)
+		{
+			uploads.push_back(texture.second);
+		}
+
+		// One staging buffer, one submit
+		Texture::UploadBatch(uploads);
+
+		results.reserve(textures.size());
+		for (auto& texture : textures)
+		{
+			m_Textures.push_back(texture);
+			const auto newIndex = static_cast<uint32_t>(m_Textures.size()) - 1u;
+			results.push_back(newIndex);
+
+			m_TextureInfos.at(newIndex).imageView = texture.second->m_ImageView.get();
+			TrackTextureResidency(newIndex);
+			m_TextureGUIIDs.push_back((ImTextureID)ImGui_ImplVulkan_AddTexture(m_TextureSampler.get(), texture.second->m_ImageView.get(), (VkImageLayout)texture.second->m_CurrentLayout));
+		}
+
+		// And one descriptor update for the lot
+		m_LogicalDevice->waitIdle();
+
+		for (auto writes : m_DescriptorWrites)
+		{
+			m_LogicalDevice->updateDescriptorSets(static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+		}
+
+		return results;
+	}
+
 	Skybox* Renderer::CreateSkybox(std::array<std::unique_ptr<stbi_uc>, 6>& pixels, int width, int height)
 	{
 		auto indices = FindQueueFamilies(m_PhysicalDevice);
-		return new Skybox(pixels, width, height, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value());
-		
+		auto* skybox = new Skybox(pixels, width, height, m_LogicalDevice, m_PhysicalDevice, m_CommandPool.get(), indices.GraphicsFamily.value());
+		if (!m_KeepCPUCopies)
+		{
+			skybox->ReleaseCPUCopy();
+		}
+		return skybox;
 	}
 
 	
@@ -2875,9 +3548,16 @@ namespace Velocity
 		m_LogicalDevice->destroyCommandPool(m_ImGuiCommandPool);
 		m_LogicalDevice->destroyDescriptorPool(m_ImGuiDescriptorPool);
 
-		for (auto& texture : m_Textures)
+		// Decodes still running on the pool would outlive us otherwise
+		DiscardPendingTextureLoads();
+
+		for (size_t i = 0; i < m_Textures.size(); ++i)
 		{
-			delete texture.second;
+			// Slots that never finished loading share the default texture
+			if (i == 0u || m_Textures[i].second != m_DefaultBindingTexture)
+			{
+				delete m_Textures[i].second;
+			}
 		}
 		
 		ImGui_ImplVulkan_Shutdown();
@@ -4,6 +4,7 @@
 #include <GLFW/glfw3.h>
 
 #include <optional>
+#include <future>
 #include <backends/imgui_impl_vulkan.h>
 
 #include <Velocity/Core/Events/ApplicationEvent.hpp>
@@ -12,6 +13,8 @@
 #include "imgui.h"
 #include <ImGuizmo.h>
 #include "Texture.hpp"
+#include "SphericalHarmonics.hpp"
+#include "TextureResidency.hpp"
 
 
 namespace Velocity {
@@ -27,6 +30,8 @@ namespace Velocity {
 	class Texture;
 	class Scene;
 	class Skybox;
+	class ClusterCuller;
+	class IBLMap;
 
 	// This is the BIG class. Contains all vulkan related code
 	class Renderer
@@ -35,6 +40,8 @@ namespace Velocity {
 		friend class ImGuiLayer;				// Gui needs to call a viewport function
 		friend class DefaultCameraController;	// Needs to check gui state
 		friend class Application;				// Same as camera controller
+		friend class IBLMap;					// Stops being polled when destroyed
+		friend class SceneLoad;					// Hands a staged scene over in one frame
 	public:
 		Renderer();
 
@@ -68,6 +75,17 @@ namespace Velocity {
 			m_Renderables.insert({ referenceName,m_BufferManager->AddMesh(filepath) });
 		}
 
+		// Called once an async mesh has been added to the heap
+		using MeshLoadedCallback = std::function<void(const std::string& referenceName, const BufferManager::MeshIndexer& mesh)>;
+
+		// Imports a batch of meshes on the worker pool. Pairs are (filepath, referenceName)
+		// Parsing, post processing and conversion run in parallel. Only the heap insertion and upload happen on the main thread, at the start of a later frame
+		// The futures complete on the main thread so dont block on them there, use FlushMeshLoads instead
+		std::vector<std::shared_future<BufferManager::MeshIndexer>> LoadMeshesAsync(const std::vector<std::pair<std::string, std::string>>& meshes, MeshLoadedCallback onLoaded = nullptr);
+
+		// Blocks until every queued async mesh is in the heap
+		void FlushMeshLoads() { ProcessPendingMeshLoads(true); }
+
 		// Gets the list of meshes
 		const std::unordered_map<std::string, BufferManager::MeshIndexer>& GetMeshList()
 		{
@@ -79,13 +97,55 @@ namespace Velocity {
 		// Returns a new texture. The index is what is passed into the render commands
 		uint32_t CreateTexture(const std::string& filepath, const std::string& referenceName);
 
+		// Loads a set of (filepath, referenceName) pairs. Decodes run side by side on the worker pool
+		// then every texture is uploaded with one submission and one descriptor update. Indices come back in the same order
+		std::vector<uint32_t> CreateTextures(const std::vector<std::pair<std::string, std::string>>& textures);
+
+		// Called once an async texture has been uploaded and its index points at the real image
+		using TextureLoadedCallback = std::function<void(const std::string& referenceName, uint32_t index)>;
+
+		// Decodes the texture on the worker pool and returns its index straight away
+		// The index shows the default texture (white square) until the upload finishes at the start of a later frame
+		uint32_t CreateTextureAsync(const std::string& filepath, const std::string& referenceName, TextureLoadedCallback onLoaded = nullptr);
+
+		// Blocks until every queued async texture is uploaded
+		void FlushTextureLoads() { ProcessPendingTextureLoads(true); }
+
+		// Limits how many bytes of decoded pixels can be waiting for upload. Loads past it wait their turn
+		void SetTextureLoadBudget(size_t bytes) { m_TextureLoadBudget = bytes; }
+
+		// Caps how much GPU memory textures use. Textures give up their finest mips, least recently drawn first, to stay under it
+		void SetTextureMemoryBudget(size_t bytes) { m_TextureResidency.SetBudget(bytes); }
+
+		// Bytes of texture mips currently on the GPU, not counting the default texture
+		size_t GetTextureMemoryUsage() const { return m_TextureResidency.GetResidentBytes(); }
+
+		// With streaming off textures keep whatever mips they have
+		void ToggleTextureStreaming(bool state) { m_EnableTextureStreaming = state; }
+
+		// With copies off textures, the skybox and mesh geometry free their CPU side once uploaded and saving reads them back instead
+		// Textures that have streamed mips out keep theirs, it is what they stream back in from
+		void ToggleCPUCopies(bool state);
+
+		// Bytes each part of the renderer holds. Host is system memory, device is GPU memory
+		struct MemoryUsage
+		{
+			size_t	GeometryHost = 0u;
+			size_t	GeometryDevice = 0u;
+			size_t	TextureHost = 0u;
+			size_t	TextureDevice = 0u;
+			size_t	SkyboxHost = 0u;
+			size_t	SkyboxDevice = 0u;
+		};
+		MemoryUsage GetMemoryUsage() const;
+
 		// Returns a material component
 		PBRComponent CreatePBRMaterial(const std::string& basefilepath, const std::string& extension, const std::string& referenceName, bool heightMapped);
 
 		// Returns a skybox
 		Skybox* CreateSkybox(const std::string& baseFilepath, const std::string& extension);
 
-		// Returns a HDR Skybox
+		// Returns a HDR Skybox. Its maps are built in the background, check IBLMap::IsReady before binding them
 		IBLMap* CreateHDRSkybox(const std::string& filepath);
 
 		// Gets a texture by the reference name you gave when loading it
@@ -151,6 +211,12 @@ namespace Velocity {
 			m_SeemlessViewport = state;
 		}
 
+		// Large meshes are split into clusters and culled on the GPU before drawing
+		void ToggleClusterCulling(bool state)
+		{
+			m_EnableClusterCulling = state;
+		}
+
 		// Sets the entity to have a transform gizmo drawn on it
 		void SetGizmoEntity(Entity* entity) { m_GizmoEntity = entity; }
 		// Sets how the gizmo will operate
@@ -229,9 +295,11 @@ namespace Velocity {
 		};
 
 		// Matches the UBO used to pass over light data per scene
+		// Also carries the skybox's diffuse lighting as spherical harmonics, ahead of the lights so the std140 offsets line up
 		struct PointLights
 		{
 			uint32_t												ActiveLightCount;
+			alignas(16) SHCoefficients								IrradianceSH;
 			alignas(16) std::array<PointLightComponent, MAX_LIGHTS> Lights;
 		};
 		
@@ -283,6 +351,9 @@ namespace Velocity {
 		// Creates the buffers used for uniform data
 		void CreateUniformBuffers();
 
+		// Creates the compute pass that culls the clusters of large meshes
+		void CreateClusterCuller();
+
 		// Creates the pool used to allocate descriptor sets
 		void CreateDescriptorPool();
 
@@ -386,14 +457,21 @@ namespace Velocity {
 		// Clears parts that need to change when opening a scene
 		void ClearState()
 		{
+			// Anything still importing belongs to the old scene
+			DiscardPendingMeshLoads();
+			DiscardPendingTextureLoads();
+
 			m_BufferManager->Clear();
 			m_Renderables.clear();
 
 			// Now loop textures skipping first
 			for (size_t i = 1; i < m_Textures.size(); ++i)
 			{
-				// Cleanup memory
-				delete m_Textures[i].second;
+				// Cleanup memory. Slots that never finished loading share the default texture
+				if (m_Textures[i].second != m_DefaultBindingTexture)
+				{
+					delete m_Textures[i].second;
+				}
 			}
 
 			// Now optimise the m_Textures array to be 1 big erasing all the previous entries
@@ -401,6 +479,7 @@ namespace Velocity {
 			m_TextureGUIIDs.resize(1);
 
 			m_PBRMaterials.clear();
+			m_TextureResidency.Clear();
 
 			// Reset and update texture sets to be clean
 			for (auto& info : m_TextureInfos)
@@ -416,10 +495,82 @@ namespace Velocity {
 			
 		}
 
+		// Deletes every texture not marked as used and moves the rest down over the gaps, slot 0 always stays
+		// Returns where each old index went, TextureResidency::NO_SLOT for the deleted ones. Nothing can be loading
+		std::vector<uint32_t> CompactTextures(const std::vector<bool>& used);
+
+		// A mesh import running on the worker pool
+		struct PendingMeshLoad
+		{
+			std::string												ReferenceName;
+			std::future<std::unique_ptr<BufferManager::PreparedMesh>>	Import;
+			std::promise<BufferManager::MeshIndexer>				Result;
+			MeshLoadedCallback										OnLoaded;
+		};
+
+		// Adds finished imports to the heap. Waits for all of them if wait is true
+		void ProcessPendingMeshLoads(bool wait);
+
+		// Waits out running imports and throws the results away
+		void DiscardPendingMeshLoads();
+
+		// A texture decode waiting for budget or running on the worker pool
+		struct PendingTextureLoad
+		{
+			uint32_t						Index = 0u;
+			std::string						Filepath;
+			size_t							Bytes = 0u;
+			bool							Started = false;
+			std::function<DecodedImage()>	Load;		// Runs on the pool instead of decoding Filepath when set
+			std::future<DecodedImage>		Decode;
+			TextureLoadedCallback			OnLoaded;
+		};
+
+		// Points a new slot at the default texture and queues the load behind the budget
+		uint32_t QueueTextureLoad(const std::string& filepath, const std::string& referenceName, size_t bytes, std::function<DecodedImage()> load, TextureLoadedCallback onLoaded);
+
+		// Uploads finished decodes and points their slots at them. Waits for all of them if wait is true
+		void ProcessPendingTextureLoads(bool wait);
+
+		// Starts queued decodes in order while they fit in the budget
+		void StartTextureDecodes();
+
+		// Waits out running decodes and throws the pixels away. Slots keep the default texture
+		void DiscardPendingTextureLoads();
+
+		// Starts managing the mips of a slot that now holds a real texture, or drops its CPU copy when copies are off
+		void TrackTextureResidency(uint32_t index);
+
+		// Applies what residency decided between frames
+		void UpdateTextureResidency();
+
+		// Moves HDR skyboxes that are still being built along. Waits for all of them if wait is true
+		void UpdateIBLMaps(bool wait);
+
+		// Rough diameter in pixels of the mesh's bounding sphere
+		float GetScreenSize(const glm::mat4& world, const BufferManager::MeshIndexer& mesh);
+
 		// Creates texture inplace from raw data
 		// Only for interal use
 		void CreateTexture(std::unique_ptr<stbi_uc> pixels, int width, int height,const std::string& referenceName);
 
+		// Raw pixels for one texture of a batch, or its cooked blocks
+		struct RawTexture
+		{
+			std::string						ReferenceName;
+			std::unique_ptr<stbi_uc>		Pixels;
+			int								Width = 0;
+			int								Height = 0;
+			std::unique_ptr<CookedTexture>	Cooked;
+		};
+
+		// Creates textures inplace from raw data, all uploaded together
+		// Only for interal use
+		std::vector<uint32_t> CreateTextureBatch(std::vector<RawTexture>& textures);
+
+		// Uploads textures built with upload off, then adds them to the texture array with a single descriptor update
+		std::vector<uint32_t> RegisterTextureBatch(const std::vector<std::pair<std::string, Texture*>>& textures);
+
 		Skybox* CreateSkybox(std::array<std::unique_ptr<stbi_uc>, 6>& pixels, int width, int height);
 
 		// Creates skybox from raw data
@@ -485,6 +636,9 @@ namespace Velocity {
 		// Contains the vertex and index buffers and provides interface to load into them
 		std::unique_ptr<BufferManager>			m_BufferManager;
 
+		// Culls meshlets in a compute pass and compacts the surviving indices
+		std::unique_ptr<ClusterCuller>			m_ClusterCuller;
+
 		// This structure is flushed every frame
 		// TODO: UNLESS renderer::setstatic is called ?
 		Scene*									m_ActiveScene = nullptr;
@@ -534,7 +688,7 @@ namespace Velocity {
 		// This cannot be a map as it links by index to a renderer specific thing
 		std::vector<std::pair<std::string,Texture*>>	m_Textures;
 		std::vector<vk::DescriptorImageInfo>			m_TextureInfos;
-		// List of PBR materials created. Each component has 5 indexes that index into m_Textures
+		// List of PBR materials created. Each component indexes its textures in m_Textures
 		std::unordered_map<std::string, PBRComponent>	m_PBRMaterials;
 
 		// Also store a list of id's to display the textures in imgui windows
@@ -566,10 +720,29 @@ namespace Velocity {
 
 		bool m_EnableGUI = true;
 		bool m_SeemlessViewport = true;
+		bool m_EnableClusterCulling = true;
 		
 		// Store all loaded meshes in a map so they can accessed easily
 		std::unordered_map<std::string, BufferManager::MeshIndexer> m_Renderables;
 
+		// Imports started by LoadMeshesAsync that havent reached the heap yet
+		std::vector<PendingMeshLoad> m_PendingMeshLoads;
+
+		// Textures started by CreateTextureAsync that are still showing the default texture
+		std::vector<PendingTextureLoad> m_PendingTextureLoads;
+		size_t							m_TextureBytesInFlight = 0u;
+		size_t							m_TextureLoadBudget = 512u * 1024u * 1024u;
+
+		// Which mips of each texture are on the GPU
+		TextureResidency				m_TextureResidency = TextureResidency(1024u * 1024u * 1024u);
+		bool							m_EnableTextureStreaming = true;
+
+		// See ToggleCPUCopies
+		bool							m_KeepCPUCopies = true;
+
+		// HDR skyboxes whose maps are still being built or cached
+		std::vector<IBLMap*>			m_PendingIBLMaps;
+
 		#pragma region ECS CALLBACKS
 
 		void UpdatePointlightArray();
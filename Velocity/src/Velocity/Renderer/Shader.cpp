@@ -4,6 +4,7 @@
 
 #include <Velocity/Core/Base.hpp>
 #include <Velocity/Core/Log.hpp>
+#include <Velocity/Utility/VirtualFileSystem.hpp>
 
 namespace Velocity {
 
@@ -33,30 +34,21 @@ namespace Velocity {
 
 	std::vector<char> Shader::ReadFile(const std::string& filename)
 	{
-		// Open file reading binary from the end
-		std::ifstream file;
-		file.open(filename, std::ios::ate | std::ios::binary);
+		// Comes out of a pack when one is mounted over the shaders
+		VirtualFileSystem::File file;
 
 		std::vector<char> bufferChar;
 
 		// Check it was accessed correctly
-		if (!file.is_open())
+		if (!VirtualFileSystem::Open(filename, file))
 		{
 			VEL_CORE_ERROR("Failed to open file {0}", filename);
 			VEL_CORE_ASSERT(false, "Failed to open file {0]", filename);
 			return bufferChar;
 		}
 
-		// Create a large enough buffer
-		size_t fileSize = static_cast<size_t>(file.tellg());
-		bufferChar.resize(fileSize);
-
-		// Seek back to start of file and read in one go
-		file.seekg(0);
-		file.read(bufferChar.data(), fileSize);
-
-		// Close and return 
-		file.close();
+		// Copy out in one go
+		bufferChar.assign(reinterpret_cast<const char*>(file.GetData()), reinterpret_cast<const char*>(file.GetData()) + file.GetSize());
 		return bufferChar;
 
 
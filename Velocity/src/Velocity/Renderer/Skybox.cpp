@@ -6,6 +6,7 @@
 
 #include "Velocity/Renderer/Renderer.hpp"
 #include "Velocity/Renderer/Texture.hpp"
+#include "Velocity/Utility/ThreadPool.hpp"
 
 namespace Velocity
 {
@@ -20,13 +21,19 @@ namespace Velocity
 		#pragma region LOAD IMAGE
 
 		m_IsLoadedByStbi = true;
-		
-		stbi_uc* textures[6];
-		int width, height, channels;	// SHOULD BE SAME FOR ALL IMAGES
-		for (int i = 0; i < 6; ++i)
+
+		// Decode the faces side by side on the worker pool
+		std::array<DecodedImage, 6> faces;
+		ThreadPool::Get().ParallelFor(faces.size(), [this, &faces, &basefolder, &extension](size_t i)
 		{
-			textures[i] = stbi_load(CalculateFile(basefolder, extension, i).c_str(), &width, &height, &channels,STBI_rgb_alpha);
-			m_RawPixels[i] = std::unique_ptr<stbi_uc>(textures[i]);
+			faces[i] = Texture::Decode(CalculateFile(basefolder, extension, static_cast<int>(i)));
+		});
+
+		// SHOULD BE SAME FOR ALL IMAGES
+		const int width = faces[0].Width;
+		for (size_t i = 0; i < faces.size(); ++i)
+		{
+			m_RawPixels[i] = std::unique_ptr<stbi_uc>(faces[i].Release());
 		}
 
 		m_Width = width;
@@ -100,6 +107,15 @@ namespace Velocity
 
 		r_Device->get().unmapMemory(stagingBuffer->Memory.get());
 
+		// Faces are in the same order as the cube layers
+		std::array<const uint8_t*, 6> faces;
+		for (size_t i = 0; i < faces.size(); ++i)
+		{
+			faces[i] = m_RawPixels[i].get();
+		}
+		m_IrradianceSH = SphericalHarmonics::ProjectCubemap(faces, m_Width);
+		SphericalHarmonics::ConvolveIrradiance(m_IrradianceSH);
+
 #pragma endregion
 
 #pragma region CREATE VULKAN IMAGE
@@ -140,6 +156,7 @@ namespace Velocity
 #pragma region ALLOCATE MEMORY
 
 		vk::MemoryRequirements memRequirements = r_Device->get().getImageMemoryRequirements(m_Image);
+		m_DeviceSize = memRequirements.size;
 
 		vk::MemoryAllocateInfo allocInfo = {
 			memRequirements.size,
@@ -396,17 +413,68 @@ namespace Velocity
 		r_Device->get().destroySampler(m_Sampler);
 		r_Device->get().freeMemory(m_ImageMemory);
 
-		if (m_IsLoadedByStbi)
+		ReleaseCPUCopy();
+	}
+
+	size_t Skybox::GetHostMemory() const
+	{
+		size_t size = 0u;
+		for (const auto& pixels : m_RawPixels)
 		{
-			for (auto& pixels : m_RawPixels)
+			if (pixels)
 			{
-				stbi_image_free(pixels.get());
-				pixels.release();
+				size += static_cast<size_t>(m_Width) * m_Height * 4u;
 			}
+		}
+		return size;
+	}
 
+	void Skybox::ReleaseCPUCopy()
+	{
+		for (auto& pixels : m_RawPixels)
+		{
+			if (m_IsLoadedByStbi)
+			{
+				stbi_image_free(pixels.release());
+			}
+			pixels.reset();
 		}
 	}
 
+	std::vector<uint8_t> Skybox::GetPixels()
+	{
+		const size_t layerSize = static_cast<size_t>(m_Width) * m_Height * 4u;
+
+		if (m_RawPixels[0])
+		{
+			std::vector<uint8_t> pixels(layerSize * 6u);
+			for (size_t i = 0; i < 6; ++i)
+			{
+				memcpy(pixels.data() + layerSize * i, m_RawPixels[i].get(), layerSize);
+			}
+			return pixels;
+		}
+
+		return ReadBackAsync()();
+	}
+
+	ReadbackJob Skybox::ReadBackAsync()
+	{
+		const size_t layerSize = static_cast<size_t>(m_Width) * m_Height * 4u;
+
+		// One region covers every face, layers land one after another
+		vk::BufferImageCopy region = {
+			0,
+			0,
+			0,
+			{ vk::ImageAspectFlagBits::eColor, 0, 0, 6 },
+			{ 0, 0, 0 },
+			{ m_Width, m_Height, 1 }
+		};
+		auto readback = Texture::ReadBackImage(*r_Device, r_PhysicalDevice, r_GraphicsQueueIndex, m_Image, vk::Format::eR8G8B8A8Srgb, m_MipLevels, 6, { region }, layerSize * 6u);
+		return [readback]() { return readback ? readback->Take() : std::vector<uint8_t>{}; };
+	}
+
 	
 	std::string Skybox::CalculateFile(const std::string& base, const std::string& extension, int count)
 	{
@@ -5,6 +5,8 @@
 #include <vulkan/vulkan.hpp>
 
 #include "BaseBuffer.hpp"
+#include "SphericalHarmonics.hpp"
+#include "StagingReadback.hpp"
 #include <Velocity/ECS/Components.hpp>
 
 namespace Velocity
@@ -20,18 +22,35 @@ namespace Velocity
 		// Assumes 6 images with name format "baseFilepath_front.extension" etc
         Skybox(const std::string& basefolder, const std::string& extension, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex);
 
-        ~Skybox();  
+        ~Skybox();
+
+		// Bytes of face pixels held in system memory and of the cubemap on the GPU
+		size_t GetHostMemory() const;
+		size_t GetDeviceMemory() const { return static_cast<size_t>(m_DeviceSize); }
+
+		// Diffuse lighting projected from the faces when loaded, see SphericalHarmonics
+		const SHCoefficients& GetIrradianceSH() const { return m_IrradianceSH; }
 	private:
 		Skybox(std::array<std::unique_ptr<stbi_uc>, 6>& pixels, int width, int height, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex);
 
 		void Init();
 
 		void GenerateMipmaps(vk::CommandBuffer& cmdBuffer);
+
+		// Frees the face pixels once they are on the GPU
+		void ReleaseCPUCopy();
+
+		// Level 0 of all six faces one after another, read back off the GPU if the CPU copy is gone
+		std::vector<uint8_t> GetPixels();
+
+		// As GetPixels but always off the GPU and only started here, the job waits for it on any thread
+		ReadbackJob ReadBackAsync();
 		
 		vk::Image			    m_Image;
 		vk::ImageView		    m_ImageView;
 		vk::DeviceMemory	    m_ImageMemory;
 		uint32_t				m_MipLevels;
+		vk::DeviceSize			m_DeviceSize = 0u;
 
 		vk::Sampler		        m_Sampler;
 
@@ -40,6 +59,8 @@ namespace Velocity
 
 		MeshComponent			m_SphereMesh;
 
+		SHCoefficients			m_IrradianceSH = {};
+
 		// Storing for serilisation purposes
 		uint32_t								m_Width;
 		uint32_t								m_Height;
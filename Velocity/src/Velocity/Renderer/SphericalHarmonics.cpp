@@ -0,0 +1,302 @@
+#include "velpch.h"
+
+#include "SphericalHarmonics.hpp"
+
+#include <cmath>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEL_SH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		const float PI = 3.14159265358979f;
+
+		// 9 coefficients for each of red, green and blue then the total weight
+		const size_t SUM_COUNT = 28u;
+		using Sums = std::array<double, SUM_COUNT>;
+
+		// Normalisation constants of the real basis
+		const float SH_0 = 0.282095f;
+		const float SH_1 = 0.488603f;
+		const float SH_2 = 1.092548f;
+		const float SH_3 = 0.315392f;
+		const float SH_4 = 0.546274f;
+
+		// One row of samples split into separate arrays so four can be loaded at once
+		struct Samples
+		{
+			std::vector<float> X, Y, Z, Weight, R, G, B;
+
+			void Resize(size_t count)
+			{
+				X.resize(count); Y.resize(count); Z.resize(count); Weight.resize(count);
+				R.resize(count); G.resize(count); B.resize(count);
+			}
+		};
+
+		// Each worker reuses its own so rows dont allocate
+		Samples& GetScratch(size_t count)
+		{
+			thread_local Samples samples;
+			samples.Resize(count);
+			return samples;
+		}
+
+		// Adds weighted basis times colour for every sample into sums
+		void Accumulate(const Samples& samples, size_t count, Sums& sums)
+		{
+			std::array<float, SUM_COUNT> rowSums = {};
+			size_t i = 0;
+
+#ifdef VEL_SH_SSE2
+			// Same sums as the scalar loop with one sample per lane, lanes are added together at the end
+			__m128 lanes[SUM_COUNT];
+			for (auto& lane : lanes)
+			{
+				lane = _mm_setzero_ps();
+			}
+
+			const __m128 sh0 = _mm_set1_ps(SH_0);
+			const __m128 sh1 = _mm_set1_ps(SH_1);
+			const __m128 sh2 = _mm_set1_ps(SH_2);
+			const __m128 sh3 = _mm_set1_ps(SH_3);
+			const __m128 sh4 = _mm_set1_ps(SH_4);
+			const __m128 three = _mm_set1_ps(3.0f);
+			const __m128 one = _mm_set1_ps(1.0f);
+
+			for (; i + 4u <= count; i += 4u)
+			{
+				const __m128 x = _mm_loadu_ps(samples.X.data() + i);
+				const __m128 y = _mm_loadu_ps(samples.Y.data() + i);
+				const __m128 z = _mm_loadu_ps(samples.Z.data() + i);
+				const __m128 w = _mm_loadu_ps(samples.Weight.data() + i);
+				const __m128 r = _mm_loadu_ps(samples.R.data() + i);
+				const __m128 g = _mm_loadu_ps(samples.G.data() + i);
+				const __m128 b = _mm_loadu_ps(samples.B.data() + i);
+
+				const __m128 w1 = _mm_mul_ps(w, sh1);
+				const __m128 w2 = _mm_mul_ps(w, sh2);
+				const __m128 basis[9] = {
+					_mm_mul_ps(w, sh0),
+					_mm_mul_ps(w1, y),
+					_mm_mul_ps(w1, z),
+					_mm_mul_ps(w1, x),
+					_mm_mul_ps(w2, _mm_mul_ps(x, y)),
+					_mm_mul_ps(w2, _mm_mul_ps(y, z)),
+					_mm_mul_ps(_mm_mul_ps(w, sh3), _mm_sub_ps(_mm_mul_ps(three, _mm_mul_ps(z, z)), one)),
+					_mm_mul_ps(w2, _mm_mul_ps(x, z)),
+					_mm_mul_ps(_mm_mul_ps(w, sh4), _mm_sub_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)))
+				};
+
+				for (size_t k = 0; k < 9u; ++k)
+				{
+					lanes[k] = _mm_add_ps(lanes[k], _mm_mul_ps(basis[k], r));
+					lanes[9u + k] = _mm_add_ps(lanes[9u + k], _mm_mul_ps(basis[k], g));
+					lanes[18u + k] = _mm_add_ps(lanes[18u + k], _mm_mul_ps(basis[k], b));
+				}
+				lanes[27] = _mm_add_ps(lanes[27], w);
+			}
+
+			for (size_t k = 0; k < SUM_COUNT; ++k)
+			{
+				alignas(16) float lane[4];
+				_mm_store_ps(lane, lanes[k]);
+				rowSums[k] = (lane[0] + lane[1]) + (lane[2] + lane[3]);
+			}
+#endif
+
+			for (; i < count; ++i)
+			{
+				const float x = samples.X[i];
+				const float y = samples.Y[i];
+				const float z = samples.Z[i];
+				const float w = samples.Weight[i];
+
+				const std::array<float, 9> basis = {
+					w * SH_0,
+					w * SH_1 * y,
+					w * SH_1 * z,
+					w * SH_1 * x,
+					w * SH_2 * x * y,
+					w * SH_2 * y * z,
+					w * SH_3 * (3.0f * z * z - 1.0f),
+					w * SH_2 * x * z,
+					w * SH_4 * (x * x - y * y)
+				};
+
+				for (size_t k = 0; k < 9u; ++k)
+				{
+					rowSums[k] += basis[k] * samples.R[i];
+					rowSums[9u + k] += basis[k] * samples.G[i];
+					rowSums[18u + k] += basis[k] * samples.B[i];
+				}
+				rowSums[27] += w;
+			}
+
+			for (size_t k = 0; k < SUM_COUNT; ++k)
+			{
+				sums[k] += rowSums[k];
+			}
+		}
+
+		// Adds the rows up in double and rescales so the weights cover exactly the whole sphere
+		SHCoefficients Resolve(const std::vector<Sums>& rows)
+		{
+			Sums total = {};
+			for (const auto& row : rows)
+			{
+				for (size_t k = 0; k < SUM_COUNT; ++k)
+				{
+					total[k] += row[k];
+				}
+			}
+
+			SHCoefficients coefficients = {};
+			if (total[27] <= 0.0)
+			{
+				return coefficients;
+			}
+
+			const double normalise = 4.0 * static_cast<double>(PI) / total[27];
+			for (size_t k = 0; k < 9u; ++k)
+			{
+				coefficients[k] = glm::vec4(
+					static_cast<float>(total[k] * normalise),
+					static_cast<float>(total[9u + k] * normalise),
+					static_cast<float>(total[18u + k] * normalise),
+					0.0f
+				);
+			}
+			return coefficients;
+		}
+	}
+
+	SHCoefficients SphericalHarmonics::ProjectEquirectangular(const float* rgb, uint32_t width, uint32_t height)
+	{
+		if (!rgb || width == 0u || height == 0u)
+		{
+			return {};
+		}
+
+		// Longitude only depends on the column
+		std::vector<float> cosLongitude(width);
+		std::vector<float> sinLongitude(width);
+		for (uint32_t i = 0; i < width; ++i)
+		{
+			const float longitude = ((static_cast<float>(i) + 0.5f) / static_cast<float>(width) - 0.5f) * 2.0f * PI;
+			cosLongitude[i] = std::cos(longitude);
+			sinLongitude[i] = std::sin(longitude);
+		}
+
+		const float texelArea = (2.0f * PI / static_cast<float>(width)) * (PI / static_cast<float>(height));
+
+		std::vector<Sums> rows(height, Sums{});
+		ThreadPool::Get().ParallelFor(height, [&](size_t row)
+		{
+			// Texels shrink towards the poles by the cosine of the latitude
+			const float latitude = (0.5f - (static_cast<float>(row) + 0.5f) / static_cast<float>(height)) * PI;
+			const float y = std::sin(latitude);
+			const float ring = std::cos(latitude);
+			const float weight = ring * texelArea;
+
+			Samples& samples = GetScratch(width);
+			const float* pixels = rgb + row * width * 3u;
+			for (uint32_t i = 0; i < width; ++i)
+			{
+				samples.X[i] = ring * cosLongitude[i];
+				samples.Y[i] = y;
+				samples.Z[i] = ring * sinLongitude[i];
+				samples.Weight[i] = weight;
+				samples.R[i] = pixels[i * 3u];
+				samples.G[i] = pixels[i * 3u + 1u];
+				samples.B[i] = pixels[i * 3u + 2u];
+			}
+
+			Accumulate(samples, width, rows[row]);
+		});
+
+		return Resolve(rows);
+	}
+
+	SHCoefficients SphericalHarmonics::ProjectCubemap(const std::array<const uint8_t*, 6>& faces, uint32_t size)
+	{
+		for (const uint8_t* face : faces)
+		{
+			if (!face)
+			{
+				return {};
+			}
+		}
+		if (size == 0u)
+		{
+			return {};
+		}
+
+		// Faces are sRGB, the sums need linear light
+		std::array<float, 256> toLinear;
+		for (size_t i = 0; i < toLinear.size(); ++i)
+		{
+			const float value = static_cast<float>(i) / 255.0f;
+			toLinear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+		}
+
+		std::vector<Sums> rows(static_cast<size_t>(size) * 6u, Sums{});
+		ThreadPool::Get().ParallelFor(rows.size(), [&](size_t row)
+		{
+			const size_t face = row / size;
+			const float v = (static_cast<float>(row % size) + 0.5f) / static_cast<float>(size) * 2.0f - 1.0f;
+
+			Samples& samples = GetScratch(size);
+			const uint8_t* pixels = faces[face] + (row % size) * size * 4u;
+			for (uint32_t i = 0; i < size; ++i)
+			{
+				const float u = (static_cast<float>(i) + 0.5f) / static_cast<float>(size) * 2.0f - 1.0f;
+
+				// Same face orientation as GetCubeDirection in ibl/common.glsl
+				float x, y, z;
+				switch (face)
+				{
+				case 0: x = 1.0f; y = -v; z = -u; break;
+				case 1: x = -1.0f; y = -v; z = u; break;
+				case 2: x = u; y = 1.0f; z = v; break;
+				case 3: x = u; y = -1.0f; z = -v; break;
+				case 4: x = u; y = -v; z = 1.0f; break;
+				default: x = -u; y = -v; z = -1.0f; break;
+				}
+
+				// Solid angle of the texel, they get smaller towards the face edges
+				const float lengthSquared = 1.0f + u * u + v * v;
+				const float inverseLength = 1.0f / std::sqrt(lengthSquared);
+
+				samples.X[i] = x * inverseLength;
+				samples.Y[i] = y * inverseLength;
+				samples.Z[i] = z * inverseLength;
+				samples.Weight[i] = inverseLength / lengthSquared;
+				samples.R[i] = toLinear[pixels[i * 4u]];
+				samples.G[i] = toLinear[pixels[i * 4u + 1u]];
+				samples.B[i] = toLinear[pixels[i * 4u + 2u]];
+			}
+
+			Accumulate(samples, size, rows[row]);
+		});
+
+		return Resolve(rows);
+	}
+
+	void SphericalHarmonics::ConvolveIrradiance(SHCoefficients& coefficients)
+	{
+		// Cosine lobe per band is PI, 2PI/3 and PI/4 (Ramamoorthi & Hanrahan). Dividing by PI leaves the diffuse BRDF to albedo
+		const std::array<float, 9> bands = { 1.0f, 2.0f / 3.0f, 2.0f / 3.0f, 2.0f / 3.0f, 0.25f, 0.25f, 0.25f, 0.25f, 0.25f };
+		for (size_t k = 0; k < coefficients.size(); ++k)
+		{
+			coefficients[k] *= bands[k];
+		}
+	}
+}
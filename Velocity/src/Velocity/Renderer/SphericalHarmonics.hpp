@@ -0,0 +1,31 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/vec4.hpp>
+
+namespace Velocity
+{
+	// Third order spherical harmonics of an environment, one RGB triple per coefficient
+	// vec4 so the array drops straight into a std140 uniform block, w is unused
+	using SHCoefficients = std::array<glm::vec4, 9>;
+
+	// Projects environments into spherical harmonics on the CPU for cheap diffuse lighting
+	// Images are split by row across the worker pool and each row is summed four samples at a time with SSE2 where available
+	// Basis order and constants match IrradianceSH in pbr.frag
+	class SphericalHarmonics
+	{
+	public:
+		// Tightly packed RGB float pixels laid out like ibl/equirecttocube.comp expects, top row straight up
+		static SHCoefficients ProjectEquirectangular(const float* rgb, uint32_t width, uint32_t height);
+
+		// Six square RGBA8 sRGB faces in Vulkan layer order (+X, -X, +Y, -Y, +Z, -Z)
+		static SHCoefficients ProjectCubemap(const std::array<const uint8_t*, 6>& faces, uint32_t size);
+
+		// Convolves projected radiance with the cosine lobe and divides by PI
+		// Evaluating the result at a normal gives the diffuse light to multiply albedo by
+		static void ConvolveIrradiance(SHCoefficients& coefficients);
+	};
+}
@@ -0,0 +1,109 @@
+#include "velpch.h"
+
+#include "StagingReadback.hpp"
+
+#include <limits>
+
+#include <Velocity/Core/Log.hpp>
+
+namespace Velocity
+{
+	StagingReadback::StagingReadback(vk::PhysicalDevice& pDevice, vk::UniqueDevice& device, uint32_t queueIndex, vk::DeviceSize size)
+	{
+		r_Device = &device;
+		m_QueueIndex = queueIndex;
+		m_Size = size;
+
+		// Zero sized buffers arent allowed, an empty read back still gets a byte
+		m_Staging = std::make_unique<BaseBuffer>(
+			pDevice,
+			device,
+			std::max<vk::DeviceSize>(size, 1u),
+			vk::BufferUsageFlagBits::eTransferDst,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+		try
+		{
+			m_Pool = device->createCommandPoolUnique({ vk::CommandPoolCreateFlagBits::eTransient, queueIndex });
+			m_CommandBuffer = std::move(device->allocateCommandBuffersUnique({ m_Pool.get(), vk::CommandBufferLevel::ePrimary, 1 }).front());
+			m_Fence = device->createFenceUnique({});
+			m_CommandBuffer->begin({ vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+		}
+		catch (vk::SystemError& e)
+		{
+			VEL_CORE_ERROR("Failed to start a read back! Error: {0}", e.what());
+			VEL_CORE_ASSERT(false, "Failed to start a read back! Error: {0}", e.what());
+		}
+	}
+
+	StagingReadback::~StagingReadback()
+	{
+		if (m_bSubmitted)
+		{
+			(void)(*r_Device)->waitForFences(1, &m_Fence.get(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+		}
+		if (m_Mapped)
+		{
+			(*r_Device)->unmapMemory(m_Staging->Memory.get());
+		}
+	}
+
+	bool StagingReadback::Submit()
+	{
+		if (!m_CommandBuffer || m_bSubmitted)
+		{
+			return false;
+		}
+		m_CommandBuffer->end();
+
+		vk::SubmitInfo submitInfo = {
+			{},{},{},1,&m_CommandBuffer.get(),{},{}
+		};
+
+		vk::Queue queue = (*r_Device)->getQueue(m_QueueIndex, 0);
+		vk::Result result = queue.submit(1, &submitInfo, m_Fence.get());
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("A read back failed to submit! Please check log!");
+			return false;
+		}
+		m_bSubmitted = true;
+		return true;
+	}
+
+	const uint8_t* StagingReadback::Wait()
+	{
+		if (m_Mapped || !m_bSubmitted)
+		{
+			return m_Mapped;
+		}
+
+		vk::Result result = (*r_Device)->waitForFences(1, &m_Fence.get(), VK_TRUE, std::numeric_limits<uint64_t>::max());
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to wait for a read back!");
+			return nullptr;
+		}
+
+		void* data;
+		result = (*r_Device)->mapMemory(m_Staging->Memory.get(), 0, m_Staging->Size, vk::MemoryMapFlags{}, &data);
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to read back (Failed to map memory)");
+			return nullptr;
+		}
+		m_Mapped = static_cast<const uint8_t*>(data);
+		return m_Mapped;
+	}
+
+	std::vector<uint8_t> StagingReadback::Take()
+	{
+		const uint8_t* data = Wait();
+		if (!data)
+		{
+			return {};
+		}
+		return std::vector<uint8_t>(data, data + static_cast<size_t>(m_Size));
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include <vulkan/vulkan.hpp>
+
+#include "BaseBuffer.hpp"
+
+namespace Velocity
+{
+	// Copies GPU memory back into host visible staging memory without waiting for it
+	// Recorded and submitted on the main thread like any other submission. Wait then blocks on its own fence, so
+	// whoever needs the bytes, usually a worker, waits instead of the frame
+	// Has its own command pool so it can be finished and destroyed on any thread
+	class StagingReadback
+	{
+	public:
+		// Allocates size bytes of staging memory and starts recording into its command buffer
+		StagingReadback(vk::PhysicalDevice& pDevice, vk::UniqueDevice& device, uint32_t queueIndex, vk::DeviceSize size);
+
+		// Waits for the copy if it was submitted, the GPU may still be writing the staging memory
+		~StagingReadback();
+
+		StagingReadback(const StagingReadback&) = delete;
+		StagingReadback& operator=(const StagingReadback&) = delete;
+
+		// Record copies into GetStaging here before Submit
+		vk::CommandBuffer& GetBuffer() { return m_CommandBuffer.get(); }
+		vk::Buffer GetStaging() const { return m_Staging->Buffer.get(); }
+		vk::DeviceSize GetSize() const { return m_Size; }
+
+		// Ends recording and submits to the first queue of the family. Main thread only, returns false if it failed
+		bool Submit();
+
+		// Blocks until the copy is done and returns the staging memory, mapped until this is destroyed
+		// Any thread, but only one at a time. nullptr if it was never submitted or the copy failed
+		const uint8_t* Wait();
+
+		// Waits as above and copies all size bytes out. Empty if the copy failed
+		std::vector<uint8_t> Take();
+
+	private:
+		vk::UniqueDevice*					r_Device;
+		uint32_t							m_QueueIndex;
+		vk::DeviceSize						m_Size;
+
+		std::unique_ptr<BaseBuffer>			m_Staging;
+		vk::UniqueCommandPool				m_Pool;
+		vk::UniqueCommandBuffer				m_CommandBuffer;
+		vk::UniqueFence						m_Fence;
+
+		bool								m_bSubmitted = false;
+		const uint8_t*						m_Mapped = nullptr;
+	};
+
+	// Finishes a read back started on the main thread and returns its bytes. Call it once, on any thread
+	// Empty if the read back failed
+	using ReadbackJob = std::function<std::vector<uint8_t>()>;
+}
@@ -4,37 +4,99 @@
 #include <Velocity/Core/Log.hpp>
 
 #include <Velocity/Renderer/BaseBuffer.hpp>
+#include <Velocity/Renderer/TextureCooker.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+#include <Velocity/Utility/VirtualFileSystem.hpp>
 
 namespace Velocity
 {
 	// creates a texture from a file on the pc
 	Texture::Texture(const std::string& filepath, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex)
+		: Texture(Decode(filepath), filepath, device, pDevice, pool, graphicsQueueIndex)
+	{
+	}
+
+	// Pre decoded constructor
+	Texture::Texture(DecodedImage&& image, const std::string& filepath, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex, bool upload)
 	{
 		r_Device = &device;
 		r_PhysicalDevice = pDevice;
 		r_GraphicsQueueIndex = graphicsQueueIndex;
 		r_Pool = pool;
-		
-		int width, height, channels;
-		m_RawPixels = std::unique_ptr<stbi_uc>(
-			stbi_load(filepath.c_str(), &width, &height, &channels, STBI_rgb_alpha)
-		);
+
+		m_FilePath = filepath;
+
+		// Cooked files already have their format and every mip
+		if (image.Cooked)
+		{
+			m_Cooked = std::move(image.Cooked);
+			m_IsLoadedByStbi = false;
+			m_CurrentFormat = m_Cooked->GetVulkanFormat();
+			m_MipLevels = static_cast<uint32_t>(m_Cooked->Mips.size());
+			m_Width = m_Cooked->Width;
+			m_Height = m_Cooked->Height;
+
+			Init(upload);
+			return;
+		}
+
+		const int width = image.Width;
+		const int height = image.Height;
+		m_RawPixels = std::unique_ptr<stbi_uc>(image.Release());
 
 		m_IsLoadedByStbi = true;
 
+		m_CurrentFormat = vk::Format::eR8G8B8A8Srgb;
 		m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max<int>(width, height)))) + 1;
 
-		m_FilePath = filepath;
 		m_Width = static_cast<uint32_t>(width);
 		m_Height = static_cast<uint32_t>(height);
 
-		Init();
-		
+		Init(upload);
+	}
+
+	// Only stbi is used here so this is fine off the main thread
+	DecodedImage Texture::Decode(const std::string& filepath)
+	{
+		DecodedImage image;
+
+		if (CookedTexture::IsCookedPath(filepath))
+		{
+			image.Cooked = std::make_unique<CookedTexture>();
+			if (CookedTexture::Load(filepath, *image.Cooked))
+			{
+				image.Width = static_cast<int>(image.Cooked->Width);
+				image.Height = static_cast<int>(image.Cooked->Height);
+			}
+			else
+			{
+				image.Cooked.reset();
+			}
+			return image;
+		}
+
+		// Decoded straight out of the pack or the mapped file
+		VirtualFileSystem::File file;
+		if (!VirtualFileSystem::Open(filepath, file))
+		{
+			return image;
+		}
+
+		int channels;
+		image.Pixels = stbi_load_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &image.Width, &image.Height, &channels, STBI_rgb_alpha);
+		return image;
+	}
+
+	bool Texture::GetInfo(const std::string& filepath, int& outWidth, int& outHeight)
+	{
+		VirtualFileSystem::File file;
+		int channels;
+		return VirtualFileSystem::Open(filepath, file) && stbi_info_from_memory(file.GetData(), static_cast<int>(file.GetSize()), &outWidth, &outHeight, &channels) != 0;
 	}
 
 	// Private constructor
 	Texture::Texture(std::unique_ptr<stbi_uc> pixels, int width, int height, vk::UniqueDevice& device,
-		vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex)
+		vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex, bool upload)
 	{
 		r_Device = &device;
 		r_PhysicalDevice = pDevice;
@@ -45,6 +107,7 @@ namespace Velocity
 
 		m_IsLoadedByStbi = false;
 
+		m_CurrentFormat = vk::Format::eR8G8B8A8Srgb;
 		m_MipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max<int>(width, height)))) + 1;
 
 		// TODO: Check this 
@@ -52,56 +115,51 @@ namespace Velocity
 		m_Width = static_cast<uint32_t>(width);
 		m_Height = static_cast<uint32_t>(height);
 
-		Init();
+		Init(upload);
 	}
 
-	void Texture::Init()
+	void Texture::Init(bool upload)
 	{
-		// 4 bytes per pixel for 32 bit images
-		VkDeviceSize imageSize = m_Width * m_Height * 4;
-
-		if (!m_RawPixels)
+		if (!m_RawPixels && !m_Cooked)
 		{
 			VEL_CORE_ERROR("Failed to load texture image!");
 			VEL_CORE_ASSERT(false, "Failed to load texture image!");
 			return;
 		}
 
-		// Create staging buffer
-		std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
-			r_PhysicalDevice,
-			*r_Device,
-			imageSize,
-			vk::BufferUsageFlagBits::eTransferSrc,
-			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-			);
-
-		void* data;
-		auto result = r_Device->get().mapMemory(stagingBuffer->Memory.get(), 0, imageSize, vk::MemoryMapFlags{}, &data);
-		if (result != vk::Result::eSuccess)
+		if (m_Cooked)
 		{
-			VEL_CORE_ASSERT(false, "Failed to load texture file: {0} (Failed to map memory)", filepath);
-			VEL_CORE_ERROR("Failed to load texture file: {0} (Failed to map memory)", m_FilePath);
-			return;
+			vk::FormatProperties formatProperties = r_PhysicalDevice.getFormatProperties(m_CurrentFormat);
+			if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImage))
+			{
+				VEL_CORE_ERROR("Failed to load texture file: {0} (GPU doesn't support its block compressed format)", m_FilePath);
+				VEL_CORE_ASSERT(false, "Failed to load texture file: {0} (GPU doesn't support its block compressed format)", m_FilePath);
+				return;
+			}
 		}
 
-		memcpy(data, m_RawPixels.get(), static_cast<size_t>(imageSize));
-
-		r_Device->get().unmapMemory(stagingBuffer->Memory.get());
+		CreateImage();
 
-#pragma endregion
+		// Batched textures are uploaded together later by UploadBatch
+		if (upload)
+		{
+			Upload();
+		}
+	}
 
+	// Image, memory and view. Contents are left undefined
+	void Texture::CreateImage()
+	{
 #pragma region CREATE VULKAN IMAGE
 
-		m_CurrentFormat = vk::Format::eR8G8B8A8Srgb;
 		m_CurrentLayout = vk::ImageLayout::eUndefined;
 
 		vk::ImageCreateInfo imageInfo = {
 			vk::ImageCreateFlags{},
 			vk::ImageType::e2D,
 			m_CurrentFormat,
-			vk::Extent3D{m_Width,m_Height,1},
-			m_MipLevels,
+			vk::Extent3D{GetResidentWidth(),GetResidentHeight(),1},
+			GetResidentLevels(),
 			1,
 			vk::SampleCountFlagBits::e1,
 			vk::ImageTiling::eOptimal,
@@ -153,30 +211,6 @@ namespace Velocity
 		// Bind the image memory
 		r_Device->get().bindImageMemory(m_Image.get(), m_ImageMemory.get(), 0);
 
-#pragma region PROCESS RAW TO VULKAN
-
-		{
-			vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
-			TemporaryCommandBuffer processBufferWrapper = TemporaryCommandBuffer(*r_Device, r_Pool, queue);
-			auto& processBuffer = processBufferWrapper.GetBuffer();
-
-			// Set this image to destination optimal
-			TransitionImageLayout(processBuffer, vk::ImageLayout::eTransferDstOptimal);
-
-			// Copy buffer
-			CopyBufferToImage(processBuffer, stagingBuffer->Buffer.get(), m_Width, m_Height);
-		}
-
-		{
-			vk::Queue queue = r_Device->get().getQueue(r_GraphicsQueueIndex, 0);
-			TemporaryCommandBuffer processBufferWrapper = TemporaryCommandBuffer(*r_Device, r_Pool, queue);
-			auto& processBuffer = processBufferWrapper.GetBuffer();
-			// Mipmap (also transfers to shader layout)
-			GenerateMipmaps(processBuffer);
-		}
-
-#pragma endregion
-
 #pragma region CREATE IMAGE VIEW
 
 		vk::ImageViewCreateInfo viewInfo = {
@@ -189,7 +223,7 @@ namespace Velocity
 			{
 				vk::ImageAspectFlagBits::eColor,
 				0,
-				m_MipLevels,
+				GetResidentLevels(),
 				0,
 				1
 			}
@@ -208,6 +242,248 @@ namespace Velocity
 #pragma endregion
 	}
 
+	// A batch of one, still a single submission
+	void Texture::Upload()
+	{
+		UploadBatch({ this });
+	}
+
+	std::vector<size_t> Texture::GetMipSizes() const
+	{
+		std::vector<size_t> sizes(m_MipLevels);
+		for (uint32_t level = 0; level < m_MipLevels; ++level)
+		{
+			if (m_Cooked)
+			{
+				sizes[level] = static_cast<size_t>(m_Cooked->Mips[level].Size);
+			}
+			else
+			{
+				sizes[level] = static_cast<size_t>(std::max<uint32_t>(m_Width >> level, 1u)) * std::max<uint32_t>(m_Height >> level, 1u) * 4u;
+			}
+		}
+		return sizes;
+	}
+
+	bool Texture::HasCPUCopy() const
+	{
+		return m_Cooked ? !m_Cooked->Data.empty() : m_RawPixels != nullptr;
+	}
+
+	size_t Texture::GetHostMemory() const
+	{
+		size_t size = m_StreamPixels.capacity();
+		if (m_Cooked)
+		{
+			size += m_Cooked->Data.capacity();
+		}
+		else if (m_RawPixels)
+		{
+			size += static_cast<size_t>(m_Width) * m_Height * 4u;
+		}
+		return size;
+	}
+
+	// Cooked textures keep their mip table so the GPU copy can still be described and read back
+	void Texture::ReleaseCPUCopy()
+	{
+		if (m_Cooked)
+		{
+			std::vector<uint8_t>().swap(m_Cooked->Data);
+			return;
+		}
+
+		if (m_IsLoadedByStbi)
+		{
+			stbi_image_free(m_RawPixels.release());
+		}
+		m_RawPixels.reset();
+	}
+
+	std::vector<uint8_t> Texture::GetPixels()
+	{
+		if (m_RawPixels)
+		{
+			return std::vector<uint8_t>(m_RawPixels.get(), m_RawPixels.get() + static_cast<size_t>(m_Width) * m_Height * 4u);
+		}
+
+		auto readback = ReadBack({ GetPixelRegion() }, static_cast<vk::DeviceSize>(m_Width) * m_Height * 4u);
+		return readback ? readback->Take() : std::vector<uint8_t>{};
+	}
+
+	std::vector<uint8_t> Texture::SerialiseCooked()
+	{
+		if (HasCPUCopy())
+		{
+			return m_Cooked->Serialise();
+		}
+
+		// The file it came from is the cheapest place to get the blocks again, as long as it hasnt been recooked since
+		CookedTexture cooked;
+		if (CookedTexture::IsCookedPath(m_FilePath) && CookedTexture::Load(m_FilePath, cooked) &&
+			cooked.Format == m_Cooked->Format && cooked.Width == m_Width && cooked.Height == m_Height && cooked.Mips.size() == m_Cooked->Mips.size())
+		{
+			return cooked.Serialise();
+		}
+
+		// Otherwise copy every level back into the layout the mip table describes
+		vk::DeviceSize size = 0u;
+		auto readback = ReadBack(GetCookedRegions(size), size);
+
+		cooked.Format = m_Cooked->Format;
+		cooked.Srgb = m_Cooked->Srgb;
+		cooked.Width = m_Width;
+		cooked.Height = m_Height;
+		cooked.Mips = m_Cooked->Mips;
+		cooked.Data = readback ? readback->Take() : std::vector<uint8_t>{};
+		return cooked.Serialise();
+	}
+
+	ReadbackJob Texture::ReadBackAsync()
+	{
+		if (m_ResidentMip != 0u)
+		{
+			auto bytes = std::make_shared<std::vector<uint8_t>>(m_Cooked ? SerialiseCooked() : GetPixels());
+			return [bytes]() { return std::move(*bytes); };
+		}
+
+		// The GPU always has every level here, so the CPU copy isnt touched
+		if (!m_Cooked)
+		{
+			auto readback = ReadBack({ GetPixelRegion() }, static_cast<vk::DeviceSize>(m_Width) * m_Height * 4u);
+			return [readback]() { return readback ? readback->Take() : std::vector<uint8_t>{}; };
+		}
+
+		vk::DeviceSize size = 0u;
+		auto readback = ReadBack(GetCookedRegions(size), size);
+		auto cooked = std::make_shared<CookedTexture>();
+		cooked->Format = m_Cooked->Format;
+		cooked->Srgb = m_Cooked->Srgb;
+		cooked->Width = m_Width;
+		cooked->Height = m_Height;
+		cooked->Mips = m_Cooked->Mips;
+		return [readback, cooked]()
+		{
+			if (!readback)
+			{
+				return std::vector<uint8_t>{};
+			}
+			cooked->Data = readback->Take();
+			return cooked->Data.empty() ? std::vector<uint8_t>{} : cooked->Serialise();
+		};
+	}
+
+	vk::BufferImageCopy Texture::GetPixelRegion() const
+	{
+		return {
+			0,
+			0,
+			0,
+			{ vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+			{ 0, 0, 0 },
+			{ m_Width, m_Height, 1 }
+		};
+	}
+
+	std::vector<vk::BufferImageCopy> Texture::GetCookedRegions(vk::DeviceSize& outSize) const
+	{
+		std::vector<vk::BufferImageCopy> regions;
+		outSize = 0u;
+		for (uint32_t level = 0; level < m_MipLevels; ++level)
+		{
+			const auto& mip = m_Cooked->Mips[level];
+			regions.push_back({
+				mip.Offset,
+				0,
+				0,
+				{ vk::ImageAspectFlagBits::eColor, level, 0, 1 },
+				{ 0, 0, 0 },
+				{ mip.Width, mip.Height, 1 }
+			});
+			outSize = std::max<vk::DeviceSize>(outSize, mip.Offset + mip.Size);
+		}
+		return regions;
+	}
+
+	// Only levels on the GPU can be read, so this needs every mip resident
+	std::shared_ptr<StagingReadback> Texture::ReadBack(const std::vector<vk::BufferImageCopy>& regions, vk::DeviceSize size)
+	{
+		if (m_ResidentMip != 0u)
+		{
+			VEL_CORE_ERROR("Failed to read back texture: {0} (Finest mips are not resident)", m_FilePath);
+			VEL_CORE_ASSERT(false, "Failed to read back texture: {0} (Finest mips are not resident)", m_FilePath);
+			return nullptr;
+		}
+
+		return ReadBackImage(*r_Device, r_PhysicalDevice, r_GraphicsQueueIndex, m_Image.get(), m_CurrentFormat, m_MipLevels, 1, regions, size);
+	}
+
+	std::shared_ptr<StagingReadback> Texture::ReadBackImage(vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, uint32_t queueIndex, vk::Image image, vk::Format format,
+		uint32_t mipLevels, uint32_t layerCount, const std::vector<vk::BufferImageCopy>& regions, vk::DeviceSize size)
+	{
+		// Later submissions on the queue see the image back in shader read layout, so nothing has to wait for this
+		auto readback = std::make_shared<StagingReadback>(pDevice, device, queueIndex, size);
+		auto& processBuffer = readback->GetBuffer();
+		vk::Buffer staging = readback->GetStaging();
+
+		TransitionImageLayout(processBuffer, image, format, vk::ImageLayout::eShaderReadOnlyOptimal, vk::ImageLayout::eTransferSrcOptimal, mipLevels, layerCount);
+		processBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, staging, static_cast<uint32_t>(regions.size()), regions.data());
+		TransitionImageLayout(processBuffer, image, format, vk::ImageLayout::eTransferSrcOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, mipLevels, layerCount);
+
+		if (!readback->Submit())
+		{
+			VEL_CORE_ERROR("Failed to read back image (Failed to submit)");
+			return nullptr;
+		}
+		return readback;
+	}
+
+	// Cooked textures already have every level, raw ones are filtered down on the pool first
+	void Texture::SetResidentMips(const std::vector<std::pair<Texture*, uint32_t>>& textures)
+	{
+		if (textures.empty())
+		{
+			return;
+		}
+
+		ThreadPool::Get().ParallelFor(textures.size(), [&textures](size_t i)
+		{
+			Texture* texture = textures[i].first;
+			const uint32_t mip = std::min<uint32_t>(textures[i].second, texture->m_MipLevels - 1u);
+			if (!texture->m_Cooked && mip > 0u)
+			{
+				// Same filtering as the blits, raw textures are always sRGB
+				texture->m_StreamPixels = TextureCooker::BuildMip(texture->m_RawPixels.get(), texture->m_Width, texture->m_Height, mip, TextureUsage::Albedo);
+			}
+		});
+
+		// Old images stay alive until the upload below has idled the queue, frames in flight may still be sampling them
+		std::vector<vk::UniqueImageView> oldViews;
+		std::vector<vk::UniqueImage> oldImages;
+		std::vector<vk::UniqueDeviceMemory> oldMemory;
+
+		std::vector<Texture*> uploads;
+		uploads.reserve(textures.size());
+		for (const auto& [texture, mip] : textures)
+		{
+			oldViews.push_back(std::move(texture->m_ImageView));
+			oldImages.push_back(std::move(texture->m_Image));
+			oldMemory.push_back(std::move(texture->m_ImageMemory));
+
+			texture->m_ResidentMip = std::min<uint32_t>(mip, texture->m_MipLevels - 1u);
+			texture->CreateImage();
+			uploads.push_back(texture);
+		}
+
+		UploadBatch(uploads);
+
+		for (Texture* texture : uploads)
+		{
+			texture->m_StreamPixels.clear();
+			texture->m_StreamPixels.shrink_to_fit();
+		}
+	}
+
 	void Texture::TransitionImageLayout(vk::CommandBuffer& buffer, vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t miplevels, uint32_t layerCount)
 	{
 		vk::ImageMemoryBarrier barrier = {
@@ -256,6 +532,14 @@ namespace Velocity
 			destStage = vk::PipelineStageFlagBits::eTransfer;
 			
 		}
+		else if (oldLayout == vk::ImageLayout::eTransferSrcOptimal && newLayout == vk::ImageLayout::eShaderReadOnlyOptimal)
+		{
+			barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+			barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+
+			sourceStage = vk::PipelineStageFlagBits::eTransfer;
+			destStage = vk::PipelineStageFlagBits::eFragmentShader;
+		}
 		else if (oldLayout == vk::ImageLayout::eTransferDstOptimal && newLayout == vk::ImageLayout::ePresentSrcKHR)
 		{
 			barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
@@ -282,10 +566,10 @@ namespace Velocity
 		);
 	}
 	
-	void Texture::CopyBufferToImage(vk::CommandBuffer& cmdBuffer, vk::Image image, vk::Buffer& buffer, uint32_t width, uint32_t height, uint32_t layerCount)
+	void Texture::CopyBufferToImage(vk::CommandBuffer& cmdBuffer, vk::Image image, vk::Buffer& buffer, uint32_t width, uint32_t height, uint32_t layerCount, vk::DeviceSize bufferOffset)
 	{
 		vk::BufferImageCopy region = {
-			0,
+			bufferOffset,
 			0,
 			0,
 			{
@@ -426,6 +710,259 @@ namespace Velocity
 		
 	}
 
+	namespace
+	{
+		// Staging offsets are kept to this, a multiple of every texel and block size and the usual optimal copy alignment
+		const vk::DeviceSize BATCH_STAGING_ALIGNMENT = 16u;
+
+		vk::ImageMemoryBarrier MipBarrier(vk::Image image, uint32_t baseMip, uint32_t mipCount, vk::ImageLayout oldLayout, vk::ImageLayout newLayout,
+			vk::AccessFlags srcAccess, vk::AccessFlags dstAccess)
+		{
+			return vk::ImageMemoryBarrier{
+				srcAccess,
+				dstAccess,
+				oldLayout,
+				newLayout,
+				VK_QUEUE_FAMILY_IGNORED,
+				VK_QUEUE_FAMILY_IGNORED,
+				image,
+				{
+					vk::ImageAspectFlagBits::eColor,
+					baseMip,
+					mipCount,
+					0,
+					1
+				}
+			};
+		}
+	}
+
+	// Every texture shares one staging buffer and one submission
+	// Raw textures get their mips generated level by level so each step is a single barrier covering all of them
+	// Cooked textures copy every mip straight in and skip the blits
+	void Texture::UploadBatch(const std::vector<Texture*>& textures)
+	{
+		if (textures.empty())
+		{
+			return;
+		}
+
+		Texture& first = *textures.front();
+		vk::UniqueDevice& device = *first.r_Device;
+
+		// Raw textures share the format so one check covers them all
+		std::vector<Texture*> generated;
+		for (Texture* texture : textures)
+		{
+			if (!texture->m_Cooked)
+			{
+				generated.push_back(texture);
+			}
+		}
+
+		if (!generated.empty())
+		{
+			vk::FormatProperties formatProperties = first.r_PhysicalDevice.getFormatProperties(generated.front()->m_CurrentFormat);
+			if (!(formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear))
+			{
+				VEL_CORE_ERROR("Texture doesn't support mipmap generation!");
+				VEL_CORE_ASSERT(false, "Texture doesn't support mipmap generation!");
+				return;
+			}
+		}
+
+		// Only the resident levels go up. Cooked mips are stored finest first so theyre the tail of the data
+		auto getUploadOffset = [](const Texture* texture)
+		{
+			return texture->m_Cooked ? static_cast<vk::DeviceSize>(texture->m_Cooked->Mips[texture->m_ResidentMip].Offset) : 0u;
+		};
+		auto getUploadSize = [&getUploadOffset](const Texture* texture)
+		{
+			return texture->m_Cooked ? static_cast<vk::DeviceSize>(texture->m_Cooked->Data.size()) - getUploadOffset(texture) :
+				static_cast<vk::DeviceSize>(texture->GetResidentWidth()) * texture->GetResidentHeight() * 4u;
+		};
+		auto getUploadSource = [&getUploadOffset](const Texture* texture)
+		{
+			if (texture->m_Cooked)
+			{
+				return static_cast<const void*>(texture->m_Cooked->Data.data() + getUploadOffset(texture));
+			}
+			return texture->m_ResidentMip > 0u ? static_cast<const void*>(texture->m_StreamPixels.data()) : static_cast<const void*>(texture->m_RawPixels.get());
+		};
+
+#pragma region CREATE STAGING BUFFER
+
+		std::vector<vk::DeviceSize> offsets(textures.size());
+		vk::DeviceSize totalSize = 0u;
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			totalSize = (totalSize + BATCH_STAGING_ALIGNMENT - 1u) & ~(BATCH_STAGING_ALIGNMENT - 1u);
+			offsets[i] = totalSize;
+			totalSize += getUploadSize(textures[i]);
+		}
+
+		// Declared before the command buffer so it outlives the submission
+		std::unique_ptr<BaseBuffer> stagingBuffer = std::make_unique<BaseBuffer>(
+			first.r_PhysicalDevice,
+			device,
+			totalSize,
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+			);
+
+		void* data;
+		auto result = device->mapMemory(stagingBuffer->Memory.get(), 0, totalSize, vk::MemoryMapFlags{}, &data);
+		if (result != vk::Result::eSuccess)
+		{
+			VEL_CORE_ERROR("Failed to upload texture batch! (Failed to map memory)");
+			VEL_CORE_ASSERT(false, "Failed to upload texture batch! (Failed to map memory)");
+			return;
+		}
+
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			memcpy(static_cast<char*>(data) + offsets[i], getUploadSource(textures[i]), static_cast<size_t>(getUploadSize(textures[i])));
+		}
+
+		device->unmapMemory(stagingBuffer->Memory.get());
+
+#pragma endregion
+
+#pragma region PROCESS RAW TO VULKAN
+
+		vk::Queue queue = device->getQueue(first.r_GraphicsQueueIndex, 0);
+		TemporaryCommandBuffer processBufferWrapper = TemporaryCommandBuffer(device, first.r_Pool, queue);
+		auto& processBuffer = processBufferWrapper.GetBuffer();
+
+		std::vector<vk::ImageMemoryBarrier> barriers;
+		barriers.reserve(textures.size());
+
+		auto submitBarriers = [&processBuffer, &barriers](vk::PipelineStageFlags sourceStage, vk::PipelineStageFlags destStage)
+		{
+			if (!barriers.empty())
+			{
+				processBuffer.pipelineBarrier(sourceStage, destStage, vk::DependencyFlags{}, 0, nullptr, 0, nullptr, static_cast<uint32_t>(barriers.size()), barriers.data());
+			}
+		};
+
+		// 1. Every mip of every image to transfer dst
+		for (Texture* texture : textures)
+		{
+			barriers.push_back(MipBarrier(texture->m_Image.get(), 0, texture->GetResidentLevels(), vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal,
+				vk::AccessFlags{}, vk::AccessFlagBits::eTransferWrite));
+		}
+		submitBarriers(vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer);
+
+		// 2. Copy each texture from its slice of the staging buffer. Cooked ones copy every level
+		std::vector<vk::BufferImageCopy> regions;
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			Texture* texture = textures[i];
+			if (!texture->m_Cooked)
+			{
+				CopyBufferToImage(processBuffer, texture->m_Image.get(), stagingBuffer->Buffer.get(), texture->GetResidentWidth(), texture->GetResidentHeight(), 1, offsets[i]);
+				continue;
+			}
+
+			regions.clear();
+			const vk::DeviceSize baseOffset = getUploadOffset(texture);
+			for (uint32_t level = 0; level < texture->GetResidentLevels(); ++level)
+			{
+				const CookedMip& mip = texture->m_Cooked->Mips[texture->m_ResidentMip + level];
+				regions.push_back(vk::BufferImageCopy{
+					offsets[i] + mip.Offset - baseOffset,
+					0,
+					0,
+					{ vk::ImageAspectFlagBits::eColor, level, 0, 1 },
+					{ 0, 0, 0 },
+					{ mip.Width, mip.Height, 1 }
+				});
+			}
+			processBuffer.copyBufferToImage(stagingBuffer->Buffer.get(), texture->m_Image.get(), vk::ImageLayout::eTransferDstOptimal, static_cast<uint32_t>(regions.size()), regions.data());
+		}
+
+		// 3. Blit level i-1 -> i for every raw texture that has level i
+		uint32_t maxMipLevels = 1u;
+		std::vector<int> mipWidths(generated.size());
+		std::vector<int> mipHeights(generated.size());
+		for (size_t t = 0; t < generated.size(); ++t)
+		{
+			mipWidths[t] = static_cast<int>(generated[t]->GetResidentWidth());
+			mipHeights[t] = static_cast<int>(generated[t]->GetResidentHeight());
+			maxMipLevels = std::max<uint32_t>(maxMipLevels, generated[t]->GetResidentLevels());
+		}
+
+		for (uint32_t i = 1; i < maxMipLevels; ++i)
+		{
+			barriers.clear();
+			for (Texture* texture : generated)
+			{
+				if (i < texture->GetResidentLevels())
+				{
+					barriers.push_back(MipBarrier(texture->m_Image.get(), i - 1, 1, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
+						vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead));
+				}
+			}
+			submitBarriers(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer);
+
+			for (size_t t = 0; t < generated.size(); ++t)
+			{
+				if (i >= generated[t]->GetResidentLevels())
+				{
+					continue;
+				}
+
+				vk::ImageBlit blit{};
+				blit.srcOffsets[0] = vk::Offset3D{ 0, 0, 0 };
+				blit.srcOffsets[1] = vk::Offset3D{ mipWidths[t], mipHeights[t], 1 };
+				blit.srcSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, i - 1, 0, 1 };
+				blit.dstOffsets[0] = vk::Offset3D{ 0, 0, 0 };
+				blit.dstOffsets[1] = vk::Offset3D{
+					mipWidths[t] > 1 ? mipWidths[t] / 2 : 1,
+					mipHeights[t] > 1 ? mipHeights[t] / 2 : 1,
+					1
+				};
+				blit.dstSubresource = vk::ImageSubresourceLayers{ vk::ImageAspectFlagBits::eColor, i, 0, 1 };
+
+				processBuffer.blitImage(
+					generated[t]->m_Image.get(),
+					vk::ImageLayout::eTransferSrcOptimal,
+					generated[t]->m_Image.get(),
+					vk::ImageLayout::eTransferDstOptimal,
+					1,
+					&blit,
+					vk::Filter::eLinear
+				);
+
+				if (mipWidths[t] > 1) mipWidths[t] /= 2;
+				if (mipHeights[t] > 1) mipHeights[t] /= 2;
+			}
+
+			// Sources are done with, same textures as the first barrier
+			for (auto& barrier : barriers)
+			{
+				barrier.oldLayout = vk::ImageLayout::eTransferSrcOptimal;
+				barrier.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+				barrier.srcAccessMask = vk::AccessFlagBits::eTransferRead;
+				barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+			}
+			submitBarriers(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
+		}
+
+		// 4. Whatever was only ever written to. The last level of raw textures, every level of cooked ones
+		barriers.clear();
+		for (Texture* texture : textures)
+		{
+			const uint32_t baseMip = texture->m_Cooked ? 0u : texture->GetResidentLevels() - 1u;
+			barriers.push_back(MipBarrier(texture->m_Image.get(), baseMip, texture->GetResidentLevels() - baseMip, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+				vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eShaderRead));
+			texture->m_CurrentLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		}
+		submitBarriers(vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eFragmentShader);
+
+#pragma endregion
+	}
+
 	// Convert stbi channels into vulkan image format
 	vk::Format Texture::stbiToVulkan(int channels)
 	{
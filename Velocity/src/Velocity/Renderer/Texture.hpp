@@ -2,11 +2,69 @@
 
 #include <stb_image.h>
 #include <string>
+#include <vector>
 
 #include <vulkan/vulkan.hpp>
 
+#include "CookedTexture.hpp"
+#include "StagingReadback.hpp"
+
 namespace Velocity
 {
+	// Pixels decoded by stbi, always 4 channels, or the blocks of a cooked texture
+	// Safe to produce on any thread. Owns the stbi allocation until a texture takes it
+	struct DecodedImage
+	{
+		DecodedImage() = default;
+		~DecodedImage() { Free(); }
+
+		DecodedImage(const DecodedImage&) = delete;
+		DecodedImage& operator=(const DecodedImage&) = delete;
+
+		DecodedImage(DecodedImage&& other) noexcept { *this = std::move(other); }
+		DecodedImage& operator=(DecodedImage&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Free();
+				Pixels = other.Pixels;
+				Width = other.Width;
+				Height = other.Height;
+				Cooked = std::move(other.Cooked);
+				other.Pixels = nullptr;
+			}
+			return *this;
+		}
+
+		// Hands the pixels over. The caller must free them with stbi_image_free
+		stbi_uc* Release()
+		{
+			stbi_uc* pixels = Pixels;
+			Pixels = nullptr;
+			return pixels;
+		}
+
+		// False if the file couldnt be loaded
+		bool IsValid() const { return Pixels != nullptr || Cooked != nullptr; }
+
+		stbi_uc*	Pixels = nullptr;
+		int			Width = 0;
+		int			Height = 0;
+
+		// Set instead of Pixels for cooked files
+		std::unique_ptr<CookedTexture> Cooked;
+
+	private:
+		void Free()
+		{
+			if (Pixels)
+			{
+				stbi_image_free(Pixels);
+				Pixels = nullptr;
+			}
+		}
+	};
+
 	// Holds an image for use in a shader
 	// Also contains static helper functions
 	class Texture
@@ -39,25 +97,90 @@ namespace Velocity
 		uint32_t GetWidth() { return m_Width; }
 		uint32_t GetHeight() { return m_Height; }
 		const std::string& GetPath() { return m_FilePath; }
+
+		// Size of each mip level on the GPU, whether it is resident or not
+		std::vector<size_t> GetMipSizes() const;
+
+		// First mip level on the GPU. Finer ones have been dropped to save memory
+		uint32_t GetResidentMip() const { return m_ResidentMip; }
+
+		// False once ReleaseCPUCopy has run, the texture then only lives on the GPU
+		bool HasCPUCopy() const;
+
+		// Bytes of pixels or blocks held in system memory
+		size_t GetHostMemory() const;
+
+		// Loads and decodes an image file without touching vulkan, so it can run on a worker thread
+		// Cooked files are read as they are rather than decoded
+		static DecodedImage Decode(const std::string& filepath);
+
+		// Reads just enough of an image file to get its size. Returns false if it is missing or isnt an image
+		static bool GetInfo(const std::string& filepath, int& outWidth, int& outHeight);
 	
 	private:
 		// Constructor for the renderer to directly construct with serialised textures
-		Texture(std::unique_ptr<stbi_uc> pixels,int width, int height, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex);
+		// upload false leaves the image empty for UploadBatch, same for the constructor below
+		Texture(std::unique_ptr<stbi_uc> pixels,int width, int height, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex, bool upload = true);
+
+		// Constructor for pixels that were decoded ahead of time, usually on a worker
+		Texture(DecodedImage&& image, const std::string& filepath, vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, vk::CommandPool& pool, uint32_t& graphicsQueueIndex, bool upload = true);
 
 		// Shared between the two constructors
-		void Init();
+		void Init(bool upload);
+		void CreateImage();
+		void Upload();
+
+		// Uploads every texture with one staging buffer and one submission. Raw textures are mipmapped, cooked ones bring their own mips
+		// The textures must have been constructed with upload set to false
+		static void UploadBatch(const std::vector<Texture*>& textures);
+
+		// Recreates each image holding only the levels from the given mip down and uploads them from the CPU copy
+		// Leaves the queue idle, the old images are gone once this returns so the views must be swapped before the next frame
+		static void SetResidentMips(const std::vector<std::pair<Texture*, uint32_t>>& textures);
+
+		// Frees the decoded pixels or cooked blocks once they are on the GPU
+		// Residency can no longer stream this texture back in so it should be fully resident first
+		void ReleaseCPUCopy();
+
+		// Level 0 as RGBA8 for a raw texture, read back off the GPU if the CPU copy is gone
+		std::vector<uint8_t> GetPixels();
+
+		// The whole cooked file. Without the CPU copy it is reloaded from disk or read back off the GPU
+		std::vector<uint8_t> SerialiseCooked();
+
+		// GetPixels for a raw texture or SerialiseCooked for a cooked one, but only starts the copy back off the GPU
+		// Main thread only. The job waits for it on any thread, so the frame doesnt
+		// Textures missing their finest mips still have their CPU copy, which is copied here instead
+		ReadbackJob ReadBackAsync();
+
+		// Starts copying regions of this texture back through a staging buffer. nullptr if it cant be read back
+		std::shared_ptr<StagingReadback> ReadBack(const std::vector<vk::BufferImageCopy>& regions, vk::DeviceSize size);
+
+		// Level 0 as one region, and every level laid out as the cooked mip table says
+		vk::BufferImageCopy GetPixelRegion() const;
+		std::vector<vk::BufferImageCopy> GetCookedRegions(vk::DeviceSize& outSize) const;
+
+		// Dimensions and level count of what is actually on the GPU
+		uint32_t GetResidentWidth() const { return std::max<uint32_t>(m_Width >> m_ResidentMip, 1u); }
+		uint32_t GetResidentHeight() const { return std::max<uint32_t>(m_Height >> m_ResidentMip, 1u); }
+		uint32_t GetResidentLevels() const { return m_MipLevels - m_ResidentMip; }
 		
 		// STATIC HELPERS
 		// Can be called to transition an image
 		static void TransitionImageLayout(vk::CommandBuffer& buffer, vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t miplevels, uint32_t
 		                                  layerCount);
-		static void CopyBufferToImage(vk::CommandBuffer& cmdBuffer, vk::Image image, vk::Buffer& buffer, uint32_t width, uint32_t height, uint32_t layerCount);
+		static void CopyBufferToImage(vk::CommandBuffer& cmdBuffer, vk::Image image, vk::Buffer& buffer, uint32_t width, uint32_t height, uint32_t layerCount, vk::DeviceSize bufferOffset = 0u);
 		static void GenerateMipmaps(vk::CommandBuffer& cmdBuffer, Texture& texture);
+
+		// Starts copying regions of an image in shader read layout into system memory, size bytes laid out as the regions say
+		// Submitted but not waited on, see StagingReadback. nullptr if it couldnt be submitted
+		static std::shared_ptr<StagingReadback> ReadBackImage(vk::UniqueDevice& device, vk::PhysicalDevice& pDevice, uint32_t queueIndex, vk::Image image, vk::Format format,
+			uint32_t mipLevels, uint32_t layerCount, const std::vector<vk::BufferImageCopy>& regions, vk::DeviceSize size);
 		
 		// Member function proxy to allow texture->transition..
 		void TransitionImageLayout(vk::CommandBuffer& buffer, vk::ImageLayout newLayout)
 		{
-			TransitionImageLayout(buffer,m_Image.get(),m_CurrentFormat,m_CurrentLayout, newLayout,m_MipLevels, 1);
+			TransitionImageLayout(buffer,m_Image.get(),m_CurrentFormat,m_CurrentLayout, newLayout,GetResidentLevels(), 1);
 			m_CurrentLayout = newLayout;
 		}
 
@@ -84,6 +207,12 @@ namespace Velocity
 		// Store amount of mips created
 		uint32_t					m_MipLevels;
 
+		// Levels before this one only live on the CPU. See TextureResidency
+		uint32_t					m_ResidentMip = 0u;
+
+		// Raw pixels already filtered down to m_ResidentMip, only held while uploading
+		std::vector<uint8_t>		m_StreamPixels;
+
 		// Tells the pipeline how to bind this texture
 		vk::DescriptorImageInfo		m_DescriptorImageInfo;
 
@@ -97,6 +226,10 @@ namespace Velocity
 		// Serilisation specific variables
 		std::unique_ptr<stbi_uc> m_RawPixels;
 		bool m_IsLoadedByStbi;
+
+		// Compressed blocks and mips for cooked textures, m_RawPixels is null for these
+		// Data is emptied by ReleaseCPUCopy, the rest stays to describe what is on the GPU
+		std::unique_ptr<CookedTexture> m_Cooked;
 		
 		// References
 		vk::UniqueDevice* r_Device;
@@ -0,0 +1,508 @@
+#include "velpch.h"
+
+#include "TextureCooker.hpp"
+
+#include <cmath>
+#include <filesystem>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Renderer/Texture.hpp>
+#include <Velocity/Utility/AssetManifest.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+#include <Velocity/Utility/VirtualFileSystem.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		// Extensions CookFolder picks up, lower case
+		const char* SOURCE_EXTENSIONS[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp" };
+
+		const std::array<float, 256>& SrgbToLinearTable()
+		{
+			static const std::array<float, 256> s_Table = []()
+			{
+				std::array<float, 256> table;
+				for (size_t i = 0; i < table.size(); ++i)
+				{
+					const float value = static_cast<float>(i) / 255.0f;
+					table[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+				}
+				return table;
+			}();
+			return s_Table;
+		}
+
+		uint8_t LinearToSrgb(float value)
+		{
+			value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+			return static_cast<uint8_t>(std::min<float>(std::max<float>(value, 0.0f), 1.0f) * 255.0f + 0.5f);
+		}
+
+		uint8_t ToByte(float value)
+		{
+			return static_cast<uint8_t>(std::min<float>(std::max<float>(value, 0.0f), 255.0f) + 0.5f);
+		}
+
+		// 2x2 box filter into the next level
+		// Colour is averaged in linear space and normals are renormalised, everything else is a plain average
+		std::vector<uint8_t> Downsample(const uint8_t* source, uint32_t width, uint32_t height, uint32_t newWidth, uint32_t newHeight, TextureUsage usage)
+		{
+			std::vector<uint8_t> output(static_cast<size_t>(newWidth) * newHeight * 4u);
+			const auto& toLinear = SrgbToLinearTable();
+			const bool srgb = TextureCooker::IsSrgb(usage);
+
+			ThreadPool::Get().ParallelFor(newHeight, [&](size_t y)
+			{
+				const uint32_t y0 = std::min<uint32_t>(static_cast<uint32_t>(y) * 2u, height - 1u);
+				const uint32_t y1 = std::min<uint32_t>(static_cast<uint32_t>(y) * 2u + 1u, height - 1u);
+
+				for (uint32_t x = 0; x < newWidth; ++x)
+				{
+					const uint32_t x0 = std::min<uint32_t>(x * 2u, width - 1u);
+					const uint32_t x1 = std::min<uint32_t>(x * 2u + 1u, width - 1u);
+
+					const uint8_t* samples[4] = {
+						source + (static_cast<size_t>(y0) * width + x0) * 4u,
+						source + (static_cast<size_t>(y0) * width + x1) * 4u,
+						source + (static_cast<size_t>(y1) * width + x0) * 4u,
+						source + (static_cast<size_t>(y1) * width + x1) * 4u
+					};
+					uint8_t* destination = output.data() + (y * newWidth + x) * 4u;
+
+					float sum[4] = {};
+					for (const uint8_t* sample : samples)
+					{
+						for (uint32_t c = 0; c < 4; ++c)
+						{
+							if (srgb && c < 3)
+							{
+								sum[c] += toLinear[sample[c]];
+							}
+							else if (usage == TextureUsage::Normal && c < 3)
+							{
+								sum[c] += sample[c] / 127.5f - 1.0f;
+							}
+							else
+							{
+								sum[c] += sample[c];
+							}
+						}
+					}
+
+					if (srgb)
+					{
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							destination[c] = LinearToSrgb(sum[c] * 0.25f);
+						}
+					}
+					else if (usage == TextureUsage::Normal)
+					{
+						const float length = std::sqrt(sum[0] * sum[0] + sum[1] * sum[1] + sum[2] * sum[2]);
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							// Opposing normals cancel out, point those straight up
+							const float normal = length > 1e-6f ? sum[c] / length : (c == 2 ? 1.0f : 0.0f);
+							destination[c] = ToByte((normal + 1.0f) * 127.5f);
+						}
+					}
+					else
+					{
+						for (uint32_t c = 0; c < 3; ++c)
+						{
+							destination[c] = ToByte(sum[c] * 0.25f);
+						}
+					}
+					destination[3] = ToByte(sum[3] * 0.25f);
+				}
+			});
+
+			return output;
+		}
+
+		bool EndsWith(const std::string& text, const std::string& ending)
+		{
+			return text.size() >= ending.size() && text.compare(text.size() - ending.size(), ending.size(), ending) == 0;
+		}
+
+		// Suffixes of the maps that end up in a packed material texture, in channel order
+		const char* MATERIAL_SUFFIXES[] = { "_ao", "_roughness", "_metallic", "_height" };
+
+		// What a channel holds when its map is missing
+		const uint8_t MATERIAL_DEFAULTS[] = { 255u, 255u, 0u, 128u };
+
+		// Bilinear fetch of the red channel at the centre of a destination pixel
+		uint8_t SampleRed(const MapPixels& image, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+		{
+			const uint32_t sourceWidth = image.Width;
+			const uint32_t sourceHeight = image.Height;
+			if (sourceWidth == width && sourceHeight == height)
+			{
+				return image.Pixels[(static_cast<size_t>(y) * width + x) * 4u];
+			}
+
+			const float u = std::max<float>((x + 0.5f) * sourceWidth / width - 0.5f, 0.0f);
+			const float v = std::max<float>((y + 0.5f) * sourceHeight / height - 0.5f, 0.0f);
+			const uint32_t x0 = std::min<uint32_t>(static_cast<uint32_t>(u), sourceWidth - 1u);
+			const uint32_t y0 = std::min<uint32_t>(static_cast<uint32_t>(v), sourceHeight - 1u);
+			const uint32_t x1 = std::min<uint32_t>(x0 + 1u, sourceWidth - 1u);
+			const uint32_t y1 = std::min<uint32_t>(y0 + 1u, sourceHeight - 1u);
+			const float fx = u - x0;
+			const float fy = v - y0;
+
+			const auto fetch = [&image, sourceWidth](uint32_t sx, uint32_t sy)
+			{
+				return static_cast<float>(image.Pixels[(static_cast<size_t>(sy) * sourceWidth + sx) * 4u]);
+			};
+			const float top = fetch(x0, y0) + (fetch(x1, y0) - fetch(x0, y0)) * fx;
+			const float bottom = fetch(x0, y1) + (fetch(x1, y1) - fetch(x0, y1)) * fx;
+			return ToByte(top + (bottom - top) * fy);
+		}
+	}
+
+	BlockFormat TextureCooker::GetFormat(TextureUsage usage)
+	{
+		switch (usage)
+		{
+		case TextureUsage::AlbedoCompact:
+			return BlockFormat::BC1;
+		case TextureUsage::AlbedoAlpha:
+			return BlockFormat::BC3;
+		case TextureUsage::Normal:
+			return BlockFormat::BC5;
+		case TextureUsage::Mask:
+			return BlockFormat::BC4;
+		default:
+			return BlockFormat::BC7;
+		}
+	}
+
+	bool TextureCooker::IsSrgb(TextureUsage usage)
+	{
+		return usage == TextureUsage::Albedo || usage == TextureUsage::AlbedoCompact || usage == TextureUsage::AlbedoAlpha;
+	}
+
+	TextureUsage TextureCooker::GuessUsage(const std::string& filepath)
+	{
+		std::string stem = std::filesystem::path(filepath).stem().generic_string();
+		std::transform(stem.begin(), stem.end(), stem.begin(), ::tolower);
+
+		if (EndsWith(stem, "_normal"))
+		{
+			return TextureUsage::Normal;
+		}
+		for (const char* suffix : MATERIAL_SUFFIXES)
+		{
+			if (EndsWith(stem, suffix))
+			{
+				return TextureUsage::Mask;
+			}
+		}
+		return TextureUsage::Albedo;
+	}
+
+	std::vector<uint8_t> TextureCooker::BuildMip(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t level, TextureUsage usage)
+	{
+		if (level == 0u)
+		{
+			return std::vector<uint8_t>(pixels, pixels + static_cast<size_t>(width) * height * 4u);
+		}
+
+		std::vector<uint8_t> downsampled;
+		const uint8_t* current = pixels;
+		for (uint32_t i = 0; i < level && (width > 1u || height > 1u); ++i)
+		{
+			const uint32_t nextWidth = std::max<uint32_t>(width / 2u, 1u);
+			const uint32_t nextHeight = std::max<uint32_t>(height / 2u, 1u);
+			downsampled = Downsample(current, width, height, nextWidth, nextHeight, usage);
+
+			current = downsampled.data();
+			width = nextWidth;
+			height = nextHeight;
+		}
+
+		return downsampled;
+	}
+
+	CookedTexture TextureCooker::Cook(const uint8_t* pixels, uint32_t width, uint32_t height, TextureUsage usage)
+	{
+		CookedTexture cooked;
+		cooked.Format = GetFormat(usage);
+		cooked.Srgb = IsSrgb(usage);
+		cooked.Width = width;
+		cooked.Height = height;
+
+		// Same chain length the runtime would have generated
+		const uint32_t mipLevels = static_cast<uint32_t>(std::floor(std::log2(std::max<uint32_t>(width, height)))) + 1u;
+		cooked.Mips.reserve(mipLevels);
+		cooked.Data.reserve(BlockCompression::GetEncodedSize(cooked.Format, width, height) * 4u / 3u + 64u);
+
+		const uint8_t* level = pixels;
+		std::vector<uint8_t> downsampled;
+		uint32_t levelWidth = width;
+		uint32_t levelHeight = height;
+
+		for (uint32_t i = 0; i < mipLevels; ++i)
+		{
+			const auto blocks = BlockCompression::Encode(level, levelWidth, levelHeight, cooked.Format);
+
+			CookedMip mip;
+			mip.Offset = cooked.Data.size();
+			mip.Size = blocks.size();
+			mip.Width = levelWidth;
+			mip.Height = levelHeight;
+			cooked.Mips.push_back(mip);
+			cooked.Data.insert(cooked.Data.end(), blocks.begin(), blocks.end());
+
+			if (i + 1u == mipLevels)
+			{
+				break;
+			}
+
+			const uint32_t nextWidth = std::max<uint32_t>(levelWidth / 2u, 1u);
+			const uint32_t nextHeight = std::max<uint32_t>(levelHeight / 2u, 1u);
+			downsampled = Downsample(level, levelWidth, levelHeight, nextWidth, nextHeight, usage);
+
+			level = downsampled.data();
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+
+		return cooked;
+	}
+
+	bool TextureCooker::CookFile(const std::string& sourcePath, const std::string& outputPath, TextureUsage usage)
+	{
+		DecodedImage image = Texture::Decode(sourcePath);
+		if (!image.Pixels)
+		{
+			VEL_CORE_ERROR("Failed to cook texture {0}, couldnt load the source", sourcePath);
+			return false;
+		}
+
+		const CookedTexture cooked = Cook(image.Pixels, static_cast<uint32_t>(image.Width), static_cast<uint32_t>(image.Height), usage);
+		if (!cooked.Save(outputPath))
+		{
+			VEL_CORE_ERROR("Failed to write cooked texture {0}", outputPath);
+			return false;
+		}
+
+		// What the GPU would have held uncompressed, mips included
+		const size_t uncompressedSize = static_cast<size_t>(image.Width) * image.Height * 4u * 4u / 3u;
+		VEL_CORE_INFO("Cooked {0} ({1} KB -> {2} KB)", outputPath, uncompressedSize / 1024u, cooked.Data.size() / 1024u);
+		return true;
+	}
+
+	size_t TextureCooker::CookFolder(const std::string& folder)
+	{
+		std::error_code error;
+		size_t cookedCount = 0u;
+
+		// Base path and extension of every material with masks in the folder
+		std::set<std::pair<std::string, std::string>> materials;
+
+		for (const auto& file : std::filesystem::directory_iterator(folder, error))
+		{
+			const std::string sourcePath = file.path().generic_string();
+			if (!IsSourceImage(sourcePath))
+			{
+				continue;
+			}
+
+			// Masks are only ever sampled packed, group them by material and cook them together below
+			const TextureUsage usage = GuessUsage(sourcePath);
+			if (usage == TextureUsage::Mask)
+			{
+				const std::string stem = file.path().stem().generic_string();
+				const size_t suffixStart = stem.find_last_of('_');
+				const std::string base = (file.path().parent_path() / stem.substr(0, suffixStart)).generic_string();
+				materials.emplace(base, file.path().extension().generic_string());
+				continue;
+			}
+
+			if (FindCooked(sourcePath) == sourcePath && CookFile(sourcePath, GetCookedPath(sourcePath), usage))
+			{
+				++cookedCount;
+			}
+		}
+
+		for (const auto& material : materials)
+		{
+			const MaterialMaps maps = GetMaterialMaps(material.first, material.second);
+			const std::string packedPath = GetPackedPath(material.first);
+			if (IsUpToDate(packedPath, { maps.Occlusion, maps.Roughness, maps.Metallic, maps.Height }))
+			{
+				continue;
+			}
+
+			CookedTexture cooked;
+			if (CookMaterial(maps, packedPath, cooked))
+			{
+				++cookedCount;
+			}
+		}
+
+		return cookedCount;
+	}
+
+	bool TextureCooker::PackMaterial(const MaterialMaps& maps, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+	{
+		const std::array<const std::string*, 4> paths = { &maps.Occlusion, &maps.Roughness, &maps.Metallic, &maps.Height };
+		std::array<DecodedImage, 4> images;
+
+		ThreadPool::Get().ParallelFor(paths.size(), [&](size_t i)
+		{
+			if (!paths[i]->empty())
+			{
+				images[i] = Texture::Decode(*paths[i]);
+			}
+		});
+
+		std::array<MapPixels, 4> decoded;
+		for (size_t i = 0; i < images.size(); ++i)
+		{
+			if (!paths[i]->empty() && !images[i].Pixels)
+			{
+				VEL_CORE_WARN("Couldnt load {0} for packing, using the default instead", *paths[i]);
+			}
+			if (images[i].Pixels)
+			{
+				decoded[i] = { images[i].Pixels, static_cast<uint32_t>(images[i].Width), static_cast<uint32_t>(images[i].Height) };
+			}
+		}
+
+		if (std::none_of(decoded.begin(), decoded.end(), [](const MapPixels& map) { return map.Pixels != nullptr; }))
+		{
+			return false;
+		}
+
+		PackMaterial(decoded, pixels, width, height);
+		return true;
+	}
+
+	void TextureCooker::PackMaterial(const std::array<MapPixels, 4>& maps, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+	{
+		width = 1u;
+		height = 1u;
+		for (const auto& map : maps)
+		{
+			if (map.Pixels)
+			{
+				width = std::max(width, map.Width);
+				height = std::max(height, map.Height);
+			}
+		}
+
+		pixels.resize(static_cast<size_t>(width) * height * 4u);
+		ThreadPool::Get().ParallelFor(height, [&](size_t y)
+		{
+			uint8_t* row = pixels.data() + y * width * 4u;
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				for (uint32_t c = 0; c < 4; ++c)
+				{
+					row[x * 4u + c] = maps[c].Pixels ? SampleRed(maps[c], x, static_cast<uint32_t>(y), width, height) : MATERIAL_DEFAULTS[c];
+				}
+			}
+		});
+	}
+
+	bool TextureCooker::CookMaterial(const MaterialMaps& maps, const std::string& outputPath, CookedTexture& cooked)
+	{
+		std::vector<uint8_t> pixels;
+		uint32_t width = 0u;
+		uint32_t height = 0u;
+		if (!PackMaterial(maps, pixels, width, height))
+		{
+			VEL_CORE_ERROR("Failed to pack material {0}, none of its maps could be loaded", outputPath);
+			return false;
+		}
+
+		cooked = Cook(pixels.data(), width, height, TextureUsage::Packed);
+
+		// Still usable this run, it just gets packed again next time
+		if (!cooked.Save(outputPath))
+		{
+			VEL_CORE_WARN("Failed to write packed material {0}", outputPath);
+			return true;
+		}
+
+		VEL_CORE_INFO("Packed {0} ({1} KB)", outputPath, cooked.Data.size() / 1024u);
+		return true;
+	}
+
+	bool TextureCooker::IsSourceImage(const std::string& filepath)
+	{
+		std::string extension = std::filesystem::path(filepath).extension().generic_string();
+		std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+
+		return std::any_of(std::begin(SOURCE_EXTENSIONS), std::end(SOURCE_EXTENSIONS), [&extension](const char* candidate)
+		{
+			return extension == candidate;
+		});
+	}
+
+	MaterialMaps TextureCooker::GetMaterialMaps(const std::string& basefilepath, const std::string& extension)
+	{
+		std::array<std::string, 4> paths;
+		for (size_t i = 0; i < paths.size(); ++i)
+		{
+			const std::string path = basefilepath + MATERIAL_SUFFIXES[i] + extension;
+			if (VirtualFileSystem::Exists(path))
+			{
+				paths[i] = path;
+			}
+		}
+
+		return { paths[0], paths[1], paths[2], paths[3] };
+	}
+
+	std::string TextureCooker::GetPackedPath(const std::string& basefilepath)
+	{
+		return basefilepath + "_orm" + CookedTexture::EXTENSION;
+	}
+
+	std::string TextureCooker::GetCookedPath(const std::string& sourcePath)
+	{
+		return std::filesystem::path(sourcePath).replace_extension(CookedTexture::EXTENSION).generic_string();
+	}
+
+	std::string TextureCooker::FindCooked(const std::string& sourcePath)
+	{
+		const std::string cookedPath = GetCookedPath(sourcePath);
+
+		return IsUpToDate(cookedPath, { sourcePath }) ? cookedPath : sourcePath;
+	}
+
+	bool TextureCooker::IsUpToDate(const std::string& cookedPath, const std::vector<std::string>& sourcePaths)
+	{
+		// The cooker has already checked it. Timestamps alone dont survive a checkout or copy
+		if (AssetManifest::IsCurrent(cookedPath))
+		{
+			return true;
+		}
+
+		// Packs ship the cooked output without its sources, so a packed file is always current
+		std::error_code error;
+		if (!std::filesystem::exists(cookedPath, error))
+		{
+			return VirtualFileSystem::IsPacked(cookedPath);
+		}
+
+		// Stale if any source has been edited since
+		const auto cookedTime = std::filesystem::last_write_time(cookedPath, error);
+		for (const auto& sourcePath : sourcePaths)
+		{
+			if (sourcePath.empty() || !std::filesystem::exists(sourcePath, error))
+			{
+				continue;
+			}
+			if (std::filesystem::last_write_time(sourcePath, error) > cookedTime)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
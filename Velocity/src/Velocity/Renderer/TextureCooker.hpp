@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "CookedTexture.hpp"
+
+namespace Velocity
+{
+	// What a texture holds, decides the block format it is cooked to
+	enum class TextureUsage : uint32_t
+	{
+		Albedo,			// BC7 sRGB
+		AlbedoCompact,	// BC1 sRGB. Opaque only, half the size of BC7
+		AlbedoAlpha,	// BC3 sRGB
+		Normal,			// BC5. Blue is rebuilt in the shader
+		Mask,			// BC4. Single channel maps like metallic, roughness and height
+		Packed			// BC7 linear. Several data maps sharing one texture, see MaterialMaps
+	};
+
+	// Single channel maps packed into one material texture as R, G, B and A
+	// Empty paths get a default: no occlusion, fully rough, not metallic and a flat height
+	struct MaterialMaps
+	{
+		std::string	Occlusion;
+		std::string	Roughness;
+		std::string	Metallic;
+		std::string	Height;
+	};
+
+	// A decoded RGBA8 map to pack, only red is read. Null pixels get the channel default
+	struct MapPixels
+	{
+		const uint8_t*	Pixels = nullptr;
+		uint32_t		Width = 0u;
+		uint32_t		Height = 0u;
+	};
+
+	// Offline conversion of source images into cooked block compressed textures
+	// Mips are built on the CPU and every level is encoded across the worker pool
+	class TextureCooker
+	{
+	public:
+		static BlockFormat GetFormat(TextureUsage usage);
+		static bool IsSrgb(TextureUsage usage);
+
+		// Guesses from the material suffix (_albedo, _normal, _roughness...). Anything unknown is treated as albedo
+		static TextureUsage GuessUsage(const std::string& filepath);
+
+		// Box filters RGBA8 pixels down to the given mip level, filtered the same way cooked mips are
+		static std::vector<uint8_t> BuildMip(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t level, TextureUsage usage);
+
+		// Builds the mip chain and encodes every level. Pixels are tightly packed RGBA8
+		static CookedTexture Cook(const uint8_t* pixels, uint32_t width, uint32_t height, TextureUsage usage);
+
+		// Decodes the source and writes the cooked file. Returns false if either side fails
+		static bool CookFile(const std::string& sourcePath, const std::string& outputPath, TextureUsage usage);
+
+		// Cooks every image in a folder that is missing or older than its source, next to the source
+		// Material masks are packed into one texture per material rather than cooked on their own
+		// Returns how many were written
+		static size_t CookFolder(const std::string& folder);
+
+		// Reads the red channel of each map and packs them into one RGBA image
+		// Maps are decoded side by side and resampled to the largest one. Returns false if none of them loaded
+		static bool PackMaterial(const MaterialMaps& maps, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+
+		// Packs maps that are already decoded, in the same channel order as MaterialMaps
+		// Resampled to the largest one, or a single pixel of defaults if none are given
+		static void PackMaterial(const std::array<MapPixels, 4>& maps, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height);
+
+		// Packs the maps, cooks them and writes the result. Failing to write is only a warning, the cooked texture is still returned
+		static bool CookMaterial(const MaterialMaps& maps, const std::string& outputPath, CookedTexture& cooked);
+
+		// True for the image formats that can be cooked
+		static bool IsSourceImage(const std::string& filepath);
+
+		// Finds the _ao, _roughness, _metallic and _height maps next to a material's base path. Missing ones are left empty
+		static MaterialMaps GetMaterialMaps(const std::string& basefilepath, const std::string& extension);
+
+		// Where the packed texture for a material's base path lives
+		static std::string GetPackedPath(const std::string& basefilepath);
+
+		// Source path with the extension swapped for the cooked one
+		static std::string GetCookedPath(const std::string& sourcePath);
+
+		// The cooked file for the source if there is one at least as new, otherwise the source itself
+		static std::string FindCooked(const std::string& sourcePath);
+
+		// True if a loaded asset manifest says the cooked file is current, otherwise if it exists and is at least as new as every source that exists
+		static bool IsUpToDate(const std::string& cookedPath, const std::vector<std::string>& sourcePaths);
+	};
+}
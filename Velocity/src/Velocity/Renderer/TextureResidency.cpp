@@ -0,0 +1,235 @@
+#include "velpch.h"
+
+#include "TextureResidency.hpp"
+
+#include <cmath>
+#include <queue>
+
+namespace Velocity
+{
+	TextureResidency::TextureResidency(size_t budget)
+		: m_Budget(budget)
+	{
+	}
+
+	void TextureResidency::Track(uint32_t index, uint32_t width, uint32_t height, const std::vector<size_t>& mipSizes, uint32_t residentMip)
+	{
+		if (mipSizes.empty())
+		{
+			return;
+		}
+
+		if (index >= m_Slots.size())
+		{
+			m_Slots.resize(index + 1u);
+		}
+
+		Untrack(index);
+
+		Slot& slot = m_Slots[index];
+		slot.Tracked = true;
+		slot.Width = width;
+		slot.Height = height;
+		slot.MipSizes = mipSizes;
+
+		// First level small enough to always keep
+		slot.Tail = 0u;
+		while (slot.Tail + 1u < mipSizes.size() && std::max<uint32_t>(width >> slot.Tail, height >> slot.Tail) > MIN_RESIDENT_SIZE)
+		{
+			++slot.Tail;
+		}
+
+		slot.Resident = std::min<uint32_t>(residentMip, static_cast<uint32_t>(mipSizes.size()) - 1u);
+		slot.Wanted = slot.Resident;
+		slot.Requested = NO_REQUEST;
+
+		// Counts as just used so a fresh load isnt the first thing evicted
+		slot.LastUsed = m_Frame;
+
+		m_ResidentBytes += GetSizeFrom(slot, slot.Resident);
+	}
+
+	void TextureResidency::Untrack(uint32_t index)
+	{
+		if (!IsTracked(index))
+		{
+			return;
+		}
+
+		m_ResidentBytes -= GetSizeFrom(m_Slots[index], m_Slots[index].Resident);
+		m_Slots[index] = Slot();
+	}
+
+	void TextureResidency::Clear()
+	{
+		m_Slots.clear();
+		m_ResidentBytes = 0u;
+	}
+
+	void TextureResidency::Remap(const std::vector<uint32_t>& newIndices)
+	{
+		std::vector<Slot> slots;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_Slots.size()); ++i)
+		{
+			if (!m_Slots[i].Tracked)
+			{
+				continue;
+			}
+
+			if (i >= newIndices.size() || newIndices[i] == NO_SLOT)
+			{
+				m_ResidentBytes -= GetSizeFrom(m_Slots[i], m_Slots[i].Resident);
+				continue;
+			}
+
+			// Keeps when it was last drawn so the move doesnt reorder evictions
+			if (newIndices[i] >= slots.size())
+			{
+				slots.resize(newIndices[i] + 1u);
+			}
+			slots[newIndices[i]] = std::move(m_Slots[i]);
+		}
+		m_Slots = std::move(slots);
+	}
+
+	void TextureResidency::Request(uint32_t index, float screenSize)
+	{
+		if (!IsTracked(index))
+		{
+			return;
+		}
+
+		Slot& slot = m_Slots[index];
+
+		// One texel per pixel, anything finer would just be minified away
+		const float largest = static_cast<float>(std::max<uint32_t>(slot.Width, slot.Height));
+		uint32_t mip = 0u;
+		if (screenSize > 0.0f && screenSize < largest)
+		{
+			mip = static_cast<uint32_t>(std::floor(std::log2(largest / screenSize)));
+		}
+
+		slot.Requested = std::min<uint32_t>(slot.Requested, std::min<uint32_t>(mip, slot.Tail));
+	}
+
+	std::vector<TextureResidency::Change> TextureResidency::Update()
+	{
+		++m_Frame;
+
+		// Start from what is resident, anything drawn this frame moves to what it asked for
+		std::vector<uint32_t> targets(m_Slots.size(), 0u);
+		size_t total = 0u;
+		for (size_t i = 0; i < m_Slots.size(); ++i)
+		{
+			Slot& slot = m_Slots[i];
+			if (!slot.Tracked)
+			{
+				continue;
+			}
+
+			if (slot.Requested != NO_REQUEST)
+			{
+				slot.Wanted = slot.Requested;
+				slot.LastUsed = m_Frame;
+				slot.Requested = NO_REQUEST;
+			}
+
+			targets[i] = slot.LastUsed == m_Frame ? slot.Wanted : slot.Resident;
+			total += GetSizeFrom(slot, targets[i]);
+		}
+
+		// Over budget, drop the finest mip of whatever was drawn longest ago. Ties go to whoever frees the most
+		if (total > m_Budget)
+		{
+			auto evictAfter = [this, &targets](uint32_t a, uint32_t b)
+			{
+				const Slot& slotA = m_Slots[a];
+				const Slot& slotB = m_Slots[b];
+				if (slotA.LastUsed != slotB.LastUsed)
+				{
+					return slotA.LastUsed > slotB.LastUsed;
+				}
+				return slotA.MipSizes[targets[a]] < slotB.MipSizes[targets[b]];
+			};
+
+			std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(evictAfter)> victims(evictAfter);
+			for (uint32_t i = 0; i < static_cast<uint32_t>(m_Slots.size()); ++i)
+			{
+				if (m_Slots[i].Tracked && targets[i] < m_Slots[i].Tail)
+				{
+					victims.push(i);
+				}
+			}
+
+			while (total > m_Budget && !victims.empty())
+			{
+				const uint32_t victim = victims.top();
+				victims.pop();
+
+				total -= m_Slots[victim].MipSizes[targets[victim]];
+				++targets[victim];
+
+				if (targets[victim] < m_Slots[victim].Tail)
+				{
+					victims.push(victim);
+				}
+			}
+		}
+
+		// Streaming in is the expensive part. Most recently drawn go first, the rest wait for a later frame
+		std::vector<uint32_t> streamIns;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_Slots.size()); ++i)
+		{
+			if (m_Slots[i].Tracked && targets[i] < m_Slots[i].Resident)
+			{
+				streamIns.push_back(i);
+			}
+		}
+
+		std::sort(streamIns.begin(), streamIns.end(), [this](uint32_t a, uint32_t b)
+		{
+			return m_Slots[a].LastUsed > m_Slots[b].LastUsed;
+		});
+
+		size_t uploaded = 0u;
+		for (uint32_t index : streamIns)
+		{
+			// Always let one through so a texture bigger than the upload budget still streams
+			const size_t cost = GetSizeFrom(m_Slots[index], targets[index]);
+			if (uploaded > 0u && uploaded + cost > m_UploadBudget)
+			{
+				targets[index] = m_Slots[index].Resident;
+				continue;
+			}
+			uploaded += cost;
+		}
+
+		std::vector<Change> changes;
+		for (uint32_t i = 0; i < static_cast<uint32_t>(m_Slots.size()); ++i)
+		{
+			Slot& slot = m_Slots[i];
+			if (!slot.Tracked || targets[i] == slot.Resident)
+			{
+				continue;
+			}
+
+			m_ResidentBytes -= GetSizeFrom(slot, slot.Resident);
+			m_ResidentBytes += GetSizeFrom(slot, targets[i]);
+			slot.Resident = targets[i];
+
+			changes.push_back({ i, targets[i] });
+		}
+
+		return changes;
+	}
+
+	size_t TextureResidency::GetSizeFrom(const Slot& slot, uint32_t mip)
+	{
+		size_t size = 0u;
+		for (size_t level = mip; level < slot.MipSizes.size(); ++level)
+		{
+			size += slot.MipSizes[level];
+		}
+		return size;
+	}
+}
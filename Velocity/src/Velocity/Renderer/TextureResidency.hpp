@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Velocity
+{
+	// Decides how many mips of each texture are kept on the GPU
+	// The renderer reports how big each texture appears on screen, textures stream up to the mip that needs and
+	// the least recently used ones give up their finest mips when the total goes over budget
+	// Only bookkeeping lives here, the renderer does the uploads and swaps the views
+	class TextureResidency
+	{
+	public:
+		// A texture whose first resident mip should change
+		struct Change
+		{
+			uint32_t	Index = 0u;
+			uint32_t	ResidentMip = 0u;
+		};
+
+		explicit TextureResidency(size_t budget);
+
+		void SetBudget(size_t bytes) { m_Budget = bytes; }
+		size_t GetBudget() const { return m_Budget; }
+
+		// Caps how much is streamed in by a single Update. Drops always go through
+		void SetUploadBudget(size_t bytes) { m_UploadBudget = bytes; }
+
+		// Bytes resident across every tracked texture
+		size_t GetResidentBytes() const { return m_ResidentBytes; }
+
+		// Starts tracking a texture slot. mipSizes[i] is the size of level i on the GPU
+		void Track(uint32_t index, uint32_t width, uint32_t height, const std::vector<size_t>& mipSizes, uint32_t residentMip);
+		void Untrack(uint32_t index);
+		void Clear();
+
+		// Moves every slot to newIndices[index] after the renderer compacts its textures. Slots mapped to NO_SLOT are dropped
+		static constexpr uint32_t NO_SLOT = ~0u;
+		void Remap(const std::vector<uint32_t>& newIndices);
+
+		bool IsTracked(uint32_t index) const { return index < m_Slots.size() && m_Slots[index].Tracked; }
+		uint32_t GetResidentMip(uint32_t index) const { return IsTracked(index) ? m_Slots[index].Resident : 0u; }
+
+		// Reports that a texture is drawn this frame across roughly screenSize pixels
+		// Called per draw, the finest mip asked for wins
+		void Request(uint32_t index, float screenSize);
+
+		// Ends the frame. Works out what should be resident and returns the textures that need to change
+		// The returned changes are treated as applied
+		std::vector<Change> Update();
+
+	private:
+		struct Slot
+		{
+			bool				Tracked = false;
+			uint32_t			Width = 0u;
+			uint32_t			Height = 0u;
+			std::vector<size_t>	MipSizes;
+			uint32_t			Resident = 0u;		// First mip on the GPU
+			uint32_t			Tail = 0u;			// Never dropped past this one
+			uint32_t			Wanted = 0u;		// Mip the last frame it was drawn asked for
+			uint32_t			Requested = NO_REQUEST;
+			uint64_t			LastUsed = 0u;
+		};
+
+		static constexpr uint32_t NO_REQUEST = ~0u;
+
+		// Textures are never dropped below this size so there is always something to sample
+		static constexpr uint32_t MIN_RESIDENT_SIZE = 64u;
+
+		// Bytes used by a texture when its first resident mip is mip
+		static size_t GetSizeFrom(const Slot& slot, uint32_t mip);
+
+		std::vector<Slot>	m_Slots;
+		size_t				m_Budget;
+		size_t				m_UploadBudget = 64u * 1024u * 1024u;
+		size_t				m_ResidentBytes = 0u;
+		uint64_t			m_Frame = 0u;
+	};
+}
@@ -55,6 +55,7 @@ namespace Velocity
 			};
 		}
 
+		// Field by field, only for scenes from before the chunked format. Those now store vertices as raw blocks
 		template<class Archive>
 		void save(Archive& ar) const
 		{
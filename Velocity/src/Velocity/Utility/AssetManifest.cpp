@@ -0,0 +1,249 @@
+#include "velpch.h"
+
+#include "AssetManifest.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include <Velocity/Core/Log.hpp>
+
+#include "VirtualFileSystem.hpp"
+
+namespace Velocity
+{
+	const char AssetManifest::MAGIC[4] = { 'V','M','A','N' };
+	const char* AssetManifest::FILENAME = "manifest.vman";
+
+	std::mutex AssetManifest::s_LoadMutex;
+	std::vector<std::shared_ptr<const AssetManifest::Loaded>> AssetManifest::s_Loaded;
+
+	bool AssetManifest::Read(const std::string& filepath)
+	{
+		m_Assets.clear();
+
+		VirtualFileSystem::File file;
+		if (!VirtualFileSystem::Open(filepath, file))
+		{
+			return false;
+		}
+
+		std::vector<Asset> assets;
+		try
+		{
+			std::istringstream stream(std::string(reinterpret_cast<const char*>(file.GetData()), file.GetSize()));
+			cereal::BinaryInputArchive archive(stream);
+
+			char magic[4] = {};
+			uint32_t version = 0u;
+			archive(cereal::binary_data(magic, sizeof(magic)), version);
+			if (memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != FORMAT_VERSION)
+			{
+				VEL_CORE_WARN("Asset manifest {0} is from an older version, cook again", filepath);
+				return false;
+			}
+			archive(assets);
+		}
+		catch (const cereal::Exception& exception)
+		{
+			VEL_CORE_ERROR("Asset manifest {0} is corrupt: {1}", filepath, exception.what());
+			return false;
+		}
+
+		for (auto& asset : assets)
+		{
+			const std::string name = asset.Name;
+			m_Assets[name] = std::move(asset);
+		}
+		return true;
+	}
+
+	bool AssetManifest::Write(const std::string& filepath) const
+	{
+		// Sorted so the same assets always give the same file
+		std::vector<const Asset*> assets;
+		assets.reserve(m_Assets.size());
+		for (const auto& asset : m_Assets)
+		{
+			assets.push_back(&asset.second);
+		}
+		std::sort(assets.begin(), assets.end(), [](const Asset* a, const Asset* b) { return a->Name < b->Name; });
+
+		const std::string tempPath = filepath + ".tmp";
+		{
+			std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+			if (!output.is_open())
+			{
+				VEL_CORE_ERROR("Failed to open {0} to write an asset manifest", tempPath);
+				return false;
+			}
+
+			cereal::BinaryOutputArchive archive(output);
+			const uint32_t version = FORMAT_VERSION;
+			archive(cereal::binary_data(MAGIC, sizeof(MAGIC)), version);
+			archive(static_cast<cereal::size_type>(assets.size()));
+			for (const Asset* asset : assets)
+			{
+				archive(*asset);
+			}
+
+			if (!output.good())
+			{
+				VEL_CORE_ERROR("Failed to write asset manifest {0}", filepath);
+				output.close();
+				std::error_code error;
+				std::filesystem::remove(tempPath, error);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, filepath, error);
+		if (error)
+		{
+			VEL_CORE_ERROR("Failed to replace asset manifest {0}: {1}", filepath, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	const AssetManifest::Asset* AssetManifest::Find(const std::string& name) const
+	{
+		const auto asset = m_Assets.find(name);
+		return asset != m_Assets.end() ? &asset->second : nullptr;
+	}
+
+	void AssetManifest::Add(const Asset& asset)
+	{
+		m_Assets[asset.Name] = asset;
+	}
+
+	bool AssetManifest::Load(const std::string& filepath, const std::string& folder)
+	{
+		auto loaded = std::make_shared<Loaded>();
+		loaded->Filepath = filepath;
+		loaded->Folder = VirtualFileSystem::Normalise(folder);
+		if (!loaded->Folder.empty() && loaded->Folder.back() != '/')
+		{
+			loaded->Folder += '/';
+		}
+
+		loaded->Manifest = std::make_unique<AssetManifest>();
+		if (!loaded->Manifest->Read(filepath))
+		{
+			VEL_CORE_ERROR("Failed to load asset manifest {0}", filepath);
+			return false;
+		}
+
+		for (const auto& asset : loaded->Manifest->GetAssets())
+		{
+			if (!asset.second.Output.empty())
+			{
+				loaded->Outputs[asset.second.Output] = asset.first;
+			}
+		}
+
+		VEL_CORE_INFO("Loaded asset manifest {0} ({1} assets)", filepath, loaded->Manifest->GetAssets().size());
+
+		std::lock_guard<std::mutex> lock(s_LoadMutex);
+		s_Loaded.push_back(loaded);
+		return true;
+	}
+
+	void AssetManifest::Unload(const std::string& filepath)
+	{
+		std::lock_guard<std::mutex> lock(s_LoadMutex);
+		s_Loaded.erase(std::remove_if(s_Loaded.begin(), s_Loaded.end(), [&filepath](const auto& loaded) { return loaded->Filepath == filepath; }), s_Loaded.end());
+	}
+
+	bool AssetManifest::FindSourceHash(const std::string& sourcePath, uint64_t& outHash)
+	{
+		std::shared_ptr<const Loaded> loaded;
+		const Asset* asset = Find(sourcePath, false, loaded);
+		if (!asset || asset->Type == AssetType::Material || asset->Inputs.empty() || asset->Inputs.front().Path != asset->Name)
+		{
+			return false;
+		}
+
+		const Input& source = asset->Inputs.front();
+		if (!IsUnchanged(loaded->Folder + source.Path, source))
+		{
+			return false;
+		}
+
+		outHash = source.Hash;
+		return true;
+	}
+
+	bool AssetManifest::IsCurrent(const std::string& cookedPath)
+	{
+		std::shared_ptr<const Loaded> loaded;
+		const Asset* asset = Find(cookedPath, true, loaded);
+		return asset && IsUnchanged(*loaded, *asset) && VirtualFileSystem::Exists(cookedPath);
+	}
+
+	bool AssetManifest::IsUnchanged(const std::string& filepath, const Input& input)
+	{
+		std::error_code error;
+		if (!std::filesystem::is_regular_file(filepath, error))
+		{
+			return true;
+		}
+
+		return static_cast<uint64_t>(std::filesystem::file_size(filepath, error)) == input.Size && GetWriteTime(filepath) == input.WriteTime;
+	}
+
+	int64_t AssetManifest::GetWriteTime(const std::string& filepath)
+	{
+		std::error_code error;
+		const auto time = std::filesystem::last_write_time(filepath, error);
+		return error ? 0 : static_cast<int64_t>(time.time_since_epoch().count());
+	}
+
+	const AssetManifest::Asset* AssetManifest::Find(const std::string& filepath, bool bOutput, std::shared_ptr<const Loaded>& outLoaded)
+	{
+		const std::string path = VirtualFileSystem::Normalise(filepath);
+
+		std::lock_guard<std::mutex> lock(s_LoadMutex);
+		for (auto it = s_Loaded.rbegin(); it != s_Loaded.rend(); ++it)
+		{
+			const auto& loaded = *it;
+			if (path.size() <= loaded->Folder.size() || path.compare(0, loaded->Folder.size(), loaded->Folder) != 0)
+			{
+				continue;
+			}
+
+			std::string name = path.substr(loaded->Folder.size());
+			if (bOutput)
+			{
+				const auto output = loaded->Outputs.find(name);
+				if (output == loaded->Outputs.end())
+				{
+					continue;
+				}
+				name = output->second;
+			}
+
+			if (const Asset* asset = loaded->Manifest->Find(name))
+			{
+				outLoaded = loaded;
+				return asset;
+			}
+		}
+		return nullptr;
+	}
+
+	bool AssetManifest::IsUnchanged(const Loaded& loaded, const Asset& asset)
+	{
+		return std::all_of(asset.Inputs.begin(), asset.Inputs.end(), [&loaded](const Input& input)
+		{
+			return IsUnchanged(loaded.Folder + input.Path, input);
+		});
+	}
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Velocity
+{
+	// What VelocityCooker built from each source asset under an assets folder, written into that folder
+	// The engine loads it over the folder like a pack, so cooked output is used without comparing timestamps or
+	// hashing sources. An entry only counts while its inputs look the same as when they were cooked, or are gone
+	// from the disk as in a build that only ships packs
+	class AssetManifest
+	{
+	public:
+		enum class AssetType : uint32_t
+		{
+			Mesh,		// Goes to the mesh cache, see MeshCache
+			Texture,	// Cooked next to its source
+			Material	// Mask maps packed into one cooked texture, see TextureCooker::CookMaterial
+		};
+
+		// A file an asset was built from, as it was when cooked
+		struct Input
+		{
+			std::string		Path;			// Relative to the folder
+			uint64_t		Size = 0u;
+			int64_t			WriteTime = 0;
+			uint64_t		Hash = 0u;		// Hash::Bytes of the whole file
+
+			template<class Archive>
+			void save(Archive& ar) const
+			{
+				ar(Path, Size, WriteTime, Hash);
+			}
+
+			template<class Archive>
+			void load(Archive& ar)
+			{
+				ar(Path, Size, WriteTime, Hash);
+			}
+		};
+
+		struct Asset
+		{
+			std::string			Name;				// Source for meshes and textures, the packed texture for materials. Relative to the folder
+			AssetType			Type = AssetType::Mesh;
+			std::vector<Input>	Inputs;
+			uint64_t			BuildKey = 0u;		// Covers the inputs and whatever else decides the output, rebuilt when it changes
+			std::string			Output;				// Cooked file relative to the folder, empty for meshes
+
+			template<class Archive>
+			void save(Archive& ar) const
+			{
+				ar(Name, static_cast<uint32_t>(Type), Inputs, BuildKey, Output);
+			}
+
+			template<class Archive>
+			void load(Archive& ar)
+			{
+				uint32_t type = 0u;
+				ar(Name, type, Inputs, BuildKey, Output);
+				Type = static_cast<AssetType>(type);
+			}
+		};
+
+		// Bump whenever Input or Asset change
+		static constexpr uint32_t FORMAT_VERSION = 1u;
+
+		static const char MAGIC[4];
+
+		// Name of the manifest inside the folder it covers
+		static const char* FILENAME;
+
+		// Reads a manifest through the VFS. Returns false and leaves this empty if it is missing, corrupt or out of date
+		bool Read(const std::string& filepath);
+
+		// Written beside the target and swapped in once whole
+		bool Write(const std::string& filepath) const;
+
+		// nullptr if there is no entry for the name
+		const Asset* Find(const std::string& name) const;
+
+		// Replaces any entry with the same name
+		void Add(const Asset& asset);
+
+		const std::unordered_map<std::string, Asset>& GetAssets() const { return m_Assets; }
+
+		// Loads a folder's manifest for the engine to use, given the way the engine names the folder e.g. "../Velocity/assets/"
+		// Later loads win over earlier ones. Returns false if the manifest is missing or corrupt
+		static bool Load(const std::string& filepath, const std::string& folder);
+		static void Unload(const std::string& filepath);
+
+		// Hash of the whole source recorded when it was cooked. Only found while the source is unchanged
+		static bool FindSourceHash(const std::string& sourcePath, uint64_t& outHash);
+
+		// True if a loaded manifest lists the cooked file, it exists and what it was built from is unchanged
+		static bool IsCurrent(const std::string& cookedPath);
+
+		// True if the file looks the same as it did when cooked, or isnt on the disk at all
+		static bool IsUnchanged(const std::string& filepath, const Input& input);
+
+		// Last write time as the manifest stores it
+		static int64_t GetWriteTime(const std::string& filepath);
+
+	private:
+		// A manifest the engine has loaded
+		struct Loaded
+		{
+			std::string										Filepath;
+			std::string										Folder;		// Normalised with a trailing '/'
+			std::unique_ptr<AssetManifest>					Manifest;
+			std::unordered_map<std::string, std::string>	Outputs;	// Cooked file to the asset that made it
+		};
+
+		// Newest loaded manifest with an entry for the path, nullptr if none have it. Path is relative to its folder
+		static const Asset* Find(const std::string& filepath, bool bOutput, std::shared_ptr<const Loaded>& outLoaded);
+
+		// True if every input is unchanged
+		static bool IsUnchanged(const Loaded& loaded, const Asset& asset);
+
+		std::unordered_map<std::string, Asset> m_Assets;
+
+		static std::mutex s_LoadMutex;
+		static std::vector<std::shared_ptr<const Loaded>> s_Loaded;
+	};
+}
@@ -0,0 +1,68 @@
+#include "velpch.h"
+
+#include "AssimpIOSystem.hpp"
+
+#include <cstring>
+
+namespace Velocity
+{
+	bool AssimpIOSystem::Exists(const char* pFile) const
+	{
+		return VirtualFileSystem::Exists(pFile);
+	}
+
+	Assimp::IOStream* AssimpIOSystem::Open(const char* pFile, const char* pMode)
+	{
+		// Packs are read only
+		if (strchr(pMode, 'w') || strchr(pMode, 'a') || strchr(pMode, '+'))
+		{
+			return DefaultIOSystem::Open(pFile, pMode);
+		}
+
+		VirtualFileSystem::File file;
+		if (!VirtualFileSystem::Open(pFile, file))
+		{
+			return nullptr;
+		}
+		return new AssimpIOStream(std::move(file));
+	}
+
+	void AssimpIOSystem::Close(Assimp::IOStream* pFile)
+	{
+		delete pFile;
+	}
+
+	size_t AssimpIOStream::Read(void* pvBuffer, size_t pSize, size_t pCount)
+	{
+		if (pSize == 0u || pCount == 0u)
+		{
+			return 0u;
+		}
+
+		// Whole elements only, as fread does
+		const size_t count = std::min(pCount, (m_File.GetSize() - m_Position) / pSize);
+		memcpy(pvBuffer, m_File.GetData() + m_Position, count * pSize);
+		m_Position += count * pSize;
+		return count;
+	}
+
+	aiReturn AssimpIOStream::Seek(size_t pOffset, aiOrigin pOrigin)
+	{
+		size_t position = pOffset;
+		if (pOrigin == aiOrigin_CUR)
+		{
+			position = m_Position + pOffset;
+		}
+		else if (pOrigin == aiOrigin_END)
+		{
+			position = m_File.GetSize() - pOffset;
+		}
+
+		if (position > m_File.GetSize())
+		{
+			return aiReturn_FAILURE;
+		}
+		m_Position = position;
+		return aiReturn_SUCCESS;
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <assimp/DefaultIOSystem.h>
+#include <assimp/IOStream.hpp>
+
+#include "VirtualFileSystem.hpp"
+
+namespace Velocity
+{
+	// Lets assimp read models, and the materials they pull in, through the VirtualFileSystem
+	// Derives from the default system so loose OBJ files still get the mapped parallel parser
+	// Writes and anything the VFS cant find go to the default system
+	class AssimpIOSystem : public Assimp::DefaultIOSystem
+	{
+	public:
+		bool Exists(const char* pFile) const override;
+		Assimp::IOStream* Open(const char* pFile, const char* pMode = "rb") override;
+		void Close(Assimp::IOStream* pFile) override;
+	};
+
+	// A whole file opened through the VFS, read out of memory
+	class AssimpIOStream : public Assimp::IOStream
+	{
+	public:
+		explicit AssimpIOStream(VirtualFileSystem::File&& file) : m_File(std::move(file)) {}
+
+		size_t Read(void* pvBuffer, size_t pSize, size_t pCount) override;
+		size_t Write(const void* pvBuffer, size_t pSize, size_t pCount) override { return 0u; }
+		aiReturn Seek(size_t pOffset, aiOrigin pOrigin) override;
+		size_t Tell() const override { return m_Position; }
+		size_t FileSize() const override { return m_File.GetSize(); }
+		void Flush() override {}
+
+	private:
+		VirtualFileSystem::File	m_File;
+		size_t					m_Position = 0u;
+	};
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+// Fast non cryptographic hashing used to key derived data (caches, asset ids)
+
+namespace Velocity
+{
+	// Straight implementation of XXH64 so keys match any other xxhash tool
+	class Hash
+	{
+	public:
+		static uint64_t Bytes(const void* data, size_t size, uint64_t seed = 0u)
+		{
+			const auto* pointer = static_cast<const uint8_t*>(data);
+			const auto* end = pointer + size;
+			uint64_t hash;
+
+			if (size >= 32)
+			{
+				uint64_t acc1 = seed + PRIME_1 + PRIME_2;
+				uint64_t acc2 = seed + PRIME_2;
+				uint64_t acc3 = seed;
+				uint64_t acc4 = seed - PRIME_1;
+
+				// 32 byte stripes, four independent lanes
+				const auto* limit = end - 32;
+				do
+				{
+					acc1 = Round(acc1, Read64(pointer));
+					acc2 = Round(acc2, Read64(pointer + 8));
+					acc3 = Round(acc3, Read64(pointer + 16));
+					acc4 = Round(acc4, Read64(pointer + 24));
+					pointer += 32;
+				} while (pointer <= limit);
+
+				hash = RotateLeft(acc1, 1) + RotateLeft(acc2, 7) + RotateLeft(acc3, 12) + RotateLeft(acc4, 18);
+				hash = MergeRound(hash, acc1);
+				hash = MergeRound(hash, acc2);
+				hash = MergeRound(hash, acc3);
+				hash = MergeRound(hash, acc4);
+			}
+			else
+			{
+				hash = seed + PRIME_5;
+			}
+
+			hash += static_cast<uint64_t>(size);
+
+			// Tail
+			while (pointer + 8 <= end)
+			{
+				hash ^= Round(0, Read64(pointer));
+				hash = RotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+				pointer += 8;
+			}
+
+			if (pointer + 4 <= end)
+			{
+				hash ^= static_cast<uint64_t>(Read32(pointer)) * PRIME_1;
+				hash = RotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+				pointer += 4;
+			}
+
+			while (pointer < end)
+			{
+				hash ^= static_cast<uint64_t>(*pointer) * PRIME_5;
+				hash = RotateLeft(hash, 11) * PRIME_1;
+				++pointer;
+			}
+
+			// Avalanche
+			hash ^= hash >> 33;
+			hash *= PRIME_2;
+			hash ^= hash >> 29;
+			hash *= PRIME_3;
+			hash ^= hash >> 32;
+
+			return hash;
+		}
+
+		static uint64_t String(const std::string& string, uint64_t seed = 0u)
+		{
+			return Bytes(string.data(), string.size(), seed);
+		}
+
+		// Folds a value into an existing hash
+		template<typename T>
+		static uint64_t Combine(uint64_t hash, const T& value)
+		{
+			return Bytes(&value, sizeof(T), hash);
+		}
+
+		// 16 hex characters, used for cache file names
+		static std::string ToString(uint64_t hash)
+		{
+			static const char* digits = "0123456789abcdef";
+			std::string result(16, '0');
+			for (int i = 15; i >= 0; --i)
+			{
+				result[i] = digits[hash & 0xF];
+				hash >>= 4;
+			}
+			return result;
+		}
+
+	private:
+		static constexpr uint64_t PRIME_1 = 11400714785074694791ull;
+		static constexpr uint64_t PRIME_2 = 14029467366897019727ull;
+		static constexpr uint64_t PRIME_3 = 1609587929392839161ull;
+		static constexpr uint64_t PRIME_4 = 9650029242287828579ull;
+		static constexpr uint64_t PRIME_5 = 2870177450012600261ull;
+
+		static uint64_t RotateLeft(uint64_t value, int bits) { return (value << bits) | (value >> (64 - bits)); }
+
+		static uint64_t Read64(const uint8_t* pointer) { uint64_t value; memcpy(&value, pointer, sizeof(value)); return value; }
+		static uint32_t Read32(const uint8_t* pointer) { uint32_t value; memcpy(&value, pointer, sizeof(value)); return value; }
+
+		static uint64_t Round(uint64_t acc, uint64_t lane)
+		{
+			acc += lane * PRIME_2;
+			acc = RotateLeft(acc, 31);
+			return acc * PRIME_1;
+		}
+
+		static uint64_t MergeRound(uint64_t acc, uint64_t value)
+		{
+			acc ^= Round(0, value);
+			return acc * PRIME_1 + PRIME_4;
+		}
+	};
+}
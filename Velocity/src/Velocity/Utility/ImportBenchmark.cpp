@@ -0,0 +1,215 @@
+#include "velpch.h"
+
+#include "ImportBenchmark.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/Renderer/BufferManager.hpp>
+
+namespace Velocity
+{
+	const char* ImportBenchmark::BENCHMARK_DIRECTORY = "../Velocity/cache/benchmarks/";
+
+	namespace
+	{
+		// Rough size of one grid vertex in the generated file, its v/vt/vn lines plus its share of the faces
+		constexpr uint64_t BYTES_PER_GRID_VERTEX = 180u;
+
+		// Rows of the grid written to each group so the file has more than one mesh
+		constexpr uint32_t ROWS_PER_GROUP = 256u;
+
+		template<typename T>
+		bool SameArray(const std::vector<T>& a, const std::vector<T>& b)
+		{
+			return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), sizeof(T) * a.size()) == 0);
+		}
+
+		bool SameMesh(const ImportedMesh& a, const ImportedMesh& b)
+		{
+			return SameArray(a.Vertices, b.Vertices) && SameArray(a.Indices, b.Indices) &&
+				SameArray(a.Meshlets, b.Meshlets) && SameArray(a.LODs, b.LODs) &&
+				a.BoundsMin == b.BoundsMin && a.BoundsMax == b.BoundsMax;
+		}
+	}
+
+	ImportBenchmark::PostProcessResult ImportBenchmark::RunPostProcess(const std::string& filepath)
+	{
+		PostProcessResult result;
+
+		MeshImportOptions serialOptions;
+		serialOptions.ParallelPostProcess = false;
+
+		ImportedMesh serialMesh;
+		auto start = std::chrono::high_resolution_clock::now();
+		const bool serialLoaded = BufferManager::ImportMesh(filepath, serialMesh, serialOptions);
+		result.SerialSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		ImportedMesh parallelMesh;
+		start = std::chrono::high_resolution_clock::now();
+		const bool parallelLoaded = BufferManager::ImportMesh(filepath, parallelMesh);
+		result.ParallelSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (!serialLoaded || !parallelLoaded)
+		{
+			VEL_CORE_ERROR("Post processing benchmark failed to import {0}", filepath);
+			return result;
+		}
+
+		result.MeshesMatch = SameMesh(serialMesh, parallelMesh);
+
+		VEL_CORE_INFO("Post processing benchmark, {0}: {1} vertices, {2} triangles", filepath, serialMesh.Vertices.size(), serialMesh.Indices.size() / 3u);
+		VEL_CORE_INFO("  Serial:   {0:.3f}s", result.SerialSeconds);
+		VEL_CORE_INFO("  Parallel: {0:.3f}s ({1:.2f}x)", result.ParallelSeconds, result.SerialSeconds / std::max<double>(result.ParallelSeconds, 1e-9));
+		if (result.MeshesMatch)
+		{
+			VEL_CORE_INFO("  Meshes match");
+		}
+		else
+		{
+			VEL_CORE_ERROR("  Meshes differ!");
+		}
+
+		return result;
+	}
+	ImportBenchmark::ObjResult ImportBenchmark::RunObj(uint64_t targetBytes)
+	{
+		ObjResult result;
+
+		const std::string filepath = std::string(BENCHMARK_DIRECTORY) + "obj_" + std::to_string(targetBytes / (1024u * 1024u)) + "mb.obj";
+
+		std::error_code error;
+		if (!std::filesystem::exists(filepath, error))
+		{
+			VEL_CORE_INFO("Generating OBJ benchmark file {0}", filepath);
+			if (!GenerateObj(filepath, targetBytes))
+			{
+				VEL_CORE_ERROR("Failed to write OBJ benchmark file {0}", filepath);
+				return result;
+			}
+		}
+		result.FileSize = std::filesystem::file_size(filepath, error);
+
+		MeshImportOptions assimpOptions;
+		assimpOptions.FastObj = false;
+
+		ImportedMesh assimpMesh;
+		auto start = std::chrono::high_resolution_clock::now();
+		const bool assimpLoaded = BufferManager::ImportMesh(filepath, assimpMesh, assimpOptions);
+		result.AssimpSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		ImportedMesh fastMesh;
+		start = std::chrono::high_resolution_clock::now();
+		const bool fastLoaded = BufferManager::ImportMesh(filepath, fastMesh);
+		result.FastSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+		if (!assimpLoaded || !fastLoaded)
+		{
+			VEL_CORE_ERROR("OBJ benchmark failed to import {0}", filepath);
+			return result;
+		}
+
+		result.MeshesMatch = SameMesh(assimpMesh, fastMesh);
+
+		VEL_CORE_INFO("OBJ import benchmark, {0} MB", result.FileSize / (1024u * 1024u));
+		VEL_CORE_INFO("  Assimp:    {0:.3f}s", result.AssimpSeconds);
+		VEL_CORE_INFO("  ObjLoader: {0:.3f}s ({1:.2f}x)", result.FastSeconds, result.AssimpSeconds / std::max<double>(result.FastSeconds, 1e-9));
+		if (result.MeshesMatch)
+		{
+			VEL_CORE_INFO("  Meshes match");
+		}
+		else
+		{
+			VEL_CORE_ERROR("  Meshes differ!");
+		}
+
+		return result;
+	}
+
+	bool ImportBenchmark::GenerateObj(const std::string& filepath, uint64_t targetBytes)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(std::filesystem::path(filepath).parent_path(), error);
+
+		std::ofstream output(filepath, std::ios::binary | std::ios::trunc);
+		if (!output.is_open())
+		{
+			return false;
+		}
+
+		const uint32_t side = std::max<uint32_t>(2u, static_cast<uint32_t>(std::sqrt(static_cast<double>(targetBytes / BYTES_PER_GRID_VERTEX))));
+
+		// Lines are built up in memory and written out in large blocks
+		std::string buffer;
+		buffer.reserve(16u * 1024u * 1024u);
+		char line[256];
+
+		auto flushIfFull = [&buffer, &output]()
+		{
+			if (buffer.size() > 15u * 1024u * 1024u)
+			{
+				output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+				buffer.clear();
+			}
+		};
+
+		buffer += "# Velocity OBJ import benchmark\n";
+
+		// Gently rolling height field so the values arent all trivial
+		for (uint32_t z = 0; z < side; ++z)
+		{
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const float height = std::sin(x * 0.05f) * std::cos(z * 0.05f) * 4.0f;
+				const int length = snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x * 0.25f, height, z * 0.25f);
+				buffer.append(line, length);
+				flushIfFull();
+			}
+		}
+		for (uint32_t z = 0; z < side; ++z)
+		{
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const int length = snprintf(line, sizeof(line), "vt %.6f %.6f\n", x / static_cast<float>(side - 1u), z / static_cast<float>(side - 1u));
+				buffer.append(line, length);
+				flushIfFull();
+			}
+		}
+		for (uint32_t z = 0; z < side; ++z)
+		{
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				const glm::vec3 normal = glm::normalize(glm::vec3(-std::cos(x * 0.05f) * 0.2f, 1.0f, std::sin(z * 0.05f) * 0.2f));
+				const int length = snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", normal.x, normal.y, normal.z);
+				buffer.append(line, length);
+				flushIfFull();
+			}
+		}
+
+		for (uint32_t z = 0; z + 1u < side; ++z)
+		{
+			if (z % ROWS_PER_GROUP == 0u)
+			{
+				const int length = snprintf(line, sizeof(line), "g rows_%u\n", z);
+				buffer.append(line, length);
+			}
+
+			for (uint32_t x = 0; x + 1u < side; ++x)
+			{
+				// OBJ indices are 1 based
+				const uint32_t a = z * side + x + 1u;
+				const uint32_t b = a + 1u;
+				const uint32_t c = a + side + 1u;
+				const uint32_t d = a + side;
+				const int length = snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+				buffer.append(line, length);
+				flushIfFull();
+			}
+		}
+
+		output.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		return output.good();
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Velocity
+{
+	// Timings and correctness checks for the mesh import paths. Results are logged as well as returned
+	class ImportBenchmark
+	{
+	public:
+		struct PostProcessResult
+		{
+			double		SerialSeconds = 0.0;
+			double		ParallelSeconds = 0.0;
+			bool		MeshesMatch = false;
+		};
+
+		struct ObjResult
+		{
+			uint64_t	FileSize = 0u;
+			double		AssimpSeconds = 0.0;
+			double		FastSeconds = 0.0;
+			bool		MeshesMatch = false;
+		};
+
+		static constexpr uint64_t DEFAULT_OBJ_SIZE = 1024ull * 1024ull * 1024ull;
+
+		// Imports the file with sub meshes post processed one after another and then in parallel
+		// The parallel path has to give exactly the same vertices, indices and meshlets
+		static PostProcessResult RunPostProcess(const std::string& filepath);
+
+		// Generates a test file of roughly targetBytes (reused if already there), imports it through assimp and ObjLoader and logs the timings
+		// Both have to give exactly the same mesh
+		static ObjResult RunObj(uint64_t targetBytes = DEFAULT_OBJ_SIZE);
+
+		// Writes a grid mesh with positions, uvs, normals and groups. Returns false if the file cant be written
+		static bool GenerateObj(const std::string& filepath, uint64_t targetBytes);
+
+		static const char* BENCHMARK_DIRECTORY;
+	};
+}
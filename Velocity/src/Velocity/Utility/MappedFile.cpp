@@ -0,0 +1,142 @@
+#include "velpch.h"
+
+#include "MappedFile.hpp"
+
+#ifndef VEL_PLATFORM_WINDOWS
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace Velocity
+{
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+
+			m_Data = other.m_Data;
+			m_Size = other.m_Size;
+			m_Open = other.m_Open;
+			m_FileHandle = other.m_FileHandle;
+			m_MappingHandle = other.m_MappingHandle;
+
+			other.m_Data = nullptr;
+			other.m_Size = 0u;
+			other.m_Open = false;
+			other.m_FileHandle = nullptr;
+			other.m_MappingHandle = nullptr;
+		}
+		return *this;
+	}
+
+	bool MappedFile::Open(const std::string& filepath)
+	{
+		Close();
+
+#ifdef VEL_PLATFORM_WINDOWS
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_FileHandle = file;
+		m_Size = static_cast<size_t>(size.QuadPart);
+		m_Open = true;
+
+		// Empty files cant be mapped but are still valid
+		if (m_Size == 0u)
+		{
+			return true;
+		}
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			Close();
+			return false;
+		}
+		m_MappingHandle = mapping;
+
+		m_Data = static_cast<const uint8_t*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+		if (m_Data == nullptr)
+		{
+			Close();
+			return false;
+		}
+#else
+		int file = open(filepath.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat info;
+		if (fstat(file, &info) != 0)
+		{
+			close(file);
+			return false;
+		}
+
+		m_Size = static_cast<size_t>(info.st_size);
+		m_Open = true;
+
+		if (m_Size > 0u)
+		{
+			void* data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, file, 0);
+			if (data == MAP_FAILED)
+			{
+				close(file);
+				m_Size = 0u;
+				m_Open = false;
+				return false;
+			}
+			m_Data = static_cast<const uint8_t*>(data);
+		}
+
+		// The mapping keeps its own reference
+		close(file);
+#endif
+
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef VEL_PLATFORM_WINDOWS
+		if (m_Data)
+		{
+			UnmapViewOfFile(m_Data);
+		}
+		if (m_MappingHandle)
+		{
+			CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+		}
+		if (m_FileHandle)
+		{
+			CloseHandle(static_cast<HANDLE>(m_FileHandle));
+		}
+#else
+		if (m_Data)
+		{
+			munmap(const_cast<uint8_t*>(m_Data), m_Size);
+		}
+#endif
+
+		m_Data = nullptr;
+		m_Size = 0u;
+		m_Open = false;
+		m_FileHandle = nullptr;
+		m_MappingHandle = nullptr;
+	}
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+namespace Velocity
+{
+	// Read only memory mapping of a whole file
+	// The OS pages data in as it is touched so large files can be read without an up front copy
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		explicit MappedFile(const std::string& filepath) { Open(filepath); }
+		~MappedFile() { Close(); }
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept { *this = std::move(other); }
+		MappedFile& operator=(MappedFile&& other) noexcept;
+
+		// Returns false if the file doesnt exist or cant be mapped
+		bool Open(const std::string& filepath);
+		void Close();
+
+		bool IsOpen() const { return m_Data != nullptr || (m_Open && m_Size == 0u); }
+
+		const uint8_t* GetData() const { return m_Data; }
+		size_t GetSize() const { return m_Size; }
+
+	private:
+		const uint8_t*	m_Data = nullptr;
+		size_t			m_Size = 0u;
+		bool			m_Open = false;
+
+		// Platform handles. Kept as void* so Windows.h isnt dragged into every include
+		void*			m_FileHandle = nullptr;
+		void*			m_MappingHandle = nullptr;
+	};
+}
@@ -0,0 +1,267 @@
+#include "velpch.h"
+
+#include "SceneBenchmark.hpp"
+#include "ImportBenchmark.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/ECS/Entity.hpp>
+#include <Velocity/ECS/SceneArchive.hpp>
+#include <Velocity/ECS/SceneAutosave.hpp>
+#include <Velocity/ECS/SceneCodec.hpp>
+#include <Velocity/Utility/ThreadPool.hpp>
+
+namespace Velocity
+{
+	namespace
+	{
+		struct SourceChunk
+		{
+			SceneChunk								Type = SceneChunk::Scene;
+			uint32_t								ElementSize = 0u;
+			std::shared_ptr<std::vector<uint8_t>>	Data;
+		};
+
+		std::vector<SceneBenchmark::Result> GetCombinations()
+		{
+			std::vector<SceneBenchmark::Result> combinations;
+			auto add = [&combinations](const std::string& name, const SceneSaveOptions& options)
+			{
+				combinations.push_back({ name, options });
+			};
+
+			add("Uncompressed", SceneSaveOptions::Uniform(SceneCompression::None, 0, false));
+			add("Snappy", SceneSaveOptions::Fast());
+			add("Snappy + filters", SceneSaveOptions::Uniform(SceneCompression::Snappy, 0, true));
+			add("Default", SceneSaveOptions());
+
+			for (int level : { 1, 6, 9 })
+			{
+				const std::string name = "Deflate " + std::to_string(level);
+				add(name, SceneSaveOptions::Uniform(SceneCompression::Deflate, level, false));
+				add(name + " + filters", SceneSaveOptions::Uniform(SceneCompression::Deflate, level, true));
+			}
+
+			// Fast geometry with strong pixels, the usual split once textures dominate
+			SceneSaveOptions mixed;
+			mixed.Pixels.Codec = SceneCompression::Deflate;
+			mixed.Pixels.Level = 6;
+			add("Snappy geometry, Deflate 6 pixels", mixed);
+			return combinations;
+		}
+	}
+
+	std::vector<SceneBenchmark::Result> SceneBenchmark::Run(const std::string& scenePath)
+	{
+		std::vector<Result> results;
+
+		SceneFileReader source;
+		if (!source.Open(scenePath) || source.GetVersion() != SceneFile::FORMAT_VERSION)
+		{
+			VEL_CORE_ERROR("Scene benchmark needs a scene saved by this version, {0} isnt one. Save it again first", scenePath);
+			return results;
+		}
+
+		// Everything is decoded up front so each combination starts from the same memory
+		const auto& entries = source.GetChunks();
+		std::vector<SourceChunk> chunks(entries.size());
+		uint64_t totalSize = 0u;
+		for (size_t i = 0; i < entries.size(); ++i)
+		{
+			chunks[i].Type = entries[i].Type;
+			chunks[i].ElementSize = entries[i].ElementSize;
+			chunks[i].Data = std::make_shared<std::vector<uint8_t>>(static_cast<size_t>(entries[i].Size));
+			totalSize += entries[i].Size;
+		}
+
+		std::atomic<bool> bRead = true;
+		ThreadPool::Get().ParallelFor(chunks.size(), [&](size_t i)
+		{
+			if (!source.Read(entries[i], chunks[i].Data->data()))
+			{
+				bRead = false;
+			}
+		});
+		if (!bRead)
+		{
+			VEL_CORE_ERROR("Scene benchmark couldnt read {0}", scenePath);
+			return results;
+		}
+
+		std::error_code error;
+		std::filesystem::create_directories(ImportBenchmark::BENCHMARK_DIRECTORY, error);
+		const std::string outputPath = std::string(ImportBenchmark::BENCHMARK_DIRECTORY) + "scene_codecs.velocity";
+
+		// Reused between combinations, sized once so the load timing doesnt include allocation
+		std::vector<std::vector<uint8_t>> loaded(chunks.size());
+		for (size_t i = 0; i < chunks.size(); ++i)
+		{
+			loaded[i].resize(chunks[i].Data->size());
+		}
+
+		VEL_CORE_INFO("Scene compression benchmark, {0} chunks, {1:.2f} MB", chunks.size(), totalSize / (1024.0 * 1024.0));
+		for (auto& result : GetCombinations())
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+			{
+				SceneFileWriter writer;
+				writer.Begin(outputPath, result.Options);
+				for (const auto& chunk : chunks)
+				{
+					writer.AddChunk(chunk.Type, chunk.Data, chunk.Data->data(), chunk.Data->size(), chunk.ElementSize);
+				}
+				if (!writer.Finish())
+				{
+					VEL_CORE_ERROR("  {0}: failed to write", result.Name);
+					continue;
+				}
+			}
+			result.SaveSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+			result.FileSize = std::filesystem::file_size(outputPath, error);
+
+			// Read back the way the loader does, every chunk in parallel
+			start = std::chrono::high_resolution_clock::now();
+			SceneFileReader reader;
+			std::atomic<bool> bLoaded = reader.Open(outputPath) && reader.GetChunks().size() == chunks.size();
+			if (bLoaded)
+			{
+				const auto& written = reader.GetChunks();
+				ThreadPool::Get().ParallelFor(written.size(), [&](size_t i)
+				{
+					if (!reader.Read(written[i], loaded[i].data()))
+					{
+						bLoaded = false;
+					}
+				});
+			}
+			result.LoadSeconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+			result.RoundTrips = bLoaded;
+			for (size_t i = 0; i < chunks.size() && result.RoundTrips; ++i)
+			{
+				result.RoundTrips = loaded[i] == *chunks[i].Data;
+			}
+
+			VEL_CORE_INFO("  {0:<36} {1:>9.2f} MB {2:>6.2f}x  save {3:.3f}s  load {4:.3f}s{5}", result.Name,
+				result.FileSize / (1024.0 * 1024.0), totalSize / std::max<double>(static_cast<double>(result.FileSize), 1.0),
+				result.SaveSeconds, result.LoadSeconds, result.RoundTrips ? "" : "  MISMATCH");
+			results.push_back(result);
+		}
+
+		std::filesystem::remove(outputPath, error);
+		return results;
+	}
+
+	SceneBenchmark::AutosaveResult SceneBenchmark::RunAutosave(uint32_t entityCount, uint32_t changesPerFrame)
+	{
+		using Clock = std::chrono::high_resolution_clock;
+		auto secondsSince = [](Clock::time_point start) { return std::chrono::duration<double>(Clock::now() - start).count(); };
+
+		AutosaveResult result;
+		result.EntityCount = entityCount;
+
+		// Named so it never replaces the autosave of a real scene
+		Scene scene;
+		scene.m_SceneName = "VEL_BENCHMARK_Autosave";
+		scene.m_SceneCamera = std::make_unique<Camera>();
+		for (uint32_t i = 0; i < entityCount; ++i)
+		{
+			Entity entity = scene.CreateEntity("Benchmark " + std::to_string(i));
+			entity.AddComponent<MeshComponent>().MeshReference = "VEL_INTERNAL_Skybox";
+			entity.GetComponent<TransformComponent>().Translation = { static_cast<float>(i % 1000u), 0.0f, static_cast<float>(i / 1000u) };
+		}
+		scene.ClearDirty();
+
+		auto start = Clock::now();
+		{
+			entt::registry copy;
+			scene.CopyRegistry(copy);
+			result.CopySeconds = secondsSince(start);
+		}
+
+		start = Clock::now();
+		{
+			std::ostringstream stream;
+			cereal::BinaryOutputArchive archive(stream);
+			SceneArchive::WriteRegistry(archive, scene.m_Registry);
+		}
+		result.SerialiseSeconds = secondsSince(start);
+
+		const std::string path = SceneAutosave::GetPath(scene.GetSceneName());
+		{
+			start = Clock::now();
+			SceneAutosave autosave(&scene);
+			result.StartSeconds = secondsSince(start);
+
+			std::mt19937 random(1234u);
+			std::uniform_int_distribution<size_t> pick(0u, scene.m_Entities.size() - 1u);
+			uint32_t fullCount = 0u;
+			uint32_t deltaCount = 0u;
+			for (uint32_t frame = 0; frame < AUTOSAVE_FRAMES; ++frame)
+			{
+				for (uint32_t i = 0; i < changesPerFrame; ++i)
+				{
+					Entity entity = scene.m_Entities[pick(random)];
+					entity.GetComponent<TransformComponent>().Translation.y += 1.0f;
+					entity.NotifyChanged<TransformComponent>();
+				}
+
+				// Any asset change makes the next autosave a full one
+				if (frame % 4u == 0u)
+				{
+					autosave.m_AssetSignature = 0u;
+				}
+
+				start = Clock::now();
+				autosave.Update(SceneAutosave::INTERVAL_SECONDS);
+				const double mainSeconds = secondsSince(start);
+				if (!autosave.m_Job.valid())
+				{
+					continue;
+				}
+				const bool bFull = autosave.m_Snapshot != nullptr;
+
+				// Waited for here so every frame has something to hand off, real ones wait for the next interval
+				start = Clock::now();
+				autosave.m_Job.wait();
+				const double workerSeconds = mainSeconds + secondsSince(start);
+
+				if (bFull)
+				{
+					++fullCount;
+					result.MaxFullSeconds = std::max(result.MaxFullSeconds, mainSeconds);
+					result.AverageFullSeconds += mainSeconds;
+					result.AverageWorkerSeconds += workerSeconds;
+				}
+				else
+				{
+					++deltaCount;
+					result.MaxDeltaSeconds = std::max(result.MaxDeltaSeconds, mainSeconds);
+					result.AverageDeltaSeconds += mainSeconds;
+				}
+			}
+			result.AverageFullSeconds /= std::max(fullCount, 1u);
+			result.AverageWorkerSeconds /= std::max(fullCount, 1u);
+			result.AverageDeltaSeconds /= std::max(deltaCount, 1u);
+		}
+
+		std::error_code error;
+		std::filesystem::remove(path, error);
+		std::filesystem::remove(SceneJournal::GetPath(path), error);
+
+		VEL_CORE_INFO("Autosave benchmark, {0} entities, {1} changed a frame", entityCount, changesPerFrame);
+		VEL_CORE_INFO("  Whole registry on the main thread: copy {0:.2f} ms, serialise {1:.2f} ms", result.CopySeconds * 1000.0, result.SerialiseSeconds * 1000.0);
+		VEL_CORE_INFO("  Starting the autosave: {0:.2f} ms", result.StartSeconds * 1000.0);
+		VEL_CORE_INFO("  Full autosave main thread: max {0:.3f} ms, average {1:.3f} ms, written after {2:.2f} ms", result.MaxFullSeconds * 1000.0,
+			result.AverageFullSeconds * 1000.0, result.AverageWorkerSeconds * 1000.0);
+		VEL_CORE_INFO("  Delta autosave main thread: max {0:.3f} ms, average {1:.3f} ms", result.MaxDeltaSeconds * 1000.0, result.AverageDeltaSeconds * 1000.0);
+		return result;
+	}
+}
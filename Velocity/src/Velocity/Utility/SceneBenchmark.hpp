@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <Velocity/ECS/SceneFile.hpp>
+
+namespace Velocity
+{
+	// Rewrites a saved scene with each codec, level and filter combination and reads it back
+	// Only the container is measured, chunks are read into memory and nothing is uploaded so it can run off the main thread
+	class SceneBenchmark
+	{
+	public:
+		struct Result
+		{
+			std::string			Name;
+			SceneSaveOptions	Options;
+			uint64_t			FileSize = 0u;
+			double				SaveSeconds = 0.0;
+			double				LoadSeconds = 0.0;
+			bool				RoundTrips = false;
+		};
+
+		// Logs a line per combination. Run it from a thread outside the pool so chunks compress in parallel like a real save
+		// Loads are read from a file that was just written so are mostly served from the OS cache
+		static std::vector<Result> Run(const std::string& scenePath);
+
+		struct AutosaveResult
+		{
+			uint32_t	EntityCount = 0u;
+
+			// The whole registry copied and serialised, what a full autosave used to cost the main thread
+			double		CopySeconds = 0.0;
+			double		SerialiseSeconds = 0.0;
+
+			// Starting the autosave, which copies the registry once
+			double		StartSeconds = 0.0;
+
+			// Main thread time of each Update that handed off a full save or a delta
+			double		MaxFullSeconds = 0.0;
+			double		AverageFullSeconds = 0.0;
+			double		MaxDeltaSeconds = 0.0;
+			double		AverageDeltaSeconds = 0.0;
+
+			// From a full save being handed off to it being written
+			double		AverageWorkerSeconds = 0.0;
+		};
+
+		static constexpr uint32_t AUTOSAVE_ENTITY_COUNT = 100000u;
+		static constexpr uint32_t AUTOSAVE_FRAMES = 64u;
+
+		// Autosaves a generated scene every frame with changesPerFrame entities moved in between, every fourth one full
+		// as if an asset had changed, and logs how long the main thread spent on each. Main thread only, it reads the
+		// renderer like a real autosave. The autosave it writes is removed afterwards
+		static AutosaveResult RunAutosave(uint32_t entityCount = AUTOSAVE_ENTITY_COUNT, uint32_t changesPerFrame = 100u);
+	};
+}
@@ -0,0 +1,146 @@
+#include "velpch.h"
+
+#include "ThreadPool.hpp"
+
+#include <exception>
+
+namespace Velocity
+{
+	namespace
+	{
+		thread_local bool s_IsWorker = false;
+	}
+
+	ThreadPool::ThreadPool(size_t threadCount)
+	{
+		if (threadCount == 0u)
+		{
+			const size_t cores = std::thread::hardware_concurrency();
+			threadCount = cores > 1u ? cores - 1u : 1u;
+		}
+
+		m_Workers.reserve(threadCount);
+		for (size_t i = 0; i < threadCount; ++i)
+		{
+			m_Workers.emplace_back([this]() { WorkerLoop(); });
+		}
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_all();
+
+		// Workers drain whatever is left in the queue before exiting
+		for (auto& worker : m_Workers)
+		{
+			worker.join();
+		}
+	}
+
+	void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& function)
+	{
+		if (count == 0u)
+		{
+			return;
+		}
+
+		// Helpers and the caller pull indices from the same counter
+		// We wait on finished items rather than helper tasks, so helpers stuck behind busy workers never block us
+		struct SharedState
+		{
+			std::atomic<size_t>		Next{ 0u };
+			std::atomic<size_t>		Done{ 0u };
+			std::mutex				Mutex;
+			std::condition_variable	Finished;
+			std::exception_ptr		Error;		// First thrown, under Mutex
+		};
+
+		auto state = std::make_shared<SharedState>();
+
+		auto work = [state, count, &function]()
+		{
+			size_t index;
+			while ((index = state->Next.fetch_add(1u)) < count)
+			{
+				// An item that throws still counts as done, otherwise the wait below never ends
+				try
+				{
+					function(index);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock(state->Mutex);
+					if (!state->Error)
+					{
+						state->Error = std::current_exception();
+					}
+				}
+
+				if (state->Done.fetch_add(1u) + 1u == count)
+				{
+					std::lock_guard<std::mutex> lock(state->Mutex);
+					state->Finished.notify_all();
+				}
+			}
+		};
+
+		const size_t helpers = std::min(count - 1u, m_Workers.size());
+		{
+			std::lock_guard<std::mutex> lock(m_QueueMutex);
+			for (size_t i = 0; i < helpers; ++i)
+			{
+				m_Tasks.emplace(work);
+			}
+		}
+		m_Condition.notify_all();
+
+		work();
+
+		std::unique_lock<std::mutex> lock(state->Mutex);
+		state->Finished.wait(lock, [&state, count]() { return state->Done.load() == count; });
+
+		if (state->Error)
+		{
+			std::rethrow_exception(state->Error);
+		}
+	}
+
+	bool ThreadPool::IsWorkerThread()
+	{
+		return s_IsWorker;
+	}
+
+	ThreadPool& ThreadPool::Get()
+	{
+		static ThreadPool s_Pool;
+		return s_Pool;
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		s_IsWorker = true;
+
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(m_QueueMutex);
+				m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+				if (m_Stopping && m_Tasks.empty())
+				{
+					return;
+				}
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace Velocity
+{
+	// Fixed set of worker threads pulling from one queue
+	// Anything touching Vulkan must still happen on the main thread, workers are for CPU work only
+	class ThreadPool
+	{
+	public:
+		// 0 threads means one less than the core count so the main thread keeps a core
+		explicit ThreadPool(size_t threadCount = 0u);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		// Queues a task. The future holds the result or any exception thrown
+		template<typename Function>
+		auto Enqueue(Function&& task) -> std::future<std::invoke_result_t<Function>>
+		{
+			using Result = std::invoke_result_t<Function>;
+
+			auto packaged = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(task));
+			auto future = packaged->get_future();
+			{
+				std::lock_guard<std::mutex> lock(m_QueueMutex);
+				m_Tasks.emplace([packaged]() { (*packaged)(); });
+			}
+			m_Condition.notify_one();
+
+			return future;
+		}
+
+		// Runs function(i) for every i in [0,count) and returns once all are done
+		// The calling thread helps out, so this is safe to call from inside a worker
+		// If any call throws the rest still run, then the first exception is rethrown here
+		void ParallelFor(size_t count, const std::function<void(size_t)>& function);
+
+		size_t GetThreadCount() const { return m_Workers.size(); }
+
+		// True on any pool worker. Lets nested work avoid spinning up threads of its own
+		static bool IsWorkerThread();
+
+		// Shared engine pool
+		static ThreadPool& Get();
+
+	private:
+		void WorkerLoop();
+
+		std::vector<std::thread>			m_Workers;
+		std::queue<std::function<void()>>	m_Tasks;
+
+		std::mutex							m_QueueMutex;
+		std::condition_variable				m_Condition;
+		bool								m_Stopping = false;
+	};
+}
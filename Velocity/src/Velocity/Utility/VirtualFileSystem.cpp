@@ -0,0 +1,421 @@
+#include "velpch.h"
+
+#include "VirtualFileSystem.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include <Velocity/Core/Log.hpp>
+#include <Velocity/ECS/SceneCodec.hpp>
+
+#include "Hash.hpp"
+#include "ThreadPool.hpp"
+
+namespace Velocity
+{
+	const char VirtualFileSystem::MAGIC[4] = { 'V','P','A','K' };
+	const char* VirtualFileSystem::EXTENSION = ".vpak";
+
+	std::mutex VirtualFileSystem::s_MountMutex;
+	std::vector<std::shared_ptr<const VirtualFileSystem::Pack>> VirtualFileSystem::s_Packs;
+	std::atomic<bool> VirtualFileSystem::s_bLooseFiles = true;
+
+	bool VirtualFileSystem::Mount(const std::string& packPath, const std::string& mountPoint)
+	{
+		auto pack = std::make_shared<Pack>();
+		pack->Filepath = packPath;
+		pack->MountPoint = Normalise(mountPoint);
+		if (!pack->MountPoint.empty() && pack->MountPoint.back() != '/')
+		{
+			pack->MountPoint += '/';
+		}
+
+		if (!pack->Mapping.Open(packPath))
+		{
+			VEL_CORE_ERROR("Failed to open pack {0}", packPath);
+			return false;
+		}
+
+		// Everything is checked here so lookups can trust the index
+		const uint8_t* data = pack->Mapping.GetData();
+		const uint64_t size = pack->Mapping.GetSize();
+		Header header;
+		if (size < sizeof(Header))
+		{
+			VEL_CORE_ERROR("Pack {0} is corrupt", packPath);
+			return false;
+		}
+		memcpy(&header, data, sizeof(Header));
+
+		if (memcmp(header.Magic, MAGIC, sizeof(MAGIC)) != 0 || header.Version != FORMAT_VERSION || header.EntrySize != sizeof(Entry))
+		{
+			VEL_CORE_ERROR("Pack {0} is corrupt or from an older version. Pack it again", packPath);
+			return false;
+		}
+		if (header.IndexOffset % alignof(Entry) != 0u || header.IndexOffset > size || static_cast<uint64_t>(header.EntryCount) * sizeof(Entry) > size - header.IndexOffset ||
+			header.NamesOffset > size || header.NamesSize > size - header.NamesOffset)
+		{
+			VEL_CORE_ERROR("Pack {0} is corrupt", packPath);
+			return false;
+		}
+
+		pack->Entries = reinterpret_cast<const Entry*>(data + header.IndexOffset);
+		pack->EntryCount = header.EntryCount;
+		pack->Names = reinterpret_cast<const char*>(data + header.NamesOffset);
+		for (uint32_t i = 0; i < pack->EntryCount; ++i)
+		{
+			const Entry& entry = pack->Entries[i];
+			if (entry.Offset > size || entry.StoredSize > size - entry.Offset || static_cast<uint64_t>(entry.NameOffset) + entry.NameLength > header.NamesSize ||
+				!SceneCodec::IsAvailable(entry.Compression) || (i > 0u && pack->Entries[i - 1u].PathHash > entry.PathHash))
+			{
+				VEL_CORE_ERROR("Pack {0} is corrupt", packPath);
+				return false;
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(s_MountMutex);
+		s_Packs.push_back(pack);
+		return true;
+	}
+
+	void VirtualFileSystem::Unmount(const std::string& packPath)
+	{
+		// Files still open keep their pack mapped
+		std::lock_guard<std::mutex> lock(s_MountMutex);
+		s_Packs.erase(std::remove_if(s_Packs.begin(), s_Packs.end(), [&packPath](const auto& pack) { return pack->Filepath == packPath; }), s_Packs.end());
+	}
+
+	bool VirtualFileSystem::Open(const std::string& filepath, File& outFile)
+	{
+		outFile = File();
+
+		const Entry* entry = nullptr;
+		auto pack = Find(filepath, entry);
+		if (!pack)
+		{
+			if (!s_bLooseFiles || !outFile.m_Loose.Open(filepath))
+			{
+				return false;
+			}
+
+			outFile.m_Data = outFile.m_Loose.GetData();
+			outFile.m_Size = outFile.m_Loose.GetSize();
+			outFile.m_bOpen = true;
+			return true;
+		}
+
+		const uint8_t* stored = pack->Mapping.GetData() + entry->Offset;
+		if (Hash::Bytes(stored, static_cast<size_t>(entry->StoredSize)) != entry->Checksum)
+		{
+			VEL_CORE_ERROR("{0} is corrupt in pack {1}", filepath, pack->Filepath);
+			return false;
+		}
+
+		if (entry->Compression == SceneCompression::None)
+		{
+			outFile.m_Data = stored;
+		}
+		else
+		{
+			outFile.m_Decompressed.reset(new uint8_t[static_cast<size_t>(entry->Size)]);
+			if (!SceneCodec::Decompress(entry->Compression, stored, static_cast<size_t>(entry->StoredSize), outFile.m_Decompressed.get(), static_cast<size_t>(entry->Size)))
+			{
+				VEL_CORE_ERROR("{0} is corrupt in pack {1}", filepath, pack->Filepath);
+				outFile.m_Decompressed.reset();
+				return false;
+			}
+			outFile.m_Data = outFile.m_Decompressed.get();
+		}
+
+		outFile.m_Size = static_cast<size_t>(entry->Size);
+		outFile.m_Pack = std::move(pack);
+		outFile.m_bOpen = true;
+		return true;
+	}
+
+	bool VirtualFileSystem::Exists(const std::string& filepath)
+	{
+		uint64_t size;
+		return GetFileSize(filepath, size);
+	}
+
+	bool VirtualFileSystem::GetFileSize(const std::string& filepath, uint64_t& outSize)
+	{
+		const Entry* entry = nullptr;
+		if (Find(filepath, entry))
+		{
+			outSize = entry->Size;
+			return true;
+		}
+
+		std::error_code error;
+		if (!s_bLooseFiles || !std::filesystem::is_regular_file(filepath, error))
+		{
+			return false;
+		}
+		outSize = static_cast<uint64_t>(std::filesystem::file_size(filepath, error));
+		return !error;
+	}
+
+	bool VirtualFileSystem::IsPacked(const std::string& filepath)
+	{
+		const Entry* entry = nullptr;
+		return Find(filepath, entry) != nullptr;
+	}
+
+	bool VirtualFileSystem::WritePack(const std::string& packPath, const std::vector<std::pair<std::string, std::string>>& files, SceneCompression codec, int level)
+	{
+		if (!SceneCodec::IsAvailable(codec))
+		{
+			VEL_CORE_WARN("{0} isnt available in this build, packing with snappy", SceneCodec::GetName(codec));
+			codec = SceneCompression::Snappy;
+		}
+
+		struct PackedFile
+		{
+			std::string		Name;
+			MappedFile		Source;
+			std::string		Compressed;
+			Entry			Index;
+			bool			bLoaded = false;
+		};
+
+		std::vector<PackedFile> packed(files.size());
+		ThreadPool::Get().ParallelFor(files.size(), [&](size_t i)
+		{
+			PackedFile& file = packed[i];
+			file.Name = Normalise(files[i].first);
+			if (!file.Source.Open(files[i].second))
+			{
+				return;
+			}
+			file.bLoaded = true;
+
+			const size_t size = file.Source.GetSize();
+			file.Index.PathHash = HashPath(file.Name);
+			file.Index.Size = size;
+			if (codec != SceneCompression::None && size > 0u && SceneCodec::Compress(codec, level, file.Source.GetData(), size, size - size / 8u, file.Compressed))
+			{
+				file.Index.Compression = codec;
+				file.Index.StoredSize = file.Compressed.size();
+				file.Index.Checksum = Hash::Bytes(file.Compressed.data(), file.Compressed.size());
+			}
+			else
+			{
+				file.Compressed.clear();
+				file.Index.StoredSize = size;
+				file.Index.Checksum = Hash::Bytes(file.Source.GetData(), size);
+			}
+		});
+
+		for (size_t i = 0; i < packed.size(); ++i)
+		{
+			if (!packed[i].bLoaded)
+			{
+				VEL_CORE_ERROR("Failed to open {0} to pack it", files[i].second);
+				return false;
+			}
+		}
+
+		// Sorted for the binary search, then by name so the same files always give the same pack
+		std::vector<size_t> order(packed.size());
+		for (size_t i = 0; i < order.size(); ++i)
+		{
+			order[i] = i;
+		}
+		std::sort(order.begin(), order.end(), [&packed](size_t a, size_t b)
+		{
+			return packed[a].Index.PathHash != packed[b].Index.PathHash ? packed[a].Index.PathHash < packed[b].Index.PathHash : packed[a].Name < packed[b].Name;
+		});
+		for (size_t i = 1; i < order.size(); ++i)
+		{
+			if (packed[order[i]].Name == packed[order[i - 1u]].Name)
+			{
+				VEL_CORE_ERROR("{0} is in pack {1} twice", packed[order[i]].Name, packPath);
+				return false;
+			}
+		}
+
+		// Written beside the pack and swapped in at the end, a mounted pack stays whole until then
+		const std::string tempPath = packPath + ".tmp";
+		std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+		if (!output.is_open())
+		{
+			VEL_CORE_ERROR("Failed to open {0} to write a pack", tempPath);
+			return false;
+		}
+
+		auto pad = [&output]()
+		{
+			static const char zeros[ENTRY_ALIGNMENT] = {};
+			const uint64_t offset = static_cast<uint64_t>(output.tellp());
+			const uint64_t padding = (ENTRY_ALIGNMENT - offset % ENTRY_ALIGNMENT) % ENTRY_ALIGNMENT;
+			output.write(zeros, static_cast<std::streamsize>(padding));
+			return offset + padding;
+		};
+
+		Header header = {};
+		memcpy(header.Magic, MAGIC, sizeof(MAGIC));
+		header.Version = FORMAT_VERSION;
+		header.EntryCount = static_cast<uint32_t>(packed.size());
+		header.EntrySize = sizeof(Entry);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+		std::vector<Entry> index;
+		index.reserve(packed.size());
+		std::string names;
+		for (size_t i : order)
+		{
+			PackedFile& file = packed[i];
+			file.Index.Offset = pad();
+			file.Index.NameOffset = static_cast<uint32_t>(names.size());
+			file.Index.NameLength = static_cast<uint32_t>(file.Name.size());
+			names += file.Name;
+
+			const char* stored = file.Index.Compression == SceneCompression::None ? reinterpret_cast<const char*>(file.Source.GetData()) : file.Compressed.data();
+			output.write(stored, static_cast<std::streamsize>(file.Index.StoredSize));
+			index.push_back(file.Index);
+
+			// Nothing more is needed from it
+			file.Source.Close();
+			std::string().swap(file.Compressed);
+		}
+
+		header.IndexOffset = pad();
+		output.write(reinterpret_cast<const char*>(index.data()), static_cast<std::streamsize>(index.size() * sizeof(Entry)));
+		header.NamesOffset = static_cast<uint64_t>(output.tellp());
+		header.NamesSize = names.size();
+		output.write(names.data(), static_cast<std::streamsize>(names.size()));
+
+		output.seekp(0);
+		output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+		output.close();
+
+		std::error_code error;
+		if (!output.good())
+		{
+			VEL_CORE_ERROR("Failed to write pack {0}", packPath);
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		// Windows wont replace a pack that is still mapped, unmount it first
+		std::filesystem::rename(tempPath, packPath, error);
+		if (error)
+		{
+			VEL_CORE_ERROR("Failed to replace pack {0}: {1}", packPath, error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+
+		VEL_CORE_INFO("Packed {0} files into {1}", packed.size(), packPath);
+		return true;
+	}
+
+	bool VirtualFileSystem::WritePack(const std::string& packPath, const std::string& directory, SceneCompression codec, int level)
+	{
+		std::error_code error;
+		const auto packFile = std::filesystem::weakly_canonical(packPath, error);
+
+		std::vector<std::pair<std::string, std::string>> files;
+		for (auto it = std::filesystem::recursive_directory_iterator(directory, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+		{
+			// The pack may be going in the folder it packs
+			if (!it->is_regular_file(error) || std::filesystem::weakly_canonical(it->path(), error) == packFile)
+			{
+				continue;
+			}
+			files.push_back({ std::filesystem::relative(it->path(), directory, error).generic_string(), it->path().string() });
+		}
+
+		if (error)
+		{
+			VEL_CORE_ERROR("Failed to read {0} to pack it: {1}", directory, error.message());
+			return false;
+		}
+		return WritePack(packPath, files, codec, level);
+	}
+
+	std::string VirtualFileSystem::Normalise(const std::string& filepath)
+	{
+		auto isSeparator = [](char character) { return character == '/' || character == '\\'; };
+
+		std::string normalised;
+		normalised.reserve(filepath.size());
+		if (!filepath.empty() && isSeparator(filepath.front()))
+		{
+			normalised += '/';
+		}
+
+		size_t start = 0u;
+		while (start < filepath.size())
+		{
+			size_t end = start;
+			while (end < filepath.size() && !isSeparator(filepath[end]))
+			{
+				++end;
+			}
+
+			const size_t length = end - start;
+			if (length > 0u && !(length == 1u && filepath[start] == '.'))
+			{
+				if (!normalised.empty() && normalised.back() != '/')
+				{
+					normalised += '/';
+				}
+				normalised.append(filepath, start, length);
+			}
+			start = end + 1u;
+		}
+
+		// A trailing separator marks a directory, mount points keep it
+		if (!normalised.empty() && normalised.back() != '/' && isSeparator(filepath.back()))
+		{
+			normalised += '/';
+		}
+		return normalised;
+	}
+
+	const VirtualFileSystem::Entry* VirtualFileSystem::Pack::Find(const std::string& relativePath) const
+	{
+		const uint64_t hash = HashPath(relativePath);
+		const Entry* end = Entries + EntryCount;
+		const Entry* entry = std::lower_bound(Entries, end, hash, [](const Entry& candidate, uint64_t value) { return candidate.PathHash < value; });
+		for (; entry != end && entry->PathHash == hash; ++entry)
+		{
+			if (relativePath.compare(0, std::string::npos, Names + entry->NameOffset, entry->NameLength) == 0)
+			{
+				return entry;
+			}
+		}
+		return nullptr;
+	}
+
+	std::shared_ptr<const VirtualFileSystem::Pack> VirtualFileSystem::Find(const std::string& filepath, const Entry*& outEntry)
+	{
+		const std::string path = Normalise(filepath);
+
+		std::lock_guard<std::mutex> lock(s_MountMutex);
+		for (auto it = s_Packs.rbegin(); it != s_Packs.rend(); ++it)
+		{
+			const auto& pack = *it;
+			if (path.size() <= pack->MountPoint.size() || path.compare(0, pack->MountPoint.size(), pack->MountPoint) != 0)
+			{
+				continue;
+			}
+
+			if (const Entry* entry = pack->Find(path.substr(pack->MountPoint.size())))
+			{
+				outEntry = entry;
+				return pack;
+			}
+		}
+		return nullptr;
+	}
+
+	uint64_t VirtualFileSystem::HashPath(const std::string& relativePath)
+	{
+		return Hash::Bytes(relativePath.data(), relativePath.size());
+	}
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <Velocity/ECS/SceneFile.hpp>
+
+#include "MappedFile.hpp"
+
+namespace Velocity
+{
+	// Every file the engine reads goes through here
+	// Packs are single memory mapped archives mounted over a directory, so one open replaces hundreds of small ones
+	// A file under that directory comes from the newest pack that has it, straight out of the mapping unless it was compressed
+	// Anything no pack has is read from disk as a loose file, which is all there is during development
+	class VirtualFileSystem
+	{
+	private:
+		struct Pack;
+
+	public:
+		// A file opened through the VFS. Points into a pack or a mapping of the loose file, or owns its decompressed bytes
+		// Holds the pack open so it stays valid after an unmount
+		class File
+		{
+		public:
+			const uint8_t* GetData() const { return m_Data; }
+			size_t GetSize() const { return m_Size; }
+			bool IsOpen() const { return m_bOpen; }
+
+		private:
+			friend class VirtualFileSystem;
+
+			const uint8_t*					m_Data = nullptr;
+			size_t							m_Size = 0u;
+			bool							m_bOpen = false;
+
+			std::shared_ptr<const Pack>		m_Pack;
+			MappedFile						m_Loose;
+			std::unique_ptr<uint8_t[]>		m_Decompressed;
+		};
+
+		// Bump whenever the header or the index changes
+		static constexpr uint32_t FORMAT_VERSION = 1u;
+
+		// Every file starts on this so SPIR-V and cooked data can be used from the mapping as they are
+		static constexpr uint64_t ENTRY_ALIGNMENT = 16u;
+
+		static const char MAGIC[4];
+		static const char* EXTENSION;
+
+		// Mounts a pack over a directory, given the way the engine names it e.g. "../Velocity/assets/"
+		// Packs mounted later win over earlier ones. Returns false if the pack is missing or corrupt
+		static bool Mount(const std::string& packPath, const std::string& mountPoint);
+		static void Unmount(const std::string& packPath);
+
+		// With loose files off only packs are read, to check a shipping build has everything it needs packed
+		static void SetLooseFiles(bool bEnabled) { s_bLooseFiles = bEnabled; }
+
+		// Opens a file from the packs or the disk. Safe from any thread
+		static bool Open(const std::string& filepath, File& outFile);
+
+		static bool Exists(const std::string& filepath);
+
+		// Size once decompressed, without decompressing anything
+		static bool GetFileSize(const std::string& filepath, uint64_t& outSize);
+
+		// True if a mounted pack has the file
+		static bool IsPacked(const std::string& filepath);
+
+		// Packs files into a pack to mount over the directory they came from. Pairs are (path under the mount point, file on disk)
+		// Files compress side by side on the pool, any that dont shrink by an eighth are stored raw. Returns false if any are missing
+		static bool WritePack(const std::string& packPath, const std::vector<std::pair<std::string, std::string>>& files, SceneCompression codec = SceneCompression::Snappy, int level = 0);
+
+		// As above with every file under the directory
+		static bool WritePack(const std::string& packPath, const std::string& directory, SceneCompression codec = SceneCompression::Snappy, int level = 0);
+
+		// Forward slashes and no empty or "." parts, which is how paths are matched. ".." is left alone
+		static std::string Normalise(const std::string& filepath);
+
+	private:
+		struct Header
+		{
+			char		Magic[4];
+			uint32_t	Version;
+			uint32_t	EntryCount;
+			uint32_t	EntrySize;
+			uint64_t	IndexOffset;
+			uint64_t	NamesOffset;
+			uint64_t	NamesSize;
+		};
+
+		// The index is sorted by PathHash, names sharing a hash are told apart by the name table
+		struct Entry
+		{
+			uint64_t			PathHash = 0u;
+			uint64_t			Offset = 0u;		// From the start of the pack, ENTRY_ALIGNMENT aligned
+			uint64_t			StoredSize = 0u;
+			uint64_t			Size = 0u;			// Once decompressed
+			uint64_t			Checksum = 0u;		// Of the stored bytes
+			uint32_t			NameOffset = 0u;
+			uint32_t			NameLength = 0u;
+			SceneCompression	Compression = SceneCompression::None;
+			uint32_t			Padding = 0u;
+		};
+
+		struct Pack
+		{
+			std::string		Filepath;
+			std::string		MountPoint;
+			MappedFile		Mapping;
+			const Entry*	Entries = nullptr;
+			uint32_t		EntryCount = 0u;
+			const char*		Names = nullptr;
+
+			// nullptr if the pack doesnt have it. Path is relative to the mount point
+			const Entry* Find(const std::string& relativePath) const;
+		};
+
+		// Newest mounted pack with the file, nullptr if none have it
+		static std::shared_ptr<const Pack> Find(const std::string& filepath, const Entry*& outEntry);
+
+		static uint64_t HashPath(const std::string& relativePath);
+
+		static std::mutex s_MountMutex;
+		static std::vector<std::shared_ptr<const Pack>> s_Packs;
+		static std::atomic<bool> s_bLooseFiles;
+	};
+}
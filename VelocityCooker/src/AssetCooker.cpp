@@ -0,0 +1,337 @@
+#include "AssetCooker.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <set>
+
+#include <Velocity/ECS/SceneCodec.hpp>
+#include <Velocity/Renderer/CookedTexture.hpp>
+#include <Velocity/Utility/Hash.hpp>
+#include <Velocity/Utility/MappedFile.hpp>
+
+using namespace Velocity;
+
+namespace
+{
+	// Formats the editor imports through assimp
+	const char* MESH_EXTENSIONS[] = { ".obj", ".fbx", ".gltf", ".glb", ".dae" };
+
+	// Bump when the cooker changes what it builds without a format version changing
+	const uint32_t COOKER_VERSION = 1u;
+
+	std::string ToLower(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), ::tolower);
+		return text;
+	}
+}
+
+AssetCooker::AssetCooker(const std::string& folder, const Options& options)
+	: m_Folder(VirtualFileSystem::Normalise(folder)), m_Options(options)
+{
+	if (!m_Folder.empty() && m_Folder.back() != '/')
+	{
+		m_Folder += '/';
+	}
+}
+
+bool AssetCooker::Run()
+{
+	std::error_code error;
+	if (!std::filesystem::is_directory(m_Folder, error))
+	{
+		VEL_CLIENT_ERROR("{0} isnt a folder", m_Folder);
+		return false;
+	}
+
+	// Forcing ignores the last manifest so everything is hashed and built again
+	const std::string manifestPath = GetPath(AssetManifest::FILENAME);
+	if (!m_Options.bForce && std::filesystem::exists(manifestPath, error))
+	{
+		m_Previous.Read(manifestPath);
+	}
+
+	FindJobs();
+	VEL_CLIENT_INFO("Cooking {0} assets in {1}", m_Jobs.size(), m_Folder);
+
+	// Jobs are one asset each, the texture encoders and mesh imports split their own work across the pool as well
+	const auto start = std::chrono::steady_clock::now();
+	ThreadPool::Get().ParallelFor(m_Jobs.size(), [this](size_t i)
+	{
+		Process(m_Jobs[i]);
+	});
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	// Failed assets are left out so the engine checks them itself
+	AssetManifest manifest;
+	std::array<size_t, 4> outcomes = {};
+	for (const auto& job : m_Jobs)
+	{
+		++outcomes[static_cast<size_t>(job.Outcome)];
+		if (job.Outcome != Job::Result::Failed)
+		{
+			manifest.Add(job.Asset);
+		}
+	}
+
+	const size_t failed = outcomes[static_cast<size_t>(Job::Result::Failed)];
+	VEL_CLIENT_INFO("Cooked {0} in {1:.2f}s: {2} built, {3} refreshed, {4} up to date, {5} failed", m_Folder, seconds,
+		outcomes[static_cast<size_t>(Job::Result::Built)], outcomes[static_cast<size_t>(Job::Result::Refreshed)], outcomes[static_cast<size_t>(Job::Result::Skipped)], failed);
+
+	bool success = manifest.Write(manifestPath) && failed == 0u;
+
+	// The pack goes beside the folder, which is where the engine mounts it from
+	if (m_Options.bPack)
+	{
+		const std::string packPath = m_Folder.substr(0, m_Folder.size() - 1u) + VirtualFileSystem::EXTENSION;
+		success = VirtualFileSystem::WritePack(packPath, m_Folder, m_Options.Codec, m_Options.Level) && success;
+	}
+
+	return success;
+}
+
+void AssetCooker::FindJobs()
+{
+	// Base path and extension of every material with masks, relative to the folder
+	std::set<std::pair<std::string, std::string>> materials;
+
+	std::error_code error;
+	for (auto it = std::filesystem::recursive_directory_iterator(m_Folder, error); !error && it != std::filesystem::recursive_directory_iterator(); it.increment(error))
+	{
+		if (!it->is_regular_file(error))
+		{
+			continue;
+		}
+
+		const std::string name = std::filesystem::relative(it->path(), m_Folder, error).generic_string();
+		const std::string extension = ToLower(it->path().extension().generic_string());
+
+		Job job;
+		job.Asset.Name = name;
+		job.Asset.Inputs.push_back({ name });
+
+		if (std::any_of(std::begin(MESH_EXTENSIONS), std::end(MESH_EXTENSIONS), [&extension](const char* candidate) { return extension == candidate; }))
+		{
+			job.Asset.Type = AssetManifest::AssetType::Mesh;
+			m_Jobs.push_back(std::move(job));
+			continue;
+		}
+
+		if (!TextureCooker::IsSourceImage(name))
+		{
+			continue;
+		}
+
+		// Masks are only ever sampled packed, they are cooked together per material below
+		job.Usage = TextureCooker::GuessUsage(name);
+		if (job.Usage == TextureUsage::Mask)
+		{
+			const std::string stem = it->path().stem().generic_string();
+			const std::string base = (std::filesystem::path(name).parent_path() / stem.substr(0, stem.find_last_of('_'))).generic_string();
+			materials.emplace(base, it->path().extension().generic_string());
+			continue;
+		}
+
+		job.Asset.Type = AssetManifest::AssetType::Texture;
+		job.Asset.Output = TextureCooker::GetCookedPath(name);
+		m_Jobs.push_back(std::move(job));
+	}
+
+	if (error)
+	{
+		VEL_CLIENT_WARN("Stopped looking through {0} early: {1}", m_Folder, error.message());
+	}
+
+	for (const auto& material : materials)
+	{
+		Job job;
+		job.Asset.Type = AssetManifest::AssetType::Material;
+		job.Asset.Name = TextureCooker::GetPackedPath(material.first);
+		job.Asset.Output = job.Asset.Name;
+		job.Usage = TextureUsage::Packed;
+		job.Maps = TextureCooker::GetMaterialMaps(GetPath(material.first), material.second);
+
+		for (const std::string* map : { &job.Maps.Occlusion, &job.Maps.Roughness, &job.Maps.Metallic, &job.Maps.Height })
+		{
+			if (!map->empty())
+			{
+				job.Asset.Inputs.push_back({ map->substr(m_Folder.size()) });
+			}
+		}
+		m_Jobs.push_back(std::move(job));
+	}
+}
+
+void AssetCooker::Process(Job& job) const
+{
+	auto& asset = job.Asset;
+	for (auto& input : asset.Inputs)
+	{
+		if (!ReadInput(input, false))
+		{
+			VEL_CLIENT_ERROR("Failed to read {0}", GetPath(input.Path));
+			job.Outcome = Job::Result::Failed;
+			return;
+		}
+	}
+
+	// Nothing has touched the inputs since the last cook, so they dont need reading
+	const AssetManifest::Asset* previous = m_Previous.Find(asset.Name);
+	const bool bSameInputs = previous && previous->Type == asset.Type && previous->Inputs.size() == asset.Inputs.size() &&
+		std::equal(asset.Inputs.begin(), asset.Inputs.end(), previous->Inputs.begin(), [](const AssetManifest::Input& current, const AssetManifest::Input& last)
+		{
+			return current.Path == last.Path && current.Size == last.Size && current.WriteTime == last.WriteTime;
+		});
+	if (bSameInputs)
+	{
+		for (size_t i = 0; i < asset.Inputs.size(); ++i)
+		{
+			asset.Inputs[i].Hash = previous->Inputs[i].Hash;
+		}
+
+		asset.BuildKey = ComputeBuildKey(job);
+		if (asset.BuildKey == previous->BuildKey && HasOutput(job))
+		{
+			job.Outcome = Job::Result::Skipped;
+			return;
+		}
+	}
+
+	for (auto& input : asset.Inputs)
+	{
+		if (!ReadInput(input, true))
+		{
+			VEL_CLIENT_ERROR("Failed to read {0}", GetPath(input.Path));
+			job.Outcome = Job::Result::Failed;
+			return;
+		}
+	}
+
+	// Touched but the same bytes, only the record needs updating
+	asset.BuildKey = ComputeBuildKey(job);
+	if (previous && asset.BuildKey == previous->BuildKey && HasOutput(job))
+	{
+		job.Outcome = Job::Result::Refreshed;
+		return;
+	}
+
+	job.Outcome = Build(job) ? Job::Result::Built : Job::Result::Failed;
+}
+
+uint64_t AssetCooker::ComputeBuildKey(const Job& job)
+{
+	// Meshes use their mesh cache key, which covers the importer and the blob layout
+	if (job.Asset.Type == AssetManifest::AssetType::Mesh)
+	{
+		return BufferManager::ComputeMeshKey(job.Asset.Inputs.front().Hash);
+	}
+
+	const uint32_t cookedVersion = CookedTexture::FORMAT_VERSION;
+	const uint32_t cookerVersion = COOKER_VERSION;
+	uint64_t key = Hash::Combine(Hash::Combine(0u, cookedVersion), cookerVersion);
+	key = Hash::Combine(key, job.Usage);
+
+	// Paths matter too, a material map moving channel changes the output
+	for (const auto& input : job.Asset.Inputs)
+	{
+		key = Hash::String(input.Path, key);
+		key = Hash::Combine(key, input.Hash);
+	}
+	return key;
+}
+
+bool AssetCooker::HasOutput(const Job& job) const
+{
+	if (job.Asset.Type == AssetManifest::AssetType::Mesh)
+	{
+		MappedFile blob;
+		CachedMeshView view;
+		return MeshCache::Load(job.Asset.BuildKey, blob, view);
+	}
+
+	std::error_code error;
+	return std::filesystem::is_regular_file(GetPath(job.Asset.Output), error);
+}
+
+bool AssetCooker::Build(Job& job) const
+{
+	const auto& asset = job.Asset;
+	switch (asset.Type)
+	{
+	case AssetManifest::AssetType::Mesh:
+	{
+		// Imports and fills the mesh cache, or finds the blob is already there
+		BufferManager::PreparedMesh prepared;
+		if (!BufferManager::PrepareMesh(GetPath(asset.Name), prepared))
+		{
+			return false;
+		}
+
+		// It hashes the source again, a different key means it changed while cooking
+		if (prepared.Key != asset.BuildKey)
+		{
+			VEL_CLIENT_WARN("{0} changed while it was being cooked", GetPath(asset.Name));
+			return false;
+		}
+
+		if (!prepared.FromCache)
+		{
+			VEL_CLIENT_INFO("Imported {0} ({1} vertices)", GetPath(asset.Name), prepared.Imported.Vertices.size());
+		}
+		break;
+	}
+
+	case AssetManifest::AssetType::Texture:
+		if (!TextureCooker::CookFile(GetPath(asset.Name), GetPath(asset.Output), job.Usage))
+		{
+			return false;
+		}
+		break;
+
+	case AssetManifest::AssetType::Material:
+	{
+		CookedTexture cooked;
+		if (!TextureCooker::CookMaterial(job.Maps, GetPath(asset.Output), cooked))
+		{
+			VEL_CLIENT_ERROR("Failed to pack material {0}", GetPath(asset.Output));
+			return false;
+		}
+		break;
+	}
+	}
+
+	// Writing the mesh blob or the packed texture is allowed to fail quietly, it isnt here
+	if (!HasOutput(job))
+	{
+		VEL_CLIENT_ERROR("Failed to write the cooked output of {0}", GetPath(asset.Name));
+		return false;
+	}
+	return true;
+}
+
+bool AssetCooker::ReadInput(AssetManifest::Input& input, bool bHash) const
+{
+	const std::string path = GetPath(input.Path);
+
+	std::error_code error;
+	input.Size = static_cast<uint64_t>(std::filesystem::file_size(path, error));
+	if (error)
+	{
+		return false;
+	}
+	input.WriteTime = AssetManifest::GetWriteTime(path);
+
+	if (bHash)
+	{
+		MappedFile file;
+		if (input.Size > 0u && !file.Open(path))
+		{
+			return false;
+		}
+		input.Hash = Hash::Bytes(file.GetData(), file.GetSize());
+	}
+	return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Velocity.hpp>
+
+// Converts everything under an assets folder into what the engine loads at runtime, and records it in the folder's asset manifest
+// Meshes go into the mesh cache, images are cooked next to their source and material masks are packed together
+// Assets whose inputs look the same as last time are skipped without being read. Ones that were touched but hash the same
+// only have their record refreshed, so a checkout or copy doesnt rebuild everything
+class AssetCooker
+{
+public:
+	struct Options
+	{
+		// Recooks every texture and material. Meshes are content addressed so their blobs are always reused
+		bool						bForce = false;
+
+		// Packs the folder into <folder>.vpak once it is cooked, see VirtualFileSystem::WritePack
+		bool						bPack = false;
+		Velocity::SceneCompression	Codec = Velocity::SceneCompression::Snappy;
+		int							Level = 0;
+	};
+
+	AssetCooker(const std::string& folder, const Options& options);
+
+	// Cooks the folder across the worker pool, then writes the manifest and the pack. Returns false if anything failed
+	bool Run();
+
+private:
+	// One asset found in the folder
+	struct Job
+	{
+		Velocity::AssetManifest::Asset	Asset;
+		Velocity::TextureUsage			Usage = Velocity::TextureUsage::Albedo;
+		Velocity::MaterialMaps			Maps;			// Full paths, materials only
+
+		enum class Result
+		{
+			Skipped,
+			Refreshed,	// Touched but hashed the same
+			Built,
+			Failed
+		};
+		Result							Outcome = Result::Failed;
+	};
+
+	// Every mesh, image and material under the folder
+	void FindJobs();
+
+	// Checks the job against the last manifest and builds it if it has changed
+	void Process(Job& job) const;
+
+	// Everything that decides what the asset builds into, from the hashes of its inputs
+	static uint64_t ComputeBuildKey(const Job& job);
+
+	// True if what the job builds into is there
+	bool HasOutput(const Job& job) const;
+
+	bool Build(Job& job) const;
+
+	// Size and write time of the input, and its hash if hash is true. Returns false if it cant be read
+	bool ReadInput(Velocity::AssetManifest::Input& input, bool bHash) const;
+
+	std::string GetPath(const std::string& name) const { return m_Folder + name; }
+
+	std::string						m_Folder;		// Normalised with a trailing '/'
+	Options							m_Options;
+	Velocity::AssetManifest			m_Previous;
+	std::vector<Job>				m_Jobs;
+};
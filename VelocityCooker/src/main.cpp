@@ -0,0 +1,90 @@
+#include "AssetCooker.hpp"
+
+#include <cstdlib>
+
+using namespace Velocity;
+
+namespace
+{
+	// What gets cooked when no folders are given, named from the cooker's working directory
+	const char* DEFAULT_FOLDERS[] = { "../Velocity/assets", "../VelocityEditor/assets" };
+
+	void PrintUsage()
+	{
+		VEL_CLIENT_INFO("Usage: VelocityCooker [options] [folders...]");
+		VEL_CLIENT_INFO("  --force          Ignore the last manifest and cook everything again");
+		VEL_CLIENT_INFO("  --pack           Pack each folder into <folder>.vpak once it is cooked");
+		VEL_CLIENT_INFO("  --codec <name>   none, snappy or deflate for packed files. Defaults to snappy");
+		VEL_CLIENT_INFO("  --level <n>      Compression level for deflate");
+	}
+}
+
+// Batch converts asset folders into the formats the engine loads at runtime, see AssetCooker
+int main(int argc, char** argv)
+{
+	Log::Init();
+
+	AssetCooker::Options options;
+	std::vector<std::string> folders;
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--force")
+		{
+			options.bForce = true;
+		}
+		else if (argument == "--pack")
+		{
+			options.bPack = true;
+		}
+		else if (argument == "--codec" && i + 1 < argc)
+		{
+			const std::string codec = argv[++i];
+			if (codec == "none")
+			{
+				options.Codec = SceneCompression::None;
+			}
+			else if (codec == "snappy")
+			{
+				options.Codec = SceneCompression::Snappy;
+			}
+			else if (codec == "deflate")
+			{
+				options.Codec = SceneCompression::Deflate;
+			}
+			else
+			{
+				VEL_CLIENT_ERROR("Unknown codec {0}", codec);
+				PrintUsage();
+				return 1;
+			}
+		}
+		else if (argument == "--level" && i + 1 < argc)
+		{
+			options.Level = std::atoi(argv[++i]);
+		}
+		else if (argument.rfind("--", 0) == 0)
+		{
+			PrintUsage();
+			return argument == "--help" ? 0 : 1;
+		}
+		else
+		{
+			folders.push_back(argument);
+		}
+	}
+
+	if (folders.empty())
+	{
+		folders.assign(std::begin(DEFAULT_FOLDERS), std::end(DEFAULT_FOLDERS));
+	}
+
+	bool success = true;
+	for (const auto& folder : folders)
+	{
+		AssetCooker cooker(folder, options);
+		success = cooker.Run() && success;
+	}
+
+	return success ? 0 : 1;
+}
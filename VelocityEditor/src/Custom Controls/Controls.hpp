@@ -40,7 +40,21 @@ namespace ImGui
 
 			if (open)
 			{
-				uiFunction(component);
+				// Plain components are compared to spot edits so change tracking hears about them
+				if constexpr (std::is_trivially_copyable_v<T>)
+				{
+					T before;
+					memcpy(&before, &component, sizeof(T));
+					uiFunction(component);
+					if (memcmp(&before, &component, sizeof(T)) != 0)
+					{
+						entity.NotifyChanged<T>();
+					}
+				}
+				else
+				{
+					uiFunction(component);
+				}
 				TreePop();
 			}
 
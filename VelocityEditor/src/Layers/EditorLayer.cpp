@@ -5,6 +5,8 @@
 #include "../Panels/GizmoControlPanel.hpp"
 #include "../Panels/SceneViewPanel.hpp"
 #include "../Panels/MainMenuPanel.hpp"
+#include "../Panels/MemoryPanel.hpp"
+#include "../Panels/SceneLoadPanel.hpp"
 #include "Velocity/Utility/Input.hpp"
 
 void EditorLayer::OnGuiRender()
@@ -14,34 +16,58 @@ void EditorLayer::OnGuiRender()
 	bool sceneClosed = false;
 	std::string newScenePath = "";
 	
-	MainMenuPanel::Draw(m_Scene.get(), &newSceneLoaded, &newScenePath,&sceneSaved,&sceneClosed);
+	// Scene actions wait for a load to finish. Saving a scene that is still gaining entities would lose the rest,
+	// and collecting its garbage would release the assets they use
+	MainMenuPanel::Draw(m_SceneLoad ? nullptr : m_Scene.get(), &newSceneLoaded, &newScenePath,&sceneSaved,&sceneClosed);
 	// They have opened a new scene
 	if (newSceneLoaded)
 	{		
-		Scene* newScene = Scene::LoadScene(newScenePath);
-		
-		// Release old scene and attach new scene
-		m_Scene.reset(newScene);
-		
-		// Shift the camera controller to the new scene camera
-		m_CameraController->SetCamera(newScene->GetCamera());
-
-		// Set to render
-		// TODO: Check if this could be moved to load logic itself
-		Renderer::GetRenderer()->SetScene(m_Scene.get());
-
-		// Update window title
-		auto& window = Application::GetWindow();
-		window->SetWindowTitle(window->GetBaseTitle() + " - Editing: " + m_Scene->GetSceneName());
+		// Anything still loading is dropped. Autosave stops too in case the scene being opened is its autosave
+		m_SceneLoad.reset(nullptr);
+		m_Autosave.reset(nullptr);
+
+		// New scenes are instant, files load in the background while this one keeps rendering
+		if (newScenePath.empty())
+		{
+			SwapScene(Scene::LoadScene(newScenePath));
+			m_Autosave = std::make_unique<SceneAutosave>(m_Scene.get());
+		}
+		else
+		{
+			m_SceneLoad = Scene::LoadSceneAsync(newScenePath);
+		}
+	}
 
-		// Clear selected entity from config to avoid null crash
-		SceneViewPanel::ClearSelectedEntity();
-		Renderer::GetRenderer()->SetGizmoEntity(nullptr);
-		
+	if (m_SceneLoad)
+	{
+		if (Scene* loaded = m_SceneLoad->Update())
+		{
+			SwapScene(loaded);
+		}
+
+		SceneLoadPanel::Draw(m_SceneLoad.get());
+
+		if (m_SceneLoad->IsDone())
+		{
+			// Autosaves start once every entity has arrived, or again for the old scene if it never swapped in
+			if (m_Scene && !m_Autosave)
+			{
+				m_Autosave = std::make_unique<SceneAutosave>(m_Scene.get());
+			}
+			m_SceneLoad.reset(nullptr);
+		}
 	}
+
 	// They have saved the scene
 	if (sceneSaved)
 	{
+		// Saving can rename the scene, the autosave follows the name. A scene still loading gets one once it is in
+		if (!m_SceneLoad)
+		{
+			m_Autosave.reset(nullptr);
+			m_Autosave = std::make_unique<SceneAutosave>(m_Scene.get());
+		}
+
 		// Update window title
 		auto& window = Application::GetWindow();
 		window->SetWindowTitle(window->GetBaseTitle() + " - Editing: " + m_Scene->GetSceneName());
@@ -49,10 +75,13 @@ void EditorLayer::OnGuiRender()
 
 	if (sceneClosed)
 	{
+		m_SceneLoad.reset(nullptr);
+
 		// Set scene to no render
 		Renderer::GetRenderer()->SetScene(nullptr);
 
 		// Clean up editor relating to scene
+		m_Autosave.reset(nullptr);
 		m_Scene.reset(nullptr);
 		m_CameraController->SetCamera(nullptr);
 
@@ -69,6 +98,29 @@ void EditorLayer::OnGuiRender()
 	SceneViewPanel::Draw(m_Scene.get());
 	CameraStatePanel::Draw(m_CameraController->GetCamera());
 	GizmoControlPanel::Draw();
+	MemoryPanel::Draw();
+}
+
+void EditorLayer::SwapScene(Scene* scene)
+{
+	// Release old scene and attach new scene
+	m_Autosave.reset(nullptr);
+	m_Scene.reset(scene);
+
+	// Shift the camera controller to the new scene camera
+	m_CameraController->SetCamera(scene->GetCamera());
+
+	// Set to render
+	// TODO: Check if this could be moved to load logic itself
+	Renderer::GetRenderer()->SetScene(m_Scene.get());
+
+	// Update window title
+	auto& window = Application::GetWindow();
+	window->SetWindowTitle(window->GetBaseTitle() + " - Editing: " + m_Scene->GetSceneName());
+
+	// Clear selected entity from config to avoid null crash
+	SceneViewPanel::ClearSelectedEntity();
+	Renderer::GetRenderer()->SetGizmoEntity(nullptr);
 }
 
 void EditorLayer::OnAttach()
@@ -92,12 +144,18 @@ void EditorLayer::OnAttach()
 
 void EditorLayer::OnDetach()
 {
-	
+	m_SceneLoad.reset(nullptr);
+	m_Autosave.reset(nullptr);
 }
 
 void EditorLayer::OnUpdate(Timestep deltaTime)
 {
 	m_CameraController->OnUpdate(deltaTime);
+
+	if (m_Autosave)
+	{
+		m_Autosave->Update(deltaTime);
+	}
 	//m_SoundClip.Play();
 }
 
@@ -13,10 +13,18 @@ public:
 	void OnUpdate(Velocity::Timestep deltaTime) override;
 	void OnEvent(Velocity::Event& event) override;
 private:
+	// Makes a loaded scene the one being edited and rendered
+	void SwapScene(Velocity::Scene* scene);
 
 	// Stores all the data on the visible scene
 	std::unique_ptr<Velocity::Scene> m_Scene;
 
+	// Saves the scene in the background, always released before the scene is
+	std::unique_ptr<Velocity::SceneAutosave> m_Autosave;
+
+	// Scene being opened in the background, the current one stays up until it swaps in
+	std::unique_ptr<Velocity::SceneLoad> m_SceneLoad;
+
 	std::unique_ptr<Velocity::Skybox> m_Skybox;
 
 	// Use a default camera
@@ -66,6 +66,29 @@ public:
 					
 				}
 
+				// Self contained copy with every asset inside, for shipping
+				if (ImGui::MenuItem("Export Pack",0,(bool*)0,scene != nullptr))
+				{
+					nfdchar_t* outPath = nullptr;
+					if (NFD_SaveDialog("velocity", nullptr, &outPath) == NFD_OKAY)
+					{
+						std::string saveLoc = std::string(outPath);
+						if (saveLoc.find(".velocity") == std::string::npos)
+						{
+							saveLoc += ".velocity";
+						}
+						scene->ExportPack(saveLoc);
+						VEL_CORE_INFO("Exported scene pack!");
+					}
+				}
+
+				// Reopens the scene as it was at its last autosave
+				if (ImGui::MenuItem("Recover Autosave",0,(bool*)0,scene != nullptr && std::filesystem::exists(SceneAutosave::GetPath(scene->GetSceneName()))))
+				{
+					*newSceneLoaded = true;
+					*newScenePath = SceneAutosave::GetPath(scene->GetSceneName());
+				}
+
 				if (ImGui::MenuItem("Close Scene",0,(bool*)0,scene !=nullptr))
 				{
 					*sceneClosed = true;
@@ -98,6 +121,53 @@ public:
 						Renderer::GetRenderer()->LoadMesh(fullPath, refName);
 					}
 				}
+				if (ImGui::MenuItem("Mesh Folder"))
+				{
+					nfdchar_t* selectedFolder = nullptr;
+
+					// Open a folder selection dialog
+					const nfdresult_t result = NFD_PickFolder(nullptr, &selectedFolder);
+					switch (result)
+					{
+						case NFD_OKAY:
+						{
+							// Gather every mesh in the folder and import them in the background
+							std::vector<std::pair<std::string, std::string>> meshes;
+							for (const auto& file : std::filesystem::directory_iterator(std::string(selectedFolder)))
+							{
+								auto extension = file.path().extension().generic_string();
+								std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+								if (extension == ".fbx" || extension == ".x" || extension == ".obj" || extension == ".3ds")
+								{
+									const std::string fullPath = file.path().generic_string();
+									meshes.push_back({ fullPath, Scene::GetRefName(fullPath) });
+								}
+							}
+
+							if (meshes.empty())
+							{
+								VEL_CORE_ERROR("Selected folder has no meshes!");
+								break;
+							}
+
+							Renderer::GetRenderer()->LoadMeshesAsync(meshes, [](const std::string& refName, const BufferManager::MeshIndexer&)
+							{
+								VEL_CORE_INFO("Loaded mesh {0}", refName);
+							});
+							break;
+						}
+						case NFD_CANCEL:
+						{
+							// Do nothinh
+							break;
+						}
+						case NFD_ERROR:
+						{
+							VEL_CORE_ERROR("Error opening file explorer! %s", std::string(NFD_GetError()));
+							break;
+						}
+					}
+				}
 				if (ImGui::MenuItem("Texture"))
 				{
 					nfdchar_t* outFile = OpenFile("jpg,jpeg,png");
@@ -107,8 +177,8 @@ public:
 
 						const std::string refName = Scene::GetRefName(fullPath);
 
-						// Now create the texture
-						Renderer::GetRenderer()->CreateTexture(fullPath, refName);
+						// Now create the texture. It decodes in the background and shows as white until ready
+						Renderer::GetRenderer()->CreateTextureAsync(fullPath, refName);
 					}
 					
 				}
@@ -256,6 +326,77 @@ public:
 				}
 				ImGui::EndMenu();
 			}
+			if (ImGui::BeginMenu("Tools"))
+			{
+				if (ImGui::MenuItem("Cook Texture Folder"))
+				{
+					nfdchar_t* selectedFolder = nullptr;
+
+					// Open a folder selection dialog
+					const nfdresult_t result = NFD_PickFolder(nullptr, &selectedFolder);
+					switch (result)
+					{
+						case NFD_OKAY:
+						{
+							// Cooked files land next to the sources and get picked up by materials from then on
+							ThreadPool::Get().Enqueue([folder = std::string(selectedFolder)]()
+							{
+								const size_t cooked = TextureCooker::CookFolder(folder);
+								VEL_CORE_INFO("Cooked {0} textures in {1}", cooked, folder);
+							});
+							break;
+						}
+						case NFD_CANCEL:
+						{
+							// Do nothing
+							break;
+						}
+						case NFD_ERROR:
+						{
+							VEL_CORE_ERROR("Error opening file explorer! %s", std::string(NFD_GetError()));
+							break;
+						}
+					}
+				}
+				// Deletes assets no saved scene points at any more. Saves wait for it to finish
+				if (ImGui::MenuItem("Clean Asset Store"))
+				{
+					ThreadPool::Get().Enqueue([]() { AssetStore::Collect(SceneLoad::ReadAssetKeys); });
+				}
+				if (ImGui::BeginMenu("Benchmarks"))
+				{
+					if (ImGui::MenuItem("Mesh Post Processing"))
+					{
+						nfdchar_t* outFile = OpenFile("fbx,x,obj,3ds");
+						if (outFile)
+						{
+							// Takes a while on big meshes, results show up in the log
+							const std::string fullPath = std::string(outFile);
+							ThreadPool::Get().Enqueue([fullPath]() { ImportBenchmark::RunPostProcess(fullPath); });
+						}
+					}
+					if (ImGui::MenuItem("OBJ Import (1 GB)"))
+					{
+						ThreadPool::Get().Enqueue([]() { ImportBenchmark::RunObj(); });
+					}
+					if (ImGui::MenuItem("Scene Compression"))
+					{
+						nfdchar_t* outFile = OpenFile("velocity");
+						if (outFile)
+						{
+							// Off the pool so the saves being timed can compress on it
+							std::thread([path = std::string(outFile)]() { SceneBenchmark::Run(path); }).detach();
+						}
+					}
+					if (ImGui::MenuItem("Autosave Hitch (100k Entities)"))
+					{
+						// On this thread, it times how long autosaving holds up the frame
+						SceneBenchmark::RunAutosave();
+					}
+					ImGui::EndMenu();
+				}
+				ImGui::EndMenu();
+			}
 			
 			ImGui::EndMainMenuBar();
 		}
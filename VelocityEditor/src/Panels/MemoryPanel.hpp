@@ -0,0 +1,45 @@
+#pragma once
+#include "imgui.h"
+
+class MemoryPanel
+{
+public:
+	static void Draw()
+	{
+		ImGui::Begin("Memory");
+
+		auto& renderer = Velocity::Renderer::GetRenderer();
+
+		if (ImGui::Checkbox("Keep CPU copies", &m_KeepCPUCopies))
+		{
+			renderer->ToggleCPUCopies(m_KeepCPUCopies);
+		}
+		ImGui::Separator();
+
+		const auto usage = renderer->GetMemoryUsage();
+
+		ImGui::Columns(3);
+		ImGui::NextColumn();
+		ImGui::Text("CPU"); ImGui::NextColumn();
+		ImGui::Text("GPU"); ImGui::NextColumn();
+		DrawRow("Geometry", usage.GeometryHost, usage.GeometryDevice);
+		DrawRow("Textures", usage.TextureHost, usage.TextureDevice);
+		DrawRow("Skybox", usage.SkyboxHost, usage.SkyboxDevice);
+		DrawRow("Total", usage.GeometryHost + usage.TextureHost + usage.SkyboxHost, usage.GeometryDevice + usage.TextureDevice + usage.SkyboxDevice);
+		ImGui::Columns(1);
+
+		ImGui::End();
+	}
+
+private:
+	static void DrawRow(const char* name, size_t host, size_t device)
+	{
+		ImGui::Text("%s", name); ImGui::NextColumn();
+		ImGui::Text("%.1f MB", static_cast<double>(host) / (1024.0 * 1024.0)); ImGui::NextColumn();
+		ImGui::Text("%.1f MB", static_cast<double>(device) / (1024.0 * 1024.0)); ImGui::NextColumn();
+	}
+
+	static bool m_KeepCPUCopies;
+};
+
+bool MemoryPanel::m_KeepCPUCopies = true;
@@ -0,0 +1,22 @@
+#pragma once
+#include "imgui.h"
+
+class SceneLoadPanel
+{
+public:
+	static void Draw(Velocity::SceneLoad* load)
+	{
+		ImGui::Begin("Loading Scene");
+
+		ImGui::Text("%s", load->GetFilepath().c_str());
+		ImGui::ProgressBar(load->GetProgress());
+
+		// Only while the current scene is still the one on screen
+		if (load->GetState() == Velocity::SceneLoad::State::Reading && ImGui::Button("Cancel"))
+		{
+			load->Cancel();
+		}
+
+		ImGui::End();
+	}
+};
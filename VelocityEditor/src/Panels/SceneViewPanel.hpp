@@ -9,6 +9,87 @@
 
 using namespace Velocity;
 
+// Inspector UI for a component. Components without a specialisation arent drawn
+template<typename T>
+struct ComponentDrawer
+{
+	static constexpr bool DRAWN = false;
+};
+
+template<>
+struct ComponentDrawer<TransformComponent>
+{
+	static constexpr bool DRAWN = true;
+	static void Draw(TransformComponent& component)
+	{
+		ImGui::DrawVec3Control("Translation", component.Translation);
+		ImGui::DrawVec3Control("Rotation", component.Rotation);
+		ImGui::DrawVec3Control("Scale", component.Scale,1.0f);
+	}
+};
+
+template<>
+struct ComponentDrawer<MeshComponent>
+{
+	static constexpr bool DRAWN = true;
+	static void Draw(MeshComponent& component)
+	{
+		BufferManager::MeshIndexer mesh = Renderer::GetRenderer()->GetMeshList().at(component.MeshReference);
+	
+		ImGui::Text("Mesh name: %s",component.MeshReference.c_str());
+		ImGui::Text("Vertex count: %d", mesh.VertexCount);
+		ImGui::Text("Index count: %d", mesh.IndexCount);
+	}
+};
+
+template<>
+struct ComponentDrawer<TextureComponent>
+{
+	static constexpr bool DRAWN = true;
+	static void Draw(TextureComponent& component)
+	{
+		auto& texture = Renderer::GetRenderer()->GetTexturesList().at(component.TextureID);
+	
+		ImGui::Text("Texture ID: %s", std::to_string(component.TextureID).c_str());
+		ImGui::Text("Texture name: %s", Renderer::GetRenderer()->GetTexturesList().at(component.TextureID).first.c_str());
+		Renderer::GetRenderer()->DrawTextureToGUI(texture.first, { ImGui::GetContentRegionAvail().y,ImGui::GetContentRegionAvail().y });
+	}
+};
+
+template<>
+struct ComponentDrawer<PointLightComponent>
+{
+	static constexpr bool DRAWN = true;
+	static void Draw(PointLightComponent& component)
+	{
+		ImGui::DrawVec3Control("Position", component.Position);
+		ImGui::SliderFloat("Intensity", &component.Intensity, 100.0f, 10000.0f);
+		ImGui::Separator();
+		ImGui::ColorPicker3("Color", &component.Color.x);
+	}
+};
+
+template<>
+struct ComponentDrawer<PBRComponent>
+{
+	static constexpr bool DRAWN = true;
+	static void Draw(PBRComponent& component)
+	{
+		auto& textures = Renderer::GetRenderer()->GetTexturesList();
+	
+		ImGui::Text("Material name: %s", component.MaterialName.c_str());
+		ImGui::Text(component.HeightMapped ? "A / N / ORM + Height" : "A / N / ORM");
+		ImVec2 imageSize = { ImGui::GetContentRegionAvail().y / 5.0f,ImGui::GetContentRegionAvail().y / 5.0f };
+		
+		Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.AlbedoID()).first, imageSize);
+		ImGui::SameLine();
+		Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.NormalID()).first, imageSize);
+		ImGui::SameLine();
+		Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.PackedID()).first, imageSize);
+		ImGui::SameLine();
+	}
+};
+
 class SceneViewPanel
 {
 public:
@@ -110,6 +191,7 @@ private:
 			if (ImGui::InputText("##Tag", buffer, sizeof(buffer)))
 			{
 				tag = std::string(buffer);
+				entity.NotifyChanged<TagComponent>();
 			}
 
 			ImGui::SameLine();
@@ -123,61 +205,23 @@ private:
 				// Exit out as handle is invalid
 				return false;
 			}
-		}
 
-		ImGui::DrawComponent<TransformComponent>("Transform", entity, [](TransformComponent& component)
-			{
-				ImGui::DrawVec3Control("Translation", component.Translation);
-				ImGui::DrawVec3Control("Rotation", component.Rotation);
-				ImGui::DrawVec3Control("Scale", component.Scale,1.0f);
-			});
-		ImGui::DrawComponent<MeshComponent>("Mesh", entity, [](MeshComponent& component)
-			{
-				BufferManager::MeshIndexer mesh = Renderer::GetRenderer()->GetMeshList().at(component.MeshReference);
-			
-				ImGui::Text("Mesh name: %s",component.MeshReference.c_str());
-				ImGui::Text("Vertex count: %d", mesh.VertexCount);
-				ImGui::Text("Index count: %d", mesh.IndexCount);
-			});
-		ImGui::DrawComponent<TextureComponent>("Texture", entity, [](TextureComponent& component)
-			{
-				auto& texture = Renderer::GetRenderer()->GetTexturesList().at(component.TextureID);
-			
-				ImGui::Text("Texture ID: %s", std::to_string(component.TextureID).c_str());
-				ImGui::Text("Texture name: %s", Renderer::GetRenderer()->GetTexturesList().at(component.TextureID).first.c_str());
-				Renderer::GetRenderer()->DrawTextureToGUI(texture.first, { ImGui::GetContentRegionAvail().y,ImGui::GetContentRegionAvail().y });
-			});
-		ImGui::DrawComponent<PointLightComponent>("Point Light", entity, [](PointLightComponent& component)
+			ImGui::SameLine();
+			if (ImGui::Button("Duplicate"))
 			{
-				ImGui::DrawVec3Control("Position", component.Position);
-				ImGui::SliderFloat("Intensity", &component.Intensity, 100.0f, 10000.0f);
-				ImGui::Separator();
-				ImGui::ColorPicker3("Color", &component.Color.x);
-			});
-		ImGui::DrawComponent<PBRComponent>("PBR Material", entity, [](PBRComponent& component)
+				m_SelectedEntity = scene->DuplicateEntity(entity);
+				Renderer::GetRenderer()->SetGizmoEntity(&m_SelectedEntity);
+			}
+		}
+
+		// Every component with a drawer, in registry order
+		SceneComponents::ForEach([&entity](auto tag)
 			{
-				auto& textures = Renderer::GetRenderer()->GetTexturesList();
-			
-				ImGui::Text("Material name: %s", component.MaterialName.c_str());
-				ImGui::Text("A / N / H / M / R");
-				ImVec2 imageSize = { ImGui::GetContentRegionAvail().y / 5.0f,ImGui::GetContentRegionAvail().y / 5.0f };
-				
-				Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.AlbedoID()).first, imageSize);
-				ImGui::SameLine();
-				Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.NormalID()).first, imageSize);
-				ImGui::SameLine();
-				if (component.HeightID() != -1)
+				using Component = typename decltype(tag)::Type;
+				if constexpr (ComponentDrawer<Component>::DRAWN)
 				{
-					Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.HeightID()).first, imageSize);
-					ImGui::SameLine();
+					ImGui::DrawComponent<Component>(ComponentTraits<Component>::NAME, entity, ComponentDrawer<Component>::Draw);
 				}
-				Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.MetallicID()).first, imageSize);
-				ImGui::SameLine();
-				Renderer::GetRenderer()->DrawTextureToGUI(textures.at(component.RoughnessID()).first, imageSize);
-				ImGui::SameLine();
-
-
-
 			});
 		return true;
 		
@@ -9,7 +9,11 @@
 %VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/pbr.vert -o Velocity/assets/shaders/pbrvert.spv
 %VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/pbr.frag -o Velocity/assets/shaders/pbrfrag.spv
 
-%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/ibl/flattocubemap.vert -o Velocity/assets/shaders/ibl/flattocubemapvert.spv
-%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/ibl/flattocubemap.frag -o Velocity/assets/shaders/ibl/flattocubemapfrag.spv
+%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/ibl/equirecttocube.comp -o Velocity/assets/shaders/ibl/equirecttocubecomp.spv
+%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/ibl/irradiance.comp -o Velocity/assets/shaders/ibl/irradiancecomp.spv
+%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/ibl/prefilter.comp -o Velocity/assets/shaders/ibl/prefiltercomp.spv
+%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/ibl/brdflut.comp -o Velocity/assets/shaders/ibl/brdflutcomp.spv
+
+%VK_SDK_PATH%/bin32/glslc.exe Velocity/assets/shaders/clustercull.comp -o Velocity/assets/shaders/clustercullcomp.spv
 
 pause
\ No newline at end of file
@@ -32,6 +32,7 @@ IncludeDir["zstr"] = "Velocity/vendor/zstr/src"
 IncludeDir["nfd"] = "Velocity/vendor/nfd/include"
 IncludeDir["snappy"] = "Velocity/vendor/snappy"
 IncludeDir["cuteheaders"] = "Velocity/vendor/cute_headers"
+IncludeDir["zlib"] = "Velocity/vendor/zlib"
 
 group "Dependencies"
 	include "Velocity/vendor/GLFW"
@@ -44,6 +45,52 @@ group "Dependencies"
 		language "C++"
 		staticruntime "on"
 
+	-- Deflate for scene files and packs. zlib has no premake file of its own so it is built from here
+	project "zlib"
+		location "Velocity/vendor/zlib"
+		kind "StaticLib"
+		language "C"
+		staticruntime "on"
+
+		targetdir("bin/" .. outputdir .. "/%{prj.name}")
+		objdir("bin-init/" .. outputdir .. "/%{prj.name}")
+
+		files
+		{
+			"%{IncludeDir.zlib}/*.h",
+			"%{IncludeDir.zlib}/adler32.c",
+			"%{IncludeDir.zlib}/compress.c",
+			"%{IncludeDir.zlib}/crc32.c",
+			"%{IncludeDir.zlib}/deflate.c",
+			"%{IncludeDir.zlib}/gzclose.c",
+			"%{IncludeDir.zlib}/gzlib.c",
+			"%{IncludeDir.zlib}/gzread.c",
+			"%{IncludeDir.zlib}/gzwrite.c",
+			"%{IncludeDir.zlib}/infback.c",
+			"%{IncludeDir.zlib}/inffast.c",
+			"%{IncludeDir.zlib}/inflate.c",
+			"%{IncludeDir.zlib}/inftrees.c",
+			"%{IncludeDir.zlib}/trees.c",
+			"%{IncludeDir.zlib}/uncompr.c",
+			"%{IncludeDir.zlib}/zutil.c"
+		}
+
+		filter "system:windows"
+			systemversion "latest"
+			defines
+			{
+				"_CRT_SECURE_NO_DEPRECATE",
+				"_CRT_NONSTDC_NO_DEPRECATE"
+			}
+
+		filter "configurations:Debug"
+			runtime "Debug"
+			symbols "on"
+
+		filter "configurations:Release"
+			runtime "Release"
+			optimize "on"
+
 group ""
 
 project "Velocity"
@@ -84,7 +131,8 @@ project "Velocity"
 		"%{IncludeDir.zstr}",
 		"%{IncludeDir.nfd}",
 		"%{IncludeDir.snappy}",
-		"%{IncludeDir.cuteheaders}"
+		"%{IncludeDir.cuteheaders}",
+		"%{IncludeDir.zlib}"
 	}
 	
 	links
@@ -93,7 +141,8 @@ project "Velocity"
 		vulkanpath .. "/Lib/vulkan-1.lib",
 		"imgui",
 		"nfd",
-		"snappy"
+		"snappy",
+		"zlib"
 	}
 	
 	filter "system:windows"
@@ -158,7 +207,8 @@ project "VelocityEditor"
 		"%{IncludeDir.zstr}",
 		"%{IncludeDir.nfd}",
 		"%{IncludeDir.snappy}",
-		"%{IncludeDir.cuteheaders}"
+		"%{IncludeDir.cuteheaders}",
+		"%{IncludeDir.zlib}"
 	}
 	
 	links
@@ -197,4 +247,77 @@ project "VelocityEditor"
 			("{COPY} " .. _WORKING_DIR .. "\\Velocity\\vendor\\assimp\\Release\\assimp-vc142-mt.dll " .. _WORKING_DIR ..  "\\bin\\" .. outputdir .. "\\VelocityEditor\\")
 		}
 
-		
\ No newline at end of file
+		
+project "VelocityCooker"
+	location "VelocityCooker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	
+	targetdir("bin/" .. outputdir .. "/%{prj.name}")
+	objdir("bin-init/" .. outputdir .. "/%{prj.name}")
+	
+	files 
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.hpp",
+		"%{prj.name}/src/**.cpp"
+	}
+	
+	includedirs
+	{
+		"Velocity/vendor/spdlog/include",
+		"Velocity/src",
+		"Velocity/vendor",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.vulkan}",
+		"%{IncludeDir.stb}",
+		"%{IncludeDir.GLFW}",
+		"%{IncludeDir.imgui}",
+		"%{IncludeDir.assimp}",
+		"%{IncludeDir.entt}",
+		"%{IncludeDir.ImGuizmo}",
+		"%{IncludeDir.cereal}",
+		"%{IncludeDir.zstr}",
+		"%{IncludeDir.nfd}",
+		"%{IncludeDir.snappy}",
+		"%{IncludeDir.cuteheaders}",
+		"%{IncludeDir.zlib}"
+	}
+	
+	links
+	{
+		"Velocity"
+	}
+	
+	filter "system:windows"
+		systemversion "latest"
+		defines "VEL_PLATFORM_WINDOWS"
+
+	filter "configurations:Debug"
+		defines "VEL_DEBUG"
+		runtime "Debug"
+		symbols "on"
+		links
+		{
+			"Velocity/vendor/assimp/Debug/assimp-vc142-mtd.lib"
+		}
+		postbuildcommands
+		{
+			("{COPY} " .. _WORKING_DIR .. "\\Velocity\\vendor\\assimp\\Debug\\assimp-vc142-mtd.dll " .. _WORKING_DIR ..  "\\bin\\" .. outputdir .. "\\VelocityCooker\\")
+		}
+
+		
+	filter "configurations:Release"
+		defines "VEL_RELEASE"
+		runtime "Release"
+		optimize "on"
+		links
+		{
+			"Velocity/vendor/assimp/Release/assimp-vc142-mt.lib"
+		}
+		postbuildcommands
+		{
+			("{COPY} " .. _WORKING_DIR .. "\\Velocity\\vendor\\assimp\\Release\\assimp-vc142-mt.dll " .. _WORKING_DIR ..  "\\bin\\" .. outputdir .. "\\VelocityCooker\\")
+		}